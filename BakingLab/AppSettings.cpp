@@ -185,6 +185,28 @@ static const char* SolveModesLabels[5] =
     "Running Average Non-Negative",
 };
 
+static const char* BakeResultLayoutsLabels[3] =
+{
+    "Per Basis",
+    "Texel Interleaved",
+    "Tiled 8x8",
+};
+
+static const char* BakeResultFormatsLabels[3] =
+{
+    "Float4",
+    "Float3 (No Padding)",
+    "Half4",
+};
+
+static const char* ProbeBasesLabels[4] =
+{
+    "L2 SH",
+    "SG6",
+    "SG9",
+    "SG12",
+};
+
 static const char* ScenesLabels[3] =
 {
     "Box",
@@ -222,6 +244,8 @@ namespace AppSettings
     FloatSetting AreaLightShadowBias;
     BoolSetting BakeDirectAreaLight;
     BoolSetting EnableAreaLightShadows;
+    BoolSetting AnalyticAreaLight;
+    IntSetting AreaLightVisibilityRays;
     ExposureModesSetting ExposureMode;
     FloatSetting ManualExposure;
     FStopsSetting ApertureSize;
@@ -258,14 +282,47 @@ namespace AppSettings
     SH4DiffuseModesSetting SH4DiffuseMode;
     SHSpecularModesSetting SHSpecularMode;
     IntSetting LightMapResolution;
+    BoolSetting PackLightMapCharts;
+    FloatSetting LightMapTexelDensity;
+    IntSetting LightMapChartPadding;
+    IntSetting LightMapPageCount;
     IntSetting NumBakeSamples;
     SampleModesSetting BakeSampleMode;
     IntSetting MaxBakePathLength;
     IntSetting BakeRussianRouletteDepth;
     FloatSetting BakeRussianRouletteProbability;
+    BoolSetting IterativeBounces;
+    IntSetting NumIterativeBounces;
+    BoolSetting RelightableBake;
+    BoolSetting MultiBasisBake;
     BakeModesSetting BakeMode;
     SolveModesSetting SolveMode;
     BoolSetting WorldSpaceBake;
+    BakeResultLayoutsSetting BakeResultLayout;
+    BakeResultFormatsSetting BakeResultFormat;
+    BoolSetting SpatialBakeOrder;
+    BoolSetting OutOfCoreBake;
+    IntSetting BakeTileSize;
+    BoolSetting BakeProbes;
+    ProbeBasesSetting ProbeBasis;
+    IntSetting ProbeGridResolution;
+    BoolSetting ShowProbes;
+    BoolSetting EnableRadianceCache;
+    IntSetting RadianceCacheBounce;
+    FloatSetting RadianceCacheCellSize;
+    IntSetting RadianceCacheMinSamples;
+    BoolSetting ShowRadianceCacheOccupancy;
+    BoolSetting EnablePathGuiding;
+    IntSetting PathGuidingTrainingPasses;
+    FloatSetting PathGuidingFraction;
+    IntSetting PathGuidingGridResolution;
+    BoolSetting EnableSampleReuse;
+    IntSetting SampleReuseCandidates;
+    IntSetting SampleReuseNeighbors;
+    IntSetting SampleReuseRadius;
+    IntSetting SampleReuseMaxHistory;
+    BoolSetting EnableEmissiveLights;
+    FloatSetting EmissiveIntensity;
     ScenesSetting CurrentScene;
     BoolSetting EnableDiffuse;
     BoolSetting EnableSpecular;
@@ -298,6 +355,12 @@ namespace AppSettings
     Button LoadLightSettings;
     Button SaveEXRScreenshot;
     BoolSetting ShowSunIntensity;
+    BoolSetting EnableTracing;
+    Button ExportTrace;
+    Button ExportBakeStats;
+    Button ExportBakeResults;
+    BoolSetting RecordRadianceSamples;
+    Button ReplayRadianceSamples;
 
     ConstantBuffer<AppSettingsCBuffer> CBuffer;
 
@@ -393,6 +456,12 @@ namespace AppSettings
         EnableAreaLightShadows.Initialize(tweakBar, "EnableAreaLightShadows", "Area Light", "Enable Area Light Shadows", "", true);
         Settings.AddSetting(&EnableAreaLightShadows);
 
+        AnalyticAreaLight.Initialize(tweakBar, "AnalyticAreaLight", "Area Light", "Analytic Direct Lighting", "Computes the unshadowed diffuse lighting from the area light analytically when baking and path tracing, and only uses shadow rays to estimate how much of it is visible. The sun is always sampled", false);
+        Settings.AddSetting(&AnalyticAreaLight);
+
+        AreaLightVisibilityRays.Initialize(tweakBar, "AreaLightVisibilityRays", "Area Light", "Visibility Rays", "Number of shadow rays that estimate the visible fraction of the analytic area light and sun lighting", 1, 1, 16);
+        Settings.AddSetting(&AreaLightVisibilityRays);
+
         ExposureMode.Initialize(tweakBar, "ExposureMode", "Camera Controls", "Exposure Mode", "Specifies how exposure should be controled", ExposureModes::Manual_SBS, 4, ExposureModesLabels);
         Settings.AddSetting(&ExposureMode);
 
@@ -508,9 +577,21 @@ namespace AppSettings
         SHSpecularMode.Initialize(tweakBar, "SHSpecularMode", "SH Settings", "SH Specular Mode", "", SHSpecularModes::Convolution, 4, SHSpecularModesLabels);
         Settings.AddSetting(&SHSpecularMode);
 
-        LightMapResolution.Initialize(tweakBar, "LightMapResolution", "Baking", "Light Map Resolution", "The texture resolution of the light map", 256, 64, 4096);
+        LightMapResolution.Initialize(tweakBar, "LightMapResolution", "Baking", "Light Map Resolution", "The texture resolution of the light map", 256, 64, 8192);
         Settings.AddSetting(&LightMapResolution);
 
+        PackLightMapCharts.Initialize(tweakBar, "PackLightMapCharts", "Baking", "Pack Light Map Charts", "Repacks the light map UV charts of each mesh into a new atlas, scaled by their world-space area", false);
+        Settings.AddSetting(&PackLightMapCharts);
+
+        LightMapTexelDensity.Initialize(tweakBar, "LightMapTexelDensity", "Baking", "Light Map Texel Density", "Target number of light map texels per world-space unit when packing charts (shrunk automatically if the charts don't fit)", 16.0000f, 0.0100f, 1024.0000f, 0.1000f, ConversionMode::None, 1.0000f);
+        Settings.AddSetting(&LightMapTexelDensity);
+
+        LightMapChartPadding.Initialize(tweakBar, "LightMapChartPadding", "Baking", "Light Map Chart Padding", "Number of gutter texels to leave on each side of a packed chart", 2, 1, 16);
+        Settings.AddSetting(&LightMapChartPadding);
+
+        LightMapPageCount.Initialize(tweakBar, "LightMapPageCount", "Baking", "Light Map Page Count", "Maximum number of atlas pages that packed light map charts can be spread across", 1, 1, 8);
+        Settings.AddSetting(&LightMapPageCount);
+
         NumBakeSamples.Initialize(tweakBar, "NumBakeSamples", "Baking", "Sqrt Num Samples", "The square root of the number of sample rays to use for baking GI", 25, 1, 100);
         Settings.AddSetting(&NumBakeSamples);
 
@@ -526,6 +607,18 @@ namespace AppSettings
         BakeRussianRouletteProbability.Initialize(tweakBar, "BakeRussianRouletteProbability", "Baking", "Russian Roullette Probability", "Maximum probability for continuing when Russian roulette is used", 0.5000f, 0.0000f, 1.0000f, 0.0100f, ConversionMode::None, 1.0000f);
         Settings.AddSetting(&BakeRussianRouletteProbability);
 
+        IterativeBounces.Initialize(tweakBar, "IterativeBounces", "Baking", "Iterative Bounces", "Bakes one bounce per light map pass, where each pass traces a single segment per sample and reads the irradiance of the previous pass back from the light map at the hit point (not supported for out-of-core bakes)", false);
+        Settings.AddSetting(&IterativeBounces);
+
+        NumIterativeBounces.Initialize(tweakBar, "NumIterativeBounces", "Baking", "Num Iterative Bounces", "Number of bounces for iterative bounce baking, which takes one full light map pass per bounce", 4, 1, 16);
+        Settings.AddSetting(&NumIterativeBounces);
+
+        RelightableBake.Initialize(tweakBar, "RelightableBake", "Baking", "Relightable Bake", "Bakes the transfer from the sky and sun to every texel instead of the final lighting, so that changes to the sky or the sun only re-light the existing bake instead of restarting it. The sun reaches the light map through a low-order SH projection, so its bounce lighting is softer than in a regular bake (only supported for progressive bake modes, and not together with out-of-core bakes, iterative bounces or the radiance cache)", false);
+        Settings.AddSetting(&RelightableBake);
+
+        MultiBasisBake.Initialize(tweakBar, "MultiBasisBake", "Baking", "Multi-Basis Bake", "Bakes every bake mode at once from a single set of uniformly distributed samples, so that switching the bake mode only changes which results are shown instead of restarting the bake. Each texel is fully baked before moving on to the next one (not supported for out-of-core or relightable bakes)", false);
+        Settings.AddSetting(&MultiBasisBake);
+
         BakeMode.Initialize(tweakBar, "BakeMode", "Baking", "Bake Mode", "The current encoding/basis used for baking light map sample points", BakeModes::SG5, 11, BakeModesLabels);
         Settings.AddSetting(&BakeMode);
 
@@ -535,6 +628,81 @@ namespace AppSettings
         WorldSpaceBake.Initialize(tweakBar, "WorldSpaceBake", "Baking", "World Space Bake", "If true, the sample points are baked in a world-space orientation instead of tangent space (SH and SG bake modes only)", false);
         Settings.AddSetting(&WorldSpaceBake);
 
+        BakeResultLayout.Initialize(tweakBar, "BakeResultLayout", "Baking", "Bake Result Layout", "Controls how the baked results for each texel are laid out in memory while baking", BakeResultLayouts::Tiled, 3, BakeResultLayoutsLabels);
+        Settings.AddSetting(&BakeResultLayout);
+
+        BakeResultFormat.Initialize(tweakBar, "BakeResultFormat", "Baking", "Bake Result Format", "Storage format for the baked results. Float3 drops the padding channel for bake modes that don't use it, Half4 halves the memory at the cost of accumulation precision", BakeResultFormats::Float4, 3, BakeResultFormatsLabels);
+        Settings.AddSetting(&BakeResultFormat);
+
+        SpatialBakeOrder.Initialize(tweakBar, "SpatialBakeOrder", "Baking", "Spatial Bake Order", "Hands out the bake groups of each pass along a world-space Morton curve through their sample points instead of in light map order, so that the groups that are baked at the same time share more of the BVH and material textures (in-core bakes only)", true);
+        Settings.AddSetting(&SpatialBakeOrder);
+
+        OutOfCoreBake.Initialize(tweakBar, "OutOfCoreBake", "Baking", "Out-Of-Core Bake", "Bakes the light map one tile at a time, streaming finished tiles to OutOfCoreBake.bin instead of keeping the whole light map in memory", false);
+        Settings.AddSetting(&OutOfCoreBake);
+
+        BakeTileSize.Initialize(tweakBar, "BakeTileSize", "Baking", "Bake Tile Size", "Width and height of the tiles used for out-of-core baking (rounded up to a multiple of 8)", 256, 64, 2048);
+        Settings.AddSetting(&BakeTileSize);
+
+        BakeProbes.Initialize(tweakBar, "BakeProbes", "Probe Baking", "Bake Probes", "Bakes a regular grid of radiance probes over the bounds of the scene, alongside the light map", false);
+        Settings.AddSetting(&BakeProbes);
+
+        ProbeBasis.Initialize(tweakBar, "ProbeBasis", "Probe Baking", "Probe Basis", "The basis used for storing the incoming radiance of each probe over the full sphere", ProbeBases::SH9, 4, ProbeBasesLabels);
+        Settings.AddSetting(&ProbeBasis);
+
+        ProbeGridResolution.Initialize(tweakBar, "ProbeGridResolution", "Probe Baking", "Probe Grid Resolution", "Number of probes along the longest axis of the scene bounds", 8, 2, 64);
+        Settings.AddSetting(&ProbeGridResolution);
+
+        ShowProbes.Initialize(tweakBar, "ShowProbes", "Probe Baking", "Show Probes", "Draws a sphere at the position of each probe, shaded with its baked radiance", false);
+        Settings.AddSetting(&ShowProbes);
+
+        EnableRadianceCache.Initialize(tweakBar, "EnableRadianceCache", "Radiance Cache", "Enable Radiance Cache", "Terminates bake paths into a world-space hash grid of cached outgoing radiance after a few bounces, which trades some bias for much shorter paths", false);
+        Settings.AddSetting(&EnableRadianceCache);
+
+        RadianceCacheBounce.Initialize(tweakBar, "RadianceCacheBounce", "Radiance Cache", "Cache Bounce", "Number of bounces that are path traced before a path terminates into the radiance cache", 1, 1, 8);
+        Settings.AddSetting(&RadianceCacheBounce);
+
+        RadianceCacheCellSize.Initialize(tweakBar, "RadianceCacheCellSize", "Radiance Cache", "Cache Cell Size", "World-space width of the radiance cache cells. Larger cells fill up faster, but blur the cached lighting over a wider area.", 0.2500f, 0.0100f, 10.0000f, 0.0100f, ConversionMode::None, 1.0000f);
+        Settings.AddSetting(&RadianceCacheCellSize);
+
+        RadianceCacheMinSamples.Initialize(tweakBar, "RadianceCacheMinSamples", "Radiance Cache", "Cache Min Samples", "Number of samples a cache cell needs before paths terminate into it. Lower values shorten paths sooner, at the cost of noisier cached radiance.", 16, 1, 4096);
+        Settings.AddSetting(&RadianceCacheMinSamples);
+
+        ShowRadianceCacheOccupancy.Initialize(tweakBar, "ShowRadianceCacheOccupancy", "Radiance Cache", "Show Cache Occupancy", "Shows how many radiance cache cells are in use by the current bake, and how many of them are warm enough to terminate paths into", false);
+        Settings.AddSetting(&ShowRadianceCacheOccupancy);
+
+        EnablePathGuiding.Initialize(tweakBar, "EnablePathGuiding", "Path Guiding", "Enable Path Guiding", "Samples bounce directions from a learned per-cell distribution of incident radiance, which is trained during the first passes of every bake and ground truth render and then mixed with BRDF sampling. Helps with light that reaches a room through small openings. Not used for out-of-core, iterative bounce or relightable bakes.", false);
+        Settings.AddSetting(&EnablePathGuiding);
+
+        PathGuidingTrainingPasses.Initialize(tweakBar, "PathGuidingTrainingPasses", "Path Guiding", "Training Passes", "Number of passes at the start of every bake and ground truth render that train the path guide, before the rest of the passes sample from it. For bake modes that aren't progressive, this is the number of texels per 8x8 group.", 4, 1, 64);
+        Settings.AddSetting(&PathGuidingTrainingPasses);
+
+        PathGuidingFraction.Initialize(tweakBar, "PathGuidingFraction", "Path Guiding", "Guided Fraction", "Probability of drawing an indirect diffuse bounce from the path guide instead of the BRDF, in cells that the guide has learned a distribution for", 0.5000f, 0.0000f, 1.0000f, 0.0100f, ConversionMode::None, 1.0000f);
+        Settings.AddSetting(&PathGuidingFraction);
+
+        PathGuidingGridResolution.Initialize(tweakBar, "PathGuidingGridResolution", "Path Guiding", "Guide Grid Resolution", "Number of path guide cells along the longest axis of the scene. More cells adapt better to local lighting, but need more training samples to fill up.", 32, 1, 64);
+        Settings.AddSetting(&PathGuidingGridResolution);
+
+        EnableSampleReuse.Initialize(tweakBar, "EnableSampleReuse", "Sample Reuse", "Enable Sample Reuse", "Picks the direct area light sample of every texel by resampling a few candidates, and re-uses the picked samples across passes and between neighboring texels on the same chart. Speeds up the convergence of the baked area light at low sample counts. Not used for out-of-core bakes, or together with Analytic Direct Lighting.", false);
+        Settings.AddSetting(&EnableSampleReuse);
+
+        SampleReuseCandidates.Initialize(tweakBar, "SampleReuseCandidates", "Sample Reuse", "Candidates", "Number of fresh points on the area light that are resampled for every area light sample of a texel", 4, 1, 32);
+        Settings.AddSetting(&SampleReuseCandidates);
+
+        SampleReuseNeighbors.Initialize(tweakBar, "SampleReuseNeighbors", "Sample Reuse", "Spatial Neighbors", "Number of neighboring texels whose reservoirs are combined with the texel's own. Neighbors are only used if their position and normal line up with the texel's surface.", 3, 0, 8);
+        Settings.AddSetting(&SampleReuseNeighbors);
+
+        SampleReuseRadius.Initialize(tweakBar, "SampleReuseRadius", "Sample Reuse", "Neighbor Radius", "Maximum distance in texels of the neighbors that share their samples", 2, 1, 8);
+        Settings.AddSetting(&SampleReuseRadius);
+
+        SampleReuseMaxHistory.Initialize(tweakBar, "SampleReuseMaxHistory", "Sample Reuse", "Max History", "Caps how many candidates a re-used reservoir can count as, relative to the fresh candidates of a single sample. Lower values adapt faster to the texel's own samples.", 20, 1, 64);
+        Settings.AddSetting(&SampleReuseMaxHistory);
+
+        EnableEmissiveLights.Initialize(tweakBar, "EnableEmissiveLights", "Emissive Lights", "Enable Emissive Lights", "Treats every triangle whose material has an emissive color as a light source. Paths pick up the emission when they first hit an emitter, and every path vertex samples one emitter through a light BVH for next event estimation. Emissive colors are only imported from FBX and other scene files that go through Assimp.", false);
+        Settings.AddSetting(&EnableEmissiveLights);
+
+        EmissiveIntensity.Initialize(tweakBar, "EmissiveIntensity", "Emissive Lights", "Emissive Intensity", "Luminance (cd/m^2) of an emissive color of 1", 10000.0000f, 0.0000f, 10000000.0000f, 100.0000f, ConversionMode::None, 1.0000f);
+        Settings.AddSetting(&EmissiveIntensity);
+
         CurrentScene.Initialize(tweakBar, "CurrentScene", "Scene", "Current Scene", "", Scenes::Box, 3, ScenesLabels);
         Settings.AddSetting(&CurrentScene);
 
@@ -631,6 +799,24 @@ namespace AppSettings
         ShowSunIntensity.Initialize(tweakBar, "ShowSunIntensity", "Debug", "Show Sun Intensity", "", false);
         Settings.AddSetting(&ShowSunIntensity);
 
+        EnableTracing.Initialize(tweakBar, "EnableTracing", "Debug", "Enable Tracing", "Records timed spans from the main, bake and render threads into per-thread ring buffers", false);
+        Settings.AddSetting(&EnableTracing);
+
+        ExportTrace.Initialize(tweakBar, "ExportTrace", "Debug", "Export Trace", "Writes the recorded spans to BakeTrace.json, which can be opened in chrome://tracing or Perfetto");
+        Settings.AddSetting(&ExportTrace);
+
+        ExportBakeStats.Initialize(tweakBar, "ExportBakeStats", "Debug", "Export Bake Stats", "Writes the hot-path counters of the current bake to BakeStats.json");
+        Settings.AddSetting(&ExportBakeStats);
+
+        ExportBakeResults.Initialize(tweakBar, "ExportBakeResults", "Debug", "Export Bake Results", "Writes every basis of each light map page to BakeResults_Page<N>.exr, with one layer per basis");
+        Settings.AddSetting(&ExportBakeResults);
+
+        RecordRadianceSamples.Initialize(tweakBar, "RecordRadianceSamples", "Debug", "Record Radiance Samples", "Records every radiance sample of the light map bake to RadianceSamples_Chunk<N>.bin, so that the bake can be re-solved later on without tracing it again. The samples are complete once the bake finishes (in-core bakes that aren't relightable only)", false);
+        Settings.AddSetting(&RecordRadianceSamples);
+
+        ReplayRadianceSamples.Initialize(tweakBar, "ReplayRadianceSamples", "Debug", "Replay Radiance Samples", "Runs the recorded radiance samples through the baker of the current bake mode and solve mode, and replaces the light map with the results");
+        Settings.AddSetting(&ReplayRadianceSamples);
+
         TwHelper::SetOpened(tweakBar, "Sun Light", true);
 
         TwHelper::SetOpened(tweakBar, "Sky", true);
@@ -649,6 +835,16 @@ namespace AppSettings
 
         TwHelper::SetOpened(tweakBar, "Baking", false);
 
+        TwHelper::SetOpened(tweakBar, "Probe Baking", false);
+
+        TwHelper::SetOpened(tweakBar, "Radiance Cache", false);
+
+        TwHelper::SetOpened(tweakBar, "Path Guiding", false);
+
+        TwHelper::SetOpened(tweakBar, "Sample Reuse", false);
+
+        TwHelper::SetOpened(tweakBar, "Emissive Lights", false);
+
         TwHelper::SetOpened(tweakBar, "Scene", false);
 
         TwHelper::SetOpened(tweakBar, "Ground Truth", false);
@@ -969,11 +1165,32 @@ namespace AppSettings
         SunElevation.SetVisible(enableHorizCoord);
 
         SGDiffuseMode.SetEditable(useSGSettings);
-        SolveMode.SetEditable(useSGSettings);
+        SolveMode.SetEditable(useSGSettings || MultiBasisBake);
 
         SH4DiffuseMode.SetEditable(BakeMode == BakeModes::SH4);
         SHSpecularMode.SetEditable(BakeMode == BakeModes::SH4 || BakeMode == BakeModes::SH9);
 
+        ShowProbes.SetEditable(BakeProbes);
+
+        NumIterativeBounces.SetEditable(IterativeBounces);
+
+        RadianceCacheBounce.SetEditable(EnableRadianceCache);
+        RadianceCacheCellSize.SetEditable(EnableRadianceCache);
+        RadianceCacheMinSamples.SetEditable(EnableRadianceCache);
+        ShowRadianceCacheOccupancy.SetEditable(EnableRadianceCache);
+
+        PathGuidingTrainingPasses.SetEditable(EnablePathGuiding);
+        PathGuidingFraction.SetEditable(EnablePathGuiding);
+        PathGuidingGridResolution.SetEditable(EnablePathGuiding);
+
+        AreaLightVisibilityRays.SetEditable(AnalyticAreaLight);
+
+        EnableSampleReuse.SetEditable(AnalyticAreaLight == false);
+        SampleReuseCandidates.SetEditable(SampleReuseEnabled());
+        SampleReuseNeighbors.SetEditable(SampleReuseEnabled());
+        SampleReuseRadius.SetEditable(SampleReuseEnabled());
+        SampleReuseMaxHistory.SetEditable(SampleReuseEnabled());
+
         if(AppSettings::HasSunDirChanged())
         {
             if(SunDirType == SunDirectionTypes::UnitVector)
@@ -300,6 +300,38 @@ enum SolveModes
     RunningAverageNN,
 }
 
+enum BakeResultLayouts
+{
+    [EnumLabel("Per Basis")]
+    PerBasis = 0,
+
+    [EnumLabel("Texel Interleaved")]
+    TexelInterleaved,
+
+    [EnumLabel("Tiled 8x8")]
+    Tiled,
+}
+
+enum BakeResultFormats
+{
+    Float4 = 0,
+
+    [EnumLabel("Float3 (No Padding)")]
+    Float3,
+
+    Half4,
+}
+
+enum ProbeBases
+{
+    [EnumLabel("L2 SH")]
+    SH9 = 0,
+
+    SG6,
+    SG9,
+    SG12,
+}
+
 enum SGDiffuseModes
 {
     InnerProduct = 0,
@@ -485,6 +517,18 @@ public class Settings
         bool BakeDirectAreaLight = false;
 
         bool EnableAreaLightShadows = true;
+
+        [DisplayName("Analytic Direct Lighting")]
+        [HelpText("Computes the unshadowed diffuse lighting from the area light analytically when baking and path tracing, and only uses shadow rays to estimate how much of it is visible. The sun is always sampled")]
+        [UseAsShaderConstant(false)]
+        bool AnalyticAreaLight = false;
+
+        [DisplayName("Visibility Rays")]
+        [HelpText("Number of shadow rays that estimate the visible fraction of the analytic area light and sun lighting")]
+        [UseAsShaderConstant(false)]
+        [MinValue(1)]
+        [MaxValue(16)]
+        int AreaLightVisibilityRays = 1;
     }
 
     [ExpandGroup(false)]
@@ -638,6 +682,7 @@ public class Settings
 
     const int MaxSGCount = 12;
     const int MaxBasisCount = MaxSGCount;
+    const int MaxLightMapPages = 8;
 
     [ExpandGroup(false)]
     [DisplayName("SG Settings")]
@@ -667,9 +712,32 @@ public class Settings
         [DisplayName("Light Map Resolution")]
         [HelpText("The texture resolution of the light map")]
         [MinValue(64)]
-        [MaxValue(4096)]
+        [MaxValue(8192)]
         int LightMapResolution = 256;
 
+        [HelpText("Repacks the light map UV charts of each mesh into a new atlas, scaled by their world-space area")]
+        [UseAsShaderConstant(false)]
+        bool PackLightMapCharts = false;
+
+        [HelpText("Target number of light map texels per world-space unit when packing charts (shrunk automatically if the charts don't fit)")]
+        [UseAsShaderConstant(false)]
+        [MinValue(0.01f)]
+        [MaxValue(1024.0f)]
+        [StepSize(0.1f)]
+        float LightMapTexelDensity = 16.0f;
+
+        [HelpText("Number of gutter texels to leave on each side of a packed chart")]
+        [UseAsShaderConstant(false)]
+        [MinValue(1)]
+        [MaxValue(16)]
+        int LightMapChartPadding = 2;
+
+        [HelpText("Maximum number of atlas pages that packed light map charts can be spread across")]
+        [UseAsShaderConstant(false)]
+        [MinValue(1)]
+        [MaxValue(8)]
+        int LightMapPageCount = 1;
+
         [HelpText("The square root of the number of sample rays to use for baking GI")]
         [MinValue(1)]
         [MaxValue(100)]
@@ -700,6 +768,26 @@ public class Settings
         [DisplayName("Russian Roullette Probability")]
         float BakeRussianRouletteProbability = 0.5f;
 
+        [HelpText("Bakes one bounce per light map pass, where each pass traces a single segment per sample and reads the irradiance of the previous pass back from the light map at the hit point (not supported for out-of-core bakes)")]
+        [UseAsShaderConstant(false)]
+        bool IterativeBounces = false;
+
+        [HelpText("Number of bounces for iterative bounce baking, which takes one full light map pass per bounce")]
+        [UseAsShaderConstant(false)]
+        [MinValue(1)]
+        [MaxValue(16)]
+        [DisplayName("Num Iterative Bounces")]
+        int NumIterativeBounces = 4;
+
+        [HelpText("Bakes the transfer from the sky and sun to every texel instead of the final lighting, so that changes to the sky or the sun only re-light the existing bake instead of restarting it. The sun reaches the light map through a low-order SH projection, so its bounce lighting is softer than in a regular bake (only supported for progressive bake modes, and not together with out-of-core bakes, iterative bounces or the radiance cache)")]
+        [UseAsShaderConstant(false)]
+        bool RelightableBake = false;
+
+        [HelpText("Bakes every bake mode at once from a single set of uniformly distributed samples, so that switching the bake mode only changes which results are shown instead of restarting the bake. Each texel is fully baked before moving on to the next one (not supported for out-of-core or relightable bakes)")]
+        [UseAsShaderConstant(false)]
+        [DisplayName("Multi-Basis Bake")]
+        bool MultiBasisBake = false;
+
         [HelpText("The current encoding/basis used for baking light map sample points")]
         BakeModes BakeMode = BakeModes.SG5;
 
@@ -708,6 +796,181 @@ public class Settings
 
         [HelpText("If true, the sample points are baked in a world-space orientation instead of tangent space (SH and SG bake modes only)")]
         bool WorldSpaceBake = false;
+
+        [HelpText("Controls how the baked results for each texel are laid out in memory while baking")]
+        [UseAsShaderConstant(false)]
+        BakeResultLayouts BakeResultLayout = BakeResultLayouts.Tiled;
+
+        [HelpText("Storage format for the baked results. Float3 drops the padding channel for bake modes that don't use it, Half4 halves the memory at the cost of accumulation precision")]
+        [UseAsShaderConstant(false)]
+        BakeResultFormats BakeResultFormat = BakeResultFormats.Float4;
+
+        [HelpText("Hands out the bake groups of each pass along a world-space Morton curve through their sample points instead of in light map order, so that the groups that are baked at the same time share more of the BVH and material textures (in-core bakes only)")]
+        [UseAsShaderConstant(false)]
+        bool SpatialBakeOrder = true;
+
+        [HelpText("Bakes the light map one tile at a time, streaming finished tiles to OutOfCoreBake.bin instead of keeping the whole light map in memory")]
+        [UseAsShaderConstant(false)]
+        [DisplayName("Out-Of-Core Bake")]
+        bool OutOfCoreBake = false;
+
+        [HelpText("Width and height of the tiles used for out-of-core baking (rounded up to a multiple of 8)")]
+        [UseAsShaderConstant(false)]
+        [MinValue(64)]
+        [MaxValue(2048)]
+        int BakeTileSize = 256;
+    }
+
+    [ExpandGroup(false)]
+    [DisplayName("Probe Baking")]
+    public class ProbeBaking
+    {
+        [DisplayName("Bake Probes")]
+        [HelpText("Bakes a regular grid of radiance probes over the bounds of the scene, alongside the light map")]
+        [UseAsShaderConstant(false)]
+        bool BakeProbes = false;
+
+        [DisplayName("Probe Basis")]
+        [HelpText("The basis used for storing the incoming radiance of each probe over the full sphere")]
+        [UseAsShaderConstant(false)]
+        ProbeBases ProbeBasis = ProbeBases.SH9;
+
+        [DisplayName("Probe Grid Resolution")]
+        [HelpText("Number of probes along the longest axis of the scene bounds")]
+        [UseAsShaderConstant(false)]
+        [MinValue(2)]
+        [MaxValue(64)]
+        int ProbeGridResolution = 8;
+
+        [DisplayName("Show Probes")]
+        [HelpText("Draws a sphere at the position of each probe, shaded with its baked radiance")]
+        [UseAsShaderConstant(false)]
+        bool ShowProbes = false;
+    }
+
+    [ExpandGroup(false)]
+    [DisplayName("Radiance Cache")]
+    public class RadianceCache
+    {
+        [DisplayName("Enable Radiance Cache")]
+        [HelpText("Terminates bake paths into a world-space hash grid of cached outgoing radiance after a few bounces, which trades some bias for much shorter paths")]
+        [UseAsShaderConstant(false)]
+        bool EnableRadianceCache = false;
+
+        [DisplayName("Cache Bounce")]
+        [HelpText("Number of bounces that are path traced before a path terminates into the radiance cache")]
+        [UseAsShaderConstant(false)]
+        [MinValue(1)]
+        [MaxValue(8)]
+        int RadianceCacheBounce = 1;
+
+        [DisplayName("Cache Cell Size")]
+        [HelpText("World-space width of the radiance cache cells. Larger cells fill up faster, but blur the cached lighting over a wider area.")]
+        [UseAsShaderConstant(false)]
+        [MinValue(0.01f)]
+        [MaxValue(10.0f)]
+        [StepSize(0.01f)]
+        float RadianceCacheCellSize = 0.25f;
+
+        [DisplayName("Cache Min Samples")]
+        [HelpText("Number of samples a cache cell needs before paths terminate into it. Lower values shorten paths sooner, at the cost of noisier cached radiance.")]
+        [UseAsShaderConstant(false)]
+        [MinValue(1)]
+        [MaxValue(4096)]
+        int RadianceCacheMinSamples = 16;
+
+        [DisplayName("Show Cache Occupancy")]
+        [HelpText("Shows how many radiance cache cells are in use by the current bake, and how many of them are warm enough to terminate paths into")]
+        [UseAsShaderConstant(false)]
+        bool ShowRadianceCacheOccupancy = false;
+    }
+
+    [ExpandGroup(false)]
+    [DisplayName("Path Guiding")]
+    public class PathGuiding
+    {
+        [DisplayName("Enable Path Guiding")]
+        [HelpText("Samples bounce directions from a learned per-cell distribution of incident radiance, which is trained during the first passes of every bake and ground truth render and then mixed with BRDF sampling. Helps with light that reaches a room through small openings. Not used for out-of-core, iterative bounce or relightable bakes.")]
+        [UseAsShaderConstant(false)]
+        bool EnablePathGuiding = false;
+
+        [DisplayName("Training Passes")]
+        [HelpText("Number of passes at the start of every bake and ground truth render that train the path guide, before the rest of the passes sample from it. For bake modes that aren't progressive, this is the number of texels per 8x8 group.")]
+        [UseAsShaderConstant(false)]
+        [MinValue(1)]
+        [MaxValue(64)]
+        int PathGuidingTrainingPasses = 4;
+
+        [DisplayName("Guided Fraction")]
+        [HelpText("Probability of drawing an indirect diffuse bounce from the path guide instead of the BRDF, in cells that the guide has learned a distribution for")]
+        [UseAsShaderConstant(false)]
+        [MinValue(0.0f)]
+        [MaxValue(1.0f)]
+        [StepSize(0.01f)]
+        float PathGuidingFraction = 0.5f;
+
+        [DisplayName("Guide Grid Resolution")]
+        [HelpText("Number of path guide cells along the longest axis of the scene. More cells adapt better to local lighting, but need more training samples to fill up.")]
+        [UseAsShaderConstant(false)]
+        [MinValue(1)]
+        [MaxValue(64)]
+        int PathGuidingGridResolution = 32;
+    }
+
+    [ExpandGroup(false)]
+    [DisplayName("Sample Reuse")]
+    public class SampleReuse
+    {
+        [DisplayName("Enable Sample Reuse")]
+        [HelpText("Picks the direct area light sample of every texel by resampling a few candidates, and re-uses the picked samples across passes and between neighboring texels on the same chart. Speeds up the convergence of the baked area light at low sample counts. Not used for out-of-core bakes, or together with Analytic Direct Lighting.")]
+        [UseAsShaderConstant(false)]
+        bool EnableSampleReuse = false;
+
+        [DisplayName("Candidates")]
+        [HelpText("Number of fresh points on the area light that are resampled for every area light sample of a texel")]
+        [UseAsShaderConstant(false)]
+        [MinValue(1)]
+        [MaxValue(32)]
+        int SampleReuseCandidates = 4;
+
+        [DisplayName("Spatial Neighbors")]
+        [HelpText("Number of neighboring texels whose reservoirs are combined with the texel's own. Neighbors are only used if their position and normal line up with the texel's surface.")]
+        [UseAsShaderConstant(false)]
+        [MinValue(0)]
+        [MaxValue(8)]
+        int SampleReuseNeighbors = 3;
+
+        [DisplayName("Neighbor Radius")]
+        [HelpText("Maximum distance in texels of the neighbors that share their samples")]
+        [UseAsShaderConstant(false)]
+        [MinValue(1)]
+        [MaxValue(8)]
+        int SampleReuseRadius = 2;
+
+        [DisplayName("Max History")]
+        [HelpText("Caps how many candidates a re-used reservoir can count as, relative to the fresh candidates of a single sample. Lower values adapt faster to the texel's own samples.")]
+        [UseAsShaderConstant(false)]
+        [MinValue(1)]
+        [MaxValue(64)]
+        int SampleReuseMaxHistory = 20;
+    }
+
+    [ExpandGroup(false)]
+    [DisplayName("Emissive Lights")]
+    public class EmissiveLights
+    {
+        [DisplayName("Enable Emissive Lights")]
+        [HelpText("Treats every triangle whose material has an emissive color as a light source. Paths pick up the emission when they first hit an emitter, and every path vertex samples one emitter through a light BVH for next event estimation. Emissive colors are only imported from FBX and other scene files that go through Assimp.")]
+        [UseAsShaderConstant(false)]
+        bool EnableEmissiveLights = false;
+
+        [DisplayName("Emissive Intensity")]
+        [HelpText("Luminance (cd/m^2) of an emissive color of 1")]
+        [UseAsShaderConstant(false)]
+        [MinValue(0.0f)]
+        [MaxValue(10000000.0f)]
+        [StepSize(100.0f)]
+        float EmissiveIntensity = 10000.0f;
     }
 
     [ExpandGroup(false)]
@@ -872,5 +1135,29 @@ public class Settings
 
         [UseAsShaderConstant(false)]
         bool ShowSunIntensity = false;
+
+        [UseAsShaderConstant(false)]
+        [HelpText("Records timed spans from the main, bake and render threads into per-thread ring buffers")]
+        bool EnableTracing = false;
+
+        [DisplayName("Export Trace")]
+        [HelpText("Writes the recorded spans to BakeTrace.json, which can be opened in chrome://tracing or Perfetto")]
+        Button ExportTrace;
+
+        [DisplayName("Export Bake Stats")]
+        [HelpText("Writes the hot-path counters of the current bake to BakeStats.json")]
+        Button ExportBakeStats;
+
+        [DisplayName("Export Bake Results")]
+        [HelpText("Writes every basis of each light map page to BakeResults_Page<N>.exr, with one layer per basis")]
+        Button ExportBakeResults;
+
+        [UseAsShaderConstant(false)]
+        [HelpText("Records every radiance sample of the light map bake to RadianceSamples_Chunk<N>.bin, so that the bake can be re-solved later on without tracing it again. The samples are complete once the bake finishes (in-core bakes that aren't relightable only)")]
+        bool RecordRadianceSamples = false;
+
+        [DisplayName("Replay Radiance Samples")]
+        [HelpText("Runs the recorded radiance samples through the baker of the current bake mode and solve mode, and replaces the light map with the results")]
+        Button ReplayRadianceSamples;
     }
 }
\ No newline at end of file
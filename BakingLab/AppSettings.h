@@ -259,6 +259,40 @@ enum class SolveModes
 
 typedef EnumSettingT<SolveModes> SolveModesSetting;
 
+enum class BakeResultLayouts
+{
+    PerBasis = 0,
+    TexelInterleaved = 1,
+    Tiled = 2,
+
+    NumValues
+};
+
+typedef EnumSettingT<BakeResultLayouts> BakeResultLayoutsSetting;
+
+enum class BakeResultFormats
+{
+    Float4 = 0,
+    Float3 = 1,
+    Half4 = 2,
+
+    NumValues
+};
+
+typedef EnumSettingT<BakeResultFormats> BakeResultFormatsSetting;
+
+enum class ProbeBases
+{
+    SH9 = 0,
+    SG6 = 1,
+    SG9 = 2,
+    SG12 = 3,
+
+    NumValues
+};
+
+typedef EnumSettingT<ProbeBases> ProbeBasesSetting;
+
 enum class Scenes
 {
     Box = 0,
@@ -275,6 +309,7 @@ namespace AppSettings
     static const float BaseSunSize = 0.2700f;
     static const int64 MaxSGCount = 12;
     static const int64 MaxBasisCount = 12;
+    static const int64 MaxLightMapPages = 8;
 
     extern BoolSetting EnableSun;
     extern BoolSetting SunAreaLightApproximation;
@@ -304,6 +339,8 @@ namespace AppSettings
     extern FloatSetting AreaLightShadowBias;
     extern BoolSetting BakeDirectAreaLight;
     extern BoolSetting EnableAreaLightShadows;
+    extern BoolSetting AnalyticAreaLight;
+    extern IntSetting AreaLightVisibilityRays;
     extern ExposureModesSetting ExposureMode;
     extern FloatSetting ManualExposure;
     extern FStopsSetting ApertureSize;
@@ -340,14 +377,47 @@ namespace AppSettings
     extern SH4DiffuseModesSetting SH4DiffuseMode;
     extern SHSpecularModesSetting SHSpecularMode;
     extern IntSetting LightMapResolution;
+    extern BoolSetting PackLightMapCharts;
+    extern FloatSetting LightMapTexelDensity;
+    extern IntSetting LightMapChartPadding;
+    extern IntSetting LightMapPageCount;
     extern IntSetting NumBakeSamples;
     extern SampleModesSetting BakeSampleMode;
     extern IntSetting MaxBakePathLength;
     extern IntSetting BakeRussianRouletteDepth;
     extern FloatSetting BakeRussianRouletteProbability;
+    extern BoolSetting IterativeBounces;
+    extern IntSetting NumIterativeBounces;
+    extern BoolSetting RelightableBake;
+    extern BoolSetting MultiBasisBake;
     extern BakeModesSetting BakeMode;
     extern SolveModesSetting SolveMode;
     extern BoolSetting WorldSpaceBake;
+    extern BakeResultLayoutsSetting BakeResultLayout;
+    extern BakeResultFormatsSetting BakeResultFormat;
+    extern BoolSetting SpatialBakeOrder;
+    extern BoolSetting OutOfCoreBake;
+    extern IntSetting BakeTileSize;
+    extern BoolSetting BakeProbes;
+    extern ProbeBasesSetting ProbeBasis;
+    extern IntSetting ProbeGridResolution;
+    extern BoolSetting ShowProbes;
+    extern BoolSetting EnableRadianceCache;
+    extern IntSetting RadianceCacheBounce;
+    extern FloatSetting RadianceCacheCellSize;
+    extern IntSetting RadianceCacheMinSamples;
+    extern BoolSetting ShowRadianceCacheOccupancy;
+    extern BoolSetting EnablePathGuiding;
+    extern IntSetting PathGuidingTrainingPasses;
+    extern FloatSetting PathGuidingFraction;
+    extern IntSetting PathGuidingGridResolution;
+    extern BoolSetting EnableSampleReuse;
+    extern IntSetting SampleReuseCandidates;
+    extern IntSetting SampleReuseNeighbors;
+    extern IntSetting SampleReuseRadius;
+    extern IntSetting SampleReuseMaxHistory;
+    extern BoolSetting EnableEmissiveLights;
+    extern FloatSetting EmissiveIntensity;
     extern ScenesSetting CurrentScene;
     extern BoolSetting EnableDiffuse;
     extern BoolSetting EnableSpecular;
@@ -380,6 +450,12 @@ namespace AppSettings
     extern Button LoadLightSettings;
     extern Button SaveEXRScreenshot;
     extern BoolSetting ShowSunIntensity;
+    extern BoolSetting EnableTracing;
+    extern Button ExportTrace;
+    extern Button ExportBakeStats;
+    extern Button ExportBakeResults;
+    extern BoolSetting RecordRadianceSamples;
+    extern Button ReplayRadianceSamples;
 
     struct AppSettingsCBuffer
     {
@@ -552,6 +628,24 @@ namespace AppSettings
         return std::sqrt(Saturate((ApertureFNumber_() - 1.8f) / (5.0f - 1.8f)));
     }
 
+    // Sample reuse resamples the shadowed lighting of single points on the area light, which can't be
+    // combined with the analytic lighting, so analytic direct lighting turns it off
+    inline bool SampleReuseEnabled()
+    {
+        return AppSettings::EnableSampleReuse && AppSettings::AnalyticAreaLight == false;
+    }
+
+    // True whenever the packer rewrites the light map UV's, which happens when packing is toggled or
+    // when one of the settings it depends on changes while it's enabled
+    inline bool HasLightMapPackingChanged()
+    {
+        return AppSettings::PackLightMapCharts.Changed() ||
+               (AppSettings::PackLightMapCharts && (AppSettings::LightMapTexelDensity.Changed() ||
+                                                    AppSettings::LightMapChartPadding.Changed() ||
+                                                    AppSettings::LightMapPageCount.Changed() ||
+                                                    AppSettings::LightMapResolution.Changed()));
+    }
+
     inline bool HasSunDirChanged()
     {
         return AppSettings::SunDirType.Changed() ||
@@ -634,5 +728,29 @@ namespace AppSettings
             return true;
     }
 
+    // Returns true if the bake mode stores data in the w channel of its results (the directional
+    // mode stores its directionality factor there, and the SG running average stores its weights)
+    inline bool BakeResultsUseAlpha(BakeModes bakeMode, SolveModes solveMode)
+    {
+        if((bakeMode == BakeModes::Directional) || (SGCount(bakeMode) > 0 && (solveMode == SolveModes::RunningAverage || solveMode == SolveModes::RunningAverageNN)))
+            return true;
+        else
+            return false;
+    }
+
+    inline uint64 ProbeBasisCount(ProbeBases probeBasis)
+    {
+        Assert_(uint64(probeBasis) < uint64(ProbeBases::NumValues));
+        static const uint64 BasisCounts[] = { 9, 6, 9, 12 };
+        StaticAssert_(ArraySize_(BasisCounts) == uint64(ProbeBases::NumValues));
+        Assert_(BasisCounts[uint64(probeBasis)] <= MaxBasisCount);
+        return BasisCounts[uint64(probeBasis)];
+    }
+
+    inline uint64 ProbeSGCount(ProbeBases probeBasis)
+    {
+        return probeBasis == ProbeBases::SH9 ? 0 : ProbeBasisCount(probeBasis);
+    }
+
     void UpdateUI();
 }
\ No newline at end of file
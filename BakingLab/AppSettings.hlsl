@@ -197,6 +197,19 @@ static const int SolveModes_NNLS = 2;
 static const int SolveModes_RunningAverage = 3;
 static const int SolveModes_RunningAverageNN = 4;
 
+static const int BakeResultLayouts_PerBasis = 0;
+static const int BakeResultLayouts_TexelInterleaved = 1;
+static const int BakeResultLayouts_Tiled = 2;
+
+static const int BakeResultFormats_Float4 = 0;
+static const int BakeResultFormats_Float3 = 1;
+static const int BakeResultFormats_Half4 = 2;
+
+static const int ProbeBases_SH9 = 0;
+static const int ProbeBases_SG6 = 1;
+static const int ProbeBases_SG9 = 2;
+static const int ProbeBases_SG12 = 3;
+
 static const int Scenes_Box = 0;
 static const int Scenes_WhiteRoom = 1;
 static const int Scenes_Sponza = 2;
@@ -204,3 +217,4 @@ static const int Scenes_Sponza = 2;
 static const float BaseSunSize = 0.2700f;
 static const int MaxSGCount = 12;
 static const int MaxBasisCount = 12;
+static const int MaxLightMapPages = 8;
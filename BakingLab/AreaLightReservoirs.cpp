@@ -0,0 +1,61 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "AreaLightReservoirs.h"
+
+void AreaLightReservoirs::Init(uint64 numTexels)
+{
+    Assert_(numTexels > 0);
+    slots.Init(numTexels);
+}
+
+void AreaLightReservoirs::Shutdown()
+{
+    slots.Shutdown();
+}
+
+bool AreaLightReservoirs::Load(uint64 texelIdx, uint64 generation, AreaLightReservoir& reservoir) const
+{
+    const Slot& slot = slots[texelIdx];
+    const long sequence = slot.Sequence;
+    if(sequence & 1)
+        return false;
+
+    _ReadBarrier();
+    const int64 slotGeneration = slot.Generation;
+    const AreaLightReservoir slotReservoir = slot.Reservoir;
+    _ReadBarrier();
+
+    if(slot.Sequence != sequence || slotGeneration != int64(generation))
+        return false;
+
+    reservoir = slotReservoir;
+    return true;
+}
+
+// With fewer bake groups than threads, the batches of consecutive passes can bake the same texel
+// at the same time. Only the writer that moves the sequence from even to odd gets to store, and
+// the other store is dropped, which just loses one reservoir for re-use.
+void AreaLightReservoirs::Store(uint64 texelIdx, uint64 generation, const AreaLightReservoir& reservoir)
+{
+    Slot& slot = slots[texelIdx];
+    const long sequence = slot.Sequence;
+    if((sequence & 1) || InterlockedCompareExchange(&slot.Sequence, sequence + 1, sequence) != sequence)
+        return;
+    _WriteBarrier();
+
+    slot.Generation = int64(generation);
+    slot.Reservoir = reservoir;
+
+    _WriteBarrier();
+    InterlockedExchange(&slot.Sequence, sequence + 2);
+}
@@ -0,0 +1,82 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+#include <SF11_Math.h>
+#include <Containers.h>
+
+using namespace SampleFramework11;
+
+// A point on the area light that was picked from a stream of candidates with weighted reservoir
+// sampling. The weights are the target function (the luminance of the unshadowed lighting at the
+// texel that owns the reservoir) divided by the PDF of the candidates.
+struct AreaLightReservoir
+{
+    Float3 LightPoint;
+    float TargetPDF = 0.0f;             // Target function at LightPoint
+    float WeightSum = 0.0f;
+    float NumCandidates = 0.0f;
+
+    // Streams in a candidate that stands for "numCandidates" candidates, and returns true if it's picked
+    bool Update(const Float3& lightPoint, float targetPDF, float weight, float numCandidates, float u)
+    {
+        WeightSum += weight;
+        NumCandidates += numCandidates;
+        if(weight <= 0.0f || u * WeightSum >= weight)
+            return false;
+
+        LightPoint = lightPoint;
+        TargetPDF = targetPDF;
+        return true;
+    }
+
+    // The unbiased contribution weight of the picked point, which stands in for its inverse PDF
+    float ContributionWeight() const
+    {
+        if(TargetPDF <= 0.0f || NumCandidates <= 0.0f)
+            return 0.0f;
+        return WeightSum / (NumCandidates * TargetPDF);
+    }
+};
+
+// Keeps the reservoir of every light map texel, so that later samples of the texel and of its
+// neighbors can re-use it. Every bake uses a new generation, which makes the reservoirs of previous
+// bakes read as empty without clearing them. The bake threads read the reservoirs of texels that
+// other threads are writing, so each one is guarded by a sequence count that's odd while it's
+// being written, and reads that overlap a write fail instead of returning a torn reservoir. A store
+// that overlaps another store of the same texel is skipped.
+class AreaLightReservoirs
+{
+
+public:
+
+    void Init(uint64 numTexels);
+    void Shutdown();
+
+    bool Initialized() const { return slots.Size() > 0; }
+    uint64 NumTexels() const { return slots.Size(); }
+
+    // Returns false if the texel has no reservoir for the generation
+    bool Load(uint64 texelIdx, uint64 generation, AreaLightReservoir& reservoir) const;
+    void Store(uint64 texelIdx, uint64 generation, const AreaLightReservoir& reservoir);
+
+private:
+
+    struct Slot
+    {
+        volatile long Sequence = 0;
+        int64 Generation = -1;
+        AreaLightReservoir Reservoir;
+    };
+
+    FixedArray<Slot> slots;
+};
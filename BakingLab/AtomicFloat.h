@@ -0,0 +1,35 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+
+// Floats that are shared between threads are stored as the bits of a long, so that they can be
+// updated with the Interlocked functions
+
+inline float AsFloat(long bits)
+{
+    return *reinterpret_cast<const float*>(&bits);
+}
+
+inline void AtomicAddFloat(volatile long* dst, float value)
+{
+    long oldBits = *dst;
+    while(true)
+    {
+        const float newValue = AsFloat(oldBits) + value;
+        const long newBits = *reinterpret_cast<const long*>(&newValue);
+        const long prevBits = InterlockedCompareExchange(dst, newBits, oldBits);
+        if(prevBits == oldBits)
+            return;
+        oldBits = prevBits;
+    }
+}
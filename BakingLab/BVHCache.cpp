@@ -0,0 +1,284 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "BVHCache.h"
+
+#include <FileIO.h>
+#include <Graphics/Model.h>
+
+#include "PathTracer.h"
+
+// Bump this whenever the layout of the cache or the contents of BVHData change
+static const uint32 BVHCacheMagic = 0x48435642;
+static const uint32 BVHCacheVersion = 3;
+static const uint64 BVHCacheAlignment = 16;
+static const uint64 NumMaterialMaps = 4;
+static const wchar* BVHCacheDir = L"BVHCache\\";
+
+// GenerateHash takes an int for the length, so large blobs are hashed in pieces
+static const uint64 MaxHashChunkSize = 1024 * 1024 * 1024;
+
+struct BVHCacheHeader
+{
+    uint32 Magic;
+    uint32 Version;
+    Hash SceneHash;
+    uint64 NumTriangles;
+    uint64 NumVertices;
+    uint64 NumMaterials;
+};
+
+struct BVHCacheTextureHeader
+{
+    uint32 Width;
+    uint32 Height;
+    uint32 NumSlices;
+    uint32 Padding;
+};
+
+static std::wstring BVHCachePath(const Hash& sceneHash)
+{
+    return std::wstring(BVHCacheDir) + sceneHash.ToString() + L".bvhcache";
+}
+
+static void HashData(const void* data, uint64 size, std::vector<Hash>& hashes)
+{
+    const uint8* bytes = reinterpret_cast<const uint8*>(data);
+    for(uint64 offset = 0; offset < size; offset += MaxHashChunkSize)
+        hashes.push_back(GenerateHash(bytes + offset, int(std::min(size - offset, MaxHashChunkSize))));
+}
+
+Hash HashSceneContents(const Model& model)
+{
+    std::vector<Hash> hashes;
+
+    const uint32 version = BVHCacheVersion;
+    HashData(&version, sizeof(version), hashes);
+
+    for(const Mesh& mesh : model.Meshes())
+    {
+        const uint32 meshInfo[] = { mesh.VertexStride(), mesh.NumVertices(), mesh.NumIndices(), mesh.IndexSize() };
+        HashData(meshInfo, sizeof(meshInfo), hashes);
+        HashData(mesh.MeshParts().data(), mesh.MeshParts().size() * sizeof(MeshPart), hashes);
+        HashData(mesh.Vertices(), uint64(mesh.NumVertices()) * mesh.VertexStride(), hashes);
+        HashData(mesh.Indices(), uint64(mesh.NumIndices()) * mesh.IndexSize(), hashes);
+    }
+
+    // The hash is what finds the cache in the first place, so it can't depend on the decoded textures
+    // without decoding every texture file again, which is most of what the cache saves. The source
+    // files are identified by their name and timestamp instead.
+    for(const MeshMaterial& material : model.Materials())
+    {
+        const std::wstring* mapNames[] = { &material.DiffuseMapName, &material.NormalMapName,
+                                           &material.RoughnessMapName, &material.MetallicMapName };
+        for(uint64 mapIdx = 0; mapIdx < ArraySize_(mapNames); ++mapIdx)
+        {
+            const std::wstring& mapName = *mapNames[mapIdx];
+            const std::wstring mapPath = model.FileDirectory() + mapName;
+            const uint64 timestamp = (mapName.length() > 1 && FileExists(mapPath.c_str())) ? GetFileTimestamp(mapPath.c_str()) : 0;
+            HashData(mapName.c_str(), mapName.length() * sizeof(wchar), hashes);
+            HashData(&timestamp, sizeof(timestamp), hashes);
+        }
+
+        HashData(&material.Emissive, sizeof(Float3), hashes);
+    }
+
+    return GenerateHash(hashes.data(), int(hashes.size() * sizeof(Hash)));
+}
+
+// Reads aligned blobs out of the mapped cache file, failing if the file is too short. The blobs are
+// copied out, since BVHData owns its arrays and outlives the mapping.
+class BVHCacheReader
+{
+
+public:
+
+    BVHCacheReader(const uint8* fileData, uint64 fileSize) : data(fileData), size(fileSize)
+    {
+    }
+
+    bool Read(void* dst, uint64 numBytes)
+    {
+        offset = (offset + BVHCacheAlignment - 1) & ~(BVHCacheAlignment - 1);
+        if(offset + numBytes > size)
+            return false;
+
+        if(numBytes > 0)
+            memcpy(dst, data + offset, numBytes);
+        offset += numBytes;
+        return true;
+    }
+
+    template<typename T> bool Read(T& item)
+    {
+        return Read(&item, sizeof(T));
+    }
+
+    template<typename T> bool ReadVector(std::vector<T>& items, uint64 count)
+    {
+        items.resize(count);
+        return Read(items.data(), count * sizeof(T));
+    }
+
+    bool ReadTexture(TextureData<UByte4N>& texture)
+    {
+        BVHCacheTextureHeader textureHeader;
+        if(Read(textureHeader) == false)
+            return false;
+
+        texture.Width = textureHeader.Width;
+        texture.Height = textureHeader.Height;
+        texture.NumSlices = textureHeader.NumSlices;
+        return ReadVector(texture.Texels, uint64(texture.Width) * texture.Height * texture.NumSlices);
+    }
+
+private:
+
+    const uint8* data = nullptr;
+    uint64 size = 0;
+    uint64 offset = 0;
+};
+
+// Writes aligned blobs to the cache file, padding with zeros
+class BVHCacheWriter
+{
+
+public:
+
+    explicit BVHCacheWriter(const wchar* filePath) : file(filePath, FileOpenMode::Write)
+    {
+    }
+
+    void Write(const void* src, uint64 numBytes)
+    {
+        static const uint8 padding[BVHCacheAlignment] = { };
+        const uint64 alignedOffset = (offset + BVHCacheAlignment - 1) & ~(BVHCacheAlignment - 1);
+        if(alignedOffset > offset)
+            file.Write(alignedOffset - offset, padding);
+
+        if(numBytes > 0)
+            file.Write(numBytes, src);
+        offset = alignedOffset + numBytes;
+    }
+
+    template<typename T> void Write(const T& item)
+    {
+        Write(&item, sizeof(T));
+    }
+
+    template<typename T> void WriteVector(const std::vector<T>& items)
+    {
+        Write(items.data(), items.size() * sizeof(T));
+    }
+
+    void WriteTexture(const TextureData<UByte4N>& texture)
+    {
+        BVHCacheTextureHeader textureHeader = { };
+        textureHeader.Width = texture.Width;
+        textureHeader.Height = texture.Height;
+        textureHeader.NumSlices = texture.NumSlices;
+        Write(textureHeader);
+        WriteVector(texture.Texels);
+    }
+
+private:
+
+    File file;
+    uint64 offset = 0;
+};
+
+// Returns false without touching the BVH data if there's no usable cache for the scene
+bool LoadBVHCache(const Hash& sceneHash, BVHData& bvhData)
+{
+    const std::wstring cachePath = BVHCachePath(sceneHash);
+    if(FileExists(cachePath.c_str()) == false)
+        return false;
+
+    MemoryMappedFile cacheFile(cachePath.c_str());
+    BVHCacheReader reader(cacheFile.Data(), cacheFile.Size());
+
+    BVHCacheHeader header;
+    if(reader.Read(header) == false)
+        return false;
+
+    if(header.Magic != BVHCacheMagic || header.Version != BVHCacheVersion || !(header.SceneHash == sceneHash))
+        return false;
+
+    BVHData cachedData;
+    bool valid = reader.ReadVector(cachedData.Triangles, header.NumTriangles);
+    valid = valid && reader.ReadVector(cachedData.Vertices, header.NumVertices);
+    valid = valid && reader.ReadVector(cachedData.MaterialIndices, header.NumTriangles);
+    valid = valid && reader.ReadVector(cachedData.MaterialEmissive, header.NumMaterials);
+
+    std::vector<TextureData<UByte4N>>* materialMaps[] = { &cachedData.MaterialDiffuseMaps, &cachedData.MaterialNormalMaps,
+                                                          &cachedData.MaterialRoughnessMaps, &cachedData.MaterialMetallicMaps };
+    StaticAssert_(ArraySize_(materialMaps) == NumMaterialMaps);
+    for(uint64 mapIdx = 0; mapIdx < NumMaterialMaps; ++mapIdx)
+        materialMaps[mapIdx]->resize(header.NumMaterials);
+
+    for(uint64 materialIdx = 0; materialIdx < header.NumMaterials; ++materialIdx)
+        for(uint64 mapIdx = 0; mapIdx < NumMaterialMaps; ++mapIdx)
+            valid = valid && reader.ReadTexture((*materialMaps[mapIdx])[materialIdx]);
+
+    if(valid == false)
+        return false;
+
+    bvhData.Triangles.swap(cachedData.Triangles);
+    bvhData.Vertices.swap(cachedData.Vertices);
+    bvhData.MaterialIndices.swap(cachedData.MaterialIndices);
+    bvhData.MaterialEmissive.swap(cachedData.MaterialEmissive);
+    bvhData.MaterialDiffuseMaps.swap(cachedData.MaterialDiffuseMaps);
+    bvhData.MaterialNormalMaps.swap(cachedData.MaterialNormalMaps);
+    bvhData.MaterialRoughnessMaps.swap(cachedData.MaterialRoughnessMaps);
+    bvhData.MaterialMetallicMaps.swap(cachedData.MaterialMetallicMaps);
+
+    return true;
+}
+
+void WriteBVHCache(const Hash& sceneHash, const BVHData& bvhData)
+{
+    if(DirectoryExists(BVHCacheDir) == false)
+        Win32Call(CreateDirectory(BVHCacheDir, nullptr));
+
+    const std::wstring cachePath = BVHCachePath(sceneHash);
+    const std::wstring tempPath = cachePath + L".tmp";
+
+    // Write to a temporary file and then swap it in, so that an interrupted write can never
+    // leave behind a cache that looks valid
+    {
+        BVHCacheWriter writer(tempPath.c_str());
+
+        BVHCacheHeader header = { };
+        header.Magic = BVHCacheMagic;
+        header.Version = BVHCacheVersion;
+        header.SceneHash = sceneHash;
+        header.NumTriangles = bvhData.Triangles.size();
+        header.NumVertices = bvhData.Vertices.size();
+        header.NumMaterials = bvhData.MaterialDiffuseMaps.size();
+        writer.Write(header);
+
+        writer.WriteVector(bvhData.Triangles);
+        writer.WriteVector(bvhData.Vertices);
+        writer.WriteVector(bvhData.MaterialIndices);
+        writer.WriteVector(bvhData.MaterialEmissive);
+
+        for(uint64 materialIdx = 0; materialIdx < header.NumMaterials; ++materialIdx)
+        {
+            writer.WriteTexture(bvhData.MaterialDiffuseMaps[materialIdx]);
+            writer.WriteTexture(bvhData.MaterialNormalMaps[materialIdx]);
+            writer.WriteTexture(bvhData.MaterialRoughnessMaps[materialIdx]);
+            writer.WriteTexture(bvhData.MaterialMetallicMaps[materialIdx]);
+        }
+    }
+
+    Win32Call(MoveFileEx(tempPath.c_str(), cachePath.c_str(), MOVEFILE_REPLACE_EXISTING));
+}
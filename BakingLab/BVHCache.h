@@ -0,0 +1,31 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+#include <MurmurHash.h>
+#include <Graphics/Model.h>
+
+struct BVHData;
+
+using namespace SampleFramework11;
+
+// Hashes everything that goes into building the BVH for a model: the vertex and index data of
+// every mesh, and the names and timestamps of the material textures
+Hash HashSceneContents(const Model& model);
+
+// Persistent cache of the flattened triangles, vertices, and material indices of a scene along
+// with the decoded CPU copies of its material textures, stored in one file per scene hash. The
+// file is mapped for loading, but its contents are copied into the std::vectors of BVHData rather
+// than used in place. Embree 2.x has no way to serialize a built scene, so only the inputs to
+// rtcCommit are cached.
+bool LoadBVHCache(const Hash& sceneHash, BVHData& bvhData);
+void WriteBVHCache(const Hash& sceneHash, const BVHData& bvhData);
@@ -0,0 +1,245 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "BakeBenchmark.h"
+
+#include <Psapi.h>
+#include <FileIO.h>
+
+#pragma comment(lib, "psapi.lib")
+
+static const uint32 BenchmarkSeed = 1337;
+static const int32 BenchmarkSqrtSamples = 8;
+static const int32 ReferenceSqrtSamples = 32;
+static const int32 BenchmarkLightMapResolution = 256;
+static const float ErrorInterval = 1.0f;           // Seconds between measurements of the light map error
+static const uint64 NumRestartFrames = 2;          // Frames to wait for the settings of a new run to take effect
+
+static const wchar* ReferenceDirectory = L"BenchmarkReferences";
+static const wchar* ResultsPath = L"BenchmarkResults.csv";
+static const wchar* ConvergencePath = L"BenchmarkConvergence.csv";
+
+static const char* SceneNames[] = { "Box", "WhiteRoom", "Sponza" };
+static const char* BakeModeNames[] = { "Diffuse", "Directional", "HL2", "SH4", "SH9", "H4", "H6",
+                                       "SG5", "SG6", "SG9", "SG12" };
+static const char* SolveModeNames[] = { "Projection", "SVD", "NNLS", "RunningAverage", "RunningAverageNN" };
+
+StaticAssert_(ArraySize_(SceneNames) == uint64(Scenes::NumValues));
+StaticAssert_(ArraySize_(BakeModeNames) == uint64(BakeModes::NumValues));
+StaticAssert_(ArraySize_(SolveModeNames) == uint64(SolveModes::NumValues));
+
+// Returns the peak working set of the process, in megabytes. Note that this is the peak over the
+// lifetime of the process, and not just the current run.
+static float PeakMemoryUsageMB()
+{
+    PROCESS_MEMORY_COUNTERS counters = { };
+    counters.cb = sizeof(counters);
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) == false)
+        return 0.0f;
+
+    return counters.PeakWorkingSetSize / (1024.0f * 1024.0f);
+}
+
+void BakeBenchmark::Initialize(bool generateRefs)
+{
+    enabled = true;
+    generateReferences = generateRefs;
+
+    // The solve mode only affects the SG bake modes, so the other modes only get a single run
+    runs.clear();
+    for(uint64 sceneIdx = 0; sceneIdx < uint64(Scenes::NumValues); ++sceneIdx)
+    {
+        for(uint64 modeIdx = 0; modeIdx < uint64(BakeModes::NumValues); ++modeIdx)
+        {
+            const BakeModes bakeMode = BakeModes(modeIdx);
+            const uint64 numSolveModes = AppSettings::SGCount(bakeMode) > 0 ? uint64(SolveModes::NumValues) : 1;
+            for(uint64 solveIdx = 0; solveIdx < numSolveModes; ++solveIdx)
+            {
+                Run run;
+                run.Scene = Scenes(sceneIdx);
+                run.BakeMode = bakeMode;
+                run.SolveMode = SolveModes(solveIdx);
+                runs.push_back(run);
+            }
+        }
+    }
+
+    if(DirectoryExists(ReferenceDirectory) == false)
+        Win32Call(CreateDirectory(ReferenceDirectory, nullptr));
+
+    resultsCSV = "Scene,BakeMode,SolveMode,Samples,Threads,BakeTime,RaysPerSecond,SamplesPerSecondPerThread,PeakMemoryMB,FinalRMSE\n";
+    convergenceCSV = "Scene,BakeMode,SolveMode,BakeTime,RMSE\n";
+
+    PrintString("Running %llu benchmark bakes%s", runs.size(), generateReferences ? " to generate references" : "");
+}
+
+bool BakeBenchmark::Update(const MeshBakerStatus& status, MeshBaker& meshBaker)
+{
+    Assert_(enabled);
+
+    if(currRun == uint64(-1))
+    {
+        currRun = 0;
+        StartRun(meshBaker);
+        return false;
+    }
+
+    if(currRun >= runs.size())
+        return true;
+
+    // Wait for the bake to restart with the new settings
+    if(numSkippedFrames < NumRestartFrames)
+    {
+        ++numSkippedFrames;
+        return false;
+    }
+
+    if(status.BakeComplete)
+    {
+        FinishRun(status, meshBaker);
+
+        ++currRun;
+        if(currRun < runs.size())
+        {
+            StartRun(meshBaker);
+            return false;
+        }
+
+        WriteStringAsFile(ResultsPath, resultsCSV);
+        if(generateReferences == false)
+            WriteStringAsFile(ConvergencePath, convergenceCSV);
+
+        PrintString("Finished running benchmark bakes");
+        return true;
+    }
+
+    if(reference.size() > 0 && status.BakeTime >= nextErrorTime)
+    {
+        const Run& run = runs[currRun];
+        const float error = ComputeError(meshBaker);
+        convergenceCSV += MakeAnsiString("%s,%s,%s,%f,%f\n", SceneNames[uint64(run.Scene)], BakeModeNames[uint64(run.BakeMode)],
+                                         SolveModeNames[uint64(run.SolveMode)], status.BakeTime, error);
+        nextErrorTime = status.BakeTime + ErrorInterval;
+    }
+
+    return false;
+}
+
+// Applies the settings for the current run, which restarts the bake on the next frame
+void BakeBenchmark::StartRun(MeshBaker& meshBaker)
+{
+    const Run& run = runs[currRun];
+
+    AppSettings::CurrentScene.SetValue(run.Scene);
+    AppSettings::BakeMode.SetValue(run.BakeMode);
+    AppSettings::SolveMode.SetValue(run.SolveMode);
+    AppSettings::NumBakeSamples.SetValue(generateReferences ? ReferenceSqrtSamples : BenchmarkSqrtSamples);
+    AppSettings::BakeSampleMode.SetValue(SampleModes::CMJ);
+    AppSettings::LightMapResolution.SetValue(BenchmarkLightMapResolution);
+    AppSettings::PackLightMapCharts.SetValue(false);
+    AppSettings::OutOfCoreBake.SetValue(false);
+    AppSettings::BakeProbes.SetValue(false);
+    AppSettings::ShowGroundTruth.SetValue(false);
+
+    meshBaker.SetBakeSeed(BenchmarkSeed);
+
+    numSkippedFrames = 0;
+    nextErrorTime = 0.0f;
+
+    reference.clear();
+    if(generateReferences == false)
+        LoadReference();
+
+    PrintString("Benchmark run %llu/%llu: %s", currRun + 1, runs.size(), RunName().c_str());
+}
+
+void BakeBenchmark::FinishRun(const MeshBakerStatus& status, MeshBaker& meshBaker)
+{
+    const Run& run = runs[currRun];
+
+    const float bakeTime = Max(status.BakeTime, 0.0001f);
+    const double raysPerSecond = status.NumBakeRays / double(bakeTime);
+    const double samplesPerSecond = status.NumBakePaths / double(bakeTime) / Max<uint64>(status.NumBakeThreads, 1);
+    const float finalError = reference.size() > 0 ? ComputeError(meshBaker) : -1.0f;
+    const int32 numSamples = AppSettings::NumBakeSamples * AppSettings::NumBakeSamples;
+
+    resultsCSV += MakeAnsiString("%s,%s,%s,%d,%llu,%f,%f,%f,%f,%f\n", SceneNames[uint64(run.Scene)],
+                                 BakeModeNames[uint64(run.BakeMode)], SolveModeNames[uint64(run.SolveMode)],
+                                 numSamples, status.NumBakeThreads, bakeTime, raysPerSecond, samplesPerSecond,
+                                 PeakMemoryUsageMB(), finalError);
+
+    if(reference.size() > 0)
+        convergenceCSV += MakeAnsiString("%s,%s,%s,%f,%f\n", SceneNames[uint64(run.Scene)], BakeModeNames[uint64(run.BakeMode)],
+                                         SolveModeNames[uint64(run.SolveMode)], bakeTime, finalError);
+
+    PrintString("    %.2f seconds, %.2f Mrays/s, %.0f samples/s per thread", bakeTime, raysPerSecond / 1000000.0,
+                samplesPerSecond);
+
+    if(generateReferences)
+    {
+        meshBaker.GetBakeResults(results);
+
+        const uint64 numElements = results.size();
+        File file(ReferencePath().c_str(), FileOpenMode::Write);
+        file.Write(numElements);
+        file.Write(numElements * sizeof(Float3), results.data());
+    }
+}
+
+void BakeBenchmark::LoadReference()
+{
+    const std::wstring referencePath = ReferencePath();
+    if(FileExists(referencePath.c_str()) == false)
+    {
+        PrintString("No reference bake found for %s, the error won't be measured", RunName().c_str());
+        return;
+    }
+
+    File file(referencePath.c_str(), FileOpenMode::Read);
+    uint64 numElements = 0;
+    file.Read(numElements);
+    if(file.Size() != sizeof(uint64) + numElements * sizeof(Float3))
+        throw Exception(L"Invalid benchmark reference file: " + referencePath);
+
+    reference.resize(numElements);
+    file.Read(numElements * sizeof(Float3), reference.data());
+}
+
+// Computes the root-mean-square error of the current light map against the reference
+float BakeBenchmark::ComputeError(const MeshBaker& meshBaker)
+{
+    meshBaker.GetBakeResults(results);
+    if(results.size() != reference.size())
+        return -1.0f;
+
+    const uint64 numElements = results.size();
+    double sum = 0.0;
+    for(uint64 i = 0; i < numElements; ++i)
+    {
+        const Float3 diff = results[i] - reference[i];
+        sum += diff.x * diff.x + diff.y * diff.y + diff.z * diff.z;
+    }
+
+    return numElements > 0 ? float(std::sqrt(sum / (numElements * 3))) : 0.0f;
+}
+
+std::wstring BakeBenchmark::ReferencePath() const
+{
+    return MakeString(L"%ls\\%ls.ref", ReferenceDirectory, AnsiToWString(RunName().c_str()).c_str());
+}
+
+std::string BakeBenchmark::RunName() const
+{
+    const Run& run = runs[currRun];
+    return MakeAnsiString("%s_%s_%s", SceneNames[uint64(run.Scene)], BakeModeNames[uint64(run.BakeMode)],
+                          SolveModeNames[uint64(run.SolveMode)]);
+}
@@ -0,0 +1,62 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+
+#include "AppSettings.h"
+#include "MeshBaker.h"
+
+using namespace SampleFramework11;
+
+// Runs a fixed-seed bake of every scene with every bake mode, and records the throughput of the
+// bake threads along with the error of the light map over time. The error is measured against
+// reference bakes that were previously generated with a high sample count. The results are
+// written to BenchmarkResults.csv and BenchmarkConvergence.csv once all runs have finished.
+class BakeBenchmark
+{
+
+public:
+
+    void Initialize(bool generateReferences);
+
+    // Call once per frame after updating the mesh baker. Returns true once every run has finished.
+    bool Update(const MeshBakerStatus& status, MeshBaker& meshBaker);
+
+    bool Enabled() const { return enabled; }
+
+private:
+
+    struct Run
+    {
+        Scenes Scene = Scenes::Box;
+        BakeModes BakeMode = BakeModes::Diffuse;
+        SolveModes SolveMode = SolveModes::Projection;
+    };
+
+    void StartRun(MeshBaker& meshBaker);
+    void FinishRun(const MeshBakerStatus& status, MeshBaker& meshBaker);
+    void LoadReference();
+    float ComputeError(const MeshBaker& meshBaker);
+    std::wstring ReferencePath() const;
+    std::string RunName() const;
+
+    bool enabled = false;
+    bool generateReferences = false;
+    std::vector<Run> runs;
+    uint64 currRun = uint64(-1);
+    uint64 numSkippedFrames = 0;
+    float nextErrorTime = 0.0f;
+    std::vector<Float3> reference;
+    std::vector<Float3> results;
+    std::string resultsCSV;
+    std::string convergenceCSV;
+};
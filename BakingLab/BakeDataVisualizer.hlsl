@@ -24,6 +24,8 @@ cbuffer Constants : register(b0)
     float4x4 ViewProjection;
     float4 SGDirections[MaxSGCount];
     float SGSharpness;
+    uint LightMapBasisCount;
+    uint LightMapPageCount;
 }
 
 //=================================================================================================
@@ -52,6 +54,18 @@ struct PSInput
     float2 LightMapUV       : LIGHTMAPUV;
 };
 
+//=================================================================================================
+// Light map sampling
+//=================================================================================================
+
+// Light map pages are stored in the integer part of U, and each page has one array slice per basis.
+// Authored UV's can be slightly outside of [0, 1], so both the page and the U within it are clamped.
+float3 LightMapCoord(in float2 lightMapUV, in uint basisIdx)
+{
+    float page = clamp(floor(lightMapUV.x), 0.0f, LightMapPageCount - 1.0f);
+    return float3(saturate(lightMapUV.x - page), lightMapUV.y, page * LightMapBasisCount + basisIdx);
+}
+
 //=================================================================================================
 // Vertex shader
 //=================================================================================================
@@ -88,7 +102,7 @@ float3 EvalSGs(in float2 lightMapUV, in uint numSGs, in float3 dir)
     for(uint i = 0; i < numSGs; ++i)
     {
         SG sg;
-        sg.Amplitude = BakedLightingMap.SampleLevel(LinearSampler, float3(lightMapUV, i), 0.0f).xyz;
+        sg.Amplitude = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(lightMapUV, i), 0.0f).xyz;
         sg.Axis = SGDirections[i].xyz;
         sg.Sharpness = SGSharpness;
 
@@ -112,7 +126,7 @@ float4 PS(in PSInput input) : SV_Target0
 
     if(BakeMode == BakeModes_Diffuse)
     {
-        output = BakedLightingMap.SampleLevel(LinearSampler, float3(uv, 0.0f), 0.0f).xyz;
+        output = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(uv, 0), 0.0f).xyz;
     }
     else if(BakeMode == BakeModes_HL2)
     {
@@ -126,14 +140,14 @@ float4 PS(in PSInput input) : SV_Target0
         [unroll]
         for(uint i = 0; i < 3; ++i)
         {
-            float3 lightMap = BakedLightingMap.SampleLevel(LinearSampler, float3(uv, i), 0.0f).xyz;;
+            float3 lightMap = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(uv, i), 0.0f).xyz;;
             output += saturate(dot(normalTS, BasisDirs[i])) * lightMap * InvPi;
         }
     }
 	else if (BakeMode == BakeModes_Directional)
 	{
-        float3 lightMapColor = BakedLightingMap.SampleLevel(LinearSampler, float3(uv, 0), 0.0f).xyz * Pi;
-        float4 lightmapDirection = BakedLightingMap.SampleLevel(LinearSampler, float3(uv, 1), 0.0f).xyzw;
+        float3 lightMapColor = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(uv, 0), 0.0f).xyz * Pi;
+        float4 lightmapDirection = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(uv, 1), 0.0f).xyzw;
 
         float rebalancingCoefficient = max(lightmapDirection.w, 0.0001);
 
@@ -150,7 +164,7 @@ float4 PS(in PSInput input) : SV_Target0
 
         [unroll]
         for(uint i = 0; i < 4; ++i)
-            shRadiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, float3(uv, i), 0.0f).xyz;
+            shRadiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(uv, i), 0.0f).xyz;
 
         output = EvalSH4(normalSHSG, shRadiance);
     }
@@ -160,7 +174,7 @@ float4 PS(in PSInput input) : SV_Target0
 
         [unroll]
         for(uint i = 0; i < 9; ++i)
-            shRadiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, float3(uv, i), 0.0f).xyz;
+            shRadiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(uv, i), 0.0f).xyz;
 
         output = EvalSH9(normalSHSG, shRadiance);
     }
@@ -170,7 +184,7 @@ float4 PS(in PSInput input) : SV_Target0
 
         [unroll]
         for(uint i = 0; i < 4; ++i)
-            hbIrradiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, float3(uv, i), 0.0f).xyz;
+            hbIrradiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(uv, i), 0.0f).xyz;
 
         output = EvalH4(normalTS, hbIrradiance) * InvPi;
     }
@@ -180,7 +194,7 @@ float4 PS(in PSInput input) : SV_Target0
 
         [unroll]
         for(uint i = 0; i < 6; ++i)
-            hbIrradiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, float3(uv, i), 0.0f).xyz;
+            hbIrradiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(uv, i), 0.0f).xyz;
 
         output = EvalH6(normalTS, hbIrradiance) * InvPi;
     }
@@ -0,0 +1,132 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "BakeStats.h"
+
+#include <Utility.h>
+#include <Exceptions.h>
+
+StaticAssert_(sizeof(BakeStatShard) % 64 == 0);
+
+static const char* CounterNames[] =
+{
+    "Paths",
+    "PrimaryRays",
+    "BounceRays",
+    "SunShadowRays",
+    "AreaLightShadowRays",
+    "EmissiveShadowRays",
+    "SkyHits",
+    "AreaLightHits",
+    "EmissiveHits",
+    "BackFaceTerminations",
+    "MaxLengthTerminations",
+    "RussianRouletteTerminations",
+    "RadianceCacheTerminations",
+    "RadianceCacheUpdates",
+    "GuidedBounces",
+    "GuideTrainingSamples",
+    "Batches",
+    "BatchCycles",
+    "PathTraceCycles",
+    "FinalResultCycles",
+};
+
+StaticAssert_(ArraySize_(CounterNames) == uint64(BakeStatCounters::NumValues));
+
+// == BakeStats ===================================================================================
+
+const char* BakeStats::CounterName(BakeStatCounters counter)
+{
+    Assert_(uint64(counter) < uint64(BakeStatCounters::NumValues));
+    return CounterNames[uint64(counter)];
+}
+
+static double Ratio(uint64 numerator, uint64 denominator)
+{
+    return denominator > 0 ? numerator / double(denominator) : 0.0;
+}
+
+std::string BakeStats::ToJSON() const
+{
+    std::string json = "{\n";
+    json += MakeAnsiString("    \"Enabled\": %s,\n", EnableBakeStats_ ? "true" : "false");
+    for(uint64 i = 0; i < uint64(BakeStatCounters::NumValues); ++i)
+        json += MakeAnsiString("    \"%s\": %llu,\n", CounterNames[i], Values[i]);
+
+    // The path length is the number of scene intersections for each path
+    const BakeStats& stats = *this;
+    const uint64 numPaths = stats[BakeStatCounters::Paths];
+    const uint64 numHitRays = stats[BakeStatCounters::PrimaryRays] + stats[BakeStatCounters::BounceRays];
+    const uint64 numShadowRays = stats[BakeStatCounters::SunShadowRays] + stats[BakeStatCounters::AreaLightShadowRays]
+                                 + stats[BakeStatCounters::EmissiveShadowRays];
+    const uint64 batchCycles = stats[BakeStatCounters::BatchCycles];
+    json += MakeAnsiString("    \"AveragePathLength\": %f,\n", Ratio(numHitRays, numPaths));
+    json += MakeAnsiString("    \"ShadowRaysPerPath\": %f,\n", Ratio(numShadowRays, numPaths));
+    json += MakeAnsiString("    \"RussianRouletteTerminationRate\": %f,\n",
+                           Ratio(stats[BakeStatCounters::RussianRouletteTerminations], numPaths));
+    json += MakeAnsiString("    \"RadianceCacheTerminationRate\": %f,\n",
+                           Ratio(stats[BakeStatCounters::RadianceCacheTerminations], numPaths));
+    json += MakeAnsiString("    \"GuidedBounceRate\": %f,\n",
+                           Ratio(stats[BakeStatCounters::GuidedBounces], stats[BakeStatCounters::BounceRays]));
+    json += MakeAnsiString("    \"CyclesPerPath\": %f,\n", Ratio(batchCycles, numPaths));
+    json += MakeAnsiString("    \"PathTraceCycleFraction\": %f,\n", Ratio(stats[BakeStatCounters::PathTraceCycles], batchCycles));
+    json += MakeAnsiString("    \"FinalResultCycleFraction\": %f\n", Ratio(stats[BakeStatCounters::FinalResultCycles], batchCycles));
+    json += "}\n";
+
+    return json;
+}
+
+// == BakeStatShards ==============================================================================
+
+BakeStatShards::~BakeStatShards()
+{
+    Shutdown();
+}
+
+void BakeStatShards::Init(uint64 count)
+{
+    Shutdown();
+
+    numShards = count;
+    shards = reinterpret_cast<BakeStatShard*>(_aligned_malloc(sizeof(BakeStatShard) * numShards, 64));
+    if(shards == nullptr)
+        throw Exception(L"Failed to allocate the bake stat counters");
+
+    Reset();
+}
+
+void BakeStatShards::Shutdown()
+{
+    if(shards != nullptr)
+    {
+        _aligned_free(shards);
+        shards = nullptr;
+    }
+    numShards = 0;
+}
+
+void BakeStatShards::Reset()
+{
+    if(shards != nullptr)
+        memset(shards, 0, sizeof(BakeStatShard) * numShards);
+}
+
+BakeStats BakeStatShards::Aggregate() const
+{
+    BakeStats stats;
+    for(uint64 shardIdx = 0; shardIdx < numShards; ++shardIdx)
+        for(uint64 i = 0; i < uint64(BakeStatCounters::NumValues); ++i)
+            stats.Values[i] += shards[shardIdx].Values[i];
+
+    return stats;
+}
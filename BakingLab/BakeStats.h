@@ -0,0 +1,110 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+#include <intrin.h>
+#include <Assert.h>
+
+using namespace SampleFramework11;
+
+// Set this to 0 to compile out all of the hot-path counters
+#ifndef EnableBakeStats_
+    #define EnableBakeStats_ (1)
+#endif
+
+enum class BakeStatCounters
+{
+    Paths = 0,
+    PrimaryRays,
+    BounceRays,
+    SunShadowRays,
+    AreaLightShadowRays,
+    EmissiveShadowRays,
+    SkyHits,
+    AreaLightHits,
+    EmissiveHits,
+    BackFaceTerminations,
+    MaxLengthTerminations,
+    RussianRouletteTerminations,
+    RadianceCacheTerminations,
+    RadianceCacheUpdates,
+    GuidedBounces,
+    GuideTrainingSamples,
+    Batches,
+    BatchCycles,
+    PathTraceCycles,
+    FinalResultCycles,
+
+    NumValues
+};
+
+// The counters for a single thread, padded out to a full cache line so that the threads never
+// write to the same line
+struct __declspec(align(64)) BakeStatShard
+{
+    uint64 Values[uint64(BakeStatCounters::NumValues)];
+};
+
+// The counters of all threads summed together
+struct BakeStats
+{
+    uint64 Values[uint64(BakeStatCounters::NumValues)];
+
+    BakeStats()
+    {
+        for(uint64 i = 0; i < uint64(BakeStatCounters::NumValues); ++i)
+            Values[i] = 0;
+    }
+
+    uint64 operator[](BakeStatCounters counter) const { return Values[uint64(counter)]; }
+
+    // Returns the counters along with a few derived ratios, as a JSON object
+    std::string ToJSON() const;
+
+    static const char* CounterName(BakeStatCounters counter);
+};
+
+// One shard of counters per thread, which are only summed together when queried. Each thread only
+// writes to its own shard without any atomics, so the sums can be slightly behind.
+class BakeStatShards
+{
+
+public:
+
+    ~BakeStatShards();
+
+    void Init(uint64 numShards);
+    void Shutdown();
+    void Reset();
+
+    BakeStatShard* Shard(uint64 idx)
+    {
+        Assert_(idx < numShards);
+        return &shards[idx];
+    }
+
+    BakeStats Aggregate() const;
+
+private:
+
+    // Allocated with _aligned_malloc, since new[] doesn't respect the alignment of the shards
+    BakeStatShard* shards = nullptr;
+    uint64 numShards = 0;
+};
+
+#if EnableBakeStats_
+    #define BakeStatAdd_(shard, counter, value) ((shard) != nullptr ? void((shard)->Values[uint64(BakeStatCounters::counter)] += (value)) : void())
+    #define BakeStatCycles_() __rdtsc()
+#else
+    #define BakeStatAdd_(shard, counter, value) ((void)0)
+    #define BakeStatCycles_() uint64(0)
+#endif
@@ -20,10 +20,13 @@
 #include <Graphics/Sampling.h>
 #include <Graphics/BRDF.h>
 #include <FileIO.h>
+#include <ThreadPool.h>
 
 #include "BakingLab.h"
 #include "MeshBaker.h"
 #include "SG.h"
+#include "Microbenchmarks.h"
+#include "Tracer.h"
 
 #include "resource.h"
 
@@ -207,6 +210,8 @@ static void SaveLightSettings(HWND parentWindow)
 
             for(uint64 i = 0; i < NumLightSettings; ++i)
                 LightSettings[i]->SerializeValue(serializer);
+
+            serializer.Flush();
         }
         catch(Exception e)
         {
@@ -474,6 +479,18 @@ BakingLab::BakingLab() : App(L"Baking Lab", MAKEINTRESOURCEW(IDI_DEFAULT)),
         GTSampleRateBuffer[i] = 0.0f;
 }
 
+void BakingLab::EnableBenchmark(bool generateReferences)
+{
+    benchmark.Initialize(generateReferences);
+    showWindow = false;
+}
+
+void BakingLab::EnableMicrobenchmarks()
+{
+    runMicrobenchmarks = true;
+    showWindow = false;
+}
+
 void BakingLab::BeforeReset()
 {
     App::BeforeReset();
@@ -507,14 +524,13 @@ void BakingLab::Initialize()
     font.Initialize(L"Arial", 18, SpriteFont::Regular, true, device);
     spriteRenderer.Initialize(device);
 
-    // Load the scenes
-    for(uint64 i = 0; i < uint64(Scenes::NumValues); ++i)
-    {
-        if(GetFileExtension(ScenePaths[i]) == L"meshdata")
-            sceneModels[i].CreateFromMeshData(device, ScenePaths[i], true);
-        else
-            sceneModels[i].CreateWithAssimp(device, ScenePaths[i], true);
-    }
+    // Load the selected scene and the environment maps at the same time. The other scenes are
+    // loaded the first time that they're selected.
+    JobGroup loadJobs;
+    loadJobs.Run([&]() { LoadScene(uint64(AppSettings::CurrentScene)); });
+    for(uint64 i = 0; i < AppSettings::NumCubeMaps; ++i)
+        loadJobs.Run([&, i]() { envMaps[i] = LoadTexture(device, AppSettings::CubeMapPaths(i)); });
+    loadJobs.Wait();
 
     Model& currentModel = sceneModels[AppSettings::CurrentScene.Value()];
     meshRenderer.Initialize(device, deviceManager.ImmediateContext(), &currentModel);
@@ -523,9 +539,6 @@ void BakingLab::Initialize()
 
     skybox.Initialize(device);
 
-    for(uint64 i = 0; i < AppSettings::NumCubeMaps; ++i)
-        envMaps[i] = LoadTexture(device, AppSettings::CubeMapPaths(i));
-
     // Load shaders
     for(uint32 msaaMode = 0; msaaMode < uint32(MSAAModes::NumValues); ++msaaMode)
     {
@@ -548,12 +561,64 @@ void BakingLab::Initialize()
     BakeInputData bakeInput;
     bakeInput.SceneModel = &currentModel;
     bakeInput.Device = device;
-    for(uint64 i = 0; i < AppSettings::NumCubeMaps; ++i)
-        bakeInput.EnvMaps[i] = envMaps[i];
     meshBaker.Initialize(bakeInput);
 
     // Camera setup
     AppSettings::UpdateHorizontalCoords();
+
+    if(runMicrobenchmarks)
+    {
+        RunMicrobenchmarks(device, currentModel, envMaps[0]);
+        Exit();
+    }
+}
+
+// Re-packs the light map charts of every scene, or restores the authored UV's if packing is disabled
+static LightMapPackParams CurrentLightMapPackParams()
+{
+    LightMapPackParams params;
+    params.AtlasSize = AppSettings::LightMapResolution;
+    params.TexelDensity = AppSettings::LightMapTexelDensity;
+    params.Padding = AppSettings::LightMapChartPadding;
+    params.MaxPages = AppSettings::LightMapPageCount;
+    return params;
+}
+
+// Loads a scene along with its light map packing, if it hasn't been loaded already
+void BakingLab::LoadScene(uint64 sceneIdx)
+{
+    if(sceneLoaded[sceneIdx])
+        return;
+
+    ID3D11Device* device = deviceManager.Device();
+
+    if(GetFileExtension(ScenePaths[sceneIdx]) == L"meshdata")
+        sceneModels[sceneIdx].CreateFromMeshData(device, ScenePaths[sceneIdx], true);
+    else
+        sceneModels[sceneIdx].CreateWithSceneCache(device, ScenePaths[sceneIdx], true);
+
+    lightMapPackers[sceneIdx].Initialize(&sceneModels[sceneIdx]);
+    if(AppSettings::PackLightMapCharts)
+        lightMapPackers[sceneIdx].Pack(device, CurrentLightMapPackParams());
+
+    sceneLoaded[sceneIdx] = true;
+}
+
+void BakingLab::PackLightMaps()
+{
+    ID3D11Device* device = deviceManager.Device();
+    const LightMapPackParams params = CurrentLightMapPackParams();
+
+    for(uint64 i = 0; i < uint64(Scenes::NumValues); ++i)
+    {
+        if(sceneLoaded[i] == false)
+            continue;
+
+        if(AppSettings::PackLightMapCharts)
+            lightMapPackers[i].Pack(device, params);
+        else
+            lightMapPackers[i].Restore(device);
+    }
 }
 
 // Creates all required render targets
@@ -586,9 +651,17 @@ void BakingLab::Update(const Timer& timer)
     if(AppSettings::SaveLightSettings)
         SaveLightSettings(window.GetHwnd());
 
+    Tracer::SetEnabled(AppSettings::EnableTracing);
+    if(AppSettings::ExportTrace)
+        Tracer::ExportChromeTrace(L"BakeTrace.json");
+
+    if(AppSettings::HasLightMapPackingChanged())
+        PackLightMaps();
+
     if(AppSettings::CurrentScene.Changed())
     {
         uint64 currSceneIdx = uint64(AppSettings::CurrentScene);
+        LoadScene(currSceneIdx);
         meshRenderer.SetModel(&sceneModels[currSceneIdx]);
         camera.SetPosition(SceneCameraPositions[currSceneIdx]);
         camera.SetXRotation(SceneCameraRotations[currSceneIdx].x);
@@ -687,8 +760,22 @@ void BakingLab::Render(const Timer& timer)
 
     ID3D11DeviceContextPtr context = deviceManager.ImmediateContext();
 
+    const uint64 currSceneIdx = uint64(AppSettings::CurrentScene);
     MeshBakerStatus status = meshBaker.Update(unJitteredCamera, colorTargetMSAA.Width, colorTargetMSAA.Height,
-                                              context, &sceneModels[AppSettings::CurrentScene]);
+                                              context, &sceneModels[currSceneIdx],
+                                              lightMapPackers[currSceneIdx].PageSizes());
+
+    if(benchmark.Enabled() && benchmark.Update(status, meshBaker))
+        Exit();
+
+    if(AppSettings::ExportBakeStats)
+        WriteStringAsFile(L"BakeStats.json", status.Stats.ToJSON());
+
+    if(AppSettings::ExportBakeResults)
+        meshBaker.ExportBakeResults(L"BakeResults");
+
+    if(AppSettings::ReplayRadianceSamples)
+        meshBaker.ReplayRadianceSamples();
 
     if(AppSettings::ShowGroundTruth)
     {
@@ -730,7 +817,8 @@ void BakingLab::Render(const Timer& timer)
 
     SetViewport(context, deviceManager.BackBufferWidth(), deviceManager.BackBufferHeight());
 
-    RenderHUD(timer, status.GroundTruthProgress, status.BakeProgress, status.GroundTruthSampleCount);
+    RenderHUD(timer, status.GroundTruthProgress, status.BakeProgress, status.ProbeProgress,
+              status.GroundTruthSampleCount, status.RadianceCache);
 
     ++frameCount;
 }
@@ -772,6 +860,9 @@ void BakingLab::RenderMainPass(const MeshBakerStatus& status)
     if(AppSettings::ShowBakeDataVisualizer)
         meshRenderer.RenderBakeDataVisualizer(context, camera, status);
 
+    if(AppSettings::ShowProbes && status.Probes != nullptr)
+        meshRenderer.RenderProbeVisualizer(context, camera, status);
+
     if(AppSettings::EnableAreaLight)
         meshRenderer.RenderAreaLight(context, camera);
 
@@ -891,7 +982,8 @@ void BakingLab::RenderBackgroundVelocity()
 }
 
 void BakingLab::RenderHUD(const Timer& timer, float groundTruthProgress, float bakeProgress,
-                         uint64 groundTruthSampleCount)
+                         float probeProgress, uint64 groundTruthSampleCount,
+                         const RadianceCacheOccupancy& radianceCacheOccupancy)
 {
     PIXEvent event(L"HUD Pass");
 
@@ -910,7 +1002,7 @@ void BakingLab::RenderHUD(const Timer& timer, float groundTruthProgress, float b
 
     Profiler::GlobalProfiler.EndFrame(spriteRenderer, font);
 
-    if(groundTruthProgress < 1.0f || bakeProgress < 1.0f)
+    if(groundTruthProgress < 1.0f || bakeProgress < 1.0f || probeProgress < 1.0f)
     {
         std::wstring progressText;
         if(groundTruthProgress < 1.0f)
@@ -939,6 +1031,12 @@ void BakingLab::RenderHUD(const Timer& timer, float groundTruthProgress, float b
             percent /= 100.0f;
             progressText = L"Baking light maps (" + ToString(percent) + L"%)";
         }
+        else if(probeProgress < 1.0f)
+        {
+            float percent = Round(probeProgress * 10000.0f);
+            percent /= 100.0f;
+            progressText = L"Baking probes (" + ToString(percent) + L"%)";
+        }
 
         transform._41 = 35.0f;
         transform._42 = deviceManager.BackBufferHeight() - 60.0f;
@@ -1000,6 +1098,16 @@ void BakingLab::RenderHUD(const Timer& timer, float groundTruthProgress, float b
         spriteRenderer.RenderText(font, intensityText.c_str(), transform);
     }
 
+    if(radianceCacheOccupancy.NumCells > 0)
+    {
+        const float occupiedPercent = Round(radianceCacheOccupancy.NumOccupiedCells * 10000.0f / radianceCacheOccupancy.NumCells) / 100.0f;
+        wstring cacheText = L"Radiance Cache: " + ToString(radianceCacheOccupancy.NumOccupiedCells) + L" cells in use (";
+        cacheText += ToString(occupiedPercent) + L"%), " + ToString(radianceCacheOccupancy.NumWarmCells) + L" warm";
+        transform._41 = 35.0f;
+        transform._42 = deviceManager.BackBufferHeight() - 140.0f;
+        spriteRenderer.RenderText(font, cacheText.c_str(), transform);
+    }
+
     spriteRenderer.End();
 }
 
@@ -1135,5 +1243,15 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
     // GenerateSHGGXProjectionTable();
 
     BakingLab app;
+
+    // "-benchmark" runs the bake benchmark, "-benchmarkreference" generates its reference bakes,
+    // and "-microbenchmark" times the individual CPU kernels
+    if(wcsstr(lpCmdLine, L"-benchmarkreference") != nullptr)
+        app.EnableBenchmark(true);
+    else if(wcsstr(lpCmdLine, L"-benchmark") != nullptr)
+        app.EnableBenchmark(false);
+    else if(wcsstr(lpCmdLine, L"-microbenchmark") != nullptr)
+        app.EnableMicrobenchmarks();
+
     app.Run();
 }
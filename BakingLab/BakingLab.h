@@ -25,6 +25,8 @@
 #include "PostProcessor.h"
 #include "MeshRenderer.h"
 #include "MeshBaker.h"
+#include "LightMapPacker.h"
+#include "BakeBenchmark.h"
 
 using namespace SampleFramework11;
 
@@ -52,6 +54,10 @@ protected:
     Model sceneModels[uint64(Scenes::NumValues)];
     MeshRenderer meshRenderer;
     MeshBaker meshBaker;
+    LightMapPacker lightMapPackers[uint64(Scenes::NumValues)];
+    bool sceneLoaded[uint64(Scenes::NumValues)] = { };
+    BakeBenchmark benchmark;
+    bool runMicrobenchmarks = false;
 
     MouseState mouseState;
 
@@ -95,14 +101,22 @@ protected:
     virtual void AfterReset() override;
 
     void CreateRenderTargets();
+    void PackLightMaps();
 
     void RenderMainPass(const MeshBakerStatus& status);
     void RenderAA();
     void RenderBackgroundVelocity();
     void RenderHUD(const Timer& timer, float groundTruthProgress, float bakeProgress,
-                   uint64 groundTruthSampleCount);
+                   float probeProgress, uint64 groundTruthSampleCount,
+                   const RadianceCacheOccupancy& radianceCacheOccupancy);
 
 public:
 
     BakingLab();
+
+    // Runs the bake benchmark with a hidden window, and exits once it's finished
+    void EnableBenchmark(bool generateReferences);
+
+    // Times the CPU kernels used for baking with a hidden window, and exits once it's finished
+    void EnableMicrobenchmarks();
 };
@@ -0,0 +1,270 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "LightBVH.h"
+
+static const float OneMinusEpsilon = 0.99999994f;
+
+static float SafeSqrt(float x)
+{
+    return std::sqrt(std::max(x, 0.0f));
+}
+
+// Cosine of the difference of two angles, clamped to 1 when the first one is smaller
+static float CosSubClamped(float sinA, float cosA, float sinB, float cosB)
+{
+    if(cosA > cosB)
+        return 1.0f;
+    return cosA * cosB + sinA * sinB;
+}
+
+// Sine of the difference of two angles, clamped to 0 when the first one is smaller
+static float SinSubClamped(float sinA, float cosA, float sinB, float cosB)
+{
+    if(cosA > cosB)
+        return 0.0f;
+    return sinA * cosB - cosA * sinB;
+}
+
+// Rotates a direction around a normalized axis
+static Float3 RotateAroundAxis(const Float3& dir, const Float3& axis, float angle)
+{
+    const float cosAngle = std::cos(angle);
+    const float sinAngle = std::sin(angle);
+    return dir * cosAngle + Float3::Cross(axis, dir) * sinAngle + axis * Float3::Dot(axis, dir) * (1.0f - cosAngle);
+}
+
+static LightBounds EmitterBounds(const EmissiveTriangle& emitter)
+{
+    LightBounds bounds;
+    bounds.BoundsMin.x = Min(emitter.V0.x, Min(emitter.V1.x, emitter.V2.x));
+    bounds.BoundsMin.y = Min(emitter.V0.y, Min(emitter.V1.y, emitter.V2.y));
+    bounds.BoundsMin.z = Min(emitter.V0.z, Min(emitter.V1.z, emitter.V2.z));
+    bounds.BoundsMax = Float3::Max(emitter.V0, Float3::Max(emitter.V1, emitter.V2));
+    bounds.Axis = emitter.Normal;
+    bounds.CosTheta = 1.0f;
+    bounds.Power = ComputeLuminance(emitter.Emission) * emitter.Area * Pi;
+    return bounds;
+}
+
+// Returns the smallest cone that contains both cones
+static void UnionCones(const LightBounds& a, const LightBounds& b, Float3& axis, float& cosTheta)
+{
+    const float thetaA = std::acos(Clamp(a.CosTheta, -1.0f, 1.0f));
+    const float thetaB = std::acos(Clamp(b.CosTheta, -1.0f, 1.0f));
+    const float thetaD = std::acos(Clamp(Float3::Dot(a.Axis, b.Axis), -1.0f, 1.0f));
+
+    if(Min(thetaD + thetaB, Pi) <= thetaA)
+    {
+        axis = a.Axis;
+        cosTheta = a.CosTheta;
+        return;
+    }
+
+    if(Min(thetaD + thetaA, Pi) <= thetaB)
+    {
+        axis = b.Axis;
+        cosTheta = b.CosTheta;
+        return;
+    }
+
+    // The new cone spans from the far edge of one cone to the far edge of the other, so its axis
+    // is rotated from the axis of the first one towards the second one
+    const float thetaO = (thetaA + thetaD + thetaB) * 0.5f;
+    const Float3 rotationAxis = Float3::Cross(a.Axis, b.Axis);
+    if(thetaO >= Pi || Float3::Dot(rotationAxis, rotationAxis) <= 0.0f)
+    {
+        axis = a.Axis;
+        cosTheta = -1.0f;
+        return;
+    }
+
+    axis = Float3::Normalize(RotateAroundAxis(a.Axis, Float3::Normalize(rotationAxis), thetaO - thetaA));
+    cosTheta = std::cos(thetaO);
+}
+
+static LightBounds UnionBounds(const LightBounds& a, const LightBounds& b)
+{
+    LightBounds bounds;
+    bounds.BoundsMin.x = Min(a.BoundsMin.x, b.BoundsMin.x);
+    bounds.BoundsMin.y = Min(a.BoundsMin.y, b.BoundsMin.y);
+    bounds.BoundsMin.z = Min(a.BoundsMin.z, b.BoundsMin.z);
+    bounds.BoundsMax = Float3::Max(a.BoundsMax, b.BoundsMax);
+    UnionCones(a, b, bounds.Axis, bounds.CosTheta);
+    bounds.Power = a.Power + b.Power;
+    return bounds;
+}
+
+// Upper bound on how much light the emitters in the bounds can send to a surface at "position"
+// that faces along "normal", following "Importance Sampling of Many Lights with Adaptive Tree
+// Splitting" [Conty Estevez and Kulla 2018]. Both the angle between the normal cone and the
+// position and the angle between the normal and the bounds are shrunk by the angle that the
+// bounds cover as seen from the position, so that the bound holds for every point inside of them.
+static float Importance(const LightBounds& bounds, const Float3& position, const Float3& normal)
+{
+    const Float3 center = (bounds.BoundsMin + bounds.BoundsMax) * 0.5f;
+    const float radius = Float3::Length(bounds.BoundsMax - bounds.BoundsMin) * 0.5f;
+
+    const Float3 toPosition = position - center;
+    const float distSq = Float3::Dot(toPosition, toPosition);
+    const float dist = std::sqrt(distSq);
+    const Float3 dirToPosition = dist > 0.0f ? toPosition / dist : Float3(0.0f);
+
+    // Cone of directions from the position that the bounds cover, which is everything if the
+    // position is inside of them
+    float cosThetaB = -1.0f;
+    if(distSq > radius * radius)
+        cosThetaB = SafeSqrt(1.0f - radius * radius / distSq);
+    const float sinThetaB = SafeSqrt(1.0f - cosThetaB * cosThetaB);
+
+    // Smallest angle between the position and the normals of the emitters, which need to face it
+    const float cosThetaW = Float3::Dot(bounds.Axis, dirToPosition);
+    const float sinThetaW = SafeSqrt(1.0f - cosThetaW * cosThetaW);
+    const float sinThetaO = SafeSqrt(1.0f - bounds.CosTheta * bounds.CosTheta);
+    const float cosThetaX = CosSubClamped(sinThetaW, cosThetaW, sinThetaO, bounds.CosTheta);
+    const float sinThetaX = SinSubClamped(sinThetaW, cosThetaW, sinThetaO, bounds.CosTheta);
+    const float cosThetaP = CosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB);
+    if(cosThetaP <= 0.0f)
+        return 0.0f;
+
+    // Smallest angle between the surface normal and the bounds, which need to be above the horizon
+    const float cosThetaI = -Float3::Dot(normal, dirToPosition);
+    const float sinThetaI = SafeSqrt(1.0f - cosThetaI * cosThetaI);
+    const float cosThetaPI = CosSubClamped(sinThetaI, cosThetaI, sinThetaB, cosThetaB);
+    if(cosThetaPI <= 0.0f)
+        return 0.0f;
+
+    // Don't let the distance falloff blow up for positions that are close to or inside of the bounds
+    return bounds.Power * cosThetaP * cosThetaPI / Max(distSq, radius);
+}
+
+// Splits the emitters at the median of their centroids along the longest axis, and returns the
+// index of the new node
+static uint32 BuildNode(std::vector<LightBVHNode>& nodes, uint32* lightOrder, uint64 start, uint64 end,
+                        const std::vector<Float3>& centroids, const std::vector<LightBounds>& emitterBounds)
+{
+    Assert_(end > start);
+
+    const uint32 nodeIdx = uint32(nodes.size());
+    nodes.push_back(LightBVHNode());
+
+    if(end - start == 1)
+    {
+        LightBVHNode& node = nodes[nodeIdx];
+        node.Bounds = emitterBounds[lightOrder[start]];
+        node.LightIdx = uint32(start);
+        node.IsLeaf = 1;
+        return nodeIdx;
+    }
+
+    Float3 centroidMin = centroids[lightOrder[start]];
+    Float3 centroidMax = centroidMin;
+    for(uint64 i = start + 1; i < end; ++i)
+    {
+        const Float3& centroid = centroids[lightOrder[i]];
+        centroidMin.x = Min(centroidMin.x, centroid.x);
+        centroidMin.y = Min(centroidMin.y, centroid.y);
+        centroidMin.z = Min(centroidMin.z, centroid.z);
+        centroidMax = Float3::Max(centroidMax, centroid);
+    }
+
+    const Float3 extents = centroidMax - centroidMin;
+    uint32 axis = 0;
+    if(extents.y > extents[axis])
+        axis = 1;
+    if(extents.z > extents[axis])
+        axis = 2;
+
+    const uint64 mid = (start + end) / 2;
+    std::nth_element(lightOrder + start, lightOrder + mid, lightOrder + end,
+                     [&](uint32 a, uint32 b) { return centroids[a][axis] < centroids[b][axis]; });
+
+    const uint32 firstChild = BuildNode(nodes, lightOrder, start, mid, centroids, emitterBounds);
+    const uint32 secondChild = BuildNode(nodes, lightOrder, mid, end, centroids, emitterBounds);
+    Assert_(firstChild == nodeIdx + 1);
+
+    LightBVHNode& node = nodes[nodeIdx];
+    node.Bounds = UnionBounds(nodes[firstChild].Bounds, nodes[secondChild].Bounds);
+    node.SecondChild = secondChild;
+    return nodeIdx;
+}
+
+void LightBVH::Build(const std::vector<EmissiveTriangle>& emitters)
+{
+    Reset();
+
+    const uint64 numEmitters = emitters.size();
+    if(numEmitters == 0)
+        return;
+
+    std::vector<Float3> centroids(numEmitters);
+    std::vector<LightBounds> emitterBounds(numEmitters);
+    std::vector<uint32> lightOrder(numEmitters);
+    for(uint64 i = 0; i < numEmitters; ++i)
+    {
+        const EmissiveTriangle& emitter = emitters[i];
+        centroids[i] = (emitter.V0 + emitter.V1 + emitter.V2) / 3.0f;
+        emitterBounds[i] = EmitterBounds(emitter);
+        lightOrder[i] = uint32(i);
+    }
+
+    nodes.reserve(numEmitters * 2 - 1);
+    BuildNode(nodes, lightOrder.data(), 0, numEmitters, centroids, emitterBounds);
+
+    // Store the emitters in the same order as the leaves
+    lights.resize(numEmitters);
+    for(uint64 i = 0; i < numEmitters; ++i)
+        lights[i] = emitters[lightOrder[i]];
+}
+
+void LightBVH::Reset()
+{
+    lights = std::vector<EmissiveTriangle>();
+    nodes = std::vector<LightBVHNode>();
+}
+
+const EmissiveTriangle* LightBVH::SampleLight(const Float3& position, const Float3& normal, float u, float& pmf) const
+{
+    pmf = 0.0f;
+    if(nodes.size() == 0 || Importance(nodes[0].Bounds, position, normal) <= 0.0f)
+        return nullptr;
+
+    // Pick a child at every level in proportion to its importance, and re-use the remainder of
+    // the sample point for the next level
+    uint32 nodeIdx = 0;
+    float nodePMF = 1.0f;
+    while(nodes[nodeIdx].IsLeaf == 0)
+    {
+        const LightBVHNode& node = nodes[nodeIdx];
+        const float importance0 = Importance(nodes[nodeIdx + 1].Bounds, position, normal);
+        const float importance1 = Importance(nodes[node.SecondChild].Bounds, position, normal);
+        if(importance0 <= 0.0f && importance1 <= 0.0f)
+            return nullptr;
+
+        const float p0 = importance0 / (importance0 + importance1);
+        if(u < p0)
+        {
+            nodeIdx = nodeIdx + 1;
+            u = Min(u / p0, OneMinusEpsilon);
+            nodePMF *= p0;
+        }
+        else
+        {
+            nodeIdx = node.SecondChild;
+            u = Min((u - p0) / (1.0f - p0), OneMinusEpsilon);
+            nodePMF *= 1.0f - p0;
+        }
+    }
+
+    pmf = nodePMF;
+    return &lights[nodes[nodeIdx].LightIdx];
+}
@@ -0,0 +1,73 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+#include <SF11_Math.h>
+
+using namespace SampleFramework11;
+
+// A single triangle with an emissive material, which only emits from its front face
+struct EmissiveTriangle
+{
+    Float3 V0;
+    Float3 V1;
+    Float3 V2;
+    Float3 Normal;                      // Front face, which is normalize(cross(V1 - V0, V2 - V0))
+    float Area = 0.0f;
+    Float3 Emission;                    // Emissive color of the material, before the intensity is applied
+};
+
+// Conservative bounds for a set of emitters: where they are, which way they face, and how much
+// light they give off in total
+struct LightBounds
+{
+    Float3 BoundsMin;
+    Float3 BoundsMax;
+    Float3 Axis;                        // Cone that contains the normals of all of the emitters
+    float CosTheta = 1.0f;
+    float Power = 0.0f;                 // Luminance times area, summed over the emitters
+};
+
+// A node of the light BVH. Interior nodes store their first child right after themselves.
+struct LightBVHNode
+{
+    LightBounds Bounds;
+    uint32 SecondChild = 0;
+    uint32 LightIdx = 0;
+    uint32 IsLeaf = 0;
+};
+
+// Bounding volume hierarchy over the emissive triangles of a scene, with one emitter per leaf. Every
+// node bounds the power and the orientation of its emitters, which lets a path vertex pick a single
+// emitter for next event estimation by walking down the tree and choosing between the two children
+// according to how much light they could possibly send its way. The cost of a pick only grows with
+// the depth of the tree, and not with the number of emitters.
+class LightBVH
+{
+
+public:
+
+    void Build(const std::vector<EmissiveTriangle>& emitters);
+    void Reset();
+
+    bool Empty() const { return lights.size() == 0; }
+    uint64 NumLights() const { return lights.size(); }
+
+    // Returns nullptr if none of the emitters can light the position, otherwise returns the picked
+    // emitter along with the probability of having picked it
+    const EmissiveTriangle* SampleLight(const Float3& position, const Float3& normal, float u, float& pmf) const;
+
+private:
+
+    std::vector<EmissiveTriangle> lights;
+    std::vector<LightBVHNode> nodes;
+};
@@ -0,0 +1,518 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "LightMapPacker.h"
+
+#include <Graphics/Model.h>
+#include <Utility.h>
+#include <Timer.h>
+
+#include "PathTracer.h"
+
+// Number of times that we'll shrink the texel density when the charts don't fit in the atlas
+static const uint64 MaxPackAttempts = 64;
+static const float PackShrinkFactor = 0.9f;
+
+// A single horizontal segment of the skyline used for packing rectangles
+struct SkylineNode
+{
+    uint32 X = 0;
+    uint32 Y = 0;
+    uint32 Width = 0;
+};
+
+// Finds the bottom-left-most position at which a rectangle can be placed on top of the skyline
+static bool SkylineFindPosition(const std::vector<SkylineNode>& skyline, uint32 width, uint32 height,
+                                uint32 atlasSize, uint32& bestX, uint32& bestY, uint64& bestNodeIdx)
+{
+    bool found = false;
+    uint32 bestTop = UINT32_MAX;
+    for(uint64 i = 0; i < skyline.size(); ++i)
+    {
+        const uint32 x = skyline[i].X;
+        if(x + width > atlasSize)
+            break;
+
+        // The rectangle rests on the highest node that it spans
+        uint32 y = 0;
+        int64 widthLeft = width;
+        for(uint64 j = i; widthLeft > 0 && j < skyline.size(); ++j)
+        {
+            y = std::max(y, skyline[j].Y);
+            widthLeft -= skyline[j].Width;
+        }
+
+        if(y + height > atlasSize)
+            continue;
+
+        if(y + height < bestTop)
+        {
+            bestTop = y + height;
+            bestX = x;
+            bestY = y;
+            bestNodeIdx = i;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+// Raises the skyline to account for a newly-placed rectangle
+static void SkylineAddRect(std::vector<SkylineNode>& skyline, uint64 nodeIdx, uint32 x, uint32 y,
+                           uint32 width, uint32 height)
+{
+    SkylineNode newNode;
+    newNode.X = x;
+    newNode.Y = y + height;
+    newNode.Width = width;
+    skyline.insert(skyline.begin() + nodeIdx, newNode);
+
+    // Shrink or remove the nodes that are now covered by the new one
+    for(uint64 i = nodeIdx + 1; i < skyline.size();)
+    {
+        const SkylineNode& prevNode = skyline[i - 1];
+        const uint32 prevEnd = prevNode.X + prevNode.Width;
+        if(skyline[i].X >= prevEnd)
+            break;
+
+        const uint32 shrink = prevEnd - skyline[i].X;
+        if(skyline[i].Width <= shrink)
+        {
+            skyline.erase(skyline.begin() + i);
+            continue;
+        }
+
+        skyline[i].X += shrink;
+        skyline[i].Width -= shrink;
+        break;
+    }
+
+    // Merge neighbors at the same height
+    for(uint64 i = 0; i + 1 < skyline.size();)
+    {
+        if(skyline[i].Y == skyline[i + 1].Y)
+        {
+            skyline[i].Width += skyline[i + 1].Width;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else
+            ++i;
+    }
+}
+
+static uint32 FindRoot(std::vector<uint32>& parents, uint32 idx)
+{
+    while(parents[idx] != idx)
+    {
+        parents[idx] = parents[parents[idx]];
+        idx = parents[idx];
+    }
+
+    return idx;
+}
+
+static float Cross2D(const Float2& a, const Float2& b)
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+void LightMapPacker::Initialize(Model* model_)
+{
+    model = model_;
+
+    // Keep the authored light map UV's so that we can always pack from (or restore) them
+    const uint64 numMeshes = model->Meshes().size();
+    authoredUVs.resize(numMeshes);
+    for(uint64 meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+    {
+        const Mesh& mesh = model->Meshes()[meshIdx];
+        Assert_(mesh.VertexStride() == sizeof(Vertex));
+        const Vertex* vertices = reinterpret_cast<const Vertex*>(mesh.Vertices());
+        authoredUVs[meshIdx].resize(mesh.NumVertices());
+        for(uint64 i = 0; i < mesh.NumVertices(); ++i)
+            authoredUVs[meshIdx][i] = vertices[i].LightMapUV;
+    }
+
+    BuildCharts();
+}
+
+// Splits each mesh into charts, where a chart is a set of triangles connected by shared vertices.
+// Since a vertex only has a single light map UV, this keeps the authored seams intact and makes
+// sure that no vertex is shared between two charts.
+void LightMapPacker::BuildCharts()
+{
+    charts.clear();
+    numReprojectedCharts = 0;
+
+    const uint64 numMeshes = model->Meshes().size();
+    for(uint64 meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+    {
+        const Mesh& mesh = model->Meshes()[meshIdx];
+        const Vertex* vertices = reinterpret_cast<const Vertex*>(mesh.Vertices());
+        const uint8* indices = mesh.Indices();
+        const uint32 indexSize = mesh.IndexSize();
+        const uint32 numVertices = mesh.NumVertices();
+        const uint32 numTriangles = mesh.NumIndices() / 3;
+
+        std::vector<uint32> parents(numVertices);
+        for(uint32 i = 0; i < numVertices; ++i)
+            parents[i] = i;
+
+        for(uint32 triIdx = 0; triIdx < numTriangles; ++triIdx)
+        {
+            const uint32 root0 = FindRoot(parents, GetIndex(indices, triIdx * 3 + 0, indexSize));
+            const uint32 root1 = FindRoot(parents, GetIndex(indices, triIdx * 3 + 1, indexSize));
+            const uint32 root2 = FindRoot(parents, GetIndex(indices, triIdx * 3 + 2, indexSize));
+            parents[root1] = root0;
+            parents[root2] = root0;
+        }
+
+        // Assign each referenced vertex to the chart of its root
+        const uint64 firstChart = charts.size();
+        std::vector<uint32> vertexCharts(numVertices, uint32(-1));
+        std::vector<uint32> rootCharts(numVertices, uint32(-1));
+        for(uint32 triIdx = 0; triIdx < numTriangles; ++triIdx)
+        {
+            for(uint32 i = 0; i < 3; ++i)
+            {
+                const uint32 vtxIdx = GetIndex(indices, triIdx * 3 + i, indexSize);
+                if(vertexCharts[vtxIdx] != uint32(-1))
+                    continue;
+
+                const uint32 root = FindRoot(parents, vtxIdx);
+                if(rootCharts[root] == uint32(-1))
+                {
+                    rootCharts[root] = uint32(charts.size() - firstChart);
+                    charts.push_back(Chart());
+                    charts.back().MeshIdx = meshIdx;
+                }
+
+                vertexCharts[vtxIdx] = rootCharts[root];
+                Chart& chart = charts[firstChart + rootCharts[root]];
+                chart.VertexIndices.push_back(vtxIdx);
+                chart.Coords.push_back(authoredUVs[meshIdx][vtxIdx]);
+            }
+        }
+
+        const uint64 numMeshCharts = charts.size() - firstChart;
+        std::vector<Float3> chartNormals(numMeshCharts);
+        std::vector<uint32> localIndices(numVertices, 0);
+        for(uint64 chartIdx = firstChart; chartIdx < charts.size(); ++chartIdx)
+        {
+            const Chart& chart = charts[chartIdx];
+            for(uint64 i = 0; i < chart.VertexIndices.size(); ++i)
+                localIndices[chart.VertexIndices[i]] = uint32(i);
+        }
+
+        // Accumulate the world-space and UV-space areas of each chart
+        for(uint32 triIdx = 0; triIdx < numTriangles; ++triIdx)
+        {
+            const uint32 idx0 = GetIndex(indices, triIdx * 3 + 0, indexSize);
+            const uint32 idx1 = GetIndex(indices, triIdx * 3 + 1, indexSize);
+            const uint32 idx2 = GetIndex(indices, triIdx * 3 + 2, indexSize);
+            const uint64 meshChartIdx = vertexCharts[idx0];
+            Chart& chart = charts[firstChart + meshChartIdx];
+
+            const Float3 triNormal = Float3::Cross(vertices[idx1].Position - vertices[idx0].Position,
+                                                   vertices[idx2].Position - vertices[idx0].Position);
+            chart.WorldArea += 0.5f * Float3::Length(triNormal);
+            chartNormals[meshChartIdx] += triNormal;
+
+            const Float2& uv0 = chart.Coords[localIndices[idx0]];
+            const Float2& uv1 = chart.Coords[localIndices[idx1]];
+            const Float2& uv2 = chart.Coords[localIndices[idx2]];
+            chart.CoordArea += 0.5f * std::abs(Cross2D(uv1 - uv0, uv2 - uv0));
+        }
+
+        // Charts without usable light map UV's get a planar projection along their average normal
+        std::vector<bool> reprojected(numMeshCharts, false);
+        for(uint64 meshChartIdx = 0; meshChartIdx < numMeshCharts; ++meshChartIdx)
+        {
+            Chart& chart = charts[firstChart + meshChartIdx];
+            if(chart.CoordArea > 1e-10f || chart.WorldArea <= 0.0f)
+                continue;
+
+            Float3 normal = Float3::Normalize(chartNormals[meshChartIdx]);
+            Float3 up = std::abs(normal.y) < 0.999f ? Float3(0.0f, 1.0f, 0.0f) : Float3(1.0f, 0.0f, 0.0f);
+            Float3 tangent = Float3::Normalize(Float3::Cross(up, normal));
+            Float3 bitangent = Float3::Cross(normal, tangent);
+            for(uint64 i = 0; i < chart.VertexIndices.size(); ++i)
+            {
+                const Float3& position = vertices[chart.VertexIndices[i]].Position;
+                chart.Coords[i] = Float2(Float3::Dot(position, tangent), Float3::Dot(position, bitangent));
+            }
+
+            chart.CoordArea = 0.0f;
+            reprojected[meshChartIdx] = true;
+            ++numReprojectedCharts;
+        }
+
+        for(uint32 triIdx = 0; triIdx < numTriangles; ++triIdx)
+        {
+            const uint32 idx0 = GetIndex(indices, triIdx * 3 + 0, indexSize);
+            if(reprojected[vertexCharts[idx0]] == false)
+                continue;
+
+            Chart& chart = charts[firstChart + vertexCharts[idx0]];
+            const uint32 idx1 = GetIndex(indices, triIdx * 3 + 1, indexSize);
+            const uint32 idx2 = GetIndex(indices, triIdx * 3 + 2, indexSize);
+            const Float2& uv0 = chart.Coords[localIndices[idx0]];
+            const Float2& uv1 = chart.Coords[localIndices[idx1]];
+            const Float2& uv2 = chart.Coords[localIndices[idx2]];
+            chart.CoordArea += 0.5f * std::abs(Cross2D(uv1 - uv0, uv2 - uv0));
+        }
+
+        for(uint64 chartIdx = firstChart; chartIdx < charts.size(); ++chartIdx)
+        {
+            Chart& chart = charts[chartIdx];
+            chart.MinCoord = chart.Coords[0];
+            chart.MaxCoord = chart.Coords[0];
+            for(uint64 i = 1; i < chart.Coords.size(); ++i)
+            {
+                chart.MinCoord.x = std::min(chart.MinCoord.x, chart.Coords[i].x);
+                chart.MinCoord.y = std::min(chart.MinCoord.y, chart.Coords[i].y);
+                chart.MaxCoord.x = std::max(chart.MaxCoord.x, chart.Coords[i].x);
+                chart.MaxCoord.y = std::max(chart.MaxCoord.y, chart.Coords[i].y);
+            }
+        }
+    }
+}
+
+LightMapPackStats LightMapPacker::Pack(ID3D11Device* device, const LightMapPackParams& params)
+{
+    Assert_(model != nullptr);
+    Assert_(params.AtlasSize > 2 * params.Padding);
+
+    Timer timer;
+    PrintString("Packing light map charts...");
+
+    LightMapPackStats stats;
+    stats.NumCharts = charts.size();
+    stats.NumReprojectedCharts = numReprojectedCharts;
+    if(charts.size() == 0)
+        return stats;
+
+    const uint64 numCharts = charts.size();
+    const uint32 atlasSize = params.AtlasSize;
+    const uint32 padding = params.Padding;
+    const float maxChartExtent = float(atlasSize - 2 * padding);
+
+    // Scale factor from chart coordinates to texels, for a density of 1 texel per unit
+    std::vector<float> baseScales(numCharts);
+    for(uint64 i = 0; i < numCharts; ++i)
+    {
+        const Chart& chart = charts[i];
+        float meshScale = 1.0f;
+        if(chart.MeshIdx < params.MeshDensityScales.size())
+            meshScale = params.MeshDensityScales[chart.MeshIdx];
+        baseScales[i] = chart.CoordArea > 0.0f ? std::sqrt(chart.WorldArea / chart.CoordArea) * meshScale : 0.0f;
+    }
+
+    // Charts are packed in groups. Everything shares one group when there's only a single page,
+    // otherwise each mesh gets its own group so that a mesh never straddles two pages.
+    const uint32 maxPages = std::max<uint32>(params.MaxPages, 1);
+    std::vector<std::vector<uint32>> groups(maxPages > 1 ? model->Meshes().size() : 1);
+    for(uint64 i = 0; i < numCharts; ++i)
+        groups[maxPages > 1 ? charts[i].MeshIdx : 0].push_back(uint32(i));
+
+    std::vector<float> scales(numCharts);
+    std::vector<bool> rotated(numCharts);
+    std::vector<Uint2> rectSizes(numCharts);
+    std::vector<Uint2> rectPositions(numCharts);
+    std::vector<uint32> chartPages(numCharts);
+    std::vector<uint64> groupAreas(groups.size());
+    std::vector<uint32> groupOrder(groups.size());
+    std::vector<std::vector<SkylineNode>> pageSkylines;
+
+    float density = params.TexelDensity;
+    for(uint64 attempt = 0; attempt < MaxPackAttempts && stats.Packed == false; ++attempt, density *= PackShrinkFactor)
+    {
+        stats.NumOversizedCharts = 0;
+        for(uint64 i = 0; i < numCharts; ++i)
+        {
+            const Chart& chart = charts[i];
+            Float2 extent = (chart.MaxCoord - chart.MinCoord) * baseScales[i] * density;
+            scales[i] = baseScales[i] * density;
+
+            // Charts that won't fit in the atlas are clamped to its size
+            const float largestExtent = std::max(extent.x, extent.y);
+            if(largestExtent > maxChartExtent)
+            {
+                const float clampScale = maxChartExtent / largestExtent;
+                scales[i] *= clampScale;
+                extent *= clampScale;
+                ++stats.NumOversizedCharts;
+            }
+
+            // Lay the chart down on its longest side, which helps the skyline stay flat
+            rotated[i] = extent.y > extent.x;
+            if(rotated[i])
+                Swap(extent.x, extent.y);
+
+            rectSizes[i].x = std::min(uint32(std::ceil(extent.x)), uint32(maxChartExtent)) + 2 * padding;
+            rectSizes[i].y = std::min(uint32(std::ceil(extent.y)), uint32(maxChartExtent)) + 2 * padding;
+        }
+
+        for(uint64 groupIdx = 0; groupIdx < groups.size(); ++groupIdx)
+        {
+            std::vector<uint32>& group = groups[groupIdx];
+            std::sort(group.begin(), group.end(), [&rectSizes](uint32 a, uint32 b)
+            {
+                if(rectSizes[a].y != rectSizes[b].y)
+                    return rectSizes[a].y > rectSizes[b].y;
+                return rectSizes[a].x > rectSizes[b].x;
+            });
+
+            groupAreas[groupIdx] = 0;
+            for(uint64 i = 0; i < group.size(); ++i)
+                groupAreas[groupIdx] += uint64(rectSizes[group[i]].x) * rectSizes[group[i]].y;
+            groupOrder[groupIdx] = uint32(groupIdx);
+        }
+
+        std::sort(groupOrder.begin(), groupOrder.end(), [&groupAreas](uint32 a, uint32 b)
+        {
+            return groupAreas[a] > groupAreas[b];
+        });
+
+        // Put each group on the first page that can hold all of its charts, opening up new pages as needed
+        pageSkylines.clear();
+        stats.Packed = true;
+        for(uint64 i = 0; i < groupOrder.size() && stats.Packed; ++i)
+        {
+            const std::vector<uint32>& group = groups[groupOrder[i]];
+            if(group.size() == 0)
+                continue;
+
+            bool placed = false;
+            for(uint64 pageIdx = 0; pageIdx < maxPages && placed == false; ++pageIdx)
+            {
+                if(pageIdx == pageSkylines.size())
+                {
+                    SkylineNode rootNode;
+                    rootNode.Width = atlasSize;
+                    pageSkylines.push_back(std::vector<SkylineNode>(1, rootNode));
+                }
+
+                std::vector<SkylineNode> skyline = pageSkylines[pageIdx];
+                placed = true;
+                for(uint64 groupChartIdx = 0; groupChartIdx < group.size(); ++groupChartIdx)
+                {
+                    const uint32 chartIdx = group[groupChartIdx];
+                    uint32 x = 0;
+                    uint32 y = 0;
+                    uint64 nodeIdx = 0;
+                    if(SkylineFindPosition(skyline, rectSizes[chartIdx].x, rectSizes[chartIdx].y, atlasSize, x, y, nodeIdx) == false)
+                    {
+                        placed = false;
+                        break;
+                    }
+
+                    SkylineAddRect(skyline, nodeIdx, x, y, rectSizes[chartIdx].x, rectSizes[chartIdx].y);
+                    rectPositions[chartIdx] = Uint2(x, y);
+                    chartPages[chartIdx] = uint32(pageIdx);
+                }
+
+                if(placed)
+                    pageSkylines[pageIdx] = skyline;
+                else if(pageSkylines[pageIdx].size() == 1 && pageSkylines[pageIdx][0].Y == 0)
+                {
+                    // The group doesn't even fit on an empty page, so there's no point in trying another one
+                    pageSkylines.pop_back();
+                    break;
+                }
+            }
+
+            stats.Packed = placed;
+        }
+
+        if(stats.Packed)
+            stats.TexelDensity = density;
+    }
+
+    if(stats.Packed == false)
+    {
+        PrintString("Failed to pack %llu light map charts into %u %ux%u pages, using the authored light map UVs",
+                    numCharts, maxPages, atlasSize, atlasSize);
+        Restore(device);
+        return stats;
+    }
+
+    // Each page only needs to be large enough to hold its charts (rounded up to a whole number of bake groups)
+    pageSizes.clear();
+    pageSizes.resize(pageSkylines.size(), 0);
+    for(uint64 i = 0; i < numCharts; ++i)
+    {
+        const uint32 chartEnd = std::max(rectPositions[i].x + rectSizes[i].x, rectPositions[i].y + rectSizes[i].y);
+        pageSizes[chartPages[i]] = std::max(pageSizes[chartPages[i]], chartEnd);
+    }
+
+    for(uint64 pageIdx = 0; pageIdx < pageSizes.size(); ++pageIdx)
+        pageSizes[pageIdx] = std::min(((pageSizes[pageIdx] + 7) / 8) * 8, atlasSize);
+
+    // Write out the new light map UV's. The integer part of U selects the page.
+    uint64 coveredTexels = 0;
+    std::vector<Mesh>& meshes = model->Meshes();
+    for(uint64 i = 0; i < numCharts; ++i)
+    {
+        const Chart& chart = charts[i];
+        Vertex* vertices = reinterpret_cast<Vertex*>(meshes[chart.MeshIdx].Vertices());
+        const Float2 chartStart = Float2(float(rectPositions[i].x + padding), float(rectPositions[i].y + padding));
+        const Float2 pageOffset = Float2(float(chartPages[i]), 0.0f);
+        const float chartHeight = (chart.MaxCoord.y - chart.MinCoord.y) * scales[i];
+        for(uint64 vtxIdx = 0; vtxIdx < chart.VertexIndices.size(); ++vtxIdx)
+        {
+            Float2 texelPos = (chart.Coords[vtxIdx] - chart.MinCoord) * scales[i];
+            if(rotated[i])
+                texelPos = Float2(chartHeight - texelPos.y, texelPos.x);
+
+            vertices[chart.VertexIndices[vtxIdx]].LightMapUV = (chartStart + texelPos) / float(atlasSize) + pageOffset;
+        }
+
+        coveredTexels += uint64(rectSizes[i].x) * rectSizes[i].y;
+    }
+
+    for(uint64 meshIdx = 0; meshIdx < meshes.size(); ++meshIdx)
+        meshes[meshIdx].UpdateBuffers(device);
+
+    uint64 pageTexels = 0;
+    for(uint64 pageIdx = 0; pageIdx < pageSizes.size(); ++pageIdx)
+        pageTexels += uint64(pageSizes[pageIdx]) * pageSizes[pageIdx];
+
+    stats.NumPages = pageSizes.size();
+    stats.Coverage = coveredTexels / float(pageTexels);
+
+    timer.Update();
+    PrintString("Packed %llu charts (%llu oversized) into %llu pages at %f texels per unit, %.1f%% coverage (%fs)",
+                stats.NumCharts, stats.NumOversizedCharts, stats.NumPages, stats.TexelDensity,
+                stats.Coverage * 100.0f, timer.DeltaSecondsF());
+
+    return stats;
+}
+
+// Puts back the light map UV's that the model was loaded with
+void LightMapPacker::Restore(ID3D11Device* device)
+{
+    Assert_(model != nullptr);
+
+    pageSizes.clear();
+
+    std::vector<Mesh>& meshes = model->Meshes();
+    for(uint64 meshIdx = 0; meshIdx < meshes.size(); ++meshIdx)
+    {
+        Vertex* vertices = reinterpret_cast<Vertex*>(meshes[meshIdx].Vertices());
+        for(uint64 i = 0; i < meshes[meshIdx].NumVertices(); ++i)
+            vertices[i].LightMapUV = authoredUVs[meshIdx][i];
+
+        meshes[meshIdx].UpdateBuffers(device);
+    }
+}
@@ -0,0 +1,85 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+#include <SF11_Math.h>
+
+namespace SampleFramework11
+{
+    class Model;
+}
+
+using namespace SampleFramework11;
+
+// Parameters for packing the light map charts of a model into a single atlas
+struct LightMapPackParams
+{
+    uint32 AtlasSize = 256;             // Width and height of the atlas, in texels
+    float TexelDensity = 16.0f;         // Target number of texels per world-space unit
+    uint32 Padding = 2;                 // Number of gutter texels on each side of a chart
+    uint32 MaxPages = 1;                // Maximum number of atlas pages that meshes can be spread across
+
+    // Optional per-mesh multiplier for the texel density, indexed by mesh
+    std::vector<float> MeshDensityScales;
+};
+
+// Info about the result of packing the light map charts
+struct LightMapPackStats
+{
+    uint64 NumCharts = 0;
+    uint64 NumOversizedCharts = 0;
+    uint64 NumReprojectedCharts = 0;
+    uint64 NumPages = 0;
+    float TexelDensity = 0.0f;          // The density that was actually used, after shrinking to fit
+    float Coverage = 0.0f;              // Fraction of the atlas covered by chart rectangles
+    bool Packed = false;                // False if the charts couldn't be fit into the atlas
+};
+
+// Segments each mesh of a model into charts, scales the charts according to their world-space
+// area and a target texel density, and packs them into one or more atlas pages. The resulting
+// UV's replace the light map UV's of the model, with the page index stored in the integer part
+// of U. The originally-authored UV's are kept around, so that the charts can be re-packed with
+// different parameters or restored.
+class LightMapPacker
+{
+
+public:
+
+    void Initialize(Model* model);
+
+    LightMapPackStats Pack(ID3D11Device* device, const LightMapPackParams& params);
+    void Restore(ID3D11Device* device);
+
+    // The size of each page from the last successful pack, or empty if the authored UV's are in use
+    const std::vector<uint32>& PageSizes() const { return pageSizes; }
+
+private:
+
+    struct Chart
+    {
+        uint64 MeshIdx = 0;
+        std::vector<uint32> VertexIndices;
+        std::vector<Float2> Coords;         // Chart-space coordinates, one for each vertex index
+        Float2 MinCoord;
+        Float2 MaxCoord;
+        float WorldArea = 0.0f;
+        float CoordArea = 0.0f;
+    };
+
+    void BuildCharts();
+
+    Model* model = nullptr;
+    std::vector<std::vector<Float2>> authoredUVs;
+    std::vector<Chart> charts;
+    uint64 numReprojectedCharts = 0;
+    std::vector<uint32> pageSizes;
+};
@@ -14,6 +14,9 @@
 cbuffer Constants : register(b0)
 {
     uint VertexOffset;
+    float LightMapPage;
+    float2 RegionOffset;
+    float RegionScale;
 }
 
 //=================================================================================================
@@ -63,8 +66,13 @@ VSOutput VS(in VSInput input)
 {
     VSOutput output;
 
-    // Calc the clip-space position based on the lightmap texture coordinates
-    output.PositionCS = float4((input.LightMapUV * 2.0f - 1.0f) * float2(1.0f, -1.0f), 1.0f, 1.0f);
+    // Calc the clip-space position based on the lightmap texture coordinates. The page index is
+    // stored in the integer part of U, so shift the current page into [0, 1]. Triangles belonging
+    // to other pages end up outside of the viewport. The region offset and scale then map the
+    // part of the page that's being rasterized (the whole page, or a single tile) to the viewport.
+    float2 lightMapUV = float2(input.LightMapUV.x - LightMapPage, input.LightMapUV.y);
+    lightMapUV = (lightMapUV - RegionOffset) * RegionScale;
+    output.PositionCS = float4((lightMapUV * 2.0f - 1.0f) * float2(1.0f, -1.0f), 1.0f, 1.0f);
 
 	// Pass along the vertex data
 	output.PositionWS = input.Position;
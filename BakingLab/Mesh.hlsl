@@ -53,6 +53,8 @@ cbuffer PSConstants : register(b0)
     float2 JitterOffset;
     float4 SGDirections[MaxSGCount];
     float SGSharpness;
+    uint LightMapBasisCount;
+    uint LightMapPageCount;
 }
 
 //=================================================================================================
@@ -121,6 +123,18 @@ struct PSOutput
     float2 Velocity             : SV_Target1;
 };
 
+//=================================================================================================
+// Light map sampling
+//=================================================================================================
+
+// Light map pages are stored in the integer part of U, and each page has one array slice per basis.
+// Authored UV's can be slightly outside of [0, 1], so both the page and the U within it are clamped.
+float3 LightMapCoord(in float2 lightMapUV, in uint basisIdx)
+{
+    float page = clamp(floor(lightMapUV.x), 0.0f, LightMapPageCount - 1.0f);
+    return float3(saturate(lightMapUV.x - page), lightMapUV.y, page * LightMapBasisCount + basisIdx);
+}
+
 //=================================================================================================
 // Vertex Shader
 //=================================================================================================
@@ -319,7 +333,7 @@ void ComputeSGContribution(in Texture2DArray<float4> bakedLightingMap, in float2
     for(uint i = 0; i < numSGs; ++i)
     {
         SG sg;
-        sg.Amplitude = bakedLightingMap.SampleLevel(LinearSampler, float3(lightMapUV, i), 0.0f).xyz;
+        sg.Amplitude = bakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(lightMapUV, i), 0.0f).xyz;
         sg.Axis = SGDirections[i].xyz;
         sg.Sharpness = SGSharpness;
 
@@ -625,7 +639,7 @@ PSOutput PS(in PSInput input)
 
         if(BakeMode == BakeModes_Diffuse)
         {
-            indirectIrradiance = BakedLightingMap.SampleLevel(LinearSampler, float3(input.LightMapUV, 0.0f), 0.0f).xyz * Pi;
+            indirectIrradiance = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(input.LightMapUV, 0), 0.0f).xyz * Pi;
         }
         else if(BakeMode == BakeModes_HL2)
         {
@@ -641,14 +655,14 @@ PSOutput PS(in PSInput input)
             [unroll]
             for(uint i = 0; i < 3; ++i)
             {
-                float3 lightMap = BakedLightingMap.SampleLevel(LinearSampler, float3(input.LightMapUV, i), 0.0f).xyz;
+                float3 lightMap = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(input.LightMapUV, i), 0.0f).xyz;
                 indirectIrradiance += saturate(dot(normalTS, BasisDirs[i])) * lightMap;
             }
         }
 		else if (BakeMode == BakeModes_Directional)
 		{
-			float3 lightMapColor = BakedLightingMap.SampleLevel(LinearSampler, float3(input.LightMapUV, 0), 0.0f).xyz * Pi;
-			float4 lightmapDirection = BakedLightingMap.SampleLevel(LinearSampler, float3(input.LightMapUV, 1), 0.0f).xyzw;
+			float3 lightMapColor = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(input.LightMapUV, 0), 0.0f).xyz * Pi;
+			float4 lightmapDirection = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(input.LightMapUV, 1), 0.0f).xyzw;
 
 			float rebalancingCoefficient = max(lightmapDirection.w, 0.0001);
 
@@ -665,7 +679,7 @@ PSOutput PS(in PSInput input)
 
             [unroll]
             for(uint i = 0; i < 4; ++i)
-                shRadiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, float3(input.LightMapUV, i), 0.0f).xyz;
+                shRadiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(input.LightMapUV, i), 0.0f).xyz;
 
             if(SH4DiffuseMode == SH4DiffuseModes_Geomerics)
                 indirectIrradiance = EvalSH4IrradianceGeomerics(normalSHSG, shRadiance);
@@ -687,7 +701,7 @@ PSOutput PS(in PSInput input)
 
             [unroll]
             for(uint i = 0; i < 9; ++i)
-                shRadiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, float3(input.LightMapUV, i), 0.0f).xyz;
+                shRadiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(input.LightMapUV, i), 0.0f).xyz;
 
             indirectIrradiance = EvalSH9Irradiance(normalSHSG, shRadiance);
 
@@ -706,7 +720,7 @@ PSOutput PS(in PSInput input)
 
             [unroll]
             for(uint i = 0; i < 4; ++i)
-                hbIrradiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, float3(input.LightMapUV, i), 0.0f).xyz;
+                hbIrradiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(input.LightMapUV, i), 0.0f).xyz;
 
             indirectIrradiance = EvalH4(normalTS, hbIrradiance);
         }
@@ -716,7 +730,7 @@ PSOutput PS(in PSInput input)
 
             [unroll]
             for(uint i = 0; i < 6; ++i)
-                hbIrradiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, float3(input.LightMapUV, i), 0.0f).xyz;
+                hbIrradiance.c[i] = BakedLightingMap.SampleLevel(LinearSampler, LightMapCoord(input.LightMapUV, i), 0.0f).xyz;
 
             indirectIrradiance = EvalH6(normalTS, hbIrradiance);
         }
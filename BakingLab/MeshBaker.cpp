@@ -21,12 +21,16 @@
 #include <Graphics/Skybox.h>
 #include <Graphics/Camera.h>
 #include <Graphics/Textures.h>
+#include <Graphics/EXRWriter.h>
 #include <Graphics/BRDF.h>
 #include <Graphics/Sampling.h>
+#include <ThreadPool.h>
 
 #include "AppSettings.h"
 #include "SG.h"
 #include "PathTracer.h"
+#include "Tracer.h"
+#include "BVHCache.h"
 
 // Suppress vs2013: "new behavior: elements of array 'array' will be default initialized"
 #pragma warning(disable : 4351)
@@ -35,12 +39,23 @@ static const uint64 TileSize = 16;
 static const uint64 BakeGroupSizeX = 8;
 static const uint64 BakeGroupSizeY = 8;
 static const uint64 BakeGroupSize = BakeGroupSizeX * BakeGroupSizeY;
+static const uint64 MaxBakeBatchRunLength = 16;     // Consecutive batches that a bake thread claims at once
+
+// Relightable bakes
+static const float RelightInterval = 0.5f;          // Seconds between re-lighting a running bake
+static const uint64 RelightSkySamplesX = 64;
+static const uint64 RelightSkySamplesY = 32;
+
+// Area light sample reuse
+static const float ReuseNormalThreshold = 0.9f;     // Minimum cosine between the normals of neighbors that share samples
+static const float ReusePlaneThreshold = 0.25f;     // Maximum offset from the texel's plane, relative to the distance
 
 // Info about a gutter texel
 struct GutterTexel
 {
     Uint2 TexelPos;
     Uint2 NeighborPos;
+    uint32 PageIdx = 0;
 };
 
 // Returns the final monte-carlo weighting factor using the PDF of a cosine-weighted hemisphere
@@ -419,6 +434,7 @@ template<uint64 SGCount> struct SGBaker
     FixedArray<Float3> Samples;
     SG ProjectedResult[SGCount];
     float RunningAverageWeights[SGCount] = { };
+    const SG* InitialLobes = nullptr;   // Uses the solver's initial guess if null
 
     void Init(uint64 numSamples, Float4 prevResult[BasisCount])
     {
@@ -430,7 +446,7 @@ template<uint64 SGCount> struct SGBaker
         if(NumSamples != Samples.Size())
             Samples.Init(NumSamples);
 
-        const SG* initialGuess = InitialGuess();
+        const SG* initialGuess = InitialLobes != nullptr ? InitialLobes : InitialGuess();
         for(uint64 i = 0; i < SGCount; ++i)
             ProjectedResult[i] = initialGuess[i];
 
@@ -474,7 +490,11 @@ template<uint64 SGCount> struct SGBaker
         params.XSamples = SampleDirs.Data();
         params.YSamples = Samples.Data();
         params.NumSamples = NumSamples;
-        SolveSGs(params);
+        params.InitialGuess = InitialLobes;
+        {
+            TraceSpan solveSpan("SG Solve");
+            SolveSGs(params);
+        }
 
         for(uint64 i = 0; i < SGCount; ++i)
             bakeOutput[i] = Float4(Float3::Clamp(sgLobes[i].Amplitude, 0.0f, FP16Max), 1.0f);
@@ -506,6 +526,395 @@ typedef SGBaker<6> SG6Baker;
 typedef SGBaker<9> SG9Baker;
 typedef SGBaker<12> SG12Baker;
 
+// Bakes every bake mode at once, by running each sample through one baker per mode. The results
+// of all modes are stored back-to-back in the same order as BakeModes, so that a single bake can
+// be viewed and compared in any of them. All modes except for Diffuse integrate uniformly
+// distributed samples, so the diffuse samples are weighted by 2 * cos(theta) to cancel out the
+// uniform PDF instead of tracing a separate set of cosine-weighted rays for them. Direct area light
+// samples are already irradiance / Pi, so they go through AddDirectSample() without that weight.
+struct MultiBasisBaker
+{
+    static const uint64 DiffuseOffset = 0;
+    static const uint64 DirectionalOffset = DiffuseOffset + DiffuseBaker::BasisCount;
+    static const uint64 HL2Offset = DirectionalOffset + DirectionalBaker::BasisCount;
+    static const uint64 SH4Offset = HL2Offset + HL2Baker::BasisCount;
+    static const uint64 SH9Offset = SH4Offset + SH4Baker::BasisCount;
+    static const uint64 H4Offset = SH9Offset + SH9Baker::BasisCount;
+    static const uint64 H6Offset = H4Offset + H4Baker::BasisCount;
+    static const uint64 SG5Offset = H6Offset + H6Baker::BasisCount;
+    static const uint64 SG6Offset = SG5Offset + SG5Baker::BasisCount;
+    static const uint64 SG9Offset = SG6Offset + SG6Baker::BasisCount;
+    static const uint64 SG12Offset = SG9Offset + SG9Baker::BasisCount;
+    static const uint64 BasisCount = SG12Offset + SG12Baker::BasisCount;
+
+    DiffuseBaker Diffuse;
+    DirectionalBaker Directional;
+    HL2Baker HL2;
+    SH4Baker SH4;
+    SH9Baker SH9;
+    H4Baker H4;
+    H6Baker H6;
+    SG5Baker SG5;
+    SG6Baker SG6;
+    SG9Baker SG9;
+    SG12Baker SG12;
+
+    // Returns the index of the first result of a bake mode
+    static uint64 BasisOffset(BakeModes bakeMode)
+    {
+        static const uint64 Offsets[] = { DiffuseOffset, DirectionalOffset, HL2Offset, SH4Offset, SH9Offset, H4Offset,
+                                          H6Offset, SG5Offset, SG6Offset, SG9Offset, SG12Offset };
+        StaticAssert_(ArraySize_(Offsets) == uint64(BakeModes::NumValues));
+        return Offsets[uint64(bakeMode)];
+    }
+
+    MultiBasisBaker()
+    {
+        // The lobes of every SG count are generated up-front by InitializeMultiSGSolver()
+        SG5.InitialLobes = InitialGuess(SG5Baker::BasisCount);
+        SG6.InitialLobes = InitialGuess(SG6Baker::BasisCount);
+        SG9.InitialLobes = InitialGuess(SG9Baker::BasisCount);
+        SG12.InitialLobes = InitialGuess(SG12Baker::BasisCount);
+    }
+
+    void Init(uint64 numSamples, Float4 prevResult[BasisCount])
+    {
+        Diffuse.Init(numSamples, prevResult + DiffuseOffset);
+        Directional.Init(numSamples, prevResult + DirectionalOffset);
+        HL2.Init(numSamples, prevResult + HL2Offset);
+        SH4.Init(numSamples, prevResult + SH4Offset);
+        SH9.Init(numSamples, prevResult + SH9Offset);
+        H4.Init(numSamples, prevResult + H4Offset);
+        H6.Init(numSamples, prevResult + H6Offset);
+        SG5.Init(numSamples, prevResult + SG5Offset);
+        SG6.Init(numSamples, prevResult + SG6Offset);
+        SG9.Init(numSamples, prevResult + SG9Offset);
+        SG12.Init(numSamples, prevResult + SG12Offset);
+    }
+
+    Float3 SampleDirection(Float2 samplePoint)
+    {
+        return SampleDirectionHemisphere(samplePoint.x, samplePoint.y);
+    }
+
+    void AddSample(Float3 sampleDirTS, uint64 sampleIdx, Float3 sample, Float3 sampleDirWS, Float3 normal)
+    {
+        const float cosineWeight = 2.0f * Saturate(sampleDirTS.z);
+        Diffuse.AddSample(sampleDirTS, sampleIdx, sample * cosineWeight, sampleDirWS, normal);
+        AddDirectionalSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+    }
+
+    void AddDirectSample(Float3 sampleDirTS, uint64 sampleIdx, Float3 sample, Float3 sampleDirWS, Float3 normal)
+    {
+        Diffuse.AddSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+        AddDirectionalSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+    }
+
+    // Runs a sample through every baker except for Diffuse
+    void AddDirectionalSample(Float3 sampleDirTS, uint64 sampleIdx, Float3 sample, Float3 sampleDirWS, Float3 normal)
+    {
+        Directional.AddSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+        HL2.AddSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+        SH4.AddSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+        SH9.AddSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+        H4.AddSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+        H6.AddSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+        SG5.AddSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+        SG6.AddSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+        SG9.AddSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+        SG12.AddSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+    }
+
+    void FinalResult(Float4 bakeOutput[BasisCount])
+    {
+        Diffuse.FinalResult(bakeOutput + DiffuseOffset);
+        Directional.FinalResult(bakeOutput + DirectionalOffset);
+        HL2.FinalResult(bakeOutput + HL2Offset);
+        SH4.FinalResult(bakeOutput + SH4Offset);
+        SH9.FinalResult(bakeOutput + SH9Offset);
+        H4.FinalResult(bakeOutput + H4Offset);
+        H6.FinalResult(bakeOutput + H6Offset);
+        SG5.FinalResult(bakeOutput + SG5Offset);
+        SG6.FinalResult(bakeOutput + SG6Offset);
+        SG9.FinalResult(bakeOutput + SG9Offset);
+        SG12.FinalResult(bakeOutput + SG12Offset);
+    }
+
+    // Multi-basis bakes always compute the final result of each texel, since the directional mode
+    // and the SG solves can't be integrated progressively
+    void ProgressiveResult(Float4 bakeOutput[BasisCount], uint64 passIdx)
+    {
+    }
+};
+
+// Adds either a path traced radiance sample or a direct area light sample to a baker. Only the
+// multi-basis baker needs to tell the two apart.
+template<typename TBaker> static void AddBakeSample(TBaker& baker, bool directSample, Float3 sampleDirTS, uint64 sampleIdx,
+                                                    Float3 sample, Float3 sampleDirWS, Float3 normal)
+{
+    baker.AddSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+}
+
+static void AddBakeSample(MultiBasisBaker& baker, bool directSample, Float3 sampleDirTS, uint64 sampleIdx,
+                          Float3 sample, Float3 sampleDirWS, Float3 normal)
+{
+    if(directSample)
+        baker.AddDirectSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+    else
+        baker.AddSample(sampleDirTS, sampleIdx, sample, sampleDirWS, normal);
+}
+
+// Checks that the Diffuse result of a multi-basis bake converges to the same irradiance as a standalone
+// Diffuse bake when half of the samples go to an area light, like they do in BakeGroupBatch()
+bool CheckMultiBasisDiffuse()
+{
+    static const uint64 SqrtNumSamples = 128;
+    static const uint64 NumSamples = SqrtNumSamples * SqrtNumSamples;
+
+    // The radiance varies over the hemisphere, and integrates to an irradiance / Pi of (1.0, 0.5, 0.25).
+    // Both it and the area light samples are doubled for splitting the samples between them.
+    const Float3 pathIrradiance = Float3(1.0f, 0.5f, 0.25f);
+    const Float3 areaLightIrradiance = Float3(0.5f, 0.25f, 1.0f);
+    const Float3 expected = pathIrradiance + areaLightIrradiance;
+
+    DiffuseBaker diffuseBaker;
+    MultiBasisBaker multiBasisBaker;
+    Float4 diffuseResult[DiffuseBaker::BasisCount];
+    Float4 multiBasisResults[MultiBasisBaker::BasisCount];
+    diffuseBaker.Init(NumSamples, diffuseResult);
+    multiBasisBaker.Init(NumSamples, multiBasisResults);
+
+    Random random;
+    random.SetSeed(1337);
+    for(uint64 sampleIdx = 0; sampleIdx < NumSamples; ++sampleIdx)
+    {
+        const Float2 samplePoint = Float2((sampleIdx % SqrtNumSamples + 0.5f) / SqrtNumSamples,
+                                          (sampleIdx / SqrtNumSamples + 0.5f) / SqrtNumSamples);
+        const Float3 diffuseDir = diffuseBaker.SampleDirection(samplePoint);
+        const Float3 multiBasisDir = multiBasisBaker.SampleDirection(samplePoint);
+        const Float3 normal = Float3(0.0f, 0.0f, 1.0f);
+
+        if(random.RandomFloat() >= 0.5f)
+        {
+            const Float3 sample = areaLightIrradiance * 2.0f;
+            AddBakeSample(diffuseBaker, true, diffuseDir, sampleIdx, sample, diffuseDir, normal);
+            AddBakeSample(multiBasisBaker, true, diffuseDir, sampleIdx, sample, diffuseDir, normal);
+        }
+        else
+        {
+            const Float3 diffuseSample = Float3(1.0f + diffuseDir.x, 0.5f + 0.5f * diffuseDir.y, 0.25f) * 2.0f;
+            const Float3 multiBasisSample = Float3(1.0f + multiBasisDir.x, 0.5f + 0.5f * multiBasisDir.y, 0.25f) * 2.0f;
+            AddBakeSample(diffuseBaker, false, diffuseDir, sampleIdx, diffuseSample, diffuseDir, normal);
+            AddBakeSample(multiBasisBaker, false, multiBasisDir, sampleIdx, multiBasisSample, multiBasisDir, normal);
+        }
+    }
+
+    diffuseBaker.FinalResult(diffuseResult);
+    multiBasisBaker.Diffuse.FinalResult(multiBasisResults + MultiBasisBaker::DiffuseOffset);
+
+    const Float3 diffuseValue = diffuseResult[0].To3D();
+    const Float3 multiBasisValue = multiBasisResults[MultiBasisBaker::DiffuseOffset].To3D();
+    bool passed = true;
+    for(uint32 i = 0; i < 3; ++i)
+    {
+        if(std::abs(diffuseValue[i] - expected[i]) > expected[i] * 0.02f)
+        {
+            PrintString("Diffuse bake converged to %f instead of %f", diffuseValue[i], expected[i]);
+            passed = false;
+        }
+
+        if(std::abs(multiBasisValue[i] - diffuseValue[i]) > diffuseValue[i] * 0.02f)
+        {
+            PrintString("Multi-basis Diffuse bake converged to %f instead of %f", multiBasisValue[i], diffuseValue[i]);
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+// Bakes probe radiance projected onto L2 SH over the full sphere of directions
+struct SH9ProbeBaker : public SH9Baker
+{
+    void Init(uint64 numSamples, Float4 prevResult[BasisCount], const SG* probeSGs)
+    {
+        SH9Baker::Init(numSamples, prevResult);
+    }
+
+    Float3 SampleDirection(Float2 samplePoint)
+    {
+        return SampleDirectionSphere(samplePoint.x, samplePoint.y);
+    }
+
+    void AddSample(Float3 sampleDir, uint64 sampleIdx, Float3 sample)
+    {
+        ResultSum += ProjectOntoSH9Color(sampleDir, sample);
+    }
+
+    void ProgressiveResult(Float4 bakeOutput[BasisCount], uint64 passIdx)
+    {
+        const float lerpFactor = passIdx / (passIdx + 1.0f);
+        for(uint64 i = 0; i < BasisCount; ++i)
+        {
+            Float3 newSample = ResultSum.Coefficients[i] * SphereMonteCarloFactor(1);
+            Float3 currValue = bakeOutput[i].To3D();
+            currValue = Lerp<Float3>(newSample, currValue, lerpFactor);
+            bakeOutput[i] = Float4(Float3::Clamp(currValue, -FP16Max, FP16Max), 1.0f);
+        }
+    }
+};
+
+// Bakes probe radiance into a set of SG lobes distributed over the full sphere. Probes are always
+// integrated progressively, so the lobes are fit with a running average and the per-lobe weights
+// are stored in the w component of the results.
+template<uint64 SGCount> struct SGProbeBaker : public SGBaker<SGCount>
+{
+    void Init(uint64 numSamples, Float4 prevResult[SGCount], const SG* probeSGs)
+    {
+        this->CurrSampleIdx = 0;
+        this->NumSamples = numSamples;
+
+        for(uint64 i = 0; i < SGCount; ++i)
+        {
+            this->ProjectedResult[i] = probeSGs[i];
+            this->ProjectedResult[i].Amplitude = prevResult[i].To3D();
+            this->RunningAverageWeights[i] = prevResult[i].w;
+        }
+    }
+
+    Float3 SampleDirection(Float2 samplePoint)
+    {
+        return SampleDirectionSphere(samplePoint.x, samplePoint.y);
+    }
+
+    void AddSample(Float3 sampleDir, uint64 sampleIdx, Float3 sample)
+    {
+        const bool nonNegative = AppSettings::SolveMode == SolveModes::RunningAverageNN;
+        SGRunningAverage(sampleDir, sample, this->ProjectedResult, SGCount, (float)sampleIdx,
+                         this->RunningAverageWeights, nonNegative);
+    }
+
+    void ProgressiveResult(Float4 bakeOutput[SGCount], uint64 passIdx)
+    {
+        for(uint64 i = 0; i < SGCount; ++i)
+            bakeOutput[i] = Float4(Float3::Clamp(this->ProjectedResult[i].Amplitude, -FP16Max, FP16Max),
+                                   this->RunningAverageWeights[i]);
+    }
+};
+
+typedef SGProbeBaker<6> SG6ProbeBaker;
+typedef SGProbeBaker<9> SG9ProbeBaker;
+typedef SGProbeBaker<12> SG12ProbeBaker;
+
+void BakeResultStorage::Init(uint64 lightMapSize_, uint64 basisCount_, BakeResultLayouts layout_, BakeResultFormats format_)
+{
+    StaticAssert_(TileSizeX == BakeGroupSizeX && TileSizeY == BakeGroupSizeY);
+    Assert_(basisCount_ <= AppSettings::MaxBasisCount || basisCount_ == MultiBasisBaker::BasisCount);
+
+    lightMapSize = lightMapSize_;
+    basisCount = basisCount_;
+    layout = layout_;
+    format = format_;
+
+    // The tiled layout pads the light map out to a multiple of the tile size, so that every tile
+    // (and thus every bake group) occupies one contiguous block of memory
+    numTilesX = (lightMapSize + (TileSizeX - 1)) / TileSizeX;
+    const uint64 numTilesY = (lightMapSize + (TileSizeY - 1)) / TileSizeY;
+    const uint64 numTexels = layout == BakeResultLayouts::Tiled ? numTilesX * numTilesY * TileSize
+                                                                : lightMapSize * lightMapSize;
+    basisStride = layout == BakeResultLayouts::PerBasis ? numTexels : 1;
+    numElements = numTexels * basisCount;
+
+    if(format == BakeResultFormats::Half4)
+        elementSize = sizeof(Half4);
+    else if(format == BakeResultFormats::Float3)
+        elementSize = sizeof(Float3);
+    else
+        elementSize = sizeof(Float4);
+
+    data.Init(numElements * elementSize);
+    Clear();
+}
+
+void BakeResultStorage::Clear()
+{
+    if(data.Size() > 0)
+        memset(data.Data(), 0, data.Size());
+}
+
+void BakeResultStorage::Shutdown()
+{
+    data.Shutdown();
+    lightMapSize = 0;
+    basisCount = 0;
+    numTilesX = 0;
+    numElements = 0;
+    elementSize = 0;
+    basisStride = 0;
+}
+
+// Bilinearly filters the irradiance of the 4 nearest texels, skipping over texels that weren't baked
+Float3 LightMapIrradiance::Sample(Float2 lightMapUV) const
+{
+    if(Pages == nullptr || NumPages == 0)
+        return 0.0f;
+
+    // The integer part of the U coordinate is the page index, clamped like in the shaders
+    const float pageCoord = Clamp(std::floor(lightMapUV.x), 0.0f, float(NumPages - 1));
+    const BakeResultStorage& page = Pages[uint64(pageCoord)];
+    const int64 pageSize = int64(page.LightMapSize());
+
+    const float x = Saturate(lightMapUV.x - pageCoord) * LightMapSize - 0.5f;
+    const float y = lightMapUV.y * LightMapSize - 0.5f;
+    const float x0 = std::floor(x);
+    const float y0 = std::floor(y);
+    const float fracX = x - x0;
+    const float fracY = y - y0;
+
+    Float3 irradiance;
+    float weightSum = 0.0f;
+    for(int64 offsetY = 0; offsetY < 2; ++offsetY)
+    {
+        for(int64 offsetX = 0; offsetX < 2; ++offsetX)
+        {
+            const int64 texelX = int64(x0) + offsetX;
+            const int64 texelY = int64(y0) + offsetY;
+            if(texelX < 0 || texelY < 0 || texelX >= pageSize || texelY >= pageSize)
+                continue;
+
+            const Float4 texel = page.Load(page.TexelOffset(texelX, texelY), 0);
+            const float weight = (offsetX ? fracX : 1.0f - fracX) * (offsetY ? fracY : 1.0f - fracY) * texel.w;
+            irradiance += texel.To3D() * weight;
+            weightSum += weight;
+        }
+    }
+
+    return weightSum > 0.0f ? irradiance / weightSum : Float3(0.0f);
+}
+
+// Data passed to the bake thread entry point
+struct BakeThreadData
+{
+    BakeResultStorage* BakeOutput = nullptr;
+    BakeTile* BakeTiles = nullptr;
+    const std::vector<IntegrationSamples>* Samples = nullptr;
+    volatile int64* CurrBatch = nullptr;
+    Float4* ProbeOutput = nullptr;
+    volatile int64* CurrProbeBatch = nullptr;
+    volatile int64* NumFinishedProbeBatches = nullptr;
+    BakeCounters* Counters = nullptr;
+    BakeStatShard* Stats = nullptr;
+    RadianceCache* RadianceCache = nullptr;
+    BakeResultStorage* BounceResults = nullptr;
+    volatile int64* NumFinishedBounceBatches = nullptr;
+    BakeResultStorage* TransferResults = nullptr;
+    PathGuide* Guide = nullptr;
+    AreaLightReservoirs* Reservoirs = nullptr;
+    RadianceSampleStore* SampleStore = nullptr;
+    const MeshBaker* Baker = nullptr;
+    uint64 ThreadIdx = 0;
+};
+
 // Data used by the baking threads
 struct BakeThreadContext
 {
@@ -514,90 +923,358 @@ struct BakeThreadContext
     const BVHData* SceneBVH = nullptr;
     const TextureData<Half4>* EnvMaps = nullptr;
     const std::vector<BakePoint>* BakePoints = nullptr;
+    const uint32* BakeGroupOrder = nullptr;         // If non-null, maps the batches of a pass to bake groups
     uint64 CurrNumBatches = 0;
-    uint64 CurrLightMapSize = 0;
+    uint64 CurrNumPages = 0;
+    uint64 CurrNumBakeGroups = 0;
+    const BakePage* BakePages = nullptr;
+    BakeTile* BakeTiles = nullptr;
     BakeModes CurrBakeMode = BakeModes::Diffuse;
     SolveModes CurrSolveMode = SolveModes::NNLS;
+    bool32 MultiBasis = false;
     Random RandomGenerator;
     SampleModes CurrSampleMode = SampleModes::Random;
     uint64 CurrNumSamples = 0;
     const std::vector<IntegrationSamples>* Samples;
-    FixedArray<Float4>* BakeOutput = nullptr;
+    BakeResultStorage* BakeOutput = nullptr;
     volatile int64* CurrBatch = nullptr;
-
-    void Init(FixedArray<Float4>* bakeOutput, const std::vector<IntegrationSamples>* samples,
-              volatile int64* currBatch, const MeshBaker* meshBaker, uint64 newTag)
+    uint64 RunBatch = 0;                            // The next batch of the run that was claimed from CurrBatch
+    uint64 RunEndBatch = 0;
+    uint64 RunLength = 1;
+    ProbeGrid Probes;
+    ProbeBases CurrProbeBasis = ProbeBases::SH9;
+    const SG* ProbeSGs = nullptr;
+    uint64 CurrNumProbeGroups = 0;
+    uint64 CurrNumProbeBatches = 0;
+    Float4* ProbeOutput = nullptr;
+    volatile int64* CurrProbeBatch = nullptr;
+    volatile int64* NumFinishedProbeBatches = nullptr;
+    uint32 BakeSeed = 0;
+    BakeCounters* Counters = nullptr;
+    uint64 NumRays = 0;
+    uint64 NumPaths = 0;
+    BakeStatShard* Stats = nullptr;
+    RadianceCache* RadianceCache = nullptr;
+    const MeshBaker* Baker = nullptr;
+    bool32 IterativeBounces = false;
+    uint64 NumBouncePasses = 0;
+    uint64 NumBounceBatches = 0;
+    BakeResultStorage* BounceResults = nullptr;
+    volatile int64* NumFinishedBounceBatches = nullptr;
+    LightMapIrradiance BounceIrradiance[2];
+    LightMapIrradiance NoBounceIrradiance;
+    bool32 Relightable = false;
+    BakeResultStorage* TransferResults = nullptr;
+    PathGuide* Guide = nullptr;
+    bool32 GuideTraining = false;
+    uint64 NumGuideTrainingBatches = 0;
+    AreaLightReservoirs* Reservoirs = nullptr;
+    RadianceSampleStore* SampleStore = nullptr;
+
+    void Init(const BakeThreadData& threadData, uint64 newTag)
     {
+        const MeshBaker* meshBaker = threadData.Baker;
+        BakeTile* bakeTiles = threadData.BakeTiles;
+
         if(BakeTag == uint64(-1))
             RandomGenerator.SeedWithRandomValue();
 
         BakeTag = newTag;
         SkyCache.Init(AppSettings::SunDirection, AppSettings::GroundAlbedo, AppSettings::Turbidity);
-        SceneBVH = &meshBaker->sceneBVH;
+        SceneBVH = meshBaker->sceneBVH;
         EnvMaps = meshBaker->input.EnvMapData;
         BakePoints = &meshBaker->bakePoints;
         CurrNumBatches = meshBaker->currNumBakeBatches;
-        CurrLightMapSize = meshBaker->currLightMapSize;
+        CurrNumPages = meshBaker->currNumPages;
+        CurrNumBakeGroups = meshBaker->currNumBakeGroups;
+        BakeGroupOrder = nullptr;
+        if(AppSettings::SpatialBakeOrder && bakeTiles == nullptr
+           && meshBaker->bakeGroupOrder.size() == meshBaker->currNumBakeGroups)
+            BakeGroupOrder = meshBaker->bakeGroupOrder.data();
+        BakePages = bakeTiles ? &meshBaker->bakeTilePage : meshBaker->bakePages;
+        BakeTiles = bakeTiles;
         CurrBakeMode = meshBaker->currBakeMode;
         CurrSolveMode = meshBaker->currSolveMode;
-        BakeOutput = bakeOutput;
-        CurrBatch = currBatch;
+        MultiBasis = meshBaker->currMultiBasis;
+        BakeOutput = threadData.BakeOutput;
+        CurrBatch = threadData.CurrBatch;
+        RunBatch = 0;
+        RunEndBatch = 0;
         CurrSampleMode = AppSettings::BakeSampleMode;
         CurrNumSamples = AppSettings::NumBakeSamples;
-        Samples = samples;
+        Samples = threadData.Samples;
+
+        // Every thread needs a run of its own within each pass and sample index, or else two threads
+        // could end up working on the same group
+        RunLength = std::min(std::max<uint64>(CurrNumBakeGroups / Samples->size(), 1), MaxBakeBatchRunLength);
+        Probes = meshBaker->probeGrid;
+        CurrProbeBasis = meshBaker->currProbeBasis;
+        ProbeSGs = meshBaker->probeSGs;
+        CurrNumProbeGroups = meshBaker->currNumProbeGroups;
+        CurrNumProbeBatches = meshBaker->currNumProbeBatches;
+        ProbeOutput = threadData.ProbeOutput;
+        CurrProbeBatch = threadData.CurrProbeBatch;
+        NumFinishedProbeBatches = threadData.NumFinishedProbeBatches;
+        BakeSeed = meshBaker->bakeSeed;
+        Counters = threadData.Counters;
+        Relightable = meshBaker->currRelightable;
+        TransferResults = threadData.TransferResults;
+
+        // The cached radiance already has the sky and sun baked into it, which a relightable bake can't use
+        RadianceCache = AppSettings::EnableRadianceCache && Relightable == false ? threadData.RadianceCache : nullptr;
+
+        // Guiding needs paths that go past their first hit, and the whole light map to be trained with
+        const bool useGuide = AppSettings::EnablePathGuiding && threadData.Guide->Initialized() && bakeTiles == nullptr
+                              && meshBaker->currIterativeBounces == false && Relightable == false;
+        Guide = useGuide ? threadData.Guide : nullptr;
+        GuideTraining = false;
+        NumGuideTrainingBatches = AppSettings::PathGuidingTrainingPasses * CurrNumBakeGroups;
+
+        // The reservoirs are indexed by bake point, so they need the whole light map to be resident
+        const bool useReservoirs = AppSettings::SampleReuseEnabled() && bakeTiles == nullptr
+                                   && threadData.Reservoirs->NumTexels() == meshBaker->bakePoints.size();
+        Reservoirs = useReservoirs ? threadData.Reservoirs : nullptr;
+
+        // The store is laid out by global bake group, and only holds the final lighting of every sample
+        const bool recordSamples = threadData.SampleStore->Recording() && bakeTiles == nullptr && Relightable == false;
+        SampleStore = recordSamples ? threadData.SampleStore : nullptr;
+        Baker = meshBaker;
+        IterativeBounces = meshBaker->currIterativeBounces;
+        NumBouncePasses = meshBaker->currNumBouncePasses;
+        NumBounceBatches = meshBaker->currNumBounceBatches;
+        BounceResults = threadData.BounceResults;
+        NumFinishedBounceBatches = threadData.NumFinishedBounceBatches;
+        for(uint64 bufferIdx = 0; bufferIdx < 2; ++bufferIdx)
+        {
+            BounceIrradiance[bufferIdx].Pages = &threadData.BounceResults[bufferIdx * AppSettings::MaxLightMapPages];
+            BounceIrradiance[bufferIdx].NumPages = CurrNumPages;
+            BounceIrradiance[bufferIdx].LightMapSize = meshBaker->currLightMapSize;
+        }
+        NumRays = 0;
+        NumPaths = 0;
     }
 };
 
-// Runs a single iteration of the bake thread. If the bake mode supports progressive baking,
-// then this function will add 1 path tracer sample to all texels within the bake group.
-// Otherwise, it will completely bake a single texel within a bake group and flood fill
-// its unbaked neighbors within the thread group.
-template<typename TBaker> static bool BakeDriver(BakeThreadContext& context, TBaker& baker)
+// Fixed-seed bakes re-seed the random number generator for every batch, so that the results
+// don't depend on which thread happened to pick up the batch
+static void SeedBatch(BakeThreadContext& context, uint64 batchIdx)
 {
-    if(context.CurrNumBatches == 0)
-        return false;
+    if(context.BakeSeed != 0)
+        context.RandomGenerator.SetSeed(context.BakeSeed ^ uint32(batchIdx * 2654435761ull));
+}
 
-    const uint64 batchIdx = InterlockedIncrement64(context.CurrBatch) - 1;
-    if(batchIdx >= context.CurrNumBatches)
+// Adds the rays and paths that were traced by the thread to the shared counters
+static void FlushBakeCounters(BakeThreadContext& context)
+{
+    InterlockedAdd64(&context.Counters->NumRays, context.NumRays);
+    InterlockedAdd64(&context.Counters->NumPaths, context.NumPaths);
+    context.NumRays = 0;
+    context.NumPaths = 0;
+}
+
+// Returns the path tracer settings shared by light map texels and probes
+static PathTracerParams BakePathTracerParams(BakeThreadContext& context)
+{
+    PathTracerParams params;
+    params.EnableDirectAreaLight = false;
+    params.EnableDirectSun = false;
+    params.EnableDiffuse = true;
+    params.EnableSpecular = false;
+    params.EnableBounceSpecular = false;
+    params.MaxPathLength = AppSettings::MaxBakePathLength;
+    params.RussianRouletteDepth = AppSettings::BakeRussianRouletteDepth;
+    params.RussianRouletteProbability = AppSettings::BakeRussianRouletteProbability;
+    params.RayLen = FLT_MAX;
+    params.SceneBVH = context.SceneBVH;
+    params.SkyCache = &context.SkyCache;
+    params.EnvMaps = context.EnvMaps;
+    params.RayCount = &context.NumRays;
+    params.Stats = context.Stats;
+
+    // Every bake fills the cache from scratch, by using the bake tag as the generation of its cells
+    if(context.RadianceCache != nullptr)
+    {
+        params.RadianceCache = context.RadianceCache;
+        params.RadianceCacheGeneration = context.BakeTag;
+        params.RadianceCacheDepth = AppSettings::RadianceCacheBounce + 1;
+        params.RadianceCacheCellSize = AppSettings::RadianceCacheCellSize;
+        params.RadianceCacheMinSamples = AppSettings::RadianceCacheMinSamples;
+    }
+
+    if(context.Guide != nullptr && (context.GuideTraining || context.Guide->Frozen(context.BakeTag)))
+    {
+        params.Guide = context.Guide;
+        params.GuideGeneration = context.BakeTag;
+        params.GuideTraining = context.GuideTraining ? 1 : 0;
+        params.GuideFraction = AppSettings::PathGuidingFraction;
+    }
+
+    return params;
+}
+
+// Texels pick the area light over path tracing when the first coordinate of their lens sample is in
+// [0.5, 1), so it's remapped to [0, 1) before it's used to sample the light
+static float AreaLightSampleU(Float2 directAreaLightSample)
+{
+    return Saturate((directAreaLightSample.x - 0.5f) * 2.0f);
+}
+
+// Resampling target for a point on the area light, which is the luminance of its unshadowed lighting
+static float AreaLightTargetPDF(const BakeThreadContext& context, const BakePoint& bakePoint, const Float3& lightPoint)
+{
+    Float3 sampleDir;
+    const Float3 lighting = AreaLightPointLighting(bakePoint.Position, bakePoint.Normal, context.SceneBVH->Scene,
+                                                   lightPoint, false, sampleDir);
+    return ComputeLuminance(lighting);
+}
+
+// Streams the point picked by another reservoir into a texel's reservoir, which only needs the
+// target function to be re-evaluated since both pick from the same area light
+static void CombineReservoir(BakeThreadContext& context, const BakePoint& bakePoint, AreaLightReservoir& reservoir,
+                             const AreaLightReservoir& other, float maxCandidates)
+{
+    const float targetPDF = AreaLightTargetPDF(context, bakePoint, other.LightPoint);
+    const float numCandidates = std::min(other.NumCandidates, maxCandidates);
+    const float weight = targetPDF * other.ContributionWeight() * numCandidates;
+    reservoir.Update(other.LightPoint, targetPDF, weight, numCandidates, context.RandomGenerator.RandomFloat());
+}
+
+// Neighbors only share their samples if they're likely to be on the same chart, which is the case
+// when they're close by and their surfaces line up
+static bool ReuseNeighbor(const BakePoint& bakePoint, const BakePoint& neighbor, float maxDistance)
+{
+    if(neighbor.Coverage == 0 || neighbor.Coverage == 0xFFFFFFFF)
         return false;
+    if(Float3::Dot(bakePoint.Normal, neighbor.Normal) < ReuseNormalThreshold)
+        return false;
+
+    const Float3 offset = neighbor.Position - bakePoint.Position;
+    const float distance = Float3::Length(offset);
+    return distance <= maxDistance && std::abs(Float3::Dot(bakePoint.Normal, offset)) <= ReusePlaneThreshold * distance;
+}
+
+// Picks the direct area light sample of a texel with resampled importance sampling. A few fresh
+// candidates are combined with the texel's reservoir from its previous samples and with the
+// reservoirs of a few neighbors, and only the picked point is tested for shadows. The reservoir is
+// then written back for the next samples to re-use, with an occluded point dropping its weight so
+// that the neighbors don't pick it up. Returns the lighting in the same units as SampleAreaLight.
+static Float3 ResampleAreaLight(BakeThreadContext& context, const BakePage& page, const BakePoint* bakePoints,
+                                uint64 texelIdxX, uint64 texelIdxY, Float2 samplePoint, Float3& sampleDir)
+{
+    AreaLightReservoirs& reservoirs = *context.Reservoirs;
+    Random& random = context.RandomGenerator;
+
+    const uint64 texelIdx = page.FirstTexel + texelIdxY * page.Size + texelIdxX;
+    const BakePoint& bakePoint = bakePoints[texelIdx];
+
+    // The first candidate uses the texel's own sample point, and the rest are random
+    const uint64 numCandidates = AppSettings::SampleReuseCandidates;
+    AreaLightReservoir reservoir;
+    for(uint64 candidateIdx = 0; candidateIdx < numCandidates; ++candidateIdx)
+    {
+        Float2 u = Float2(AreaLightSampleU(samplePoint), samplePoint.y);
+        if(candidateIdx > 0)
+            u = random.RandomFloat2();
+
+        float invPDF = 0.0f;
+        const Float3 lightPoint = SampleAreaLightPoint(bakePoint.Position, u.x, u.y, invPDF);
+        const float targetPDF = AreaLightTargetPDF(context, bakePoint, lightPoint);
+        reservoir.Update(lightPoint, targetPDF, targetPDF * invPDF, 1.0f, random.RandomFloat());
+    }
+
+    const float maxCandidates = float(AppSettings::SampleReuseMaxHistory * numCandidates);
+
+    AreaLightReservoir prevReservoir;
+    if(reservoirs.Load(texelIdx, context.BakeTag, prevReservoir))
+        CombineReservoir(context, bakePoint, reservoir, prevReservoir, maxCandidates);
+
+    const int64 radius = AppSettings::SampleReuseRadius;
+    const float maxDistance = (radius + 1.0f) * Max(bakePoint.Size.x, bakePoint.Size.y) * 1.5f;
+    const uint64 numNeighbors = AppSettings::SampleReuseNeighbors;
+    for(uint64 neighborIdx = 0; neighborIdx < numNeighbors; ++neighborIdx)
+    {
+        const int64 neighborX = int64(texelIdxX) + int64(random.RandomUint() % (radius * 2 + 1)) - radius;
+        const int64 neighborY = int64(texelIdxY) + int64(random.RandomUint() % (radius * 2 + 1)) - radius;
+        if(neighborX < 0 || neighborY < 0 || neighborX >= int64(page.Size) || neighborY >= int64(page.Size))
+            continue;
+        if(uint64(neighborX) == texelIdxX && uint64(neighborY) == texelIdxY)
+            continue;
+
+        const uint64 neighborTexelIdx = page.FirstTexel + uint64(neighborY) * page.Size + uint64(neighborX);
+        if(ReuseNeighbor(bakePoint, bakePoints[neighborTexelIdx], maxDistance) == false)
+            continue;
+
+        AreaLightReservoir neighborReservoir;
+        if(reservoirs.Load(neighborTexelIdx, context.BakeTag, neighborReservoir))
+            CombineReservoir(context, bakePoint, reservoir, neighborReservoir, maxCandidates);
+    }
+
+    Float3 result = 0.0f;
+    sampleDir = bakePoint.Normal;
+    if(reservoir.TargetPDF > 0.0f)
+    {
+        const Float3 lighting = AreaLightPointLighting(bakePoint.Position, bakePoint.Normal, context.SceneBVH->Scene,
+                                                       reservoir.LightPoint, true, sampleDir);
+        if(AppSettings::EnableAreaLightShadows)
+            ++context.NumRays;
+
+        result = lighting * reservoir.ContributionWeight();
+        if(lighting.x <= 0.0f && lighting.y <= 0.0f && lighting.z <= 0.0f)
+            reservoir.WeightSum = 0.0f;
+    }
+
+    reservoirs.Store(texelIdx, context.BakeTag, reservoir);
+
+    return result;
+}
 
+// Runs a single batch for an 8x8 bake group within a page. If the bake mode supports progressive
+// baking, then this function will add 1 path tracer sample to all texels within the bake group.
+// Otherwise, it will completely bake a single texel within a bake group and flood fill
+// its unbaked neighbors within the thread group. Bounce passes are always progressive, and leave
+// out the direct area light since the next pass samples it at the hit points. Relightable bakes
+// are progressive too, and also write the distant light transfer to the remaining sets of
+// transferOutput (the first set is bakeOutput).
+template<typename TBaker> static void BakeGroupBatch(BakeThreadContext& context, TBaker& baker, const BakePage& page,
+                                                     const BakePoint* bakePoints, BakeResultStorage& bakeOutput,
+                                                     uint64 batchIdx, uint64 globalGroupIdx,
+                                                     const LightMapIrradiance* bounceIrradiance, bool bouncePass,
+                                                     BakeResultStorage* transferOutput)
+{
     // Are we baking one sample per texel and progessively integrating, or are we going to
     // fully compute the final baked texel value and flood fill the neighbors?
-    const bool progressiveintegration = AppSettings::SupportsProgressiveIntegration(context.CurrBakeMode, context.CurrSolveMode);
+    const bool progressiveintegration = bouncePass || (context.MultiBasis == false && AppSettings::SupportsProgressiveIntegration(context.CurrBakeMode, context.CurrSolveMode));
 
-    // Figure out which 8x8 group we're working on
-    const uint64 numGroupsX = (context.CurrLightMapSize + (BakeGroupSizeX - 1)) / BakeGroupSizeX;
-    const uint64 numGroupsY = (context.CurrLightMapSize + (BakeGroupSizeY - 1)) / BakeGroupSizeY;
-    const uint64 numBakeGroups = numGroupsX * numGroupsY;
+    const uint64 numBakeGroups = context.CurrNumBakeGroups;
+    const uint64 lightMapSize = page.Size;
 
-    const uint64 groupIdx = batchIdx % numBakeGroups;
-    const uint64 groupIdxX = groupIdx % numGroupsX;
-    const uint64 groupIdxY = groupIdx / numGroupsX;
+    const uint64 groupIdx = globalGroupIdx - page.FirstGroup;
+    const uint64 groupIdxX = groupIdx % page.NumGroupsX;
+    const uint64 groupIdxY = groupIdx / page.NumGroupsX;
 
     const uint64 sqrtNumSamples = context.CurrNumSamples;
     const uint64 numSamplesPerTexel = sqrtNumSamples * sqrtNumSamples;
 
     Random& random = context.RandomGenerator;
 
-    const bool addAreaLight = AppSettings::EnableAreaLight && AppSettings::BakeDirectAreaLight;
+    const bool addAreaLight = AppSettings::EnableAreaLight && AppSettings::BakeDirectAreaLight && bouncePass == false;
 
     // Get the set of integration samples to use, which is tiled across threads
     const uint64 numThreads = context.Samples->size();
-    const IntegrationSamples& integrationSamples = (*context.Samples)[groupIdx % numThreads];
+    const IntegrationSamples& integrationSamples = (*context.Samples)[globalGroupIdx % numThreads];
 
-    PathTracerParams params;
-    params.EnableDirectAreaLight = false;
-    params.EnableDirectSun = false;
-    params.EnableDiffuse = true;
-    params.EnableSpecular = false;
-    params.EnableBounceSpecular = false;
-    params.MaxPathLength = AppSettings::MaxBakePathLength;
-    params.RussianRouletteDepth = AppSettings::BakeRussianRouletteDepth;
-    params.RussianRouletteProbability = AppSettings::BakeRussianRouletteProbability;
-    params.RayLen = FLT_MAX;
-    params.SceneBVH = context.SceneBVH;
-    params.SkyCache = &context.SkyCache;
-    params.EnvMaps = context.EnvMaps;
+    PathTracerParams params = BakePathTracerParams(context);
+    params.BounceIrradiance = bounceIrradiance;
+
+    // The bounce passes leave out the direct light of the emitters just like that of the area light,
+    // since the next pass picks it up through next event estimation at the surfaces it hits
+    params.EnableDirectEmissive = bouncePass == false;
+
+    DistantLightTransfer transfer;
+    if(transferOutput != nullptr)
+        params.Transfer = &transfer;
+
+    TraceSpan batchSpan("Bake Batch");
 
     if(progressiveintegration)
     {
@@ -613,21 +1290,22 @@ template<typename TBaker> static bool BakeDriver(BakeThreadContext& context, TBa
                 // Compute the absolute indices of the texel we're going to work on
                 const uint64 texelIdxX = groupIdxX * BakeGroupSizeX + groupTexelIdxX;
                 const uint64 texelIdxY = groupIdxY * BakeGroupSizeY + groupTexelIdxY;
-                const uint64 texelIdx = texelIdxY * context.CurrLightMapSize + texelIdxX;
-                if(texelIdxX >= context.CurrLightMapSize || texelIdxY >= context.CurrLightMapSize)
+                const uint64 texelIdx = page.FirstTexel + texelIdxY * lightMapSize + texelIdxX;
+                if(texelIdxX >= lightMapSize || texelIdxY >= lightMapSize)
                     continue;
 
                 // Skip if the texel is empty
-                const std::vector<BakePoint>& bakePoints = *context.BakePoints;
                 const BakePoint& bakePoint = bakePoints[texelIdx];
                 if(bakePoint.Coverage == 0 || bakePoint.Coverage == 0xFFFFFFFF)
                     continue;
 
+                const uint64 texelOffset = bakeOutput.TexelOffset(texelIdxX, texelIdxY);
+
                 Float4 texelResults[TBaker::BasisCount];
                 if(sampleIdx > 0)
                 {
                     for(uint64 basisIdx = 0; basisIdx < TBaker::BasisCount; ++basisIdx)
-                        texelResults[basisIdx] = context.BakeOutput[basisIdx][texelIdx];
+                        texelResults[basisIdx] = bakeOutput.Load(texelOffset, basisIdx);
                 }
 
                 // The baker only accumulates one sample per pixel in progressive rendering.
@@ -648,14 +1326,24 @@ template<typename TBaker> static bool BakeDriver(BakeThreadContext& context, TBa
                 rayDirWS = Float3::Normalize(rayDirWS);
 
                 Float3 sampleResult = 0.0f;
+                transfer = DistantLightTransfer();
 
                 Float2 directAreaLightSample = sampleSet.Lens();
-                if(addAreaLight && directAreaLightSample.x >= 0.5f)
+                const bool directSample = addAreaLight && directAreaLightSample.x >= 0.5f;
+                if(directSample && context.Reservoirs != nullptr)
+                {
+                    sampleResult = ResampleAreaLight(context, page, bakePoints, texelIdxX, texelIdxY,
+                                                     directAreaLightSample, rayDirWS);
+                    rayDirTS = Float3::Transform(rayDirWS, Float3x3::Transpose(tangentFrame));
+                }
+                else if(directSample)
                 {
                     Float3 areaLightIrradiance;
+                    uint32 numShadowRays = 0;
                     sampleResult = SampleAreaLight(bakePoint.Position, bakePoint.Normal, context.SceneBVH->Scene,
-                                                   1.0f, 0.0f, false, 0.0f, 1.0f, sampleSet.Lens().x,
-                                                   sampleSet.Lens().y, areaLightIrradiance, rayDirWS);
+                                                   1.0f, 0.0f, false, 0.0f, 1.0f, AreaLightSampleU(directAreaLightSample),
+                                                   directAreaLightSample.y, areaLightIrradiance, rayDirWS, numShadowRays);
+                    context.NumRays += numShadowRays;
                     rayDirTS = Float3::Transform(rayDirWS, Float3x3::Transpose(tangentFrame));
                 }
                 else
@@ -667,7 +1355,10 @@ template<typename TBaker> static bool BakeDriver(BakeThreadContext& context, TBa
 
                     float illuminance = 0.0f;
                     bool hitSky = false;
+                    TraceSpan pathTraceSpan("Path Trace");
+                    const uint64 pathStartCycles = BakeStatCycles_();
                     sampleResult = PathTrace(params, random, illuminance, hitSky);
+                    BakeStatAdd_(context.Stats, PathTraceCycles, BakeStatCycles_() - pathStartCycles);
                 }
 
                 // Account for equally distributing our samples among the area light and the rest of the environment
@@ -677,12 +1368,48 @@ template<typename TBaker> static bool BakeDriver(BakeThreadContext& context, TBa
 				if (!isfinite(sampleResult.x) || !isfinite(sampleResult.y) || !isfinite(sampleResult.z))
 					sampleResult = 0.0;
 
-                baker.AddSample(rayDirTS, sampleIdx, sampleResult, rayDirWS, bakePoint.Normal);
+                AddBakeSample(baker, directSample, rayDirTS, sampleIdx, sampleResult, rayDirWS, bakePoint.Normal);
+                ++context.NumPaths;
+
+                if(context.SampleStore != nullptr && bouncePass == false)
+                    context.SampleStore->Record(globalGroupIdx, groupTexelIdx, sampleIdx, rayDirTS, sampleResult, directSample);
 
                 baker.ProgressiveResult(texelResults, sampleIdx);
 
+                TraceSpan writeSpan("Write Results");
                 for(uint64 basisIdx = 0; basisIdx < TBaker::BasisCount; ++basisIdx)
-                    context.BakeOutput[basisIdx][texelIdx] = texelResults[basisIdx];
+                    bakeOutput.Store(texelOffset, basisIdx, texelResults[basisIdx]);
+
+                if(transferOutput == nullptr)
+                    continue;
+
+                // Every transfer coefficient is integrated just like the lighting, by running it
+                // through the baker along the same sample direction
+                for(uint64 setIdx = 0; setIdx < DistantLightTransfer::NumSets; ++setIdx)
+                {
+                    BakeResultStorage& setOutput = transferOutput[setIdx + 1];
+
+                    Float4 setResults[TBaker::BasisCount];
+                    if(sampleIdx > 0)
+                    {
+                        for(uint64 basisIdx = 0; basisIdx < TBaker::BasisCount; ++basisIdx)
+                            setResults[basisIdx] = setOutput.Load(texelOffset, basisIdx);
+                    }
+
+                    Float3 setSample = transfer.Coefficients[setIdx];
+                    if(addAreaLight)
+                        setSample *= 2.0f;
+
+                    if(!isfinite(setSample.x) || !isfinite(setSample.y) || !isfinite(setSample.z))
+                        setSample = 0.0f;
+
+                    baker.Init(1, setResults);
+                    AddBakeSample(baker, directSample, rayDirTS, sampleIdx, setSample, rayDirWS, bakePoint.Normal);
+                    baker.ProgressiveResult(setResults, sampleIdx);
+
+                    for(uint64 basisIdx = 0; basisIdx < TBaker::BasisCount; ++basisIdx)
+                        setOutput.Store(texelOffset, basisIdx, setResults[basisIdx]);
+                }
             }
         }
     }
@@ -698,15 +1425,14 @@ template<typename TBaker> static bool BakeDriver(BakeThreadContext& context, TBa
 
         const uint64 texelIdxX = groupIdxX * BakeGroupSizeX + groupTexelIdxX;
         const uint64 texelIdxY = groupIdxY * BakeGroupSizeY + groupTexelIdxY;
-        const uint64 texelIdx = texelIdxY * context.CurrLightMapSize + texelIdxX;
-        if(texelIdxX >= context.CurrLightMapSize || texelIdxY >= context.CurrLightMapSize)
-            return true;
+        const uint64 texelIdx = page.FirstTexel + texelIdxY * lightMapSize + texelIdxX;
+        if(texelIdxX >= lightMapSize || texelIdxY >= lightMapSize)
+            return;
 
         // Skip if the texel is empty
-        const std::vector<BakePoint>& bakePoints = *context.BakePoints;
         const BakePoint& bakePoint = bakePoints[texelIdx];
         if(bakePoint.Coverage == 0 || bakePoint.Coverage == 0xFFFFFFFF)
-            return true;
+            return;
 
         Float3x3 tangentFrame;
         tangentFrame.SetXBasis(bakePoint.Tangent);
@@ -727,12 +1453,21 @@ template<typename TBaker> static bool BakeDriver(BakeThreadContext& context, TBa
             Float3 sampleResult;
 
             Float2 directAreaLightSample = sampleSet.Lens();
-            if(addAreaLight && directAreaLightSample.x >= 0.5f)
+            const bool directSample = addAreaLight && directAreaLightSample.x >= 0.5f;
+            if(directSample && context.Reservoirs != nullptr)
+            {
+                sampleResult = ResampleAreaLight(context, page, bakePoints, texelIdxX, texelIdxY,
+                                                 directAreaLightSample, rayDirWS);
+                rayDirTS = Float3::Transform(rayDirWS, Float3x3::Transpose(tangentFrame));
+            }
+            else if(directSample)
             {
                 Float3 areaLightIrradiance;
+                uint32 numShadowRays = 0;
                 sampleResult += SampleAreaLight(bakePoint.Position, bakePoint.Normal, context.SceneBVH->Scene,
-                                                1.0f, 0.0f, false, 0.0f, 1.0f, sampleSet.Lens().x,
-                                                sampleSet.Lens().y, areaLightIrradiance, rayDirWS);
+                                                1.0f, 0.0f, false, 0.0f, 1.0f, AreaLightSampleU(directAreaLightSample),
+                                                directAreaLightSample.y, areaLightIrradiance, rayDirWS, numShadowRays);
+                context.NumRays += numShadowRays;
                 rayDirTS = Float3::Transform(rayDirWS, Float3x3::Transpose(tangentFrame));
             }
             else
@@ -744,7 +1479,10 @@ template<typename TBaker> static bool BakeDriver(BakeThreadContext& context, TBa
 
                 float illuminance = 0.0f;
                 bool hitSky = false;
+                TraceSpan pathTraceSpan("Path Trace");
+                const uint64 pathStartCycles = BakeStatCycles_();
                 sampleResult = PathTrace(params, random, illuminance, hitSky);
+                BakeStatAdd_(context.Stats, PathTraceCycles, BakeStatCycles_() - pathStartCycles);
             }
 
             // Account for equally distributing our samples among the area light and the rest of the environment
@@ -754,12 +1492,21 @@ template<typename TBaker> static bool BakeDriver(BakeThreadContext& context, TBa
 			if (!isfinite(sampleResult.x) || !isfinite(sampleResult.y) || !isfinite(sampleResult.z))
 				sampleResult = 0.0;
 
-            baker.AddSample(rayDirTS, sampleIdx, sampleResult, rayDirWS, bakePoint.Normal);
+            AddBakeSample(baker, directSample, rayDirTS, sampleIdx, sampleResult, rayDirWS, bakePoint.Normal);
+            ++context.NumPaths;
+
+            if(context.SampleStore != nullptr)
+                context.SampleStore->Record(globalGroupIdx, groupTexelIdx, sampleIdx, rayDirTS, sampleResult, directSample);
         }
 
+        const uint64 finalResultStartCycles = BakeStatCycles_();
         baker.FinalResult(texelResults);
+        BakeStatAdd_(context.Stats, FinalResultCycles, BakeStatCycles_() - finalResultStartCycles);
+
+        TraceSpan writeSpan("Write Results");
+        const uint64 texelOffset = bakeOutput.TexelOffset(texelIdxX, texelIdxY);
         for(uint64 basisIdx = 0; basisIdx < TBaker::BasisCount; ++basisIdx)
-            context.BakeOutput[basisIdx][texelIdx] = texelResults[basisIdx];
+            bakeOutput.Store(texelOffset, basisIdx, texelResults[basisIdx]);
 
         // Temporarily fill in the rest of the texels in the group
         for(uint64 i = groupTexelIdx; i < BakeGroupSize; ++i)
@@ -768,62 +1515,304 @@ template<typename TBaker> static bool BakeDriver(BakeThreadContext& context, TBa
             const uint64 offsetY = i / BakeGroupSizeX;
             const uint64 neighborX = groupIdxX * BakeGroupSizeX + offsetX;
             const uint64 neighborY = groupIdxY * BakeGroupSizeY + offsetY;
-            if(neighborX >= context.CurrLightMapSize || neighborY >= context.CurrLightMapSize)
+            if(neighborX >= lightMapSize || neighborY >= lightMapSize)
                 continue;
 
-            uint64 neighborTexelIdx = neighborY * context.CurrLightMapSize + neighborX;
+            const uint64 neighborOffset = bakeOutput.TexelOffset(neighborX, neighborY);
             for(uint64 basisIdx = 0; basisIdx < TBaker::BasisCount; ++basisIdx)
-                context.BakeOutput[basisIdx][neighborTexelIdx] = texelResults[basisIdx];
+                bakeOutput.Store(neighborOffset, basisIdx, texelResults[basisIdx]);
         }
     }
+}
+
+// Waits for the other bake threads to finish the batches of a bounce pass, which returns false if
+// the bake restarts in the meantime
+static bool WaitForBouncePass(BakeThreadContext& context, uint64 passIdx)
+{
+    TraceSpan waitSpan("Wait For Bounce Pass");
+    while(context.NumFinishedBounceBatches[passIdx] < int64(context.NumBounceBatches))
+    {
+        if(context.Baker->killBakeThreads || uint64(context.Baker->bakeTag) != context.BakeTag)
+            return false;
+        Sleep(0);
+    }
 
     return true;
 }
 
-// Data passed to the bake thread entry point
-struct BakeThreadData
+// Runs a single iteration of the bake thread, where the batches of every page are pulled from
+// a single shared counter. Each thread claims a run of up to RunLength consecutive batches at once
+// and works through it one batch per iteration, so that it bakes neighboring groups of the bake
+// order back-to-back. Every row of CurrNumBakeGroups batches visits each group exactly once, for a
+// single pass and sample index (or group texel when baking whole texels), and a run never crosses
+// into the next row. Together with the run length being capped by the number of threads,
+// this keeps two threads from baking the same group at the same time, since they would race on the
+// texels of the group. With iterative bounces the batches of the bounce passes come first, and each
+// pass reads back the irradiance that the previous one baked into the light map.
+template<typename TBaker> static bool BakeDriver(BakeThreadContext& context, TBaker& baker, DiffuseBaker& bounceBaker)
 {
-    FixedArray<Float4>* BakeOutput = nullptr;
-    const std::vector<IntegrationSamples>* Samples = nullptr;
-    volatile int64* CurrBatch = nullptr;
-    const MeshBaker* Baker = nullptr;
+    if(context.CurrNumBatches == 0)
+        return false;
+
+    if(context.RunBatch >= context.RunEndBatch)
+    {
+        TraceSpan claimSpan("Claim Batch Run");
+        const int64 numGroups = int64(context.CurrNumBakeGroups);
+        int64 runStart = 0;
+        int64 runEnd = 0;
+        do
+        {
+            runStart = *context.CurrBatch;
+            if(runStart >= int64(context.CurrNumBatches))
+                return false;
+
+            const int64 rowEnd = (runStart / numGroups + 1) * numGroups;
+            runEnd = std::min(runStart + int64(context.RunLength), rowEnd);
+        } while(InterlockedCompareExchange64(context.CurrBatch, runEnd, runStart) != runStart);
+
+        context.RunBatch = uint64(runStart);
+        context.RunEndBatch = uint64(runEnd);
+    }
+
+    const uint64 batchIdx = context.RunBatch++;
+    if(batchIdx >= context.CurrNumBatches)
+    {
+        context.RunBatch = context.RunEndBatch;
+        return false;
+    }
+
+    const uint64 numBounceBatches = context.NumBouncePasses * context.NumBounceBatches;
+    const uint64 passIdx = batchIdx < numBounceBatches ? batchIdx / context.NumBounceBatches : context.NumBouncePasses;
+    const uint64 passBatchIdx = batchIdx < numBounceBatches ? batchIdx % context.NumBounceBatches : batchIdx - numBounceBatches;
+    if(passIdx > 0 && WaitForBouncePass(context, passIdx - 1) == false)
+        return true;
+
+    // The first rounds of batches train the path guide, and the rest sample from it once the last
+    // training batch has frozen it. The few batches that start before that just sample the BRDF's.
+    context.GuideTraining = context.Guide != nullptr && passBatchIdx < context.NumGuideTrainingBatches;
+
+    const LightMapIrradiance* bounceIrradiance = nullptr;
+    if(context.IterativeBounces)
+        bounceIrradiance = passIdx > 0 ? &context.BounceIrradiance[(passIdx - 1) % 2] : &context.NoBounceIrradiance;
+
+    // Figure out which 8x8 group we're working on. The groups of all pages are laid out back-to-back,
+    // and each pass visits them in world-space order if there is one, so the run of a thread covers
+    // a compact region of the scene.
+    uint64 globalGroupIdx = passBatchIdx % context.CurrNumBakeGroups;
+    if(context.BakeGroupOrder != nullptr)
+        globalGroupIdx = context.BakeGroupOrder[globalGroupIdx];
+
+    uint64 pageIdx = 0;
+    while(pageIdx + 1 < context.CurrNumPages && globalGroupIdx >= context.BakePages[pageIdx + 1].FirstGroup)
+        ++pageIdx;
+
+    SeedBatch(context, batchIdx);
+    const uint64 batchStartCycles = BakeStatCycles_();
+    if(passIdx < context.NumBouncePasses)
+    {
+        BakeResultStorage& bounceOutput = context.BounceResults[(passIdx % 2) * AppSettings::MaxLightMapPages + pageIdx];
+        BakeGroupBatch<DiffuseBaker>(context, bounceBaker, context.BakePages[pageIdx], context.BakePoints->data(),
+                                     bounceOutput, passBatchIdx, globalGroupIdx, bounceIrradiance, true, nullptr);
+    }
+    else if(context.Relightable)
+    {
+        // The final results are written by the main thread when it re-lights the bake
+        BakeResultStorage* transferOutput = &context.TransferResults[pageIdx * MeshBaker::NumTransferSets];
+        BakeGroupBatch<TBaker>(context, baker, context.BakePages[pageIdx], context.BakePoints->data(),
+                               transferOutput[0], passBatchIdx, globalGroupIdx, bounceIrradiance, false, transferOutput);
+    }
+    else
+    {
+        BakeGroupBatch<TBaker>(context, baker, context.BakePages[pageIdx], context.BakePoints->data(),
+                               context.BakeOutput[pageIdx], passBatchIdx, globalGroupIdx, bounceIrradiance, false, nullptr);
+    }
+    BakeStatAdd_(context.Stats, BatchCycles, BakeStatCycles_() - batchStartCycles);
+    BakeStatAdd_(context.Stats, Batches, 1);
+
+    FlushBakeCounters(context);
+    if(passIdx < context.NumBouncePasses)
+        InterlockedIncrement64(&context.NumFinishedBounceBatches[passIdx]);
+    if(context.GuideTraining && context.Guide->FinishTrainingBatch(context.BakeTag, context.NumGuideTrainingBatches))
+    {
+        TraceSpan freezeSpan("Freeze Path Guide");
+        context.Guide->Freeze(context.BakeTag);
+    }
+    InterlockedIncrement64(&context.Counters->NumFinishedBatches);
+
+    return true;
+}
+
+// Runs a single iteration of the bake thread in out-of-core mode, where the batches are pulled
+// from whichever resident tile still has work left. All tiles have the same size, and thus the
+// same number of batches.
+template<typename TBaker> static bool BakeTileDriver(BakeThreadContext& context, TBaker& baker)
+{
+    if(context.CurrNumBatches == 0)
+        return false;
+
+    for(uint64 slotIdx = 0; slotIdx < MeshBaker::NumBakeTileSlots; ++slotIdx)
+    {
+        BakeTile& tile = context.BakeTiles[slotIdx];
+        if(uint64(tile.CurrBatch) >= context.CurrNumBatches)
+            continue;
+
+        const uint64 batchIdx = InterlockedIncrement64(&tile.CurrBatch) - 1;
+        if(batchIdx >= context.CurrNumBatches)
+            continue;
+
+        const uint64 groupIdx = batchIdx % context.CurrNumBakeGroups;
+        SeedBatch(context, tile.TileIdx * context.CurrNumBatches + batchIdx);
+        const uint64 batchStartCycles = BakeStatCycles_();
+        BakeGroupBatch<TBaker>(context, baker, context.BakePages[0], tile.BakePoints.data(),
+                               tile.Results, batchIdx, groupIdx, nullptr, false, nullptr);
+        BakeStatAdd_(context.Stats, BatchCycles, BakeStatCycles_() - batchStartCycles);
+        BakeStatAdd_(context.Stats, Batches, 1);
+
+        FlushBakeCounters(context);
+        InterlockedIncrement64(&tile.NumFinishedBatches);
+        return true;
+    }
+
+    return false;
+}
+
+// Runs a single batch for a group of 64 probes, which adds 1 path tracer sample from the full
+// sphere of directions to every probe in the group. Unlike light map texels there's no surface
+// to offset from, so the paths start exactly at the probe position.
+template<typename TBaker> static void BakeProbeBatch(BakeThreadContext& context, TBaker& baker, uint64 batchIdx)
+{
+    const uint64 probeGroupIdx = batchIdx % context.CurrNumProbeGroups;
+    const uint64 sampleIdx = batchIdx / context.CurrNumProbeGroups;
+    const uint64 numProbes = context.Probes.NumProbes();
+
+    // Get the set of integration samples to use, which is tiled across threads
+    const uint64 numThreads = context.Samples->size();
+    const IntegrationSamples& integrationSamples = (*context.Samples)[probeGroupIdx % numThreads];
+
+    // There's no normal to importance sample the area light with, so just let the paths hit it
+    PathTracerParams params = BakePathTracerParams(context);
+    params.EnableDirectAreaLight = AppSettings::EnableAreaLight && AppSettings::BakeDirectAreaLight;
+
+    for(uint64 groupProbeIdx = 0; groupProbeIdx < BakeGroupSize; ++groupProbeIdx)
+    {
+        const uint64 probeIdx = probeGroupIdx * BakeGroupSize + groupProbeIdx;
+        if(probeIdx >= numProbes)
+            break;
+
+        Float4* probeOutput = context.ProbeOutput + probeIdx * TBaker::BasisCount;
+
+        Float4 probeResults[TBaker::BasisCount];
+        for(uint64 basisIdx = 0; basisIdx < TBaker::BasisCount; ++basisIdx)
+            probeResults[basisIdx] = sampleIdx > 0 ? probeOutput[basisIdx] : Float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+        baker.Init(1, probeResults, context.ProbeSGs);
+
+        IntegrationSampleSet sampleSet;
+        sampleSet.Init(integrationSamples, groupProbeIdx, sampleIdx);
+
+        const Float3 rayDir = baker.SampleDirection(sampleSet.Pixel());
+        params.RayDir = rayDir;
+        params.RayStart = context.Probes.ProbePosition(probeIdx);
+        params.RayLen = FLT_MAX;
+        params.SampleSet = &sampleSet;
+
+        float illuminance = 0.0f;
+        bool hitSky = false;
+        Float3 sampleResult = PathTrace(params, context.RandomGenerator, illuminance, hitSky);
+
+        if(!isfinite(sampleResult.x) || !isfinite(sampleResult.y) || !isfinite(sampleResult.z))
+            sampleResult = 0.0f;
+
+        baker.AddSample(rayDir, sampleIdx, sampleResult);
+        ++context.NumPaths;
+
+        baker.ProgressiveResult(probeResults, sampleIdx);
+
+        for(uint64 basisIdx = 0; basisIdx < TBaker::BasisCount; ++basisIdx)
+            probeOutput[basisIdx] = probeResults[basisIdx];
+    }
+}
+
+// The probe basis is independent of the light map bake mode, so every bake thread has a baker
+// for each of them
+struct ProbeBakers
+{
+    SH9ProbeBaker SH9;
+    SG6ProbeBaker SG6;
+    SG9ProbeBaker SG9;
+    SG12ProbeBaker SG12;
 };
 
+// Runs a single iteration of the bake thread for the probe grid
+static bool BakeProbeDriver(BakeThreadContext& context, ProbeBakers& bakers)
+{
+    if(context.CurrNumProbeBatches == 0)
+        return false;
+
+    const uint64 batchIdx = InterlockedIncrement64(context.CurrProbeBatch) - 1;
+    if(batchIdx >= context.CurrNumProbeBatches)
+        return false;
+
+    // Probes only ever sample from the path guide, once the light map batches have trained it
+    context.GuideTraining = false;
+
+    SeedBatch(context, ~batchIdx);
+    const uint64 batchStartCycles = BakeStatCycles_();
+    if(context.CurrProbeBasis == ProbeBases::SH9)
+        BakeProbeBatch(context, bakers.SH9, batchIdx);
+    else if(context.CurrProbeBasis == ProbeBases::SG6)
+        BakeProbeBatch(context, bakers.SG6, batchIdx);
+    else if(context.CurrProbeBasis == ProbeBases::SG9)
+        BakeProbeBatch(context, bakers.SG9, batchIdx);
+    else if(context.CurrProbeBasis == ProbeBases::SG12)
+        BakeProbeBatch(context, bakers.SG12, batchIdx);
+    BakeStatAdd_(context.Stats, BatchCycles, BakeStatCycles_() - batchStartCycles);
+    BakeStatAdd_(context.Stats, Batches, 1);
+
+    FlushBakeCounters(context);
+    InterlockedIncrement64(context.NumFinishedProbeBatches);
+    return true;
+}
+
 // Entry point for a bake thread
 template<typename TBaker> uint32 __stdcall BakeThread(void* data)
 {
     BakeThreadData* threadData = reinterpret_cast<BakeThreadData*>(data);
     const MeshBaker* meshBaker = threadData->Baker;
 
+    Tracer::RegisterThread("Bake Thread", threadData->ThreadIdx);
+
     BakeThreadContext context;
+    context.Stats = threadData->Stats;
     TBaker baker;
+    DiffuseBaker bounceBaker;
+    ProbeBakers probeBakers;
 
     while(meshBaker->killBakeThreads == false)
     {
         const uint64 currTag = meshBaker->bakeTag;
         if(context.BakeTag != currTag)
-            context.Init(threadData->BakeOutput, threadData->Samples,
-                         threadData->CurrBatch, threadData->Baker, currTag);
+            context.Init(*threadData, currTag);
 
-        if(BakeDriver<TBaker>(context, baker) == false)
+        bool baked = context.BakeTiles ? BakeTileDriver<TBaker>(context, baker)
+                                       : BakeDriver<TBaker>(context, baker, bounceBaker);
+        if(baked == false)
+            baked = BakeProbeDriver(context, probeBakers);
+        if(baked == false)
+        {
+            TraceSpan idleSpan("Idle");
             Sleep(5);
+        }
     }
 
     return 0;
 }
 
 
-// Builds a BVH tree for an entire model/scene
-static void BuildBVH(const Model& model, BVHData& bvhData, ID3D11Device* d3dDevice, RTCDevice device)
+// Flattens all meshes of a model into a single triangle list, and decodes the material textures
+// into CPU memory straight from their source files
+static void FlattenScene(const Model& model, BVHData& bvhData)
 {
-    if(bvhData.Scene != nullptr)
-    {
-        rtcDeleteScene(bvhData.Scene);
-        bvhData.Scene = nullptr;
-    }
-    bvhData.Scene = rtcDeviceNewScene(device, RTC_SCENE_DYNAMIC, RTC_INTERSECT1);
-    bvhData.Device = device;
-
     // Count the total number of vertices and triangles
     uint32 totalNumVertices = 0;
     uint32 totalNumTriangles = 0;
@@ -838,7 +1827,6 @@ static void BuildBVH(const Model& model, BVHData& bvhData, ID3D11Device* d3dDevi
     bvhData.Triangles.resize(totalNumTriangles);
     bvhData.Vertices.resize(totalNumVertices);
     bvhData.MaterialIndices.resize(totalNumTriangles);
-    std::vector<Float4> vertices(totalNumVertices);
 
     uint32 vtxOffset = 0;
     uint32 triOffset = 0;
@@ -852,7 +1840,6 @@ static void BuildBVH(const Model& model, BVHData& bvhData, ID3D11Device* d3dDevi
         const uint32 numVertices = mesh.NumVertices();
         const uint32 numIndices = mesh.NumIndices();
         const uint32 indexSize = mesh.IndexSize();
-        const uint32 vertexStride = mesh.VertexStride();
 
         // Prepare the triangles
         const uint32 numTriangles = numIndices / 3;
@@ -874,20 +1861,100 @@ static void BuildBVH(const Model& model, BVHData& bvhData, ID3D11Device* d3dDevi
 
         // Prepare the vertices
         for(uint32 i = 0; i < numVertices; ++i)
-        {
-            const Float3& position = vertexData[i].Position;
-            vertices[i + vtxOffset] = Float4(position, 0.0f);
             bvhData.Vertices[i + vtxOffset] = vertexData[i];
-        }
 
         triOffset += numTriangles;
         vtxOffset += numVertices;
     }
 
+    // Load the material texture data
+    const uint64 numMaterials = model.Materials().size();
+    bvhData.MaterialDiffuseMaps.resize(numMaterials);
+    bvhData.MaterialNormalMaps.resize(numMaterials);
+    bvhData.MaterialRoughnessMaps.resize(numMaterials);
+    bvhData.MaterialMetallicMaps.resize(numMaterials);
+
+    bvhData.MaterialEmissive.resize(numMaterials);
+    for(uint64 materialIdx = 0; materialIdx < numMaterials; ++materialIdx)
+        bvhData.MaterialEmissive[materialIdx] = model.Materials()[materialIdx].Emissive;
+
+    const uint64 numMaps = uint64(MaterialMaps::NumValues);
+    ParallelFor(numMaterials * numMaps, [&](uint64 idx)
+    {
+        const uint64 materialIdx = idx / numMaps;
+        const MaterialMaps map = MaterialMaps(idx % numMaps);
+        bool srgb = false;
+        const std::wstring mapPath = model.MaterialMapPath(materialIdx, map, srgb);
+
+        if(map == MaterialMaps::Diffuse)
+            LoadTextureData(mapPath.c_str(), bvhData.MaterialDiffuseMaps[materialIdx], srgb);
+        else if(map == MaterialMaps::Normal)
+            LoadTextureData(mapPath.c_str(), bvhData.MaterialNormalMaps[materialIdx], srgb);
+        else if(map == MaterialMaps::Roughness)
+            LoadTextureData(mapPath.c_str(), bvhData.MaterialRoughnessMaps[materialIdx], srgb);
+        else if(map == MaterialMaps::Metallic)
+            LoadTextureData(mapPath.c_str(), bvhData.MaterialMetallicMaps[materialIdx], srgb);
+    });
+}
+
+// Collects every triangle with an emissive material, and builds the light BVH over them
+static void BuildEmissiveLights(BVHData& bvhData)
+{
+    std::vector<EmissiveTriangle> emitters;
+
+    const uint64 numTriangles = bvhData.Triangles.size();
+    for(uint64 triIdx = 0; triIdx < numTriangles; ++triIdx)
+    {
+        const Float3& emissive = bvhData.MaterialEmissive[bvhData.MaterialIndices[triIdx]];
+        if(ComputeLuminance(emissive) <= 0.0f)
+            continue;
+
+        const Uint3& triangle = bvhData.Triangles[triIdx];
+        EmissiveTriangle emitter;
+        emitter.V0 = bvhData.Vertices[triangle.x].Position;
+        emitter.V1 = bvhData.Vertices[triangle.y].Position;
+        emitter.V2 = bvhData.Vertices[triangle.z].Position;
+
+        // Matches the front face of IsTriangleBackFacing in the path tracer
+        const Float3 cross = Float3::Cross(emitter.V1 - emitter.V0, emitter.V2 - emitter.V0);
+        const float crossLen = Float3::Length(cross);
+        if(crossLen <= 0.0f)
+            continue;
+
+        emitter.Normal = cross / crossLen;
+        emitter.Area = crossLen * 0.5f;
+        emitter.Emission = emissive;
+        emitters.push_back(emitter);
+    }
+
+    bvhData.EmissiveLights.Build(emitters);
+}
+
+// Builds a BVH tree for an entire model/scene, re-using the flattened scene data from the BVH
+// cache on disk when the scene hasn't changed since it was written
+static void BuildBVH(const Model& model, const Hash& sceneHash, BVHData& bvhData, RTCDevice device)
+{
+    bvhData.Reset();
+
+    if(LoadBVHCache(sceneHash, bvhData) == false)
+    {
+        FlattenScene(model, bvhData);
+        WriteBVHCache(sceneHash, bvhData);
+    }
+
+    BuildEmissiveLights(bvhData);
+
+    bvhData.SceneHash = sceneHash;
+    bvhData.Scene = rtcDeviceNewScene(device, RTC_SCENE_DYNAMIC, RTC_INTERSECT1);
+    bvhData.Device = device;
+
+    const uint32 totalNumTriangles = uint32(bvhData.Triangles.size());
+    const uint32 totalNumVertices = uint32(bvhData.Vertices.size());
     uint32 geoID = rtcNewTriangleMesh(bvhData.Scene, RTC_GEOMETRY_STATIC, totalNumTriangles, totalNumVertices);
 
     Float4* meshVerts = reinterpret_cast<Float4*>(rtcMapBuffer(bvhData.Scene, geoID, RTC_VERTEX_BUFFER));
-    memcpy(meshVerts, vertices.data(), totalNumVertices * sizeof(Float4));
+    for(uint32 i = 0; i < totalNumVertices; ++i)
+        meshVerts[i] = Float4(bvhData.Vertices[i].Position, 0.0f);
     rtcUnmapBuffer(bvhData.Scene, geoID, RTC_VERTEX_BUFFER);
 
     Uint3* meshTriangles = reinterpret_cast<Uint3*>(rtcMapBuffer(bvhData.Scene, geoID, RTC_INDEX_BUFFER));
@@ -900,44 +1967,15 @@ static void BuildBVH(const Model& model, BVHData& bvhData, ID3D11Device* d3dDevi
     Assert_(embreeError == RTC_NO_ERROR);
     if(embreeError != RTC_NO_ERROR)
         throw Exception(L"Failed to build embree scene!");
-
-    // Load the material texture data
-    const uint64 numMaterials = model.Materials().size();
-    bvhData.MaterialDiffuseMaps.resize(numMaterials);
-    bvhData.MaterialNormalMaps.resize(numMaterials);
-    bvhData.MaterialRoughnessMaps.resize(numMaterials);
-    bvhData.MaterialMetallicMaps.resize(numMaterials);
-
-    for(uint64 i = 0; i < numMaterials; ++i)
-    {
-        const MeshMaterial& material = model.Materials()[i];
-        GetTextureData(d3dDevice, material.DiffuseMap, bvhData.MaterialDiffuseMaps[i]);
-        GetTextureData(d3dDevice, material.NormalMap, bvhData.MaterialNormalMaps[i]);
-        GetTextureData(d3dDevice, material.RoughnessMap, bvhData.MaterialRoughnessMaps[i]);
-        GetTextureData(d3dDevice, material.MetallicMap, bvhData.MaterialMetallicMaps[i]);
-    }
 }
 
-// Computes lightmap sample points and gutter texels
-static void ExtractBakePoints(const BakeInputData& bakeInput, std::vector<BakePoint>& bakePoints,
-                              std::vector<GutterTexel>& gutterTexels)
-{
-    const uint32 LightMapSize = AppSettings::LightMapResolution;
-    const uint64 NumTexels = LightMapSize * LightMapSize;
-
-    bakePoints.clear();
-    bakePoints.resize(NumTexels);
-    gutterTexels.clear();
-
-    Timer timer;
-    PrintString("Extracting light map sample points...");
+// == BakePointRasterizer =========================================================================
 
-    ID3D11Device* device = bakeInput.Device;
-    ID3D11DeviceContextPtr context;
-    device->GetImmediateContext(&context);
+void BakePointRasterizer::Initialize(ID3D11Device* device_, uint32 targetSize_)
+{
+    device = device_;
+    targetSize = targetSize_;
 
-    // Rasterize the mesh to the lightmap in UV space
-    const uint32 NumTargets = 5;
     const DXGI_FORMAT RTFormats[NumTargets] =
     {
         DXGI_FORMAT_R32G32B32A32_FLOAT,
@@ -947,14 +1985,38 @@ static void ExtractBakePoints(const BakeInputData& bakeInput, std::vector<BakePo
         DXGI_FORMAT_R32_UINT,
     };
 
-    RenderTarget2D targets[NumTargets];
-    RenderTarget2D msaaTargets[NumTargets];
     for(uint64 i = 0; i < NumTargets; ++i)
     {
-        targets[i].Initialize(bakeInput.Device, LightMapSize, LightMapSize, RTFormats[i]);
-        msaaTargets[i].Initialize(bakeInput.Device, LightMapSize, LightMapSize, RTFormats[i], 1, 8, 0);
+        targets[i].Initialize(device, targetSize, targetSize, RTFormats[i]);
+        msaaTargets[i].Initialize(device, targetSize, targetSize, RTFormats[i], 1, 8, 0);
+        stagingTextures[i].Initialize(device, targetSize, targetSize, RTFormats[i]);
     }
 
+    vs = CompileVSFromFile(device, L"LightMapRasterization.hlsl");
+    ps = CompilePSFromFile(device, L"LightMapRasterization.hlsl");
+    resolveVS = CompileVSFromFile(device, L"LightMapRasterization.hlsl", "ResolveVS");
+    resolvePS = CompilePSFromFile(device, L"LightMapRasterization.hlsl", "ResolvePS");
+
+    rasterizerStates.Initialize(device);
+    blendStates.Initialize(device);
+    dsStates.Initialize(device);
+
+    constantBuffer.Initialize(device);
+}
+
+// Rasterizes a square region of a light map page in UV space, and extracts the sample points and
+// gutter texels from the top-left readSize x readSize texels of the region. The grid of points is
+// written to gridPoints, and the active points are also appended to activePoints if it's non-null.
+void BakePointRasterizer::Rasterize(const Model& model, uint32 lightMapSize, uint32 pageIdx, Uint2 regionOffset,
+                                    uint32 regionSize, uint32 readSize, BakePoint* gridPoints,
+                                    std::vector<BakePoint>* activePoints, std::vector<GutterTexel>& gutterTexels)
+{
+    Assert_(regionSize <= targetSize);
+    Assert_(readSize <= regionSize);
+
+    ID3D11DeviceContextPtr context;
+    device->GetImmediateContext(&context);
+
     ID3D11RenderTargetView* rtViews[NumTargets];
     for(uint64 i = 0; i < NumTargets; ++i)
         rtViews[i] = msaaTargets[i].RTView;
@@ -965,44 +2027,32 @@ static void ExtractBakePoints(const BakeInputData& bakeInput, std::vector<BakePo
     for(uint64 i = 0; i < NumTargets; ++i)
         context->ClearRenderTargetView(rtViews[i], clearColor);
 
-    VertexShaderPtr vs = CompileVSFromFile(device, L"LightMapRasterization.hlsl");
-    PixelShaderPtr ps = CompilePSFromFile(device, L"LightMapRasterization.hlsl");
-
     context->VSSetShader(vs, nullptr, 0);
     context->GSSetShader(nullptr, nullptr, 0);
     context->PSSetShader(ps, nullptr, 0);
     context->HSSetShader(nullptr, nullptr, 0);
     context->DSSetShader(nullptr, nullptr, 0);
 
-    RasterizerStates rasterizerStates;
-    rasterizerStates.Initialize(device);
     context->RSSetState(rasterizerStates.NoCull());
 
-    BlendStates blendStates;
-    blendStates.Initialize(device);
     float blendFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
     context->OMSetBlendState(blendStates.BlendDisabled(), blendFactor, 0xFFFFFFFF);
-
-    DepthStencilStates dsStates;
-    dsStates.Initialize(device);
     context->OMSetDepthStencilState(dsStates.DepthDisabled(), 0);
 
+    // The region ends up in the top-left corner of the targets
     D3D11_VIEWPORT viewport;
-    viewport.Width = float(LightMapSize);
-    viewport.Height = float(LightMapSize);
+    viewport.Width = float(regionSize);
+    viewport.Height = float(regionSize);
     viewport.TopLeftX = 0.0f;
     viewport.TopLeftY = 0.0f;
     viewport.MinDepth = 0.0f;
     viewport.MaxDepth = 1.0f;
     context->RSSetViewports(1, &viewport);
 
-    ConstantBuffer<uint32> constantBuffer;
-    constantBuffer.Initialize(device);
+    constantBuffer.SetVS(context, 0);
     constantBuffer.SetPS(context, 0);
 
     uint32 vertexOffset = 0;
-
-    const Model& model = *bakeInput.SceneModel;
     const std::vector<Mesh>& meshes = model.Meshes();
     for(uint64 meshIdx = 0; meshIdx < meshes.size(); ++meshIdx)
     {
@@ -1021,7 +2071,10 @@ static void ExtractBakePoints(const BakeInputData& bakeInput, std::vector<BakePo
         context->IASetIndexBuffer(mesh.IndexBuffer(), mesh.IndexBufferFormat(), 0);
         context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-        constantBuffer.Data = vertexOffset;
+        constantBuffer.Data.VertexOffset = vertexOffset;
+        constantBuffer.Data.LightMapPage = float(pageIdx);
+        constantBuffer.Data.RegionOffset = Float2(float(regionOffset.x), float(regionOffset.y)) / float(lightMapSize);
+        constantBuffer.Data.RegionScale = float(lightMapSize) / float(regionSize);
         constantBuffer.ApplyChanges(context);
 
         context->DrawIndexed(mesh.NumIndices(), 0, 0);
@@ -1030,8 +2083,6 @@ static void ExtractBakePoints(const BakeInputData& bakeInput, std::vector<BakePo
     }
 
     // Resolve the targets
-    VertexShaderPtr resolveVS = CompileVSFromFile(device, L"LightMapRasterization.hlsl", "ResolveVS");
-    PixelShaderPtr resolvePS = CompilePSFromFile(device, L"LightMapRasterization.hlsl", "ResolvePS");
     context->VSSetShader(resolveVS, nullptr, 0);
     context->PSSetShader(resolvePS, nullptr, 0);
 
@@ -1069,27 +2120,37 @@ static void ExtractBakePoints(const BakeInputData& bakeInput, std::vector<BakePo
     context->PSSetShaderResources(0, NumTargets, srViews);
 
     // Read back the results, and extract the sample points
-    StagingTexture2D stagingTextures[NumTargets];
-    uint32 pitches[5] = { 0 };
-    const uint8* textureData[5] = { nullptr };
+    uint32 pitches[NumTargets] = { 0 };
+    const uint8* textureData[NumTargets] = { nullptr };
     for(uint64 i = 0; i < NumTargets; ++i)
     {
-        stagingTextures[i].Initialize(device, LightMapSize, LightMapSize, RTFormats[i]);
         context->CopyResource(stagingTextures[i].Texture, targets[i].Texture);
         textureData[i] = reinterpret_cast<uint8*>(stagingTextures[i].Map(context, 0, pitches[i]));
     }
 
-    for(uint32 y = 0; y < LightMapSize; ++y)
+    // Texel positions are offset by the page index in X, which matches the encoding of the UV's
+    const uint32 texelOffsetX = pageIdx * lightMapSize + regionOffset.x;
+    const uint32 texelOffsetY = regionOffset.y;
+
+    // A region that hangs off the edge of the atlas would pick up the next page on the right,
+    // so treat anything outside of the atlas as empty
+    const uint32 validSizeX = std::min(readSize, lightMapSize - std::min(regionOffset.x, lightMapSize));
+    const uint32 validSizeY = std::min(readSize, lightMapSize - std::min(regionOffset.y, lightMapSize));
+
+    for(uint32 y = 0; y < readSize; ++y)
     {
         const Float4* positions = reinterpret_cast<const Float4*>(textureData[0] + y * pitches[0]);
         const Float4* normals = reinterpret_cast<const Float4*>(textureData[1] + y * pitches[1]);
         const Float4* tangents = reinterpret_cast<const Float4*>(textureData[2] + y * pitches[2]);
         const Float4* bitangents = reinterpret_cast<const Float4*>(textureData[3] + y * pitches[3]);
         const uint32* coverage = reinterpret_cast<const uint32*>(textureData[4] + y * pitches[4]);
-        for(uint32 x = 0; x < LightMapSize; ++x)
+        for(uint32 x = 0; x < readSize; ++x)
         {
-            const uint64 pointIdx = y * LightMapSize + x;
-            BakePoint& bakePoint = bakePoints[pointIdx];
+            BakePoint& bakePoint = gridPoints[y * readSize + x];
+            bakePoint = BakePoint();
+
+            if(x >= validSizeX || y >= validSizeY)
+                continue;
 
             if(coverage[x] != 0)
             {
@@ -1100,14 +2161,16 @@ static void ExtractBakePoints(const BakeInputData& bakeInput, std::vector<BakePo
                 bakePoint.Bitangent = bitangents[x].To3D();
                 bakePoint.Size = Float2(positions[x].w, normals[x].w);
                 bakePoint.Coverage = coverage[x];
-                bakePoint.TexelPos = Uint2(x, y);
-                bakePoints.push_back(bakePoint);
+                bakePoint.TexelPos = Uint2(x + texelOffsetX, y + texelOffsetY);
+                if(activePoints != nullptr)
+                    activePoints->push_back(bakePoint);
             }
             else
             {
                 // Check if this is a gutter texel that needs to replicate its value from a neighbor
                 GutterTexel gutterTexel;
                 gutterTexel.TexelPos = Uint2(x, y);
+                gutterTexel.PageIdx = pageIdx;
                 int32 currDist = 0;
                 bool foundNeighbor = false;
 
@@ -1115,7 +2178,7 @@ static void ExtractBakePoints(const BakeInputData& bakeInput, std::vector<BakePo
                 for(int32 ny = -1; ny <= 1; ++ny)
                 {
                     int32 neighborY = y + ny;
-                    if(neighborY < 0 || neighborY >= int32(LightMapSize))
+                    if(neighborY < 0 || neighborY >= int32(validSizeY))
                         continue;
 
                     for(int32 nx = -1; nx <= 1; ++nx)
@@ -1124,7 +2187,7 @@ static void ExtractBakePoints(const BakeInputData& bakeInput, std::vector<BakePo
                             continue;
 
                         int32 neighborX = x + nx;
-                        if(neighborX < 0 || neighborX >= int32(LightMapSize))
+                        if(neighborX < 0 || neighborX >= int32(validSizeX))
                             continue;
 
                         int32 dist = std::abs(nx) + std::abs(ny);
@@ -1146,7 +2209,8 @@ static void ExtractBakePoints(const BakeInputData& bakeInput, std::vector<BakePo
                 {
                     // Mark it as a gutter texel
                     bakePoint.Coverage = 0xFFFFFFFF;
-                    bakePoint.TexelPos = gutterTexel.NeighborPos;
+                    bakePoint.TexelPos = Uint2(gutterTexel.NeighborPos.x + texelOffsetX,
+                                               gutterTexel.NeighborPos.y + texelOffsetY);
                     gutterTexels.push_back(gutterTexel);
                 }
             }
@@ -1155,12 +2219,140 @@ static void ExtractBakePoints(const BakeInputData& bakeInput, std::vector<BakePo
 
     for(uint64 i = 0; i < NumTargets; ++i)
         stagingTextures[i].Unmap(context, 0);
+}
+
+// Computes lightmap sample points and gutter texels. The grid of texels for each page is stored
+// at the page's FirstTexel offset, and the active points are compacted and appended after that.
+static void ExtractBakePoints(const BakeInputData& bakeInput, const BakePage* bakePages, uint64 numPages,
+                              std::vector<BakePoint>& bakePoints, std::vector<GutterTexel>& gutterTexels)
+{
+    Assert_(numPages > 0);
+
+    const uint32 LightMapSize = AppSettings::LightMapResolution;
+    const BakePage& lastPage = bakePages[numPages - 1];
+    const uint64 NumTexels = lastPage.FirstTexel + uint64(lastPage.Size) * lastPage.Size;
 
+    bakePoints.clear();
+    bakePoints.resize(NumTexels);
+    gutterTexels.clear();
+
+    Timer timer;
+    PrintString("Extracting light map sample points...");
+
+    // Rasterize the mesh to the lightmap in UV space, one page at a time
+    BakePointRasterizer rasterizer;
+    rasterizer.Initialize(bakeInput.Device, LightMapSize);
+
+    std::vector<BakePoint> activePoints;
+    for(uint64 pageIdx = 0; pageIdx < numPages; ++pageIdx)
+    {
+        const BakePage& page = bakePages[pageIdx];
+        rasterizer.Rasterize(*bakeInput.SceneModel, LightMapSize, uint32(pageIdx), Uint2(0, 0), LightMapSize,
+                             page.Size, &bakePoints[page.FirstTexel], &activePoints, gutterTexels);
+    }
+
+    bakePoints.insert(bakePoints.end(), activePoints.begin(), activePoints.end());
 
     timer.Update();
     PrintString("Finished! (%fs)", timer.DeltaSecondsF());
 }
 
+// Returns the bounds of every vertex in the scene
+static void ComputeSceneBounds(const BVHData& bvhData, Float3& sceneMin, Float3& sceneMax)
+{
+    sceneMin = FLT_MAX;
+    sceneMax = -FLT_MAX;
+    for(const Vertex& vertex : bvhData.Vertices)
+    {
+        sceneMin = Float3::Min(sceneMin, vertex.Position);
+        sceneMax = Float3::Max(sceneMax, vertex.Position);
+    }
+}
+
+// Spreads the lower 21 bits of x out to every third bit
+static uint64 SpreadBits3(uint64 x)
+{
+    x &= 0x1FFFFF;
+    x = (x | (x << 32)) & 0x1F00000000FFFF;
+    x = (x | (x << 16)) & 0x1F0000FF0000FF;
+    x = (x | (x << 8)) & 0x100F00F00F00F00F;
+    x = (x | (x << 4)) & 0x10C30C30C30C30C3;
+    x = (x | (x << 2)) & 0x1249249249249249;
+    return x;
+}
+
+// Sorts the bake groups of every page along a Morton curve through the centers of their bake points,
+// so that the groups that are baked at the same time hit the same parts of the BVH and the same
+// material textures. Groups without any bake points go last.
+static void BuildBakeGroupOrder(const BakePage* bakePages, uint64 numPages, uint64 numGroups,
+                                const std::vector<BakePoint>& bakePoints, std::vector<uint32>& groupOrder)
+{
+    std::vector<Float3> groupCenters(numGroups);
+    std::vector<uint32> groupNumPoints(numGroups, 0);
+    Float3 boundsMin = FLT_MAX;
+    Float3 boundsMax = -FLT_MAX;
+
+    for(uint64 pageIdx = 0; pageIdx < numPages; ++pageIdx)
+    {
+        const BakePage& page = bakePages[pageIdx];
+        const uint64 lightMapSize = page.Size;
+        for(uint64 texelIdxY = 0; texelIdxY < lightMapSize; ++texelIdxY)
+        {
+            for(uint64 texelIdxX = 0; texelIdxX < lightMapSize; ++texelIdxX)
+            {
+                const BakePoint& bakePoint = bakePoints[page.FirstTexel + texelIdxY * lightMapSize + texelIdxX];
+                if(bakePoint.Coverage == 0 || bakePoint.Coverage == 0xFFFFFFFF)
+                    continue;
+
+                const uint64 groupIdx = page.FirstGroup + (texelIdxY / BakeGroupSizeY) * page.NumGroupsX
+                                        + texelIdxX / BakeGroupSizeX;
+                groupCenters[groupIdx] += bakePoint.Position;
+                groupNumPoints[groupIdx] += 1;
+            }
+        }
+    }
+
+    for(uint64 groupIdx = 0; groupIdx < numGroups; ++groupIdx)
+    {
+        if(groupNumPoints[groupIdx] == 0)
+            continue;
+
+        const Float3 center = groupCenters[groupIdx] / float(groupNumPoints[groupIdx]);
+        groupCenters[groupIdx] = center;
+        boundsMin = Float3::Min(boundsMin, center);
+        boundsMax = Float3::Max(boundsMax, center);
+    }
+
+    // Quantize the centers to 21 bits per axis within their bounds, and break ties with the group
+    // index so that the order doesn't depend on the sort
+    const float MaxCoord = float(0x1FFFFF);
+    const Float3 extents = boundsMax - boundsMin;
+    const Float3 scale = Float3(extents.x > 0.0f ? MaxCoord / extents.x : 0.0f,
+                                extents.y > 0.0f ? MaxCoord / extents.y : 0.0f,
+                                extents.z > 0.0f ? MaxCoord / extents.z : 0.0f);
+
+    std::vector<std::pair<uint64, uint32>> groupKeys(numGroups);
+    for(uint64 groupIdx = 0; groupIdx < numGroups; ++groupIdx)
+    {
+        uint64 key = UINT64_MAX;
+        if(groupNumPoints[groupIdx] > 0)
+        {
+            const Float3 coord = (groupCenters[groupIdx] - boundsMin) * scale;
+            key = SpreadBits3(uint64(Clamp(coord.x, 0.0f, MaxCoord)))
+                  | (SpreadBits3(uint64(Clamp(coord.y, 0.0f, MaxCoord))) << 1)
+                  | (SpreadBits3(uint64(Clamp(coord.z, 0.0f, MaxCoord))) << 2);
+        }
+
+        groupKeys[groupIdx] = std::make_pair(key, uint32(groupIdx));
+    }
+
+    std::sort(groupKeys.begin(), groupKeys.end());
+
+    groupOrder.resize(numGroups);
+    for(uint64 i = 0; i < numGroups; ++i)
+        groupOrder[i] = groupKeys[i].second;
+}
+
 // == Ground Truth Rendering ======================================================================
 
 // Data uses by the ground truth render thread
@@ -1184,17 +2376,19 @@ struct RenderThreadContext
     FixedArray<Half4>* RenderBuffer = nullptr;
     FixedArray<float>* RenderWeightBuffer = nullptr;
     volatile int64* CurrTile = nullptr;
+    PathGuide* Guide = nullptr;
+    uint64 NumGuideTrainingTiles = 0;
 
     void Init(FixedArray<Half4>* renderBuffer, FixedArray<float>* renderWeightBuffer,
-              const std::vector<IntegrationSamples>* samples,
-              volatile int64* currTile, const MeshBaker* meshBaker, uint64 newTag)
+              const std::vector<IntegrationSamples>* samples, volatile int64* currTile,
+              PathGuide* pathGuide, const MeshBaker* meshBaker, uint64 newTag)
     {
         if(RenderTag == uint64(-1))
             RandomGenerator.SeedWithRandomValue();
 
         RenderTag = newTag;
         SkyCache.Init(AppSettings::SunDirection, AppSettings::GroundAlbedo, AppSettings::Turbidity);
-        SceneBVH = &meshBaker->sceneBVH;
+        SceneBVH = meshBaker->sceneBVH;
         EnvMaps = meshBaker->input.EnvMapData;
         OutputWidth = meshBaker->currWidth;
         OutputHeight = meshBaker->currHeight;
@@ -1209,6 +2403,8 @@ struct RenderThreadContext
         CurrSampleMode = AppSettings::RenderSampleMode;
         CurrNumSamples = AppSettings::NumRenderSamples;
         Samples = samples;
+        Guide = AppSettings::EnablePathGuiding && pathGuide->Initialized() ? pathGuide : nullptr;
+        NumGuideTrainingTiles = AppSettings::PathGuidingTrainingPasses * CurrNumTiles;
     }
 };
 
@@ -1228,6 +2424,10 @@ static bool RenderDriver(RenderThreadContext& context)
     if(passIdx >= numSamplesPerPixel)
         return false;
 
+    // The first passes train the path guide, and the rest sample from it once the last training tile has frozen it
+    const bool guideTraining = context.Guide != nullptr && tileIdx < context.NumGuideTrainingTiles;
+    const bool useGuide = guideTraining || (context.Guide != nullptr && context.Guide->Frozen(context.RenderTag));
+
     const uint64 numPixelsPerTile = TileSize * TileSize;
 
     const Float4x4 viewProjInv = context.ViewProjInv;
@@ -1320,6 +2520,13 @@ static bool RenderDriver(RenderThreadContext& context)
             params.MaxPathLength = pathLength;
             params.RussianRouletteDepth = AppSettings::RenderRussianRouletteDepth;
             params.RussianRouletteProbability = AppSettings::RenderRussianRouletteProbability;
+            if(useGuide)
+            {
+                params.Guide = context.Guide;
+                params.GuideGeneration = context.RenderTag;
+                params.GuideTraining = guideTraining ? 1 : 0;
+                params.GuideFraction = AppSettings::PathGuidingFraction;
+            }
             Float3 radiance = PathTrace(params, context.RandomGenerator, illuminance, hitSky);
 
             FixedArray<Half4>& renderBuffer = *context.RenderBuffer;
@@ -1336,6 +2543,12 @@ static bool RenderDriver(RenderThreadContext& context)
         }
     }
 
+    if(guideTraining && context.Guide->FinishTrainingBatch(context.RenderTag, context.NumGuideTrainingTiles))
+    {
+        TraceSpan freezeSpan("Freeze Path Guide");
+        context.Guide->Freeze(context.RenderTag);
+    }
+
     return true;
 }
 
@@ -1346,7 +2559,9 @@ struct RenderThreadData
     FixedArray<float>* RenderWeightBuffer = nullptr;
     const std::vector<IntegrationSamples>* Samples = nullptr;
     volatile int64* CurrTile = nullptr;
+    PathGuide* Guide = nullptr;
     const MeshBaker* Baker = nullptr;
+    uint64 ThreadIdx = 0;
 };
 
 // Entry point for the ground truth render thread
@@ -1355,6 +2570,8 @@ static uint32 __stdcall RenderThread(void* data)
     RenderThreadData* threadData = reinterpret_cast<RenderThreadData*>(data);
     const MeshBaker* meshBaker = threadData->Baker;
 
+    Tracer::RegisterThread("Render Thread", threadData->ThreadIdx);
+
     RenderThreadContext context;
 
     while(meshBaker->killRenderThreads == false)
@@ -1362,10 +2579,19 @@ static uint32 __stdcall RenderThread(void* data)
         const uint64 currTag = meshBaker->renderTag;
         if(context.RenderTag != currTag)
             context.Init(threadData->RenderBuffer, threadData->RenderWeightBuffer, threadData->Samples,
-                         threadData->CurrTile, threadData->Baker, currTag);
+                         threadData->CurrTile, threadData->Guide, threadData->Baker, currTag);
 
-        if(RenderDriver(context) == false)
+        bool rendered = false;
+        {
+            TraceSpan renderSpan("Render Tile");
+            rendered = RenderDriver(context);
+        }
+
+        if(rendered == false)
+        {
+            TraceSpan idleSpan("Idle");
             Sleep(5);
+        }
     }
 
     return 0;
@@ -1380,6 +2606,95 @@ static uint64 GetNumThreads()
     return std::max<uint64>(1, sysInfo.dwNumberOfProcessors - 1);
 }
 
+// Recorded radiance samples are written to this index file, with the chunks next to it
+static const wchar* SampleStoreFilePath = L"RadianceSamples";
+static const uint64 ReplayJobsPerThread = 4;
+
+// Gathers the size of every page, which is part of the layout of a radiance sample store
+static void GetPageSizes(const BakePage* bakePages, uint64 numPages, uint32* pageSizes)
+{
+    for(uint64 pageIdx = 0; pageIdx < numPages; ++pageIdx)
+        pageSizes[pageIdx] = bakePages[pageIdx].Size;
+}
+
+// Every setting that changes the radiance seen by the bake points. Settings that only change how
+// noisy the bake is, like the radiance cache or path guiding, are left out. Every member is 4
+// bytes, so there's no padding to throw off the hash.
+struct RadianceSourceSettings
+{
+    uint32 SkyMode;
+    Float3 SkyColor;
+    Float3 GroundAlbedo;
+    float Turbidity;
+    bool32 EnableSun;
+    Float3 SunDirection;
+    Float3 SunTintColor;
+    float SunIntensityScale;
+    float SunSize;
+    bool32 NormalizeSunIntensity;
+    bool32 EnableAreaLight;
+    Float3 AreaLightColor;
+    float AreaLightSize;
+    Float3 AreaLightPosition;
+    bool32 EnableAreaLightShadows;
+    bool32 AnalyticAreaLight;
+    int32 AreaLightVisibilityRays;
+    bool32 BakeDirectAreaLight;
+    bool32 EnableEmissiveLights;
+    float EmissiveIntensity;
+    float DiffuseAlbedoScale;
+    bool32 EnableAlbedoMaps;
+    float MetallicOffset;
+    int32 MaxBakePathLength;
+    int32 NumIterativeBounces;
+    bool32 WorldSpaceBake;
+};
+
+// Hashes the scene together with the settings, so that recorded samples are only replayed into the
+// bake that they came from
+static Hash HashRadianceSources(const Hash& sceneHash)
+{
+    RadianceSourceSettings settings;
+    settings.SkyMode = AppSettings::SkyMode.Value();
+    settings.SkyColor = AppSettings::SkyColor.Value();
+    settings.GroundAlbedo = AppSettings::GroundAlbedo.Value();
+    settings.Turbidity = AppSettings::Turbidity.Value();
+    settings.EnableSun = AppSettings::EnableSun.Value();
+    settings.SunDirection = AppSettings::SunDirection.Value();
+    settings.SunTintColor = AppSettings::SunTintColor.Value();
+    settings.SunIntensityScale = AppSettings::SunIntensityScale.Value();
+    settings.SunSize = AppSettings::SunSize.Value();
+    settings.NormalizeSunIntensity = AppSettings::NormalizeSunIntensity.Value();
+    settings.EnableAreaLight = AppSettings::EnableAreaLight.Value();
+    settings.AreaLightColor = AppSettings::AreaLightColor.Value();
+    settings.AreaLightSize = AppSettings::AreaLightSize.Value();
+    settings.AreaLightPosition = Float3(AppSettings::AreaLightX.Value(), AppSettings::AreaLightY.Value(),
+                                        AppSettings::AreaLightZ.Value());
+    settings.EnableAreaLightShadows = AppSettings::EnableAreaLightShadows.Value();
+    settings.AnalyticAreaLight = AppSettings::AnalyticAreaLight.Value();
+    settings.AreaLightVisibilityRays = AppSettings::AreaLightVisibilityRays.Value();
+    settings.BakeDirectAreaLight = AppSettings::BakeDirectAreaLight.Value();
+    settings.EnableEmissiveLights = AppSettings::EnableEmissiveLights.Value();
+    settings.EmissiveIntensity = AppSettings::EmissiveIntensity.Value();
+    settings.DiffuseAlbedoScale = AppSettings::DiffuseAlbedoScale.Value();
+    settings.EnableAlbedoMaps = AppSettings::EnableAlbedoMaps.Value();
+    settings.MetallicOffset = AppSettings::MetallicOffset.Value();
+    settings.MaxBakePathLength = AppSettings::MaxBakePathLength.Value();
+    settings.NumIterativeBounces = AppSettings::IterativeBounces ? AppSettings::NumIterativeBounces.Value() : 1;
+    settings.WorldSpaceBake = AppSettings::WorldSpaceBake.Value();
+
+    const Hash hashes[2] = { sceneHash, GenerateHash(&settings, int(sizeof(settings))) };
+    return GenerateHash(hashes, int(sizeof(hashes)));
+}
+
+// Only the standalone Diffuse baker traces cosine-distributed rays
+static RadianceSampleDistribution BakeSampleDistribution(bool multiBasis, BakeModes bakeMode)
+{
+    if(multiBasis == false && bakeMode == BakeModes::Diffuse)
+        return RadianceSampleDistribution::Cosine;
+    return RadianceSampleDistribution::Uniform;
+}
+
 MeshBaker::MeshBaker()
 {
 }
@@ -1391,9 +2706,13 @@ MeshBaker::~MeshBaker()
 
 void MeshBaker::Initialize(const BakeInputData& inputData)
 {
+    Tracer::RegisterThread("Main Thread", 0);
+
     input = inputData;
-    for(uint64 i = 0; i < AppSettings::NumCubeMaps; ++i)
-        GetTextureData(input.Device, input.EnvMaps[i], input.EnvMapData[i]);
+    ParallelFor(AppSettings::NumCubeMaps, [&](uint64 i)
+    {
+        LoadTextureData(AppSettings::CubeMapPaths(i), input.EnvMapData[i]);
+    });
 
      // Init embree
     rtcDevice = rtcNewDevice();
@@ -1404,7 +2723,7 @@ void MeshBaker::Initialize(const BakeInputData& inputData)
         throw Exception(L"Failed to initialize embree!");
 
     // Build the BVHs
-    BuildBVH(*input.SceneModel, sceneBVH, input.Device, rtcDevice);
+    UpdateSceneBVH();
 
     renderSampleMode = AppSettings::RenderSampleMode;
     numRenderSamples = AppSettings::NumRenderSamples;
@@ -1413,6 +2732,7 @@ void MeshBaker::Initialize(const BakeInputData& inputData)
     numBakeSamples = AppSettings::NumBakeSamples;
 
     numThreads = GetNumThreads();
+    bakeStats.Init(numThreads);
     renderSamples.resize(numThreads);
     bakeSamples.resize(numThreads);
 
@@ -1436,87 +2756,438 @@ void MeshBaker::Shutdown()
     KillBakeThreads();
     KillRenderThreads();
 
+    sampleStore.Close();
+
     // Shutdown embree
-    sceneBVH = BVHData();
+    sceneBVH = nullptr;
+    for(uint64 i = 0; i < MaxCachedBVHs; ++i)
+        cachedBVHs[i].Reset();
     rtcDeleteDevice(rtcDevice);
     rtcDevice = nullptr;
 }
 
-MeshBakerStatus MeshBaker::Update(const Camera& camera, uint32 screenWidth, uint32 screenHeight,
-                                  ID3D11DeviceContext* deviceContext, const Model* currentModel)
+// Points sceneBVH at the BVH for the current scene model, building it only if none of the cached
+// BVHs were built from the same scene contents
+void MeshBaker::UpdateSceneBVH()
 {
-    Assert_(initialized);
+    const Hash sceneHash = HashSceneContents(*input.SceneModel);
 
-    const bool32 showGroundTruth = AppSettings::ShowGroundTruth;
+    uint64 bvhIdx = uint64(-1);
+    for(uint64 i = 0; i < MaxCachedBVHs; ++i)
+    {
+        if(cachedBVHs[i].Scene != nullptr && cachedBVHs[i].SceneHash == sceneHash)
+        {
+            bvhIdx = i;
+            break;
+        }
+    }
 
-    if(currentModel != input.SceneModel)
+    if(bvhIdx == uint64(-1))
     {
-        KillBakeThreads();
-        KillRenderThreads();
+        // Replace the least recently used BVH
+        bvhIdx = 0;
+        for(uint64 i = 1; i < MaxCachedBVHs; ++i)
+            if(cachedBVHLastUse[i] < cachedBVHLastUse[bvhIdx])
+                bvhIdx = i;
 
-        sceneBVH = BVHData();
-        input.SceneModel = currentModel;
-        BuildBVH(*input.SceneModel, sceneBVH, input.Device, rtcDevice);
+        BuildBVH(*input.SceneModel, sceneHash, cachedBVHs[bvhIdx], rtcDevice);
+    }
 
-        InterlockedIncrement64(&renderTag);
-        InterlockedIncrement64(&bakeTag);
-        currTile = 0;
-        currBakeBatch = 0;
+    cachedBVHLastUse[bvhIdx] = ++bvhUseCount;
+    sceneBVH = &cachedBVHs[bvhIdx];
+}
 
-        // Make sure that we re-extract the lightmap data
-        currLightMapSize = 0;
-    }
+// Restarts the light map bake. The bounce pass counters are reset before the tag changes, so that a
+// bake thread can never see the new tag together with the counts of the previous bake.
+void MeshBaker::RestartBake()
+{
+    for(uint64 passIdx = 0; passIdx < MaxBouncePasses; ++passIdx)
+        numFinishedBounceBatches[passIdx] = 0;
 
-    if(showGroundTruth == false)
-    {
-        // Handle light map size change, which requires re-extraction of sample points
-        const uint32 lightMapSize = AppSettings::LightMapResolution;
+    InterlockedIncrement64(&bakeTag);
+}
+
+// Sums up the transfer sets of one page weighted by the SH9 lighting, and stores the final results
+struct RelightPage
+{
+    const BakeResultStorage* Transfer;
+    BakeResultStorage* PageResults;
+    const XMVECTOR* Lighting;
+    uint64 BasisCount;
+
+    template<typename TType> void operator()(TType) const
+    {
+        const BakeResultStorage* transfer = Transfer;
+        BakeResultStorage& pageResults = *PageResults;
+        const XMVECTOR* lighting = Lighting;
+        const uint64 basisCount = BasisCount;
+        const uint64 pageSize = pageResults.LightMapSize();
+
+        // Every set has the same layout, so a texel is at the same offset in all of them
+        ParallelFor(pageSize, [&](uint64 y)
+        {
+            for(uint64 x = 0; x < pageSize; ++x)
+            {
+                const uint64 texelOffset = pageResults.TexelOffset<TType::Layout>(x, y);
+                for(uint64 basisIdx = 0; basisIdx < basisCount; ++basisIdx)
+                {
+                    XMVECTOR result = transfer[0].Load<TType::Format>(texelOffset, basisIdx).ToSIMD();
+                    for(uint64 setIdx = 0; setIdx < DistantLightTransfer::NumSets; ++setIdx)
+                        result = XMVectorMultiplyAdd(transfer[setIdx + 1].Load<TType::Format>(texelOffset, basisIdx).ToSIMD(),
+                                                     lighting[setIdx], result);
+                    pageResults.Store<TType::Format>(texelOffset, basisIdx, Float4(result));
+                }
+            }
+        });
+    }
+};
+
+// Projects the sky and the sun onto SH9, and computes the final results of every texel from its
+// transfer. The bake threads keep writing to the transfer in the meantime, which at worst mixes
+// the results of two adjacent passes.
+void MeshBaker::Relight()
+{
+    Assert_(currRelightable);
+    TraceSpan relightSpan("Relight");
+
+    // Integrate the sky over a regular grid of directions, weighted by their solid angle
+    SkyCache skyCache;
+    if(AppSettings::SkyMode == SkyModes::Procedural)
+        skyCache.Init(AppSettings::SunDirection, AppSettings::GroundAlbedo, AppSettings::Turbidity);
+
+    SH9Color skyLighting;
+    const float dTheta = Pi / RelightSkySamplesY;
+    const float dPhi = (2.0f * Pi) / RelightSkySamplesX;
+    for(uint64 y = 0; y < RelightSkySamplesY; ++y)
+    {
+        const float theta = (y + 0.5f) * dTheta;
+        const float solidAngle = std::sin(theta) * dTheta * dPhi;
+        for(uint64 x = 0; x < RelightSkySamplesX; ++x)
+        {
+            const float phi = (x + 0.5f) * dPhi;
+            const Float3 dir = Float3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+
+            Float3 skyRadiance;
+            if(AppSettings::SkyMode == SkyModes::Procedural)
+                skyRadiance = Skybox::SampleSky(skyCache, dir);
+            else if(AppSettings::SkyMode == SkyModes::Simple)
+                skyRadiance = AppSettings::SkyColor.Value() * FP16Scale;
+            else if(AppSettings::SkyMode >= AppSettings::CubeMapStart)
+                skyRadiance = SampleCubemap(dir, input.EnvMapData[AppSettings::SkyMode - AppSettings::CubeMapStart]);
+
+            skyLighting += ProjectOntoSH9Color(dir, skyRadiance * solidAngle);
+        }
+    }
+
+    // The sun disc is small enough to treat as a delta light with the same total power
+    SH9Color skyAndSunLighting = skyLighting;
+    if(AppSettings::EnableSun)
+    {
+        const float sunSolidAngle = 2.0f * Pi * (1.0f - std::cos(DegToRad(AppSettings::SunSize)));
+        const Float3 sunDir = Float3::Normalize(AppSettings::SunDirection);
+        skyAndSunLighting += ProjectOntoSH9Color(sunDir, AppSettings::SunLuminance() * sunSolidAngle);
+    }
+
+    // The w component is left at 0, so that the results keep the w of the non-distant lighting
+    XMVECTOR lighting[DistantLightTransfer::NumSets];
+    for(uint64 i = 0; i < DistantLightTransfer::NumCoefficients; ++i)
+    {
+        lighting[i] = Float4(skyLighting.Coefficients[i], 0.0f).ToSIMD();
+        lighting[DistantLightTransfer::NumCoefficients + i] = Float4(skyAndSunLighting.Coefficients[i], 0.0f).ToSIMD();
+    }
+
+    const uint64 basisCount = AppSettings::BasisCount(currBakeMode);
+    for(uint64 pageIdx = 0; pageIdx < currNumPages; ++pageIdx)
+    {
+        RelightPage relightPage;
+        relightPage.Transfer = &transferResults[pageIdx * NumTransferSets];
+        relightPage.PageResults = &bakeResults[pageIdx];
+        relightPage.Lighting = lighting;
+        relightPage.BasisCount = basisCount;
+        AccessBakeResults(bakeResults[pageIdx], relightPage);
+    }
+}
+
+// The batches of the bounce passes come before the ones for the final pass
+void MeshBaker::UpdateNumBakeBatches()
+{
+    const uint64 numSamples = AppSettings::NumBakeSamples * AppSettings::NumBakeSamples;
+    if(currMultiBasis == false && AppSettings::SupportsProgressiveIntegration(currBakeMode, currSolveMode))
+        currNumBakeBatches = currNumBakeGroups * numSamples;
+    else
+        currNumBakeBatches = currNumBakeGroups * BakeGroupSize;
+
+    currNumBounceBatches = currNumBakeGroups * numSamples;
+    currNumBakeBatches += currNumBouncePasses * currNumBounceBatches;
+}
+
+// Converts one basis of a page to half precision in a mapped staging texture, and fills in the gutter
+// texels of the page from their neighbors
+struct UploadPageBasis
+{
+    const BakeResultStorage* PageResults;
+    const std::vector<GutterTexel>* GutterTexels;
+    uint64 PageIdx;
+    uint64 BasisIdx;
+    const D3D11_MAPPED_SUBRESOURCE* Mapped;
+
+    template<typename TType> void operator()(TType) const
+    {
+        const BakeResultStorage& pageResults = *PageResults;
+        const uint64 pageSize = pageResults.LightMapSize();
+
+        Half4* dst = reinterpret_cast<Half4*>(Mapped->pData);
+        for(uint64 y = 0; y < pageSize; ++y)
+        {
+            for(uint64 x = 0; x < pageSize; ++x)
+                dst[x] = Half4(pageResults.Load<TType::Format>(pageResults.TexelOffset<TType::Layout>(x, y), BasisIdx));
+
+            dst += Mapped->RowPitch / sizeof(Half4);
+        }
+
+        const uint64 numGutterTexels = GutterTexels->size();
+        for(uint64 i = 0; i < numGutterTexels; ++i)
+        {
+            const GutterTexel& gutterTexel = (*GutterTexels)[i];
+            if(gutterTexel.PageIdx != PageIdx)
+                continue;
+
+            const uint64 srcOffset = pageResults.TexelOffset<TType::Layout>(gutterTexel.NeighborPos.x, gutterTexel.NeighborPos.y);
+            uint8* gutterDst = reinterpret_cast<uint8*>(Mapped->pData) + gutterTexel.TexelPos.y * Mapped->RowPitch;
+            gutterDst += gutterTexel.TexelPos.x * sizeof(Half4);
+            *reinterpret_cast<Half4*>(gutterDst) = Half4(pageResults.Load<TType::Format>(srcOffset, BasisIdx));
+        }
+    }
+};
+
+MeshBakerStatus MeshBaker::Update(const Camera& camera, uint32 screenWidth, uint32 screenHeight,
+                                  ID3D11DeviceContext* deviceContext, const Model* currentModel,
+                                  const std::vector<uint32>& lightMapPageSizes)
+{
+    Assert_(initialized);
+
+    const bool32 showGroundTruth = AppSettings::ShowGroundTruth;
+
+    // The bake threads only pick up the cache once the bake restarts, which happens after this
+    if(AppSettings::EnableRadianceCache && radianceCache.Initialized() == false)
+    {
+        KillBakeThreads();
+        radianceCache.Init();
+    }
+
+    if(currentModel != input.SceneModel)
+    {
+        KillBakeThreads();
+        KillRenderThreads();
+
+        input.SceneModel = currentModel;
+        UpdateSceneBVH();
+
+        InterlockedIncrement64(&renderTag);
+        RestartBake();
+        currTile = 0;
+        currBakeBatch = 0;
+
+        // Make sure that we re-extract the lightmap data, and re-fit the probe grid to the new scene
+        currLightMapSize = 0;
+        currProbeGridResolution = 0;
+    }
+    else if(AppSettings::HasLightMapPackingChanged())
+    {
+        // The app re-packs the charts before updating the baker, and rewrites the light map UV's of the
+        // model in place. The bounce passes read those UV's from the BVH's copy of the vertices, so it
+        // has to be rebuilt (or picked from the cache, since the vertices hash differently now).
+        KillBakeThreads();
+        KillRenderThreads();
+
+        UpdateSceneBVH();
+
+        InterlockedIncrement64(&renderTag);
+        RestartBake();
+        currTile = 0;
+        currBakeBatch = 0;
+    }
+
+    // The path guides cover the bounds of the scene, so they're re-fit along with the probe grid
+    const uint64 pathGuideResolution = uint64(AppSettings::PathGuidingGridResolution);
+    if(AppSettings::EnablePathGuiding && sceneBVH->Vertices.size() > 0
+       && (pathGuideModel != input.SceneModel || pathGuideResolution != currPathGuideResolution))
+    {
+        KillBakeThreads();
+        KillRenderThreads();
+
+        Float3 sceneMin;
+        Float3 sceneMax;
+        ComputeSceneBounds(*sceneBVH, sceneMin, sceneMax);
+
+        bakePathGuide.Init(sceneMin, sceneMax, pathGuideResolution);
+        renderPathGuide.Init(sceneMin, sceneMax, pathGuideResolution);
+        pathGuideModel = input.SceneModel;
+        currPathGuideResolution = pathGuideResolution;
+
+        InterlockedIncrement64(&renderTag);
+        RestartBake();
+        currTile = 0;
+        currBakeBatch = 0;
+    }
+
+    if(showGroundTruth == false)
+    {
+        // Handle light map size change, which requires re-extraction of sample points
+        const uint32 lightMapSize = AppSettings::LightMapResolution;
         const BakeModes bakeMode = AppSettings::BakeMode;
         const SolveModes solveMode = AppSettings::SolveMode;
-        if(lightMapSize != currLightMapSize || bakeMode != currBakeMode || solveMode != currSolveMode || AppSettings::WorldSpaceBake.Changed())
+
+        // No page sizes means that the authored UV's are in use, which map to a single full-size page
+        std::vector<uint32> pageSizes = lightMapPageSizes;
+        if(pageSizes.empty())
+            pageSizes.push_back(lightMapSize);
+        Assert_(pageSizes.size() <= AppSettings::MaxLightMapPages);
+
+        // A multi-basis bake already has the results of every bake mode, so switching between them
+        // only changes which of them are uploaded to the light map texture
+        const bool32 multiBasis = AppSettings::MultiBasisBake && AppSettings::OutOfCoreBake == false;
+        const bool bakeModeChanged = bakeMode != currBakeMode;
+        bool bakeRestarted = false;
+
+        // The packing settings only change the light map UV's while the charts are being packed
+        const bool packingChanged = AppSettings::HasLightMapPackingChanged();
+
+        if(lightMapSize != currLightMapSize || (bakeModeChanged && multiBasis == false) || multiBasis != currMultiBasis
+           || solveMode != currSolveMode || AppSettings::WorldSpaceBake.Changed()
+           || AppSettings::BakeResultLayout.Changed() || AppSettings::BakeResultFormat.Changed()
+           || packingChanged || AppSettings::OutOfCoreBake.Changed() || AppSettings::BakeTileSize.Changed()
+           || AppSettings::IterativeBounces.Changed() || AppSettings::NumIterativeBounces.Changed()
+           || AppSettings::RelightableBake.Changed() || pageSizes != currPageSizes)
         {
             KillBakeThreads();
             KillRenderThreads();
 
-            ExtractBakePoints(input, bakePoints, gutterTexels);
-            bakePointBuffer.Initialize(input.Device, sizeof(BakePoint), uint32(bakePoints.size()),
-                                       false, false, false, bakePoints.data());
+            // Lay out the bake groups and texels of each page back-to-back
+            currNumPages = pageSizes.size();
+            currNumBakeGroups = 0;
+            uint64 numTexels = 0;
+            for(uint64 pageIdx = 0; pageIdx < currNumPages; ++pageIdx)
+            {
+                const uint32 pageSize = std::min(pageSizes[pageIdx], lightMapSize);
+                const uint64 numGroupsX = (pageSize + (BakeGroupSizeX - 1)) / BakeGroupSizeX;
+                const uint64 numGroupsY = (pageSize + (BakeGroupSizeY - 1)) / BakeGroupSizeY;
+
+                BakePage& page = bakePages[pageIdx];
+                page.Size = pageSize;
+                page.NumGroupsX = numGroupsX;
+                page.FirstGroup = currNumBakeGroups;
+                page.FirstTexel = numTexels;
+
+                currNumBakeGroups += numGroupsX * numGroupsY;
+                numTexels += uint64(pageSize) * pageSize;
+            }
+
+            currPageSizes = pageSizes;
+            currLightMapSize = lightMapSize;
+            currOutOfCore = AppSettings::OutOfCoreBake;
+            currMultiBasis = multiBasis;
 
-            const uint64 basisCount = AppSettings::BasisCount(bakeMode);
-            const uint64 numTexels = lightMapSize * lightMapSize;
-            for(uint64 i = 0; i < AppSettings::MaxBasisCount; ++i)
-                bakeResults[i].Shutdown();
+            const uint64 basisCount = currMultiBasis ? MultiBasisBaker::BasisCount : AppSettings::BasisCount(bakeMode);
 
-            for(uint64 i = 0; i < basisCount; ++i)
-                bakeResults[i].Init(numTexels);
+            // Dropping the padding channel is only possible when the bake mode doesn't use it
+            BakeResultFormats resultFormat = AppSettings::BakeResultFormat;
+            if(resultFormat == BakeResultFormats::Float3 && (currMultiBasis || AppSettings::BakeResultsUseAlpha(bakeMode, solveMode)))
+                resultFormat = BakeResultFormats::Float4;
+
+            for(uint64 pageIdx = 0; pageIdx < AppSettings::MaxLightMapPages; ++pageIdx)
+                bakeResults[pageIdx].Shutdown();
+
+            if(currOutOfCore)
+            {
+                // Nothing is extracted up-front, the tiles generate their own bake points when they're loaded
+                bakePoints = std::vector<BakePoint>();
+                gutterTexels = std::vector<GutterTexel>();
+                bakeGroupOrder = std::vector<uint32>();
+                bakePointBuffer = StructuredBuffer();
 
-            const uint64 numGroupsX = (lightMapSize + (BakeGroupSizeX - 1)) / BakeGroupSizeX;
-            const uint64 numGroupsY = (lightMapSize + (BakeGroupSizeY - 1)) / BakeGroupSizeY;
-            if(AppSettings::SupportsProgressiveIntegration(bakeMode, solveMode))
-                currNumBakeBatches = numGroupsX * numGroupsY * AppSettings::NumBakeSamples * AppSettings::NumBakeSamples;
+                InitBakeTiles(basisCount, resultFormat);
+            }
             else
-                currNumBakeBatches = numGroupsX * numGroupsY * BakeGroupSize;
+            {
+                ShutdownBakeTiles();
+
+                ExtractBakePoints(input, bakePages, currNumPages, bakePoints, gutterTexels);
+                BuildBakeGroupOrder(bakePages, currNumPages, currNumBakeGroups, bakePoints, bakeGroupOrder);
+                bakePointBuffer.Initialize(input.Device, sizeof(BakePoint), uint32(bakePoints.size()),
+                                           false, false, false, bakePoints.data());
+
+                for(uint64 pageIdx = 0; pageIdx < currNumPages; ++pageIdx)
+                    bakeResults[pageIdx].Init(bakePages[pageIdx].Size, basisCount, AppSettings::BakeResultLayout, resultFormat);
+            }
+
+            // Every baker is run once per transfer set, which only works for the progressive ones
+            currRelightable = AppSettings::RelightableBake && currOutOfCore == false && currMultiBasis == false
+                              && AppSettings::SupportsProgressiveIntegration(bakeMode, solveMode);
+            for(uint64 pageIdx = 0; pageIdx < AppSettings::MaxLightMapPages; ++pageIdx)
+            {
+                for(uint64 setIdx = 0; setIdx < NumTransferSets; ++setIdx)
+                {
+                    BakeResultStorage& transferOutput = transferResults[pageIdx * NumTransferSets + setIdx];
+                    transferOutput.Shutdown();
+                    if(currRelightable && pageIdx < currNumPages)
+                        transferOutput.Init(bakePages[pageIdx].Size, basisCount, AppSettings::BakeResultLayout, resultFormat);
+                }
+            }
+
+            // The bounce passes read back results from anywhere in the light map, so they need all of it to be
+            // resident. The bounce results also have the distant lights baked in, so they can't be re-lit.
+            currIterativeBounces = AppSettings::IterativeBounces && currOutOfCore == false && currRelightable == false;
+            currNumBouncePasses = currIterativeBounces ? AppSettings::NumIterativeBounces - 1 : 0;
+            Assert_(currNumBouncePasses <= MaxBouncePasses);
+            for(uint64 bufferIdx = 0; bufferIdx < 2; ++bufferIdx)
+            {
+                for(uint64 pageIdx = 0; pageIdx < AppSettings::MaxLightMapPages; ++pageIdx)
+                {
+                    BakeResultStorage& bounceOutput = bounceResults[bufferIdx * AppSettings::MaxLightMapPages + pageIdx];
+                    bounceOutput.Shutdown();
+                    if(currNumBouncePasses > bufferIdx && pageIdx < currNumPages)
+                        bounceOutput.Init(bakePages[pageIdx].Size, 1, BakeResultLayouts::PerBasis, BakeResultFormats::Float4);
+                }
+            }
 
-            currLightMapSize = lightMapSize;
             currBakeMode = bakeMode;
             currSolveMode = solveMode;
-            InterlockedIncrement64(&bakeTag);
+            UpdateNumBakeBatches();
+
+            SGDistribution distribution = AppSettings::WorldSpaceBake ? SGDistribution::Spherical : SGDistribution::Hemispherical;
+            if(currMultiBasis)
+                InitializeMultiSGSolver(distribution);
+
+            RestartBake();
             currBakeBatch = 0;
+            bakeRestarted = true;
+        }
 
+        if(bakeRestarted || bakeModeChanged)
+        {
+            currBakeMode = bakeMode;
+            const uint64 basisCount = AppSettings::BasisCount(currBakeMode);
+
+            // The multi-basis bakers use their own lobes for every SG count, which leaves the solver's
+            // default initial guess alone while the bake threads are running
             const uint64 sgCount = AppSettings::SGCount(currBakeMode);
             SGDistribution distribution = AppSettings::WorldSpaceBake ? SGDistribution::Spherical : SGDistribution::Hemispherical;
-            if(sgCount > 0)
+            if(sgCount > 0 && currMultiBasis == false)
                 InitializeSGSolver(sgCount, distribution);
 
-            const SG* initalGuess = InitialGuess();
+            const SG* initalGuess = currMultiBasis ? InitialGuess(sgCount) : InitialGuess();
             sgSharpness = initalGuess[0].Sharpness;
             for(uint64  i = 0; i < sgCount; ++i)
                 sgDirections[i] = initalGuess[i].Axis;
 
+            // Out-of-core bakes may use a down-scaled texture for previewing the results
+            const uint32 previewSize = uint32((lightMapSize + bakePreviewScale - 1) / bakePreviewScale);
+
             D3D11_TEXTURE2D_DESC texDesc;
-            texDesc.Width = lightMapSize;
-            texDesc.Height = lightMapSize;
-            texDesc.ArraySize = uint32(basisCount);
+            texDesc.Width = previewSize;
+            texDesc.Height = previewSize;
+            texDesc.ArraySize = uint32(basisCount * currNumPages);
             texDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
             texDesc.CPUAccessFlags = 0;
             texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
@@ -1559,18 +3230,71 @@ MeshBakerStatus MeshBaker::Update(const Camera& camera, uint32 screenWidth, uint
             KillBakeThreads();
             KillRenderThreads();
 
+            if(bakeSeed != 0)
+                rng.SetSeed(bakeSeed);
+
             for(uint64 i = 0; i < numThreads; ++i)
                 GenerateIntegrationSamples(bakeSamples[i], numBakeSamples, BakeGroupSize, 1,
                                            bakeSampleMode, NumIntegrationTypes, rng);
 
-            const uint64 numGroupsX = (lightMapSize + (BakeGroupSizeX - 1)) / BakeGroupSizeX;
-            const uint64 numGroupsY = (lightMapSize + (BakeGroupSizeY - 1)) / BakeGroupSizeY;
-            if(AppSettings::SupportsProgressiveIntegration(bakeMode, solveMode))
-                currNumBakeBatches = numGroupsX * numGroupsY * AppSettings::NumBakeSamples * AppSettings::NumBakeSamples;
+            UpdateNumBakeBatches();
+
+            currNumProbeBatches = currNumProbeGroups * AppSettings::NumBakeSamples * AppSettings::NumBakeSamples;
+
+            RestartBake();
+            currBakeBatch = 0;
+        }
+
+        // Handle changes to the probe grid, which requires re-allocating the probe results
+        if(AppSettings::BakeProbes != currBakeProbes || AppSettings::ProbeBasis != currProbeBasis
+           || uint64(AppSettings::ProbeGridResolution) != currProbeGridResolution)
+        {
+            KillBakeThreads();
+            KillRenderThreads();
+
+            InitProbes();
+        }
+
+        // The reservoirs take up a slot for every bake point, so they're only kept around while sample reuse is on
+        const uint64 numReservoirs = AppSettings::SampleReuseEnabled() ? bakePoints.size() : 0;
+        if(numReservoirs != bakeReservoirs.NumTexels())
+        {
+            KillBakeThreads();
+
+            if(numReservoirs > 0)
+                bakeReservoirs.Init(numReservoirs);
             else
-                currNumBakeBatches = numGroupsX * numGroupsY * BakeGroupSize;
+                bakeReservoirs.Shutdown();
+
+            RestartBake();
+            currBakeBatch = 0;
+        }
+
+        // The store needs every sample of the bake, so the bake starts over whenever recording starts
+        // with a new layout. Stopping also restarts it, since the bake threads hold on to the store.
+        const bool recordSamples = AppSettings::RecordRadianceSamples && currOutOfCore == false && currRelightable == false;
+        const uint64 numSamplesPerTexel = AppSettings::NumBakeSamples * AppSettings::NumBakeSamples;
+        uint32 pageSizes[AppSettings::MaxLightMapPages] = { };
+        GetPageSizes(bakePages, currNumPages, pageSizes);
+        if(recordSamples && (sampleStore.Recording() == false || sampleStore.SamplesPerTexel() != numSamplesPerTexel
+           || sampleStore.MatchesLayout(currLightMapSize, pageSizes, currNumPages, currNumBakeGroups, BakeGroupSize) == false))
+        {
+            KillBakeThreads();
+
+            sampleStore.BeginRecording(SampleStoreFilePath, currLightMapSize, pageSizes, currNumPages, currNumBakeGroups,
+                                       BakeGroupSize, numSamplesPerTexel, BakeSampleDistribution(currMultiBasis, currBakeMode),
+                                       HashRadianceSources(sceneBVH->SceneHash));
+
+            RestartBake();
+            currBakeBatch = 0;
+        }
+        else if(recordSamples == false && sampleStore.Recording())
+        {
+            KillBakeThreads();
+
+            sampleStore.Close();
 
-            InterlockedIncrement64(&bakeTag);
+            RestartBake();
             currBakeBatch = 0;
         }
     }
@@ -1654,30 +3378,55 @@ MeshBakerStatus MeshBaker::Update(const Camera& camera, uint32 screenWidth, uint
         StartBakeThreads();
     }
 
-    // Change checks common to bake and ground truth
-    if(AppSettings::AreaLightColor.Changed() || AppSettings::AreaLightSize.Changed()
-        || AppSettings::AreaLightX.Changed() || AppSettings::AreaLightY.Changed()
-        || AppSettings::AreaLightZ.Changed() || AppSettings::EnableAreaLight.Changed()
-        || AppSettings::SkyMode.Changed() || AppSettings::EnableSun.Changed()
+    // Change checks common to bake and ground truth. A relightable bake only needs to be re-lit
+    // when the sky or the sun changes.
+    const bool distantLightChanged = AppSettings::SkyMode.Changed() || AppSettings::EnableSun.Changed()
         || AppSettings::SkyColor.Changed() || AppSettings::GroundAlbedo.Changed()
         || AppSettings::Turbidity.Changed() || AppSettings::HasSunDirChanged()
         || AppSettings::SunTintColor.Changed() || AppSettings::SunIntensityScale.Changed()
-        || AppSettings::SunSize.Changed() || AppSettings::NormalizeSunIntensity.Changed()
+        || AppSettings::SunSize.Changed() || AppSettings::NormalizeSunIntensity.Changed();
+    const bool sceneChanged = AppSettings::AreaLightColor.Changed() || AppSettings::AreaLightSize.Changed()
+        || AppSettings::AreaLightX.Changed() || AppSettings::AreaLightY.Changed()
+        || AppSettings::AreaLightZ.Changed() || AppSettings::EnableAreaLight.Changed()
         || AppSettings::DiffuseAlbedoScale.Changed() || AppSettings::EnableAlbedoMaps.Changed()
-        || AppSettings::EnableAreaLightShadows.Changed() || AppSettings::MetallicOffset.Changed())
+        || AppSettings::EnableAreaLightShadows.Changed() || AppSettings::MetallicOffset.Changed()
+        || AppSettings::AnalyticAreaLight.Changed() || AppSettings::AreaLightVisibilityRays.Changed()
+        || AppSettings::EnableEmissiveLights.Changed() || AppSettings::EmissiveIntensity.Changed();
+    if(distantLightChanged || sceneChanged)
     {
         InterlockedIncrement64(&renderTag);
-        InterlockedIncrement64(&bakeTag);
         currTile = 0;
-        currBakeBatch = 0;
+
+        if(currRelightable && sceneChanged == false)
+            relightPending = true;
+        else
+        {
+            RestartBake();
+            currBakeBatch = 0;
+        }
     }
 
     // Change checks for baking only
     if(AppSettings::BakeDirectAreaLight.Changed() || AppSettings::BakeRussianRouletteDepth.Changed()
        || AppSettings::BakeRussianRouletteProbability.Changed() || AppSettings::MaxBakePathLength.Changed()
-       || AppSettings::SolveMode.Changed())
+       || AppSettings::SolveMode.Changed() || AppSettings::EnableRadianceCache.Changed()
+       || AppSettings::RadianceCacheBounce.Changed() || AppSettings::RadianceCacheCellSize.Changed()
+       || AppSettings::RadianceCacheMinSamples.Changed() || AppSettings::EnableSampleReuse.Changed()
+       || AppSettings::SampleReuseCandidates.Changed() || AppSettings::SampleReuseNeighbors.Changed()
+       || AppSettings::SampleReuseRadius.Changed() || AppSettings::SampleReuseMaxHistory.Changed()
+       || AppSettings::SpatialBakeOrder.Changed())
+    {
+        RestartBake();
+        currBakeBatch = 0;
+    }
+
+    // Change checks for both baking and the ground truth render
+    if(AppSettings::EnablePathGuiding.Changed() || AppSettings::PathGuidingTrainingPasses.Changed()
+       || AppSettings::PathGuidingFraction.Changed())
     {
-        InterlockedIncrement64(&bakeTag);
+        InterlockedIncrement64(&renderTag);
+        currTile = 0;
+        RestartBake();
         currBakeBatch = 0;
     }
 
@@ -1716,12 +3465,56 @@ MeshBakerStatus MeshBaker::Update(const Camera& camera, uint32 screenWidth, uint
     status.LightMap = bakeTextureSRV;
     status.BakePoints = bakePointBuffer.SRView;
     status.NumBakePoints = bakePointBuffer.NumElements;
+    status.LightMapBasisCount = AppSettings::BasisCount(currBakeMode);
+    status.LightMapPageCount = std::max<uint64>(currNumPages, 1);
 
     const uint64 sgCount = AppSettings::SGCount(currBakeMode);
     for(uint64 i = 0; i < sgCount; ++i)
         status.SGDirections[i] = sgDirections[i];
     status.SGSharpness = sgCount > 0 ? sgSharpness : 0.0f;
 
+    if(showGroundTruth == false)
+        UpdateProbes(deviceContext, status);
+
+    // Restart the throughput counters along with the bake
+    if(bakeCountersTag != bakeTag)
+    {
+        bakeCountersTag = bakeTag;
+        bakeCounters.NumRays = 0;
+        bakeCounters.NumPaths = 0;
+        bakeCounters.NumFinishedBatches = 0;
+        bakeStats.Reset();
+        bakeTimer = Timer();
+        lastRelightTime = 0.0f;
+        lastRelightBatchCount = 0;
+    }
+
+    bakeTimer.Update();
+    status.BakeTime = bakeTimer.ElapsedSecondsF();
+    status.NumBakeRays = uint64(bakeCounters.NumRays);
+    status.NumBakePaths = uint64(bakeCounters.NumPaths);
+    status.NumBakeThreads = numThreads;
+    status.Stats = bakeStats.Aggregate();
+    if(AppSettings::EnableRadianceCache && AppSettings::ShowRadianceCacheOccupancy)
+        status.RadianceCache = radianceCache.Occupancy(bakeTag, AppSettings::RadianceCacheMinSamples);
+    if(currOutOfCore)
+        status.BakeComplete = numStoredTiles == atlasTiles.size();
+    else
+        status.BakeComplete = uint64(bakeCounters.NumFinishedBatches) >= currNumBakeBatches;
+
+    // A restarted bake overwrites the recorded samples, so the store is only complete once it finishes
+    if(sampleStore.Recording())
+    {
+        if(sampleStoreTag != bakeTag)
+        {
+            sampleStore.RestartRecording(BakeSampleDistribution(currMultiBasis, currBakeMode),
+                                         HashRadianceSources(sceneBVH->SceneHash));
+            sampleStoreTag = bakeTag;
+        }
+        else if(status.BakeComplete && sampleStore.Complete() == false)
+            sampleStore.FinishRecording();
+    }
+
     if(showGroundTruth)
     {
         const uint64 numPasses = AppSettings::NumRenderSamples * AppSettings::NumRenderSamples;
@@ -1752,54 +3545,371 @@ MeshBakerStatus MeshBaker::Update(const Camera& camera, uint32 screenWidth, uint
 
         deviceContext->CopyResource(renderTexture, stagingTexture);
     }
+    else if(currOutOfCore)
+    {
+        status.GroundTruthProgress = 1.0f;
+        lastTileNum = INT64_MAX;
+
+        UpdateBakeTiles(deviceContext, status);
+    }
     else
     {
-        const uint32 LightMapSize = AppSettings::LightMapResolution;
         const uint64 numPasses = AppSettings::NumBakeSamples * AppSettings::NumBakeSamples;
         status.BakeProgress = Saturate(currBakeBatch / (currNumBakeBatches - 1.0f));
         status.GroundTruthProgress = 1.0f;
         lastTileNum = INT64_MAX;
 
+        // Relightable bakes only update their final results every so often while the bake is running,
+        // once it finishes, and right away when the sky or the sun changes
+        if(currRelightable)
+        {
+            const int64 numFinishedBatches = bakeCounters.NumFinishedBatches;
+            const bool newResults = numFinishedBatches != lastRelightBatchCount;
+            if(relightPending || (newResults && (status.BakeComplete || status.BakeTime - lastRelightTime >= RelightInterval)))
+            {
+                Relight();
+                relightPending = false;
+                lastRelightTime = status.BakeTime;
+                lastRelightBatchCount = numFinishedBatches;
+            }
+        }
+
+        // Update one array slice per frame, cycling through the basis functions of every page
+        TraceSpan uploadSpan("Upload Light Map");
         const uint64 basisCount = AppSettings::BasisCount(currBakeMode);
+        const uint64 basisOffset = currMultiBasis ? MultiBasisBaker::BasisOffset(currBakeMode) : 0;
         bakeStagingTextureIdx = (bakeStagingTextureIdx + 1) % NumStagingTextures;
-        bakeTextureUpdateIdx = (bakeTextureUpdateIdx + 1) % basisCount;
+        bakeTextureUpdateIdx = (bakeTextureUpdateIdx + 1) % (basisCount * currNumPages);
         ID3D11Texture2D* stagingTexture = bakeStagingTextures[bakeStagingTextureIdx];
 
+        const uint64 pageIdx = bakeTextureUpdateIdx / basisCount;
+        const uint64 basisIdx = basisOffset + bakeTextureUpdateIdx % basisCount;
+        const uint32 pageSize = bakePages[pageIdx].Size;
+        const BakeResultStorage& pageResults = bakeResults[pageIdx];
+
         D3D11_MAPPED_SUBRESOURCE mapped;
         ZeroMemory(&mapped, sizeof(mapped));
         if(SUCCEEDED(deviceContext->Map(stagingTexture, 0, D3D11_MAP_WRITE, 0, &mapped)))
         {
-            Half4* dst = reinterpret_cast<Half4*>(mapped.pData);
-            const Float4* src = bakeResults[bakeTextureUpdateIdx].Data();
-            for(uint64 y = 0; y < LightMapSize; ++y)
-            {
-                for(uint64 x = 0; x < LightMapSize; ++x)
-                    dst[x] = Half4(src[x]);
+            UploadPageBasis uploadPageBasis;
+            uploadPageBasis.PageResults = &pageResults;
+            uploadPageBasis.GutterTexels = &gutterTexels;
+            uploadPageBasis.PageIdx = pageIdx;
+            uploadPageBasis.BasisIdx = basisIdx;
+            uploadPageBasis.Mapped = &mapped;
+            AccessBakeResults(pageResults, uploadPageBasis);
+
+            deviceContext->Unmap(stagingTexture, 0);
+        }
+
+        D3D11_BOX srcBox;
+        srcBox.left = 0;
+        srcBox.right = pageSize;
+        srcBox.top = 0;
+        srcBox.bottom = pageSize;
+        srcBox.front = 0;
+        srcBox.back = 1;
+        deviceContext->CopySubresourceRegion(bakeTexture, uint32(bakeTextureUpdateIdx), 0, 0, 0, stagingTexture, 0, &srcBox);
+    }
+
+    Sleep(0);
+
+    return status;
+}
+
+void MeshBaker::SetBakeSeed(uint32 seed)
+{
+    if(seed == bakeSeed)
+        return;
+
+    // Forces the integration samples to be re-generated on the next update, which restarts the bake
+    bakeSeed = seed;
+    numBakeSamples = 0;
+}
+
+// Loads one basis for a row of texels of a page
+struct LoadResultRow
+{
+    const BakeResultStorage* PageResults;
+    uint64 BasisIdx;
+    uint64 Y;
+    Float4* RowTexels;
+
+    template<typename TType> void operator()(TType) const
+    {
+        const BakeResultStorage& pageResults = *PageResults;
+        const uint64 pageSize = pageResults.LightMapSize();
+        for(uint64 x = 0; x < pageSize; ++x)
+            RowTexels[x] = pageResults.Load<TType::Format>(pageResults.TexelOffset<TType::Layout>(x, Y), BasisIdx);
+    }
+};
+
+// Appends every basis of every texel of a page to the results, in texel order
+struct AppendPageResults
+{
+    const BakeResultStorage* PageResults;
+    uint64 BasisOffset;
+    uint64 BasisCount;
+    std::vector<Float3>* Results;
 
-                dst += mapped.RowPitch / sizeof(Half4);
-                src += LightMapSize;
+    template<typename TType> void operator()(TType) const
+    {
+        const BakeResultStorage& pageResults = *PageResults;
+        const uint64 pageSize = pageResults.LightMapSize();
+        for(uint64 y = 0; y < pageSize; ++y)
+        {
+            for(uint64 x = 0; x < pageSize; ++x)
+            {
+                const uint64 texelOffset = pageResults.TexelOffset<TType::Layout>(x, y);
+                for(uint64 basisIdx = 0; basisIdx < BasisCount; ++basisIdx)
+                    Results->push_back(pageResults.Load<TType::Format>(texelOffset, BasisOffset + basisIdx).To3D());
             }
+        }
+    }
+};
 
-            const uint64 numGutterTexels = gutterTexels.size();
-            for(uint64 i = 0; i < numGutterTexels; ++i)
+void MeshBaker::GetBakeResults(std::vector<Float3>& results) const
+{
+    Assert_(currOutOfCore == false);
+
+    // Multi-basis bakes only return the results of the current bake mode
+    const uint64 basisOffset = currMultiBasis ? MultiBasisBaker::BasisOffset(currBakeMode) : 0;
+
+    results.clear();
+    for(uint64 pageIdx = 0; pageIdx < currNumPages; ++pageIdx)
+    {
+        const BakeResultStorage& pageResults = bakeResults[pageIdx];
+
+        AppendPageResults appendPageResults;
+        appendPageResults.PageResults = &pageResults;
+        appendPageResults.BasisOffset = basisOffset;
+        appendPageResults.BasisCount = currMultiBasis ? AppSettings::BasisCount(currBakeMode) : pageResults.BasisCount();
+        appendPageResults.Results = &results;
+        AccessBakeResults(pageResults, appendPageResults);
+    }
+}
+
+// Writes each light map page to its own EXR file, with one layer for every basis function. Multi-basis
+// bakes write one file per bake mode and page instead. The bake threads keep running during the
+// export, so the results can be slightly mixed between passes.
+void MeshBaker::ExportBakeResults(const wchar* filePathPrefix) const
+{
+    if(currOutOfCore)
+    {
+        PrintString("Bake results can't be exported while baking out-of-core");
+        return;
+    }
+
+    static const wchar* BakeModeNames[] = { L"Diffuse", L"Directional", L"HL2", L"SH4", L"SH9", L"H4",
+                                            L"H6", L"SG5", L"SG6", L"SG9", L"SG12" };
+    StaticAssert_(ArraySize_(BakeModeNames) == uint64(BakeModes::NumValues));
+
+    const uint64 numModes = currMultiBasis ? uint64(BakeModes::NumValues) : 1;
+    for(uint64 modeIdx = 0; modeIdx < numModes; ++modeIdx)
+    {
+        const BakeModes bakeMode = currMultiBasis ? BakeModes(modeIdx) : currBakeMode;
+        const uint64 basisOffset = currMultiBasis ? MultiBasisBaker::BasisOffset(bakeMode) : 0;
+
+        for(uint64 pageIdx = 0; pageIdx < currNumPages; ++pageIdx)
+        {
+            const BakeResultStorage& pageResults = bakeResults[pageIdx];
+            const uint64 pageSize = pageResults.LightMapSize();
+            const uint64 basisCount = currMultiBasis ? AppSettings::BasisCount(bakeMode) : pageResults.BasisCount();
+            if(pageSize == 0 || basisCount == 0)
+                continue;
+
+            std::vector<std::string> layerNames(basisCount);
+            for(uint64 basisIdx = 0; basisIdx < basisCount; ++basisIdx)
+                layerNames[basisIdx] = MakeAnsiString("Basis%02llu", basisIdx);
+
+            std::wstring filePath = MakeString(L"%ls_Page%llu.exr", filePathPrefix, pageIdx);
+            if(currMultiBasis)
+                filePath = MakeString(L"%ls_%ls_Page%llu.exr", filePathPrefix, BakeModeNames[modeIdx], pageIdx);
+
+            WriteEXR(filePath.c_str(), uint32(pageSize), uint32(pageSize), layerNames,
+                     [&](uint64 basisIdx, uint64 y, Float4* rowTexels)
+            {
+                LoadResultRow loadResultRow;
+                loadResultRow.PageResults = &pageResults;
+                loadResultRow.BasisIdx = basisOffset + basisIdx;
+                loadResultRow.Y = y;
+                loadResultRow.RowTexels = rowTexels;
+                AccessBakeResults(pageResults, loadResultRow);
+            });
+
+            PrintString("Exported %llu bake result layers to %ls", basisCount, filePath.c_str());
+        }
+    }
+}
+
+// Runs the recorded samples of every texel through a baker, and stores the final results. Nothing is
+// traced, the bake points are only needed for rotating the sample directions into world space.
+// Uniformly distributed samples can be replayed into a baker that expects cosine-distributed ones
+// by weighting them with the ratio of the two PDFs, which is 2 * cos(theta). The direct area light
+// samples are irradiance / Pi, and don't depend on the PDF of the sample directions.
+template<typename TBaker> static void ReplaySamples(const RadianceSampleStore& store, const BakePage* bakePages,
+                                                    uint64 numPages, const BakePoint* bakePoints,
+                                                    BakeResultStorage* bakeOutput, RadianceSampleDistribution distribution)
+{
+    const uint64 numSamples = store.SamplesPerTexel();
+    const bool cosineWeight = store.Distribution() != distribution;
+    Assert_(cosineWeight == false || distribution == RadianceSampleDistribution::Cosine);
+
+    // Each job replays a contiguous range of groups, so that a big light map doesn't flood the
+    // thread pool with one job per group
+    const uint64 numGroups = store.NumGroups();
+    if(numGroups == 0)
+        return;
+
+    const uint64 numJobs = std::min(std::max<uint64>(ThreadPool::NumThreads(), 1) * ReplayJobsPerThread, numGroups);
+    const uint64 groupsPerJob = (numGroups + numJobs - 1) / numJobs;
+
+    ParallelFor(numJobs, [&](uint64 jobIdx)
+    {
+        TBaker baker;
+        const uint64 jobEnd = std::min((jobIdx + 1) * groupsPerJob, numGroups);
+        for(uint64 globalGroupIdx = jobIdx * groupsPerJob; globalGroupIdx < jobEnd; ++globalGroupIdx)
+        {
+            uint64 pageIdx = 0;
+            while(pageIdx + 1 < numPages && globalGroupIdx >= bakePages[pageIdx + 1].FirstGroup)
+                ++pageIdx;
+
+            const BakePage& page = bakePages[pageIdx];
+            BakeResultStorage& pageOutput = bakeOutput[pageIdx];
+            const uint64 lightMapSize = page.Size;
+            const uint64 groupIdx = globalGroupIdx - page.FirstGroup;
+            const uint64 groupIdxX = groupIdx % page.NumGroupsX;
+            const uint64 groupIdxY = groupIdx / page.NumGroupsX;
+
+            for(uint64 groupTexelIdx = 0; groupTexelIdx < BakeGroupSize; ++groupTexelIdx)
             {
-                const GutterTexel& gutterTexel = gutterTexels[i];
-                const uint64 srcIdx = gutterTexel.NeighborPos.y * LightMapSize + gutterTexel.NeighborPos.x;
-                uint8* gutterDst = reinterpret_cast<uint8*>(mapped.pData) + gutterTexel.TexelPos.y * mapped.RowPitch;
-                gutterDst += gutterTexel.TexelPos.x * sizeof(Half4);
-                const Half4& gutterSrc = bakeResults[bakeTextureUpdateIdx][srcIdx];
-                *reinterpret_cast<Half4*>(gutterDst) = gutterSrc;
+                const uint64 texelIdxX = groupIdxX * BakeGroupSizeX + groupTexelIdx % BakeGroupSizeX;
+                const uint64 texelIdxY = groupIdxY * BakeGroupSizeY + groupTexelIdx / BakeGroupSizeX;
+                if(texelIdxX >= lightMapSize || texelIdxY >= lightMapSize)
+                    continue;
+
+                const BakePoint& bakePoint = bakePoints[page.FirstTexel + texelIdxY * lightMapSize + texelIdxX];
+                if(bakePoint.Coverage == 0 || bakePoint.Coverage == 0xFFFFFFFF)
+                    continue;
+
+                Float3x3 tangentFrame;
+                tangentFrame.SetXBasis(bakePoint.Tangent);
+                tangentFrame.SetYBasis(bakePoint.Bitangent);
+                tangentFrame.SetZBasis(bakePoint.Normal);
+
+                Float4 texelResults[TBaker::BasisCount];
+                baker.Init(numSamples, texelResults);
+
+                const StoredRadianceSample* samples = store.TexelSamples(globalGroupIdx, groupTexelIdx);
+                for(uint64 sampleIdx = 0; sampleIdx < numSamples; ++sampleIdx)
+                {
+                    const StoredRadianceSample& sample = samples[sampleIdx];
+                    const Float3 sampleDirTS = sample.DecodeDirection();
+                    const Float3 sampleDirWS = Float3::Normalize(Float3::Transform(sampleDirTS, tangentFrame));
+                    const bool directSample = sample.IsDirectSample();
+                    Float3 radiance = sample.DecodeRadiance();
+                    if(cosineWeight && directSample == false)
+                        radiance *= 2.0f * Saturate(sampleDirTS.z);
+
+                    AddBakeSample(baker, directSample, sampleDirTS, sample.DecodeSampleIdx(), radiance, sampleDirWS, bakePoint.Normal);
+                }
+
+                baker.FinalResult(texelResults);
+
+                const uint64 texelOffset = pageOutput.TexelOffset(texelIdxX, texelIdxY);
+                for(uint64 basisIdx = 0; basisIdx < TBaker::BasisCount; ++basisIdx)
+                    pageOutput.Store(texelOffset, basisIdx, texelResults[basisIdx]);
             }
+        }
+    });
+}
 
-            deviceContext->Unmap(stagingTexture, 0);
+void MeshBaker::ReplayRadianceSamples()
+{
+    if(currOutOfCore || currRelightable)
+    {
+        PrintString("Radiance samples can only be replayed into in-core bakes that aren't relightable");
+        return;
+    }
+
+    // The chunks of the store that's being recorded are already mapped, and can't be opened twice
+    RadianceSampleStore replayStore;
+    const RadianceSampleStore* store = &sampleStore;
+    if(sampleStore.Recording() && sampleStore.Complete() == false)
+    {
+        PrintString("Radiance samples can't be replayed until the bake has finished recording them");
+        return;
+    }
+    else if(sampleStore.Recording() == false)
+    {
+        if(replayStore.Open(SampleStoreFilePath) == false)
+        {
+            PrintString("No complete set of recorded radiance samples found at %ls.bin", SampleStoreFilePath);
+            return;
         }
 
-        deviceContext->CopySubresourceRegion(bakeTexture, uint32(bakeTextureUpdateIdx), 0, 0, 0, stagingTexture, 0, nullptr);
+        store = &replayStore;
     }
 
-    Sleep(0);
+    uint32 pageSizes[AppSettings::MaxLightMapPages] = { };
+    GetPageSizes(bakePages, currNumPages, pageSizes);
+    if(store->MatchesLayout(currLightMapSize, pageSizes, currNumPages, currNumBakeGroups, BakeGroupSize) == false)
+    {
+        PrintString("The radiance samples were recorded with a different light map layout");
+        return;
+    }
 
-    return status;
+    if((store->SourceHash() == HashRadianceSources(sceneBVH->SceneHash)) == false)
+    {
+        PrintString("The radiance samples were recorded from a different scene, or with different lighting settings");
+        return;
+    }
+
+    // Cosine-distributed samples barely cover the horizon, so they can't be re-weighted into a uniform distribution
+    const RadianceSampleDistribution distribution = BakeSampleDistribution(currMultiBasis, currBakeMode);
+    if(store->Distribution() == RadianceSampleDistribution::Cosine && distribution == RadianceSampleDistribution::Uniform)
+    {
+        PrintString("The radiance samples were recorded by a Diffuse bake, and can only be replayed into a Diffuse bake");
+        return;
+    }
+
+    KillBakeThreads();
+
+    Timer replayTimer;
+    if(currMultiBasis)
+        ReplaySamples<MultiBasisBaker>(*store, bakePages, currNumPages, bakePoints.data(), bakeResults, distribution);
+    else if(currBakeMode == BakeModes::Directional)
+        ReplaySamples<DirectionalBaker>(*store, bakePages, currNumPages, bakePoints.data(), bakeResults, distribution);
+    else if(currBakeMode == BakeModes::HL2)
+        ReplaySamples<HL2Baker>(*store, bakePages, currNumPages, bakePoints.data(), bakeResults, distribution);
+    else if(currBakeMode == BakeModes::SH4)
+        ReplaySamples<SH4Baker>(*store, bakePages, currNumPages, bakePoints.data(), bakeResults, distribution);
+    else if(currBakeMode == BakeModes::SH9)
+        ReplaySamples<SH9Baker>(*store, bakePages, currNumPages, bakePoints.data(), bakeResults, distribution);
+    else if(currBakeMode == BakeModes::H4)
+        ReplaySamples<H4Baker>(*store, bakePages, currNumPages, bakePoints.data(), bakeResults, distribution);
+    else if(currBakeMode == BakeModes::H6)
+        ReplaySamples<H6Baker>(*store, bakePages, currNumPages, bakePoints.data(), bakeResults, distribution);
+    else if(currBakeMode == BakeModes::SG5)
+        ReplaySamples<SG5Baker>(*store, bakePages, currNumPages, bakePoints.data(), bakeResults, distribution);
+    else if(currBakeMode == BakeModes::SG6)
+        ReplaySamples<SG6Baker>(*store, bakePages, currNumPages, bakePoints.data(), bakeResults, distribution);
+    else if(currBakeMode == BakeModes::SG9)
+        ReplaySamples<SG9Baker>(*store, bakePages, currNumPages, bakePoints.data(), bakeResults, distribution);
+    else if(currBakeMode == BakeModes::SG12)
+        ReplaySamples<SG12Baker>(*store, bakePages, currNumPages, bakePoints.data(), bakeResults, distribution);
+    else
+        ReplaySamples<DiffuseBaker>(*store, bakePages, currNumPages, bakePoints.data(), bakeResults, distribution);
+    replayTimer.Update();
+
+    // Park the bake at its end, so that the bake threads leave the results alone until it restarts
+    currBakeBatch = int64(currNumBakeBatches);
+    bakeCounters.NumFinishedBatches = int64(currNumBakeBatches);
+
+    const double replaySeconds = std::max(replayTimer.ElapsedSecondsD(), 0.000001);
+    const double replayMB = (store->NumSamples() * sizeof(StoredRadianceSample)) / (1024.0 * 1024.0);
+    PrintString("Replayed %llu radiance samples (%.2f MB) in %.3f seconds, %.2f MB/s", store->NumSamples(),
+                replayMB, replaySeconds, replayMB / replaySeconds);
 }
 
 void MeshBaker::KillBakeThreads()
@@ -1852,15 +3962,32 @@ void MeshBaker::StartBakeThreads()
     else if(currBakeMode == BakeModes::SG12)
         threadFunction = BakeThread<SG12Baker>;
 
+    if(currMultiBasis)
+        threadFunction = BakeThread<MultiBasisBaker>;
+
     bakeThreads.resize(numThreads);
     bakeThreadData.resize(numThreads);
     for(uint64 i = 0; i < numThreads; ++i)
     {
         BakeThreadData* threadData = &bakeThreadData[i];
         threadData->BakeOutput = bakeResults;
+        threadData->BakeTiles = currOutOfCore ? bakeTiles : nullptr;
         threadData->Samples = &bakeSamples;
         threadData->CurrBatch = &currBakeBatch;
+        threadData->ProbeOutput = probeResults.Data();
+        threadData->CurrProbeBatch = &currProbeBatch;
+        threadData->NumFinishedProbeBatches = &numFinishedProbeBatches;
+        threadData->Counters = &bakeCounters;
+        threadData->Stats = bakeStats.Shard(i);
+        threadData->RadianceCache = &radianceCache;
+        threadData->BounceResults = bounceResults;
+        threadData->NumFinishedBounceBatches = numFinishedBounceBatches;
+        threadData->TransferResults = transferResults;
+        threadData->Guide = &bakePathGuide;
+        threadData->Reservoirs = &bakeReservoirs;
+        threadData->SampleStore = &sampleStore;
         threadData->Baker = this;
+        threadData->ThreadIdx = i;
         bakeThreads[i] = HANDLE(_beginthreadex(nullptr, 0, threadFunction, threadData, 0, nullptr));
         if(bakeThreads[i] == 0)
         {
@@ -1909,7 +4036,9 @@ void MeshBaker::StartRenderThreads()
         threadData->RenderWeightBuffer = &renderWeightBuffer;
         threadData->Samples = &renderSamples;
         threadData->CurrTile = &currTile;
+        threadData->Guide = &renderPathGuide;
         threadData->Baker = this;
+        threadData->ThreadIdx = i;
         renderThreads[i] = HANDLE(_beginthreadex(nullptr, 0, RenderThread, threadData, 0, nullptr));
         if(renderThreads[i] == 0)
         {
@@ -1919,4 +4048,414 @@ void MeshBaker::StartRenderThreads()
     }
 
     renderThreadsSuspended = false;
-}
\ No newline at end of file
+}
+// == Out-of-core baking ==========================================================================
+
+// Out-of-core bakes are streamed to this file. It starts with a BakeTileFileHeader, followed by one
+// chunk per tile in the order that the tiles finish: a BakeTileChunkHeader, and then the results as
+// Half4's, with all TileSize x TileSize texels of the first basis followed by those of the next.
+static const wchar* BakeTileFilePath = L"OutOfCoreBake.bin";
+static const uint32 BakeTileFileMagic = 0x464F4F42;
+static const uint32 BakeTileFileVersion = 1;
+
+// Unused tile slots have their batch counter parked at this value, so that the bake threads skip them
+static const int64 BlockedTileBatch = INT64_MAX / 2;
+
+// Out-of-core bakes keep the preview texture within this much GPU memory by down-scaling it
+static const uint64 MaxBakePreviewMemory = 512 * 1024 * 1024;
+
+struct BakeTileFileHeader
+{
+    uint32 Magic;
+    uint32 Version;
+    uint32 LightMapSize;
+    uint32 TileSize;
+    uint32 NumTiles;
+    uint32 BasisCount;
+    uint32 BakeMode;
+    uint32 NumPages;
+    uint32 PageSizes[AppSettings::MaxLightMapPages];
+};
+
+struct BakeTileChunkHeader
+{
+    uint32 PageIdx;
+    uint32 OffsetX;
+    uint32 OffsetY;
+    uint32 TileSize;
+};
+
+void MeshBaker::InitBakeTiles(uint64 basisCount, BakeResultFormats resultFormat)
+{
+    const uint32 lightMapSize = uint32(currLightMapSize);
+
+    // Tiles need to be made up of whole bake groups, and there's no point in going larger than the atlas
+    StaticAssert_(BakeGroupSizeX == BakeGroupSizeY);
+    const uint32 maxTileSize = uint32((lightMapSize + (BakeGroupSizeX - 1)) / BakeGroupSizeX * BakeGroupSizeX);
+    uint32 tileSize = uint32((AppSettings::BakeTileSize + (BakeGroupSizeX - 1)) / BakeGroupSizeX * BakeGroupSizeX);
+    tileSize = std::min(tileSize, maxTileSize);
+
+    bakeTilePage.Size = tileSize;
+    bakeTilePage.NumGroupsX = tileSize / BakeGroupSizeX;
+    bakeTilePage.FirstGroup = 0;
+    bakeTilePage.FirstTexel = 0;
+    currNumBakeGroups = bakeTilePage.NumGroupsX * (tileSize / BakeGroupSizeY);
+
+    // Cover every page with tiles
+    atlasTiles.clear();
+    for(uint64 pageIdx = 0; pageIdx < currNumPages; ++pageIdx)
+    {
+        const uint32 numPageTiles = (bakePages[pageIdx].Size + (tileSize - 1)) / tileSize;
+        for(uint32 tileY = 0; tileY < numPageTiles; ++tileY)
+            for(uint32 tileX = 0; tileX < numPageTiles; ++tileX)
+                atlasTiles.push_back(Uint3(uint32(pageIdx), tileX * tileSize, tileY * tileSize));
+    }
+
+    for(uint64 slotIdx = 0; slotIdx < NumBakeTileSlots; ++slotIdx)
+    {
+        BakeTile& tile = bakeTiles[slotIdx];
+        tile.TileIdx = uint64(-1);
+        tile.BakePoints.resize(tileSize * tileSize);
+        tile.GutterTexels.clear();
+        tile.Results.Shutdown();
+        tile.Results.Init(tileSize, basisCount, AppSettings::BakeResultLayout, resultFormat);
+        tile.CurrBatch = BlockedTileBatch;
+        tile.NumFinishedBatches = 0;
+    }
+
+    if(tileRasterizer.TargetSize() != tileSize)
+        tileRasterizer.Initialize(input.Device, tileSize);
+
+    bakeTileScratch.resize(tileSize * tileSize * basisCount);
+
+    // Halve the preview resolution until it fits in the memory budget. The scale is capped so
+    // that every tile still maps to a whole number of preview texels.
+    const uint64 numSlices = basisCount * currNumPages;
+    bakePreviewScale = 1;
+    while(bakePreviewScale < BakeGroupSizeX)
+    {
+        const uint64 previewSize = (lightMapSize + bakePreviewScale - 1) / bakePreviewScale;
+        if(previewSize * previewSize * numSlices * sizeof(Half4) <= MaxBakePreviewMemory)
+            break;
+        bakePreviewScale *= 2;
+    }
+
+    // Make sure that the bake starts over with a fresh file
+    bakeTilesTag = -1;
+
+    const uint64 tileMemory = tileSize * tileSize * sizeof(BakePoint) + bakeTiles[0].Results.MemorySize();
+    PrintString("Out-of-core bake: %llu tiles of %ux%u texels, %llu resident (%.2f MB)",
+                uint64(atlasTiles.size()), tileSize, tileSize, NumBakeTileSlots,
+                (tileMemory * NumBakeTileSlots) / (1024.0 * 1024.0));
+}
+
+void MeshBaker::ShutdownBakeTiles()
+{
+    for(uint64 slotIdx = 0; slotIdx < NumBakeTileSlots; ++slotIdx)
+    {
+        BakeTile& tile = bakeTiles[slotIdx];
+        tile.TileIdx = uint64(-1);
+        tile.BakePoints = std::vector<BakePoint>();
+        tile.GutterTexels = std::vector<GutterTexel>();
+        tile.Results.Shutdown();
+        tile.CurrBatch = BlockedTileBatch;
+        tile.NumFinishedBatches = 0;
+    }
+
+    atlasTiles.clear();
+    bakeTileScratch = std::vector<Half4>();
+    bakePreviewScale = 1;
+    bakeTilesTag = -1;
+    bakeTileFile.Close();
+}
+
+// Starts the out-of-core bake over from the first tile. The bake threads must not be running.
+void MeshBaker::RestartBakeTiles()
+{
+    Assert_(bakeThreadsSuspended);
+
+    for(uint64 slotIdx = 0; slotIdx < NumBakeTileSlots; ++slotIdx)
+    {
+        BakeTile& tile = bakeTiles[slotIdx];
+        tile.TileIdx = uint64(-1);
+        tile.CurrBatch = BlockedTileBatch;
+        tile.NumFinishedBatches = 0;
+    }
+
+    nextAtlasTile = 0;
+    numStoredTiles = 0;
+    bakeTilesTag = bakeTag;
+
+    BakeTileFileHeader header;
+    ZeroMemory(&header, sizeof(header));
+    header.Magic = BakeTileFileMagic;
+    header.Version = BakeTileFileVersion;
+    header.LightMapSize = uint32(currLightMapSize);
+    header.TileSize = bakeTilePage.Size;
+    header.NumTiles = uint32(atlasTiles.size());
+    header.BasisCount = uint32(AppSettings::BasisCount(currBakeMode));
+    header.BakeMode = uint32(currBakeMode);
+    header.NumPages = uint32(currNumPages);
+    for(uint64 pageIdx = 0; pageIdx < currNumPages; ++pageIdx)
+        header.PageSizes[pageIdx] = bakePages[pageIdx].Size;
+
+    bakeTileFile.Close();
+    bakeTileFile.Open(BakeTileFilePath, FileOpenMode::Write);
+    bakeTileFile.Write(header);
+}
+
+// Streams out finished tiles, and re-uses their slots for the next tiles of the atlas
+void MeshBaker::UpdateBakeTiles(ID3D11DeviceContext* deviceContext, MeshBakerStatus& status)
+{
+    if(bakeTilesTag != bakeTag)
+    {
+        KillBakeThreads();
+        RestartBakeTiles();
+        StartBakeThreads();
+    }
+
+    const uint64 numAtlasTiles = atlasTiles.size();
+    float tileProgress = 0.0f;
+    for(uint64 slotIdx = 0; slotIdx < NumBakeTileSlots; ++slotIdx)
+    {
+        BakeTile& tile = bakeTiles[slotIdx];
+        if(tile.TileIdx != uint64(-1) && uint64(tile.NumFinishedBatches) == currNumBakeBatches)
+        {
+            StoreBakeTile(deviceContext, tile);
+            tile.TileIdx = uint64(-1);
+
+            ++numStoredTiles;
+            if(numStoredTiles == numAtlasTiles)
+            {
+                bakeTileFile.Close();
+                PrintString("Finished out-of-core bake, results written to %ls", BakeTileFilePath);
+            }
+        }
+
+        if(tile.TileIdx == uint64(-1) && nextAtlasTile < numAtlasTiles)
+            LoadBakeTile(tile, nextAtlasTile++);
+
+        if(tile.TileIdx != uint64(-1))
+            tileProgress += tile.NumFinishedBatches / float(currNumBakeBatches);
+    }
+
+    status.BakeProgress = numAtlasTiles > 0 ? Saturate((numStoredTiles + tileProgress) / numAtlasTiles) : 1.0f;
+}
+
+// Rasterizes the bake points of an atlas tile, and hands the tile over to the bake threads
+void MeshBaker::LoadBakeTile(BakeTile& tile, uint64 tileIdx)
+{
+    Assert_(tile.TileIdx == uint64(-1));
+
+    const Uint3 atlasTile = atlasTiles[tileIdx];
+    const uint32 tileSize = bakeTilePage.Size;
+
+    tile.TileIdx = tileIdx;
+    tile.PageIdx = atlasTile.x;
+    tile.Offset = Uint2(atlasTile.y, atlasTile.z);
+    tile.GutterTexels.clear();
+    tileRasterizer.Rasterize(*input.SceneModel, uint32(currLightMapSize), tile.PageIdx, tile.Offset, tileSize,
+                             tileSize, tile.BakePoints.data(), nullptr, tile.GutterTexels);
+    tile.Results.Clear();
+    tile.NumFinishedBatches = 0;
+
+    // Resetting the batch counter publishes the tile to the bake threads
+    InterlockedExchange64(&tile.CurrBatch, 0);
+}
+
+// Converts every basis of a tile's results to half precision, with one basis after another
+struct ConvertTileResults
+{
+    const BakeResultStorage* Results;
+    Half4* Dst;
+
+    template<typename TType> void operator()(TType) const
+    {
+        const BakeResultStorage& results = *Results;
+        const uint64 tileSize = results.LightMapSize();
+        Half4* dst = Dst;
+        for(uint64 basisIdx = 0; basisIdx < results.BasisCount(); ++basisIdx)
+            for(uint64 y = 0; y < tileSize; ++y)
+                for(uint64 x = 0; x < tileSize; ++x)
+                    *dst++ = Half4(results.Load<TType::Format>(results.TexelOffset<TType::Layout>(x, y), basisIdx));
+    }
+};
+
+// Writes a finished tile to the bake file, and copies it into the preview texture
+void MeshBaker::StoreBakeTile(ID3D11DeviceContext* deviceContext, BakeTile& tile)
+{
+    TraceSpan storeSpan("Store Tile");
+
+    InterlockedExchange64(&tile.CurrBatch, BlockedTileBatch);
+
+    const uint32 tileSize = bakeTilePage.Size;
+    const uint64 numTileTexels = tileSize * tileSize;
+    const uint64 basisCount = tile.Results.BasisCount();
+
+    // Convert to half precision one basis at a time, and fill in the gutter texels from their
+    // neighbors. Gutter texels whose neighbor lies in a different tile are left empty.
+    ConvertTileResults convertTileResults;
+    convertTileResults.Results = &tile.Results;
+    convertTileResults.Dst = bakeTileScratch.data();
+    AccessBakeResults(tile.Results, convertTileResults);
+
+    for(uint64 basisIdx = 0; basisIdx < basisCount; ++basisIdx)
+    {
+        Half4* dst = &bakeTileScratch[basisIdx * numTileTexels];
+        for(uint64 i = 0; i < tile.GutterTexels.size(); ++i)
+        {
+            const GutterTexel& gutterTexel = tile.GutterTexels[i];
+            dst[gutterTexel.TexelPos.y * tileSize + gutterTexel.TexelPos.x] =
+                dst[gutterTexel.NeighborPos.y * tileSize + gutterTexel.NeighborPos.x];
+        }
+    }
+
+    BakeTileChunkHeader chunk;
+    chunk.PageIdx = tile.PageIdx;
+    chunk.OffsetX = tile.Offset.x;
+    chunk.OffsetY = tile.Offset.y;
+    chunk.TileSize = tileSize;
+    bakeTileFile.Write(chunk);
+    bakeTileFile.Write(bakeTileScratch.size() * sizeof(Half4), bakeTileScratch.data());
+
+    // Point-sample the tile down to the preview resolution (in-place, since the destination
+    // index never passes the source index), and clip it to the edge of the preview texture
+    const uint32 scale = uint32(bakePreviewScale);
+    const uint32 previewSize = (uint32(currLightMapSize) + scale - 1) / scale;
+    const uint32 previewTileSize = tileSize / scale;
+    const uint32 previewX = tile.Offset.x / scale;
+    const uint32 previewY = tile.Offset.y / scale;
+    if(previewX >= previewSize || previewY >= previewSize)
+        return;
+
+    D3D11_BOX dstBox;
+    dstBox.left = previewX;
+    dstBox.right = std::min(previewX + previewTileSize, previewSize);
+    dstBox.top = previewY;
+    dstBox.bottom = std::min(previewY + previewTileSize, previewSize);
+    dstBox.front = 0;
+    dstBox.back = 1;
+
+    for(uint64 basisIdx = 0; basisIdx < basisCount; ++basisIdx)
+    {
+        Half4* texels = &bakeTileScratch[basisIdx * numTileTexels];
+        if(scale > 1)
+        {
+            for(uint64 y = 0; y < previewTileSize; ++y)
+                for(uint64 x = 0; x < previewTileSize; ++x)
+                    texels[y * previewTileSize + x] = texels[(y * scale) * tileSize + x * scale];
+        }
+
+        const uint32 slice = uint32(tile.PageIdx * basisCount + basisIdx);
+        deviceContext->UpdateSubresource(bakeTexture, slice, &dstBox, texels, previewTileSize * sizeof(Half4), 0);
+    }
+}
+
+// == Probe baking ================================================================================
+
+// Places the probes on a regular grid that covers the bounds of the scene, and allocates their
+// results. The bake threads must not be running.
+void MeshBaker::InitProbes()
+{
+    Assert_(bakeThreadsSuspended);
+
+    currBakeProbes = AppSettings::BakeProbes;
+    currProbeBasis = AppSettings::ProbeBasis;
+    currProbeGridResolution = AppSettings::ProbeGridResolution;
+
+    probeGrid = ProbeGrid();
+    probeResults.Shutdown();
+    probeBuffer = nullptr;
+    probeBufferSRV = nullptr;
+    currNumProbeGroups = 0;
+    currNumProbeBatches = 0;
+    currProbeBatch = 0;
+    numFinishedProbeBatches = 0;
+    probeBakeTag = bakeTag;
+    probeUploadBatch = uint64(-1);
+
+    if(currBakeProbes == false || sceneBVH->Vertices.size() == 0)
+        return;
+
+    Float3 sceneMin;
+    Float3 sceneMax;
+    ComputeSceneBounds(*sceneBVH, sceneMin, sceneMax);
+
+    // Size the cells so that the longest axis gets the full grid resolution, and put the probes
+    // at the cell centers so that they don't end up on the outer walls of the scene
+    const Float3 sceneExtents = sceneMax - sceneMin;
+    const float maxExtent = Max(Max(sceneExtents.x, sceneExtents.y), Max(sceneExtents.z, 0.0001f));
+    const float cellSize = maxExtent / currProbeGridResolution;
+
+    probeGrid.Size.x = std::max(uint32(std::ceil(sceneExtents.x / cellSize - 0.001f)), 1u);
+    probeGrid.Size.y = std::max(uint32(std::ceil(sceneExtents.y / cellSize - 0.001f)), 1u);
+    probeGrid.Size.z = std::max(uint32(std::ceil(sceneExtents.z / cellSize - 0.001f)), 1u);
+    probeGrid.Spacing = sceneExtents / Float3(float(probeGrid.Size.x), float(probeGrid.Size.y), float(probeGrid.Size.z));
+    probeGrid.Origin = sceneMin + probeGrid.Spacing * 0.5f;
+
+    const uint64 numProbes = probeGrid.NumProbes();
+    const uint64 basisCount = AppSettings::ProbeBasisCount(currProbeBasis);
+    probeResults.Init(numProbes * basisCount, Float4(0.0f, 0.0f, 0.0f, 0.0f));
+
+    currNumProbeGroups = (numProbes + (BakeGroupSize - 1)) / BakeGroupSize;
+    currNumProbeBatches = currNumProbeGroups * AppSettings::NumBakeSamples * AppSettings::NumBakeSamples;
+
+    // Probes see the full sphere of directions, so their lobes can't use the hemispherical
+    // distribution that the light map may be using
+    const uint64 sgCount = AppSettings::ProbeSGCount(currProbeBasis);
+    if(sgCount > 0)
+        GenerateUniformSGs(probeSGs, sgCount, SGDistribution::Spherical);
+
+    D3D11_BUFFER_DESC bufferDesc;
+    bufferDesc.ByteWidth = uint32(probeResults.Size() * sizeof(Float4));
+    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    bufferDesc.CPUAccessFlags = 0;
+    bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    bufferDesc.StructureByteStride = sizeof(Float4);
+    DXCall(input.Device->CreateBuffer(&bufferDesc, nullptr, &probeBuffer));
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    srvDesc.Buffer.ElementOffset = 0;
+    srvDesc.Buffer.ElementWidth = uint32(probeResults.Size());
+    DXCall(input.Device->CreateShaderResourceView(probeBuffer, &srvDesc, &probeBufferSRV));
+
+    PrintString("Baking %u x %u x %u probe grid (%llu probes)", probeGrid.Size.x, probeGrid.Size.y,
+                probeGrid.Size.z, numProbes);
+}
+
+// Restarts the probes along with the light map, and uploads their results for the visualizer
+void MeshBaker::UpdateProbes(ID3D11DeviceContext* deviceContext, MeshBakerStatus& status)
+{
+    if(probeBakeTag != bakeTag)
+    {
+        probeBakeTag = bakeTag;
+        currProbeBatch = 0;
+        numFinishedProbeBatches = 0;
+        probeUploadBatch = uint64(-1);
+    }
+
+    if(currNumProbeBatches == 0)
+        return;
+
+    const uint64 numFinishedBatches = std::min<uint64>(numFinishedProbeBatches, currNumProbeBatches);
+    status.ProbeProgress = Saturate(numFinishedBatches / float(currNumProbeBatches));
+    status.Probes = probeBufferSRV;
+    status.ProbeLayout = probeGrid;
+    status.ProbeBasis = currProbeBasis;
+
+    const uint64 sgCount = AppSettings::ProbeSGCount(currProbeBasis);
+    for(uint64 i = 0; i < sgCount; ++i)
+        status.ProbeSGDirections[i] = probeSGs[i].Axis;
+    status.ProbeSGSharpness = sgCount > 0 ? probeSGs[0].Sharpness : 0.0f;
+
+    // Stop uploading once the final results have made it to the GPU
+    if(AppSettings::ShowProbes && numFinishedBatches != probeUploadBatch)
+    {
+        TraceSpan uploadSpan("Upload Probes");
+        deviceContext->UpdateSubresource(probeBuffer, 0, nullptr, probeResults.Data(), 0, 0);
+        probeUploadBatch = numFinishedBatches;
+    }
+}
@@ -14,7 +14,11 @@
 #include <SF11_Math.h>
 #include <InterfacePointers.h>
 #include <Containers.h>
+#include <FileIO.h>
+#include <Timer.h>
 #include <Graphics/Textures.h>
+#include <Graphics/GraphicsTypes.h>
+#include <Graphics/DeviceStates.h>
 #include <Graphics/ShaderCompilation.h>
 #include <Graphics/SH.h>
 #include <Graphics/Skybox.h>
@@ -22,6 +26,12 @@
 #include "PathTracer.h"
 #include "SharedConstants.h"
 #include "AppSettings.h"
+#include "SG.h"
+#include "BakeStats.h"
+#include "RadianceCache.h"
+#include "PathGuide.h"
+#include "AreaLightReservoirs.h"
+#include "RadianceSampleStore.h"
 
 namespace SampleFramework11
 {
@@ -44,13 +54,28 @@ struct BakeInputData
 {
     const Model* SceneModel = nullptr;
     ID3D11Device* Device = nullptr;
-    ID3D11ShaderResourceView* EnvMaps[AppSettings::NumCubeMaps];
-    TextureData<Half4> EnvMapData[AppSettings::NumCubeMaps];
+    TextureData<Half4> EnvMapData[AppSettings::NumCubeMaps];   // Loaded by the baker
+};
+
+// A regular grid of probes covering the bounds of the scene. The probes are stored with x
+// changing fastest, followed by y and then z.
+struct ProbeGrid
+{
+    Float3 Origin;                      // Position of the first probe
+    Float3 Spacing;
+    Uint3 Size;
+
+    uint64 NumProbes() const
+    {
+        return uint64(Size.x) * Size.y * Size.z;
+    }
 
-    BakeInputData()
+    Float3 ProbePosition(uint64 probeIdx) const
     {
-        for(uint64 i = 0; i < ArraySize_(EnvMaps); ++i)
-            EnvMaps[i] = nullptr;
+        const uint64 x = probeIdx % Size.x;
+        const uint64 y = (probeIdx / Size.x) % Size.y;
+        const uint64 z = probeIdx / (uint64(Size.x) * Size.y);
+        return Origin + Float3(float(x), float(y), float(z)) * Spacing;
     }
 };
 
@@ -65,6 +90,239 @@ struct MeshBakerStatus
     uint64 GroundTruthSampleCount = 0;
     Float3 SGDirections[AppSettings::MaxSGCount];
     float SGSharpness = 0.0f;
+    uint64 LightMapBasisCount = 0;
+    uint64 LightMapPageCount = 1;
+    ID3D11ShaderResourceView* Probes = nullptr;
+    ProbeGrid ProbeLayout;
+    ProbeBases ProbeBasis = ProbeBases::SH9;
+    Float3 ProbeSGDirections[AppSettings::MaxSGCount];
+    float ProbeSGSharpness = 0.0f;
+    float ProbeProgress = 1.0f;
+    float BakeTime = 0.0f;              // Seconds since the light map bake last restarted
+    uint64 NumBakeRays = 0;
+    uint64 NumBakePaths = 0;
+    uint64 NumBakeThreads = 0;
+    bool BakeComplete = false;
+    BakeStats Stats;                    // Hot-path counters for the bake since it last restarted
+    RadianceCacheOccupancy RadianceCache;   // Only filled in when the occupancy is shown
+};
+
+// Counters for measuring the throughput of the bake, which the bake threads add to once per batch
+struct BakeCounters
+{
+    volatile int64 NumRays = 0;
+    volatile int64 NumPaths = 0;
+    volatile int64 NumFinishedBatches = 0;
+};
+
+// A single page of the light map atlas. A page covers the top-left Size x Size texels of its
+// slices in the light map texture array, and owns a contiguous range of bake groups.
+struct BakePage
+{
+    uint32 Size = 0;
+    uint64 NumGroupsX = 0;
+    uint64 FirstGroup = 0;
+    uint64 FirstTexel = 0;
+};
+
+// Stores the baked results for every texel and basis function of the light map. The
+// layout controls which results end up next to each other in memory: all texels of
+// a single basis, all bases of a single texel, or all bases of every texel within
+// an 8x8 bake group. The format can optionally drop the w channel or store halfs.
+class BakeResultStorage
+{
+
+public:
+
+    static const uint64 TileSizeX = 8;
+    static const uint64 TileSizeY = 8;
+    static const uint64 TileSize = TileSizeX * TileSizeY;
+
+    void Init(uint64 lightMapSize, uint64 basisCount, BakeResultLayouts layout, BakeResultFormats format);
+    void Shutdown();
+    void Clear();
+
+    // Returns the offset of the first basis result for a texel
+    uint64 TexelOffset(uint64 x, uint64 y) const
+    {
+        if(layout == BakeResultLayouts::Tiled)
+            return TexelOffset<BakeResultLayouts::Tiled>(x, y);
+        else if(layout == BakeResultLayouts::TexelInterleaved)
+            return TexelOffset<BakeResultLayouts::TexelInterleaved>(x, y);
+        else
+            return TexelOffset<BakeResultLayouts::PerBasis>(x, y);
+    }
+
+    Float4 Load(uint64 texelOffset, uint64 basisIdx) const
+    {
+        if(format == BakeResultFormats::Half4)
+            return Load<BakeResultFormats::Half4>(texelOffset, basisIdx);
+        else if(format == BakeResultFormats::Float3)
+            return Load<BakeResultFormats::Float3>(texelOffset, basisIdx);
+        else
+            return Load<BakeResultFormats::Float4>(texelOffset, basisIdx);
+    }
+
+    void Store(uint64 texelOffset, uint64 basisIdx, const Float4& value)
+    {
+        if(format == BakeResultFormats::Half4)
+            Store<BakeResultFormats::Half4>(texelOffset, basisIdx, value);
+        else if(format == BakeResultFormats::Float3)
+            Store<BakeResultFormats::Float3>(texelOffset, basisIdx, value);
+        else
+            Store<BakeResultFormats::Float4>(texelOffset, basisIdx, value);
+    }
+
+    // Versions of the above with the layout or format fixed at compile time, which have to match the
+    // storage. Loops over many texels should pick these once through AccessBakeResults().
+    template<BakeResultLayouts Layout> uint64 TexelOffset(uint64 x, uint64 y) const
+    {
+        Assert_(layout == Layout);
+        if(Layout == BakeResultLayouts::Tiled)
+        {
+            const uint64 tileIdx = (y / TileSizeY) * numTilesX + (x / TileSizeX);
+            const uint64 tileTexelIdx = (y % TileSizeY) * TileSizeX + (x % TileSizeX);
+            return (tileIdx * TileSize + tileTexelIdx) * basisCount;
+        }
+        else if(Layout == BakeResultLayouts::TexelInterleaved)
+            return (y * lightMapSize + x) * basisCount;
+        else
+            return y * lightMapSize + x;
+    }
+
+    template<BakeResultFormats Format> Float4 Load(uint64 texelOffset, uint64 basisIdx) const
+    {
+        Assert_(format == Format);
+        const uint64 elemIdx = texelOffset + basisIdx * basisStride;
+        Assert_(elemIdx < numElements);
+        if(Format == BakeResultFormats::Half4)
+            return reinterpret_cast<const Half4*>(data.Data())[elemIdx].ToFloat4();
+        else if(Format == BakeResultFormats::Float3)
+            return Float4(reinterpret_cast<const Float3*>(data.Data())[elemIdx], 1.0f);
+        else
+            return reinterpret_cast<const Float4*>(data.Data())[elemIdx];
+    }
+
+    template<BakeResultFormats Format> void Store(uint64 texelOffset, uint64 basisIdx, const Float4& value)
+    {
+        Assert_(format == Format);
+        const uint64 elemIdx = texelOffset + basisIdx * basisStride;
+        Assert_(elemIdx < numElements);
+        if(Format == BakeResultFormats::Half4)
+            reinterpret_cast<Half4*>(data.Data())[elemIdx] = Half4(value);
+        else if(Format == BakeResultFormats::Float3)
+            reinterpret_cast<Float3*>(data.Data())[elemIdx] = value.To3D();
+        else
+            reinterpret_cast<Float4*>(data.Data())[elemIdx] = value;
+    }
+
+    uint64 LightMapSize() const { return lightMapSize; }
+    uint64 BasisCount() const { return basisCount; }
+    BakeResultLayouts Layout() const { return layout; }
+    BakeResultFormats Format() const { return format; }
+    uint64 MemorySize() const { return data.Size(); }
+
+private:
+
+    FixedArray<uint8> data;
+    uint64 lightMapSize = 0;
+    uint64 basisCount = 0;
+    uint64 numTilesX = 0;
+    uint64 numElements = 0;
+    uint64 elementSize = 0;
+    uint64 basisStride = 0;
+    BakeResultLayouts layout = BakeResultLayouts::PerBasis;
+    BakeResultFormats format = BakeResultFormats::Float4;
+};
+
+// Names a layout and format of BakeResultStorage at compile time
+template<BakeResultLayouts L, BakeResultFormats F> struct BakeResultType
+{
+    static const BakeResultLayouts Layout = L;
+    static const BakeResultFormats Format = F;
+};
+
+template<BakeResultLayouts Layout, typename TFunc> void AccessBakeResults(BakeResultFormats format, const TFunc& func)
+{
+    if(format == BakeResultFormats::Half4)
+        func(BakeResultType<Layout, BakeResultFormats::Half4>());
+    else if(format == BakeResultFormats::Float3)
+        func(BakeResultType<Layout, BakeResultFormats::Float3>());
+    else
+        func(BakeResultType<Layout, BakeResultFormats::Float4>());
+}
+
+// Calls func(BakeResultType<Layout, Format>()) with the layout and format of the storage, so that
+// loops over every texel pick them once up-front instead of for every result they touch
+template<typename TFunc> void AccessBakeResults(const BakeResultStorage& storage, const TFunc& func)
+{
+    if(storage.Layout() == BakeResultLayouts::Tiled)
+        AccessBakeResults<BakeResultLayouts::Tiled>(storage.Format(), func);
+    else if(storage.Layout() == BakeResultLayouts::TexelInterleaved)
+        AccessBakeResults<BakeResultLayouts::TexelInterleaved>(storage.Format(), func);
+    else
+        AccessBakeResults<BakeResultLayouts::PerBasis>(storage.Format(), func);
+}
+
+// Rasterizes the scene meshes in light map UV space to generate the bake points. The render
+// targets and shaders are kept around, so that out-of-core tiles can be extracted one at a time.
+class BakePointRasterizer
+{
+
+public:
+
+    void Initialize(ID3D11Device* device, uint32 targetSize);
+
+    void Rasterize(const Model& model, uint32 lightMapSize, uint32 pageIdx, Uint2 regionOffset,
+                   uint32 regionSize, uint32 readSize, BakePoint* gridPoints,
+                   std::vector<BakePoint>* activePoints, std::vector<GutterTexel>& gutterTexels);
+
+    uint32 TargetSize() const { return targetSize; }
+
+private:
+
+    static const uint64 NumTargets = 5;
+
+    struct RasterizationConstants
+    {
+        uint32 VertexOffset;
+        float LightMapPage;
+        Float2 RegionOffset;
+        float RegionScale;
+    };
+
+    ID3D11Device* device = nullptr;
+    uint32 targetSize = 0;
+
+    RenderTarget2D targets[NumTargets];
+    RenderTarget2D msaaTargets[NumTargets];
+    StagingTexture2D stagingTextures[NumTargets];
+
+    VertexShaderPtr vs;
+    PixelShaderPtr ps;
+    VertexShaderPtr resolveVS;
+    PixelShaderPtr resolvePS;
+
+    RasterizerStates rasterizerStates;
+    BlendStates blendStates;
+    DepthStencilStates dsStates;
+
+    ConstantBuffer<RasterizationConstants> constantBuffer;
+};
+
+// A square tile of the light map that's resident while it's being baked out-of-core. The bake
+// threads pull batches from CurrBatch, and the tile is finished once NumFinishedBatches reaches
+// the batch count. The main thread then streams it to disk and re-uses the slot for the next tile.
+struct BakeTile
+{
+    uint64 TileIdx = uint64(-1);        // Index of the atlas tile, or -1 if the slot is unused
+    uint32 PageIdx = 0;
+    Uint2 Offset;                       // Position of the top-left texel within the page
+    std::vector<BakePoint> BakePoints;
+    std::vector<GutterTexel> GutterTexels;
+    BakeResultStorage Results;
+    volatile int64 CurrBatch = 0;
+    volatile int64 NumFinishedBatches = 0;
 };
 
 class MeshBaker
@@ -78,8 +336,22 @@ public:
     void Initialize(const BakeInputData& inputData);
     void Shutdown();
 
+    // An empty list of page sizes means that the light map is a single page of LightMapResolution texels
     MeshBakerStatus Update(const Camera& camera, uint32 screenWidth, uint32 screenHeight,
-                           ID3D11DeviceContext* deviceContext, const Model* currentModel);
+                           ID3D11DeviceContext* deviceContext, const Model* currentModel,
+                           const std::vector<uint32>& lightMapPageSizes);
+
+    // A non-zero seed makes the bake deterministic, by seeding the integration samples and the
+    // random numbers of every batch with it. The bake restarts if the seed changes.
+    void SetBakeSeed(uint32 seed);
+
+    // Returns the RGB of every basis of every texel, for all pages of an in-core bake
+    void GetBakeResults(std::vector<Float3>& results) const;
+    void ExportBakeResults(const wchar* filePathPrefix) const;
+
+    // Re-computes the light map of an in-core bake from the recorded radiance samples with the current
+    // bake mode and solve mode, which stops the bake until it restarts
+    void ReplayRadianceSamples();
 
     // Read/Write Data shared with render threads
     FixedArray<Half4> renderBuffer;
@@ -96,34 +368,103 @@ public:
     Float4x4 currViewProjInv;
     bool killRenderThreads = false;
     uint64 currNumTiles = 0;
+    PathGuide renderPathGuide;          // Trained by the render threads, only allocated while path guiding is enabled
 
     // Read/Write data shared with bake threads
-    FixedArray<Float4> bakeResults[AppSettings::MaxBasisCount];
+    BakeResultStorage bakeResults[AppSettings::MaxLightMapPages];
     volatile int64 currBakeBatch = 0;
+    BakeCounters bakeCounters;
+    BakeStatShards bakeStats;
+    RadianceCache radianceCache;        // Only allocated once the radiance cache is first enabled
+    PathGuide bakePathGuide;            // Only allocated while path guiding is enabled
+    AreaLightReservoirs bakeReservoirs; // Only allocated while sample reuse is enabled, with one reservoir per bake point
+    RadianceSampleStore sampleStore;    // Only recording while RecordRadianceSamples is enabled
 
     // Read-only data shared with bake threads
     volatile int64 bakeTag = 0;
     bool killBakeThreads = false;
     uint64 currNumBakeBatches = 0;
     uint64 currLightMapSize = 0;
+    uint64 currNumPages = 0;
+    uint64 currNumBakeGroups = 0;
+    BakePage bakePages[AppSettings::MaxLightMapPages];
+    std::vector<uint32> currPageSizes;
     BakeModes currBakeMode = BakeModes::Diffuse;
     SolveModes currSolveMode = SolveModes::NNLS;
+    bool32 currMultiBasis = false;      // Every bake mode is baked at once, and currBakeMode only picks the one that's shown
     std::vector<BakePoint> bakePoints;
     std::vector<GutterTexel> gutterTexels;
+    std::vector<uint32> bakeGroupOrder; // Bake groups sorted along a world-space Morton curve
+    uint32 bakeSeed = 0;
+
+    // Out-of-core baking, where only a few tiles of the light map are resident at a time
+    static const uint64 NumBakeTileSlots = 4;
+    BakeTile bakeTiles[NumBakeTileSlots];
+    BakePage bakeTilePage;
+    bool32 currOutOfCore = false;
+
+    // Iterative bounce baking, where the bounce passes run before the final pass and ping-pong
+    // between two sets of single-basis pages (indexed with bufferIdx * MaxLightMapPages + pageIdx)
+    static const uint64 MaxBouncePasses = 15;
+    BakeResultStorage bounceResults[2 * AppSettings::MaxLightMapPages];
+    volatile int64 numFinishedBounceBatches[MaxBouncePasses] = { };
+    bool32 currIterativeBounces = false;   // Always false for out-of-core bakes
+    uint64 currNumBouncePasses = 0;
+    uint64 currNumBounceBatches = 0;    // Number of batches in each bounce pass
+
+    // Relightable baking, where the bake threads fill in one set of pages for the lighting from
+    // non-distant lights and one for each coefficient of the distant light transfer (indexed with
+    // pageIdx * NumTransferSets + setIdx). The final results are computed from these by Relight().
+    static const uint64 NumTransferSets = DistantLightTransfer::NumSets + 1;
+    BakeResultStorage transferResults[NumTransferSets * AppSettings::MaxLightMapPages];
+    bool32 currRelightable = false;     // Only true for in-core bakes with a progressive bake mode
+
+    // Probe baking, which runs on the bake threads whenever there are no light map batches left
+    FixedArray<Float4> probeResults;    // ProbeBasisCount results per probe
+    volatile int64 currProbeBatch = 0;
+    volatile int64 numFinishedProbeBatches = 0;
+    ProbeGrid probeGrid;
+    ProbeBases currProbeBasis = ProbeBases::SH9;
+    SG probeSGs[AppSettings::MaxSGCount];
+    uint64 currNumProbeGroups = 0;
+    uint64 currNumProbeBatches = 0;
 
     // Read-only data shared with both bake and render threads
-    BVHData sceneBVH;
+    const BVHData* sceneBVH = nullptr;
     TextureData<Half4> envMap;
     BakeInputData input;
 
+    // The BVHs of the most recently used scenes are kept around, so that switching back to one
+    // of them doesn't need to rebuild anything
+    static const uint64 MaxCachedBVHs = 4;
+    BVHData cachedBVHs[MaxCachedBVHs];
+    uint64 cachedBVHLastUse[MaxCachedBVHs] = { };
+    uint64 bvhUseCount = 0;
+
 private:
 
+    void UpdateSceneBVH();
+
+    void RestartBake();
+    void UpdateNumBakeBatches();
+    void Relight();
+
     void KillBakeThreads();
     void StartBakeThreads();
 
     void KillRenderThreads();
     void StartRenderThreads();
 
+    void InitBakeTiles(uint64 basisCount, BakeResultFormats resultFormat);
+    void ShutdownBakeTiles();
+    void RestartBakeTiles();
+    void UpdateBakeTiles(ID3D11DeviceContext* deviceContext, MeshBakerStatus& status);
+    void LoadBakeTile(BakeTile& tile, uint64 tileIdx);
+    void StoreBakeTile(ID3D11DeviceContext* deviceContext, BakeTile& tile);
+
+    void InitProbes();
+    void UpdateProbes(ID3D11DeviceContext* deviceContext, MeshBakerStatus& status);
+
     bool initialized = false;
 
     RTCDevice rtcDevice = nullptr;
@@ -160,8 +501,40 @@ private:
     StructuredBuffer bakePointBuffer;
     bool bakeThreadsSuspended = false;
 
+    BakePointRasterizer tileRasterizer;
+    std::vector<Uint3> atlasTiles;      // Page index and texel offset of every tile of the atlas
+    uint64 nextAtlasTile = 0;
+    uint64 numStoredTiles = 0;
+    int64 bakeTilesTag = -1;
+    uint64 bakePreviewScale = 1;
+    File bakeTileFile;
+    std::vector<Half4> bakeTileScratch;
+
+    bool32 currBakeProbes = false;
+    uint64 currProbeGridResolution = 0;
+    int64 probeBakeTag = -1;
+    uint64 probeUploadBatch = uint64(-1);
+    ID3D11BufferPtr probeBuffer;
+    ID3D11ShaderResourceViewPtr probeBufferSRV;
+
+    int64 bakeCountersTag = -1;
+    Timer bakeTimer;
+
+    int64 sampleStoreTag = -1;
+
+    bool relightPending = false;
+    float lastRelightTime = 0.0f;
+    int64 lastRelightBatchCount = 0;
+
     Float3 sgDirections[AppSettings::MaxSGCount];
     float sgSharpness = 0.0f;
 
     int64 lastTileNum = INT64_MAX;
-};
\ No newline at end of file
+
+    const Model* pathGuideModel = nullptr;
+    uint64 currPathGuideResolution = 0;
+};
+
+// Runs synthetic samples through a standalone Diffuse baker and a multi-basis baker, and returns false
+// if their Diffuse results don't agree. Used by the microbenchmarks, before anything is timed.
+bool CheckMultiBasisDiffuse();
\ No newline at end of file
@@ -236,7 +236,7 @@ static void GenerateSphere(uint64 NumUSlices, uint64 NumVSlices, ID3D11Device* d
 }
 
 MeshRenderer::MeshRenderer() : currFrame(0), sceneModel(nullptr),
-                                numHemisphereIndices(0), numAreaLightIndices(0)
+                                numHemisphereIndices(0), numProbeSphereIndices(0), numAreaLightIndices(0)
 {
 }
 
@@ -253,6 +253,9 @@ void MeshRenderer::LoadShaders()
     visualizerVS = CompileVSFromFile(device, L"BakeDataVisualizer.hlsl", "VS", "vs_5_0");
     visualizerPS = CompilePSFromFile(device, L"BakeDataVisualizer.hlsl", "PS", "ps_5_0");
 
+    probeVisualizerVS = CompileVSFromFile(device, L"ProbeVisualizer.hlsl", "VS", "vs_5_0");
+    probeVisualizerPS = CompilePSFromFile(device, L"ProbeVisualizer.hlsl", "PS", "ps_5_0");
+
     fullScreenVS = CompileVSFromFile(device, L"EVSMConvert.hlsl", "FullScreenVS");
 
     CompileOptions opts;
@@ -312,6 +315,7 @@ void MeshRenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context
     meshPSConstants.Initialize(device);
     areaLightConstants.Initialize(device);
     visualizerConstants.Initialize(device);
+    probeVisualizerConstants.Initialize(device);
     evsmConstants.Initialize(device);
     reductionConstants.Initialize(device);
 
@@ -337,6 +341,8 @@ void MeshRenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context
 
     GenerateHemisphere(16, 4, device, hemisphereVB, hemisphereIB, numHemisphereIndices);
 
+    GenerateSphere(32, 16, device, probeSphereVB, probeSphereIB, numProbeSphereIndices);
+
     GenerateSphere(256, 192, device, areaLightVB, areaLightIB, numAreaLightIndices);
 
     D3D11_INPUT_ELEMENT_DESC elements[1];
@@ -351,6 +357,9 @@ void MeshRenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context
     DXCall(device->CreateInputLayout(elements, 1, visualizerVS->ByteCode->GetBufferPointer(),
                                      visualizerVS->ByteCode->GetBufferSize(), &visualizerInputLayout));
 
+    DXCall(device->CreateInputLayout(elements, 1, probeVisualizerVS->ByteCode->GetBufferPointer(),
+                                     probeVisualizerVS->ByteCode->GetBufferSize(), &probeVisualizerInputLayout));
+
     DXCall(device->CreateInputLayout(elements, 1, areaLightVS->ByteCode->GetBufferPointer(),
                                      areaLightVS->ByteCode->GetBufferSize(), &areaLightInputLayout));
 
@@ -633,6 +642,8 @@ void MeshRenderer::RenderMainPass(ID3D11DeviceContext* context, const Camera& ca
     for(uint64 i = 0; i < ArraySize_(status.SGDirections); ++i)
         meshPSConstants.Data.SGDirections[i] = Float4(status.SGDirections[i], 0.0f);
     meshPSConstants.Data.SGSharpness = status.SGSharpness;
+    meshPSConstants.Data.LightMapBasisCount = uint32(status.LightMapBasisCount);
+    meshPSConstants.Data.LightMapPageCount = uint32(status.LightMapPageCount);
     meshPSConstants.ApplyChanges(context);
     meshPSConstants.SetPS(context, 0);
 
@@ -1027,6 +1038,8 @@ void MeshRenderer::RenderBakeDataVisualizer(ID3D11DeviceContext* context, const
     for(uint64 i = 0; i < ArraySize_(status.SGDirections); ++i)
         visualizerConstants.Data.SGDirections[i] = Float4(status.SGDirections[i], 0.0f);
     visualizerConstants.Data.SGSharpness = status.SGSharpness;
+    visualizerConstants.Data.LightMapBasisCount = uint32(status.LightMapBasisCount);
+    visualizerConstants.Data.LightMapPageCount = uint32(status.LightMapPageCount);
     visualizerConstants.ApplyChanges(context);
     visualizerConstants.SetVS(context, 0);
     visualizerConstants.SetPS(context, 0);
@@ -1059,4 +1072,56 @@ void MeshRenderer::RenderBakeDataVisualizer(ID3D11DeviceContext* context, const
     ID3D11ShaderResourceView* nullSRVs[] = { nullptr };
     context->VSSetShaderResources(0, 1, nullSRVs);
     context->PSSetShaderResources(0, 1, nullSRVs);
+}
+
+// Renders a sphere for every probe of the probe grid, shaded with the probe's baked radiance
+void MeshRenderer::RenderProbeVisualizer(ID3D11DeviceContext* context, const Camera& camera, const MeshBakerStatus& status)
+{
+    PIXEvent event(L"Probe Visualizer");
+
+    const ProbeGrid& probeGrid = status.ProbeLayout;
+
+    // Set states
+    float blendFactor[4] = {1, 1, 1, 1};
+    context->OMSetBlendState(blendStates.BlendDisabled(), blendFactor, 0xFFFFFFFF);
+    context->OMSetDepthStencilState(depthStencilStates.DepthWriteEnabled(), 0);
+    context->RSSetState(rasterizerStates.NoCull());
+
+    // Set constant buffers
+    probeVisualizerConstants.Data.ViewProjection = Float4x4::Transpose(camera.ViewProjectionMatrix());
+    for(uint64 i = 0; i < ArraySize_(status.ProbeSGDirections); ++i)
+        probeVisualizerConstants.Data.SGDirections[i] = Float4(status.ProbeSGDirections[i], 0.0f);
+    probeVisualizerConstants.Data.SGSharpness = status.ProbeSGSharpness;
+    probeVisualizerConstants.Data.ProbeGridOrigin = probeGrid.Origin;
+    probeVisualizerConstants.Data.ProbeGridSpacing = probeGrid.Spacing;
+    probeVisualizerConstants.Data.ProbeRadius = Min(Min(probeGrid.Spacing.x, probeGrid.Spacing.y), probeGrid.Spacing.z) * 0.2f;
+    probeVisualizerConstants.Data.ProbeGridSize = probeGrid.Size;
+    probeVisualizerConstants.Data.ProbeBasis = uint32(status.ProbeBasis);
+    probeVisualizerConstants.ApplyChanges(context);
+    probeVisualizerConstants.SetVS(context, 0);
+    probeVisualizerConstants.SetPS(context, 0);
+
+    // Set shaders
+    context->DSSetShader(nullptr, nullptr, 0);
+    context->HSSetShader(nullptr, nullptr, 0);
+    context->GSSetShader(nullptr, nullptr, 0);
+    context->VSSetShader(probeVisualizerVS, nullptr, 0);
+    context->PSSetShader(probeVisualizerPS, nullptr, 0);
+
+    ID3D11ShaderResourceView* psSrvs[1] = { status.Probes };
+    context->PSSetShaderResources(0, 1, psSrvs);
+
+    // Draw a sphere for every probe
+    ID3D11Buffer* vertexBuffers[1] = { probeSphereVB };
+    uint32 vertexStrides[1] = { sizeof(Float3) };
+    uint32 offsets[1] = { 0 };
+    context->IASetVertexBuffers(0, 1, vertexBuffers, vertexStrides, offsets);
+    context->IASetIndexBuffer(probeSphereIB, DXGI_FORMAT_R32_UINT, 0);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->IASetInputLayout(probeVisualizerInputLayout);
+
+    context->DrawIndexedInstanced(uint32(numProbeSphereIndices), uint32(probeGrid.NumProbes()), 0, 0, 0);
+
+    ID3D11ShaderResourceView* nullSRVs[] = { nullptr };
+    context->PSSetShaderResources(0, 1, nullSRVs);
 }
\ No newline at end of file
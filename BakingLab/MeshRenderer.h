@@ -56,6 +56,8 @@ MeshRenderer();
     void RenderAreaLight(ID3D11DeviceContext* context, const Camera& camera);
     void RenderBakeDataVisualizer(ID3D11DeviceContext* context, const Camera& camera,
                                    const MeshBakerStatus& status);
+    void RenderProbeVisualizer(ID3D11DeviceContext* context, const Camera& camera,
+                               const MeshBakerStatus& status);
 
 protected:
 
@@ -96,6 +98,14 @@ protected:
     VertexShaderPtr visualizerVS;
     PixelShaderPtr visualizerPS;
 
+    ID3D11BufferPtr probeSphereVB;
+    ID3D11BufferPtr probeSphereIB;
+    uint64 numProbeSphereIndices;
+
+    ID3D11InputLayoutPtr probeVisualizerInputLayout;
+    VertexShaderPtr probeVisualizerVS;
+    PixelShaderPtr probeVisualizerPS;
+
     ID3D11BufferPtr areaLightVB;
     ID3D11BufferPtr areaLightIB;
     uint64 numAreaLightIndices;
@@ -158,6 +168,8 @@ protected:
 
         Float4Align Float4 SGDirections[AppSettings::MaxSGCount];
         float SGSharpness;
+        uint32 LightMapBasisCount;
+        uint32 LightMapPageCount;
     };
 
     struct AreaLightConstants
@@ -191,12 +203,27 @@ protected:
         Float4x4 ViewProjection;
         Float4Align Float4 SGDirections[AppSettings::MaxSGCount];
         float SGSharpness;
+        uint32 LightMapBasisCount;
+        uint32 LightMapPageCount;
+    };
+
+    struct ProbeVisualizerConstants
+    {
+        Float4x4 ViewProjection;
+        Float4Align Float4 SGDirections[AppSettings::MaxSGCount];
+        Float4Align Float3 ProbeGridOrigin;
+        float SGSharpness;
+        Float3 ProbeGridSpacing;
+        float ProbeRadius;
+        Uint3 ProbeGridSize;
+        uint32 ProbeBasis;
     };
 
     ConstantBuffer<MeshVSConstants> meshVSConstants;
     ConstantBuffer<MeshPSConstants> meshPSConstants;
     ConstantBuffer<AreaLightConstants> areaLightConstants;
     ConstantBuffer<VisualizerConstants> visualizerConstants;
+    ConstantBuffer<ProbeVisualizerConstants> probeVisualizerConstants;
     ConstantBuffer<EVSMConstants> evsmConstants;
     ConstantBuffer<ReductionConstants> reductionConstants;
 };
\ No newline at end of file
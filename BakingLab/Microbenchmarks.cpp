@@ -0,0 +1,231 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Microbenchmarks.h"
+
+#include <Timer.h>
+#include <FileIO.h>
+#include <Graphics/Model.h>
+#include <Graphics/SH.h>
+#include <Graphics/Skybox.h>
+#include <Graphics/Textures.h>
+#include <Graphics/Sampling.h>
+
+#include "AppSettings.h"
+#include "SG.h"
+#include "MeshBaker.h"
+
+static const uint64 NumTrials = 5;
+static const uint64 SqrtTexelSamples = 25;                          // Matches the default bake sample count
+static const uint64 NumTexelSamples = SqrtTexelSamples * SqrtTexelSamples;
+static const uint64 NumBatchSamples = 4096;                         // A 64x64 tile of texels or pixels
+static const wchar* ResultsPath = L"MicrobenchmarkResults.csv";
+
+// Results are accumulated here, so that the compiler can't throw away the work being timed
+static volatile float resultSink = 0.0f;
+
+// Calls "func" numBatches times and keeps the fastest of several trials, where each call of
+// "func" performs batchSize calls of the kernel being measured
+template<typename T> static void Measure(const char* name, uint64 batchSize, uint64 numBatches,
+                                         std::string& csvOutput, T func)
+{
+    // Warm up the caches first
+    func();
+
+    double bestTime = DBL_MAX;
+    for(uint64 trialIdx = 0; trialIdx < NumTrials; ++trialIdx)
+    {
+        Timer timer;
+        for(uint64 batchIdx = 0; batchIdx < numBatches; ++batchIdx)
+            func();
+        timer.Update();
+
+        bestTime = Min(bestTime, timer.ElapsedSecondsD());
+    }
+
+    const uint64 numCalls = batchSize * numBatches;
+    const double nsPerCall = bestTime * 1000000000.0 / numCalls;
+    const double callsPerSecond = numCalls / bestTime;
+
+    csvOutput += MakeAnsiString("%s,%llu,%llu,%f,%f\n", name, batchSize, numCalls, nsPerCall, callsPerSecond);
+    PrintString("%-28s %10.1f ns/call %12.2f Mcalls/s", name, nsPerCall, callsPerSecond / 1000000.0);
+}
+
+static void MeasureSGSolve(const char* name, SolveModes solveMode, const Float3* dirs, const Float3* colors,
+                           std::string& csvOutput)
+{
+    const SolveModes prevSolveMode = AppSettings::SolveMode;
+    AppSettings::SolveMode.SetValue(solveMode);
+
+    SG sgs[9];
+    SGSolveParam params;
+    params.XSamples = const_cast<Float3*>(dirs);
+    params.YSamples = const_cast<Float3*>(colors);
+    params.NumSamples = NumTexelSamples;
+    params.NumSGs = ArraySize_(sgs);
+    params.OutSGs = sgs;
+
+    Measure(name, 1, 64, csvOutput, [&]()
+    {
+        SolveSGs(params);
+        resultSink = resultSink + sgs[0].Amplitude.x;
+    });
+
+    AppSettings::SolveMode.SetValue(prevSolveMode);
+}
+
+void RunMicrobenchmarks(ID3D11Device* device, const Model& model, ID3D11ShaderResourceView* envMap)
+{
+    PrintString("Running microbenchmarks");
+
+    // Timing the bake kernels is pointless if the bakers don't agree with each other
+    if(CheckMultiBasisDiffuse())
+        PrintString("Multi-basis Diffuse matches the Diffuse baker");
+    else
+        PrintString("Multi-basis Diffuse doesn't match the Diffuse baker");
+
+    std::string csvOutput = "Kernel,BatchSize,Calls,NanosecondsPerCall,CallsPerSecond\n";
+
+    // Random inputs, shared by all of the kernels
+    Random rng;
+    rng.SetSeed(1337);
+
+    std::vector<Float2> uvs(NumBatchSamples);
+    std::vector<Float3> dirs(NumBatchSamples);
+    std::vector<Float3> colors(NumBatchSamples);
+    for(uint64 i = 0; i < NumBatchSamples; ++i)
+    {
+        uvs[i] = rng.RandomFloat2();
+        dirs[i] = SampleDirectionSphere(rng.RandomFloat(), rng.RandomFloat());
+        colors[i] = Float3(rng.RandomFloat(), rng.RandomFloat(), rng.RandomFloat());
+    }
+
+    std::vector<Float3> hemisphereDirs(NumTexelSamples);
+    for(uint64 i = 0; i < NumTexelSamples; ++i)
+        hemisphereDirs[i] = SampleDirectionHemisphere(rng.RandomFloat(), rng.RandomFloat());
+
+    // SH/H-basis projection, one texel's worth of samples per batch
+    Measure("ProjectOntoSH9Color", NumTexelSamples, 256, csvOutput, [&]()
+    {
+        SH9Color sh;
+        for(uint64 i = 0; i < NumTexelSamples; ++i)
+            sh += ProjectOntoSH9Color(hemisphereDirs[i], colors[i]);
+        resultSink = resultSink + sh.Coefficients[0].x;
+    });
+
+    std::vector<SH9Color> shTexels(NumBatchSamples);
+    for(uint64 i = 0; i < NumBatchSamples; ++i)
+        shTexels[i] = ProjectOntoSH9Color(dirs[i], colors[i]);
+
+    Measure("ConvertToH4", NumBatchSamples, 64, csvOutput, [&]()
+    {
+        float sum = 0.0f;
+        for(uint64 i = 0; i < NumBatchSamples; ++i)
+            sum += ConvertToH4(shTexels[i]).Coefficients[0].x;
+        resultSink = resultSink + sum;
+    });
+
+    Measure("ConvertToH6", NumBatchSamples, 64, csvOutput, [&]()
+    {
+        float sum = 0.0f;
+        for(uint64 i = 0; i < NumBatchSamples; ++i)
+            sum += ConvertToH6(shTexels[i]).Coefficients[0].x;
+        resultSink = resultSink + sum;
+    });
+
+    // SG solves, using 9 hemispherical lobes and one texel's worth of samples
+    InitializeSGSolver(9, SGDistribution::Hemispherical);
+
+    Measure("SGRunningAverage", NumTexelSamples, 64, csvOutput, [&]()
+    {
+        SG sgs[9];
+        float lobeWeights[9] = { };
+        for(uint64 i = 0; i < ArraySize_(sgs); ++i)
+            sgs[i] = InitialGuess()[i];
+
+        for(uint64 i = 0; i < NumTexelSamples; ++i)
+            SGRunningAverage(hemisphereDirs[i], colors[i], sgs, ArraySize_(sgs), float(i), lobeWeights, true);
+        resultSink = resultSink + sgs[0].Amplitude.x;
+    });
+
+    MeasureSGSolve("SolveNNLS", SolveModes::NNLS, hemisphereDirs.data(), colors.data(), csvOutput);
+    MeasureSGSolve("SolveSVD", SolveModes::SVD, hemisphereDirs.data(), colors.data(), csvOutput);
+
+    // Texture fetches, using the same CPU copies of the textures that the path tracer uses
+    const std::vector<MeshMaterial>& materials = model.Materials();
+    if(materials.size() > 0 && materials[0].DiffuseMap != nullptr)
+    {
+        TextureData<UByte4N> albedoMap;
+        GetTextureData(device, materials[0].DiffuseMap, albedoMap);
+
+        Measure("SampleTexture2D", NumBatchSamples, 256, csvOutput, [&]()
+        {
+            float sum = 0.0f;
+            for(uint64 i = 0; i < NumBatchSamples; ++i)
+                sum += Float3(SampleTexture2D(uvs[i], albedoMap)).x;
+            resultSink = resultSink + sum;
+        });
+    }
+
+    TextureData<Half4> envMapData;
+    GetTextureData(device, envMap, envMapData);
+
+    Measure("SampleCubemap", NumBatchSamples, 256, csvOutput, [&]()
+    {
+        float sum = 0.0f;
+        for(uint64 i = 0; i < NumBatchSamples; ++i)
+            sum += Float3(SampleCubemap(dirs[i], envMapData)).x;
+        resultSink = resultSink + sum;
+    });
+
+    // Procedural sky evaluation
+    SkyCache skyCache;
+    skyCache.Init(Float3::Normalize(Float3(0.25f, 0.5f, 0.5f)), Float3(0.5f), 2.0f);
+
+    Measure("Skybox::SampleSky", NumBatchSamples, 16, csvOutput, [&]()
+    {
+        float sum = 0.0f;
+        for(uint64 i = 0; i < NumBatchSamples; ++i)
+            sum += Skybox::SampleSky(skyCache, dirs[i]).x;
+        resultSink = resultSink + sum;
+    });
+
+    // Sample generation, one texel's worth of samples per call
+    std::vector<Float2> cmjSamples(NumTexelSamples);
+    uint32 cmjPattern = 0;
+    Measure("GenerateCMJSamples2D", 1, 1024, csvOutput, [&]()
+    {
+        GenerateCMJSamples2D(cmjSamples.data(), SqrtTexelSamples, SqrtTexelSamples, cmjPattern++);
+        resultSink = resultSink + cmjSamples[0].x;
+    });
+
+    Float3x3 tangentToWorld;
+    Measure("SampleDirectionGGX", NumBatchSamples, 256, csvOutput, [&]()
+    {
+        float sum = 0.0f;
+        for(uint64 i = 0; i < NumBatchSamples; ++i)
+            sum += SampleDirectionGGX(hemisphereDirs[i % NumTexelSamples], Float3(0.0f, 0.0f, 1.0f), 0.25f,
+                                      tangentToWorld, uvs[i].x, uvs[i].y).x;
+        resultSink = resultSink + sum;
+    });
+
+    Measure("Random::RandomFloat2", NumBatchSamples, 256, csvOutput, [&]()
+    {
+        Float2 sum;
+        for(uint64 i = 0; i < NumBatchSamples; ++i)
+            sum += rng.RandomFloat2();
+        resultSink = resultSink + sum.x;
+    });
+
+    WriteStringAsFile(ResultsPath, csvOutput);
+    PrintString("Microbenchmark results written to %ls", ResultsPath);
+}
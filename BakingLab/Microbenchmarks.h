@@ -0,0 +1,27 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+
+namespace SampleFramework11
+{
+    class Model;
+}
+
+using namespace SampleFramework11;
+
+// Times the CPU kernels that the bake and the ground truth renderer spend most of their time in,
+// using batch sizes that match how the bakers call them. The time per call and the throughput of
+// each kernel is printed and written to MicrobenchmarkResults.csv. The textures are read back
+// from the first material of the model and from the environment map. Before timing anything, it
+// checks that the Diffuse result of the multi-basis baker matches the standalone Diffuse baker.
+void RunMicrobenchmarks(ID3D11Device* device, const Model& model, ID3D11ShaderResourceView* envMap);
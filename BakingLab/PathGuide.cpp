@@ -0,0 +1,193 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "PathGuide.h"
+#include "AtomicFloat.h"
+
+// Fraction of every cell's distribution that's spread uniformly over the sphere, so that a few
+// noisy training samples can't make the PDF of a bin arbitrarily small
+static const float UniformFraction = 0.1f;
+
+static const float BinSolidAngle = (4.0f * Pi) / PathGuide::NumBins;
+
+// Maps a direction to its bin, using the cosine of the angle with +Y and the azimuth around it
+static uint64 DirectionToBin(const Float3& direction)
+{
+    float phi = std::atan2(direction.z, direction.x);
+    if(phi < 0.0f)
+        phi += 2.0f * Pi;
+
+    const float u = phi / (2.0f * Pi);
+    const float v = (Clamp(direction.y, -1.0f, 1.0f) + 1.0f) * 0.5f;
+    const uint64 binX = std::min(uint64(u * PathGuide::NumBinsX), PathGuide::NumBinsX - 1);
+    const uint64 binY = std::min(uint64(v * PathGuide::NumBinsY), PathGuide::NumBinsY - 1);
+    return binY * PathGuide::NumBinsX + binX;
+}
+
+void PathGuide::Init(const Float3& boundsMin_, const Float3& boundsMax, uint64 resolution)
+{
+    Assert_(resolution > 0);
+
+    const Float3 extents = boundsMax - boundsMin_;
+    const float maxExtent = Max(Max(extents.x, extents.y), Max(extents.z, 0.0001f));
+    const float size = maxExtent / resolution;
+
+    boundsMin = boundsMin_;
+    cellSize = size;
+    gridSize.x = std::max(uint32(std::ceil(extents.x / size)), 1u);
+    gridSize.y = std::max(uint32(std::ceil(extents.y / size)), 1u);
+    gridSize.z = std::max(uint32(std::ceil(extents.z / size)), 1u);
+
+    const uint64 numCells = uint64(gridSize.x) * gridSize.y * gridSize.z;
+    cells.Init(numCells);
+    cdfs.Init(numCells * NumBins, 0.0f);
+    trainingProgress = 0;
+    frozenGeneration = -1;
+}
+
+void PathGuide::Shutdown()
+{
+    cells.Shutdown();
+    cdfs.Shutdown();
+}
+
+uint64 PathGuide::CellIndex(const Float3& position) const
+{
+    Assert_(Initialized());
+
+    const Float3 gridPos = (position - boundsMin) / cellSize;
+    const uint64 x = uint64(Clamp(gridPos.x, 0.0f, gridSize.x - 1.0f));
+    const uint64 y = uint64(Clamp(gridPos.y, 0.0f, gridSize.y - 1.0f));
+    const uint64 z = uint64(Clamp(gridPos.z, 0.0f, gridSize.z - 1.0f));
+    return (z * gridSize.y + y) * gridSize.x + x;
+}
+
+void PathGuide::AddSample(uint64 cellIdx, const Float3& direction, float radiance, uint64 generation)
+{
+    Cell& cell = cells[cellIdx];
+    int64 currGeneration = cell.Generation;
+    if(currGeneration > int64(generation))
+        return;
+
+    if(currGeneration < int64(generation))
+    {
+        // Claim the cell for the new generation. A thread that adds to the cell in between the
+        // claim and the reset loses its sample, which only costs a bit of training.
+        if(InterlockedCompareExchange64(&cell.Generation, int64(generation), currGeneration) == currGeneration)
+        {
+            for(uint64 binIdx = 0; binIdx < NumBins; ++binIdx)
+                cell.Bins[binIdx] = 0;
+            cell.NumSamples = 0;
+            _WriteBarrier();
+        }
+
+        if(cell.Generation != int64(generation))
+            return;
+    }
+
+    AtomicAddFloat(&cell.Bins[DirectionToBin(direction)], radiance);
+    InterlockedIncrement(&cell.NumSamples);
+}
+
+bool PathGuide::FinishTrainingBatch(uint64 generation, uint64 numTrainingBatches)
+{
+    // Batches of an older bake can still finish after a newer one started, which mustn't reset
+    // the count of the newer one
+    const int64 newGeneration = int64(generation & 0xFFFFFFFF);
+    int64 oldValue = trainingProgress;
+    while(true)
+    {
+        const int64 oldGeneration = oldValue & 0xFFFFFFFF;
+        if(oldGeneration > newGeneration)
+            return false;
+
+        const int64 count = oldGeneration == newGeneration ? (oldValue >> 32) + 1 : 1;
+        const int64 newValue = (count << 32) | newGeneration;
+        const int64 prevValue = InterlockedCompareExchange64(&trainingProgress, newValue, oldValue);
+        if(prevValue == oldValue)
+            return uint64(count) == numTrainingBatches;
+        oldValue = prevValue;
+    }
+}
+
+void PathGuide::Freeze(uint64 generation)
+{
+    const uint64 numCells = cells.Size();
+    for(uint64 cellIdx = 0; cellIdx < numCells; ++cellIdx)
+    {
+        const Cell& cell = cells[cellIdx];
+        float* cdf = &cdfs[cellIdx * NumBins];
+
+        float binSum = 0.0f;
+        if(cell.Generation == int64(generation) && cell.NumSamples >= long(MinTrainingSamples))
+        {
+            for(uint64 binIdx = 0; binIdx < NumBins; ++binIdx)
+                binSum += std::max(AsFloat(cell.Bins[binIdx]), 0.0f);
+        }
+
+        if(binSum <= 0.0f || isfinite(binSum) == false)
+        {
+            cdf[NumBins - 1] = 0.0f;
+            continue;
+        }
+
+        float sum = 0.0f;
+        for(uint64 binIdx = 0; binIdx < NumBins; ++binIdx)
+        {
+            const float binProbability = std::max(AsFloat(cell.Bins[binIdx]), 0.0f) / binSum;
+            sum += Lerp(binProbability, 1.0f / NumBins, UniformFraction);
+            cdf[binIdx] = sum;
+        }
+
+        // Make sure that the last entry is exactly 1, since it doubles as the valid flag
+        cdf[NumBins - 1] = 1.0f;
+    }
+
+    _WriteBarrier();
+    frozenGeneration = int64(generation);
+}
+
+bool PathGuide::HasDistribution(uint64 cellIdx) const
+{
+    return cdfs[cellIdx * NumBins + NumBins - 1] > 0.0f;
+}
+
+Float3 PathGuide::SampleDirection(uint64 cellIdx, Float2 samplePoint) const
+{
+    Assert_(HasDistribution(cellIdx));
+    const float* cdf = &cdfs[cellIdx * NumBins];
+
+    // Pick the bin with a binary search, and then re-use the rest of the sample within it
+    const uint64 binIdx = std::min<uint64>(std::upper_bound(cdf, cdf + NumBins, samplePoint.x) - cdf, NumBins - 1);
+    const float binStart = binIdx > 0 ? cdf[binIdx - 1] : 0.0f;
+    const float binEnd = cdf[binIdx];
+    const float binU = binEnd > binStart ? Saturate((samplePoint.x - binStart) / (binEnd - binStart)) : 0.5f;
+
+    const float u = ((binIdx % NumBinsX) + binU) / NumBinsX;
+    const float v = ((binIdx / NumBinsX) + samplePoint.y) / NumBinsY;
+
+    const float phi = u * 2.0f * Pi;
+    const float cosTheta = v * 2.0f - 1.0f;
+    const float sinTheta = std::sqrt(Saturate(1.0f - cosTheta * cosTheta));
+    return Float3(sinTheta * std::cos(phi), cosTheta, sinTheta * std::sin(phi));
+}
+
+float PathGuide::PDF(uint64 cellIdx, const Float3& direction) const
+{
+    if(HasDistribution(cellIdx) == false)
+        return 0.0f;
+
+    const float* cdf = &cdfs[cellIdx * NumBins];
+    const uint64 binIdx = DirectionToBin(direction);
+    const float binProbability = cdf[binIdx] - (binIdx > 0 ? cdf[binIdx - 1] : 0.0f);
+    return binProbability / BinSolidAngle;
+}
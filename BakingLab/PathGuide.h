@@ -0,0 +1,78 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+#include <SF11_Math.h>
+#include <Containers.h>
+
+using namespace SampleFramework11;
+
+// Learns the distribution of incident radiance over a uniform grid covering the scene, with a
+// directional histogram for each cell. The histograms use an equal-area mapping (cosine of the
+// polar angle against the azimuth), so every bin covers the same solid angle.
+//
+// A guide goes through two phases for every bake or render, which are told apart by their
+// generation. During training the path tracer adds the incident radiance along its bounce
+// directions from any number of threads. The thread that finishes the last training batch then
+// freezes the guide, which turns the histograms into CDFs. After that the guide is read-only, and
+// paths sample their bounce directions from it.
+class PathGuide
+{
+
+public:
+
+    static const uint64 NumBinsX = 16;              // Azimuth
+    static const uint64 NumBinsY = 16;              // Cosine of the polar angle
+    static const uint64 NumBins = NumBinsX * NumBinsY;
+    static const uint64 MinTrainingSamples = 64;    // Cells with fewer samples aren't used for sampling
+
+    // The longest axis of the bounds gets "resolution" cells
+    void Init(const Float3& boundsMin, const Float3& boundsMax, uint64 resolution);
+    void Shutdown();
+
+    bool Initialized() const { return cells.Size() > 0; }
+
+    uint64 CellIndex(const Float3& position) const;
+
+    // Training phase. Samples from an older generation than the current one are dropped.
+    void AddSample(uint64 cellIdx, const Float3& direction, float radiance, uint64 generation);
+
+    // Returns true for the call that finishes the last training batch of the generation, which
+    // should then freeze the guide
+    bool FinishTrainingBatch(uint64 generation, uint64 numTrainingBatches);
+    void Freeze(uint64 generation);
+
+    // Sampling phase, which is only valid once the generation is frozen
+    bool Frozen(uint64 generation) const { return frozenGeneration == int64(generation); }
+    bool HasDistribution(uint64 cellIdx) const;
+    Float3 SampleDirection(uint64 cellIdx, Float2 samplePoint) const;
+    float PDF(uint64 cellIdx, const Float3& direction) const;
+
+private:
+
+    // The training data of a single cell. The bins store the bits of their float sums, so that
+    // they can be updated with a compare-exchange.
+    struct Cell
+    {
+        volatile int64 Generation = -1;
+        volatile long NumSamples = 0;
+        volatile long Bins[NumBins] = { };
+    };
+
+    FixedArray<Cell> cells;
+    FixedArray<float> cdfs;                         // NumBins per cell, with a last entry of 0 for unused cells
+    Float3 boundsMin;
+    Float3 cellSize;
+    Uint3 gridSize;
+    volatile int64 trainingProgress = 0;            // Generation in the lower 32 bits, batch count in the upper 32
+    volatile int64 frozenGeneration = -1;
+};
@@ -11,9 +11,14 @@
 #include "PCH.h"
 
 #include "PathTracer.h"
+#include "Tracer.h"
+#include "BakeStats.h"
+#include "RadianceCache.h"
+#include "PathGuide.h"
 
 #include <Graphics/BRDF.h>
 #include <Graphics/Sampling.h>
+#include <Graphics/SH.h>
 
 // Vertex operators
 inline Vertex operator+(const Vertex& a, const Vertex& b)
@@ -108,70 +113,211 @@ static bool Occluded(RTCScene scene, const Float3& position, const Float3& direc
     return ray.Hit();
 }
 
-// Calculates diffuse and specular from a spherical area light
-static Float3 SampleSphericalAreaLight(const Float3& position, const Float3& normal, RTCScene scene,
-                                       const Float3& diffuseAlbedo, const Float3& cameraPos,
-                                       bool includeSpecular, Float3 specAlbedo, float roughness,
-                                       float u1, float u2, float lightRadius,
-                                       const Float3& lightPos, const Float3& lightColor,
-                                       Float3& irradiance, Float3& sampleDir)
+// Picks a direction within the cone that a sphere subtends from a position, uniformly with respect
+// to solid angle. This only picks points on the cap of the sphere that the position can see, or
+// any direction if the position is inside of the sphere. Returns the distance to the point on the
+// sphere along the picked direction.
+static float SampleSphereCone(const Float3& position, const Float3& center, float radius, float u1, float u2,
+                              Float3& sampleDir, float& invPDF)
 {
-    const float radius2 = lightRadius * lightRadius;
-    const float invPDF = 2.0f * Pi * radius2;
-
-    Float3 result = 0.0f;
-    Float3 areaLightIrradiance = 0.0f;
-
-    float r = lightRadius;
-    float x = u1;
-    float y = u2;
+    const Float3 toCenter = center - position;
+    const float dist2 = Float3::Dot(toCenter, toCenter);
+    const float dist = std::sqrt(dist2);
+    const float radius2 = radius * radius;
+    const bool inside = dist2 <= radius2;
+    const float cosThetaMax = inside ? -1.0f : std::sqrt(Saturate(1.0f - radius2 / dist2));
+
+    const float cosTheta = 1.0f - u1 * (1.0f - cosThetaMax);
+    const float sinTheta = std::sqrt(Saturate(1.0f - cosTheta * cosTheta));
+    const float phi = 2.0f * Pi * u2;
+
+    const Float3 axis = dist > 0.0f ? toCenter / dist : Float3(0.0f, 1.0f, 0.0f);
+    const Float3 tangent = Float3::Normalize(Float3::Perpendicular(axis));
+    const Float3 bitangent = Float3::Cross(axis, tangent);
+    sampleDir = tangent * (sinTheta * std::cos(phi)) + bitangent * (sinTheta * std::sin(phi)) + axis * cosTheta;
+    sampleDir = Float3::Normalize(sampleDir);
+
+    invPDF = 2.0f * Pi * (1.0f - cosThetaMax);
+
+    // The near side of the sphere is in front of the position, unless it's inside
+    const float centerDist = dist * cosTheta;
+    const float halfChord = std::sqrt(Max(radius2 - dist2 * sinTheta * sinTheta, 0.0f));
+    return inside ? centerDist + halfChord : centerDist - halfChord;
+}
 
-    Float3 samplePos;
-    samplePos.x = lightPos.x + 2.0f * r * std::cos(2.0f * Pi * y) * std::sqrt(x * (1.0f - x));
-    samplePos.y = lightPos.y + 2.0f * r * std::sin(2.0f * Pi * y) * std::sqrt(x * (1.0f - x));
-    samplePos.z = lightPos.z + r * (1.0f - 2.0f * x);
+// Returns the unshadowed irradiance from a sphere with a radiance of 1, where "cosTheta" is the
+// cosine of the angle between the surface normal and the direction to the center of the sphere, and
+// "sinSigmaSqr" is the squared sine of the half-angle of the cone that it subtends. This accounts for
+// spheres that are partially below the horizon of the surface.
+// Reference: "Moving Frostbite to Physically Based Rendering" [Lagarde and de Rousiers 2014]
+static float SphereIrradiance(float cosTheta, float sinSigmaSqr)
+{
+    if(sinSigmaSqr >= 1.0f)
+        return Pi;
+
+    if(cosTheta * cosTheta > sinSigmaSqr)
+        return Pi * sinSigmaSqr * Saturate(cosTheta);
+
+    const float sinTheta = std::sqrt(Saturate(1.0f - cosTheta * cosTheta));
+    const float x = std::sqrt(1.0f / sinSigmaSqr - 1.0f);
+    const float y = Clamp(-x * (cosTheta / Max(sinTheta, 0.0001f)), -1.0f, 1.0f);
+    const float sinThetaSqrtY = sinTheta * std::sqrt(1.0f - y * y);
+    const float irradiance = (cosTheta * std::acos(y) - x * sinThetaSqrtY) * sinSigmaSqr + std::atan(sinThetaSqrtY / x);
+    return Max(irradiance, 0.0f);
+}
 
-    sampleDir = samplePos - position;
-    float sampleDirLen = Float3::Length(sampleDir);
-    bool visible = false;
-    if(sampleDirLen > 0.0f)
+// Computes the unshadowed diffuse lighting from a spherical light analytically, and scales it by a
+// stochastic estimate of the fraction of it that isn't shadowed. The estimate is the ratio of the
+// cosine-weighted visibility to the cosine weights, over a few shadow rays that are stratified
+// within the cone of the light. If none of them end up above the horizon, the lighting is left
+// unshadowed.
+static Float3 AnalyticSphericalAreaLight(const Float3& position, const Float3& normal, RTCScene scene,
+                                         const Float3& diffuseAlbedo, float u1, float u2, float lightRadius,
+                                         const Float3& lightPos, const Float3& lightColor,
+                                         Float3& irradiance, Float3& sampleDir, uint32& numShadowRays)
+{
+    const Float3 toCenter = lightPos - position;
+    const float dist2 = Float3::Dot(toCenter, toCenter);
+    if(dist2 <= 0.0f)
+        return 0.0f;
+
+    sampleDir = toCenter / std::sqrt(dist2);
+    const float sinSigmaSqr = Saturate(lightRadius * lightRadius / dist2);
+    const float unitIrradiance = SphereIrradiance(Float3::Dot(normal, sampleDir), sinSigmaSqr);
+    if(unitIrradiance <= 0.0f)
+        return 0.0f;
+
+    float visibility = 1.0f;
+    if(AppSettings::EnableAreaLightShadows)
     {
-        sampleDir /= sampleDirLen;
+        float visibleWeight = 0.0f;
+        float totalWeight = 0.0f;
+        const uint64 numRays = AppSettings::AreaLightVisibilityRays;
+        for(uint64 rayIdx = 0; rayIdx < numRays; ++rayIdx)
+        {
+            const float rayU1 = (rayIdx + u1) / numRays;
+            const float rayU2 = Frac(u2 + rayIdx * 0.618034f);
+
+            Float3 rayDir;
+            float invPDF = 0.0f;
+            const float rayDist = SampleSphereCone(position, lightPos, lightRadius, rayU1, rayU2, rayDir, invPDF);
+            const float nDotL = Float3::Dot(normal, rayDir);
+            if(nDotL <= 0.0f)
+                continue;
+
+            ++numShadowRays;
+            totalWeight += nDotL;
+            if(Occluded(scene, position, rayDir, 0.1f, rayDist) == false)
+                visibleWeight += nDotL;
+        }
 
-        visible = (AppSettings::EnableAreaLightShadows == false) || (Occluded(scene, position, sampleDir, 0.1f, sampleDirLen) == false);
+        if(totalWeight > 0.0f)
+            visibility = visibleWeight / totalWeight;
     }
 
-    float areaNDotL = std::abs(Float3::Dot(sampleDir, Float3::Normalize(samplePos - lightPos)));
-    float sDotN = Saturate(Float3::Dot(sampleDir, normal));
+    const Float3 sampleIrradiance = lightColor * (unitIrradiance * visibility);
+    irradiance += sampleIrradiance;
+    return sampleIrradiance * diffuseAlbedo * InvPi;
+}
+
+// Calculates diffuse and specular from a spherical area light, by sampling the cone of directions
+// that it covers. Directions that end up below the horizon don't need a shadow ray. If "analytic"
+// is set, the diffuse lighting is computed analytically instead.
+static Float3 SampleSphericalAreaLight(const Float3& position, const Float3& normal, RTCScene scene,
+                                       const Float3& diffuseAlbedo, const Float3& cameraPos,
+                                       bool includeSpecular, Float3 specAlbedo, float roughness,
+                                       float u1, float u2, float lightRadius,
+                                       const Float3& lightPos, const Float3& lightColor, bool analytic,
+                                       Float3& irradiance, Float3& sampleDir, uint32& numShadowRays)
+{
+    numShadowRays = 0;
+
+    // The analytic lighting only covers the diffuse term
+    if(analytic && includeSpecular == false)
+        return AnalyticSphericalAreaLight(position, normal, scene, diffuseAlbedo, u1, u2, lightRadius,
+                                          lightPos, lightColor, irradiance, sampleDir, numShadowRays);
 
-    float invRSqr = 1.0f / (sampleDirLen * sampleDirLen);
+    float invPDF = 0.0f;
+    const float sampleDist = SampleSphereCone(position, lightPos, lightRadius, u1, u2, sampleDir, invPDF);
 
-    float attenuation = areaNDotL * invRSqr;
-    if(attenuation && visible)
+    const float nDotL = Saturate(Float3::Dot(normal, sampleDir));
+    if(nDotL <= 0.0f)
+        return 0.0f;
+
+    if(AppSettings::EnableAreaLightShadows)
     {
-        Float3 sampleIrradiance = Saturate(Float3::Dot(normal, sampleDir)) * lightColor * attenuation;
-        Float3 sample = CalcLighting(normal, sampleIrradiance, sampleDir, diffuseAlbedo, position,
-                                     cameraPos, roughness, includeSpecular, specAlbedo);
-        result = sample * invPDF;
-        areaLightIrradiance = sampleIrradiance * invPDF;
+        ++numShadowRays;
+        if(Occluded(scene, position, sampleDir, 0.1f, sampleDist))
+            return 0.0f;
     }
 
-    irradiance += areaLightIrradiance;
-
-    return result;
+    const Float3 sampleIrradiance = nDotL * lightColor * invPDF;
+    irradiance += sampleIrradiance;
+    return CalcLighting(normal, sampleIrradiance, sampleDir, diffuseAlbedo, position,
+                        cameraPos, roughness, includeSpecular, specAlbedo);
 }
 
 // Calculates diffuse and specular contribution from the area light, given a 2D random sample point
-// representing a location on the surface of the light
+// representing a direction within the cone that the light covers
 Float3 SampleAreaLight(const Float3& position, const Float3& normal, RTCScene scene,
                        const Float3& diffuseAlbedo, const Float3& cameraPos,
                        bool includeSpecular, Float3 specAlbedo, float roughness,
-                       float u1, float u2, Float3& irradiance, Float3& sampleDir)
+                       float u1, float u2, Float3& irradiance, Float3& sampleDir, uint32& numShadowRays)
 {
     Float3 lightPos = Float3(AppSettings::AreaLightX, AppSettings::AreaLightY, AppSettings::AreaLightZ);
     return SampleSphericalAreaLight(position, normal, scene, diffuseAlbedo, cameraPos, includeSpecular,
                                     specAlbedo, roughness, u1, u2, AppSettings::AreaLightSize,
-                                    lightPos, AppSettings::AreaLightColor.Value() * FP16Scale, irradiance, sampleDir);
+                                    lightPos, AppSettings::AreaLightColor.Value() * FP16Scale,
+                                    AppSettings::AnalyticAreaLight != false, irradiance, sampleDir, numShadowRays);
+}
+
+// Picks a point on the cap of the area light that's visible from a position, with the same
+// distribution as SampleAreaLight
+Float3 SampleAreaLightPoint(const Float3& position, float u1, float u2, float& invPDF)
+{
+    Float3 lightPos = Float3(AppSettings::AreaLightX, AppSettings::AreaLightY, AppSettings::AreaLightZ);
+
+    Float3 sampleDir;
+    float invSolidAnglePDF = 0.0f;
+    const float sampleDist = SampleSphereCone(position, lightPos, AppSettings::AreaLightSize, u1, u2,
+                                              sampleDir, invSolidAnglePDF);
+    const Float3 lightPoint = position + sampleDir * sampleDist;
+
+    // Convert the PDF from solid angle to area
+    const float lightCosTheta = std::abs(Float3::Dot(sampleDir, Float3::Normalize(lightPoint - lightPos)));
+    invPDF = lightCosTheta > 0.0f ? invSolidAnglePDF * sampleDist * sampleDist / lightCosTheta : 0.0f;
+
+    return lightPoint;
+}
+
+// Returns the diffuse lighting that a point on the area light adds to a white surface, which is what
+// SampleAreaLight returns before it's divided by the PDF
+Float3 AreaLightPointLighting(const Float3& position, const Float3& normal, RTCScene scene,
+                              const Float3& lightPoint, bool testVisibility, Float3& sampleDir)
+{
+    Float3 lightPos = Float3(AppSettings::AreaLightX, AppSettings::AreaLightY, AppSettings::AreaLightZ);
+
+    sampleDir = lightPoint - position;
+    const float sampleDirLen = Float3::Length(sampleDir);
+    if(sampleDirLen <= 0.0f)
+        return 0.0f;
+    sampleDir /= sampleDirLen;
+
+    // Points on the far side of the light are hidden by the light itself, unless the position is inside of it
+    float areaNDotL = -Float3::Dot(sampleDir, Float3::Normalize(lightPoint - lightPos));
+    if(Float3::Length(position - lightPos) <= AppSettings::AreaLightSize)
+        areaNDotL = std::abs(areaNDotL);
+
+    const float sDotN = Saturate(Float3::Dot(normal, sampleDir));
+    const float attenuation = areaNDotL / (sampleDirLen * sampleDirLen);
+    if(attenuation <= 0.0f || sDotN <= 0.0f)
+        return 0.0f;
+
+    if(testVisibility && AppSettings::EnableAreaLightShadows && Occluded(scene, position, sampleDir, 0.1f, sampleDirLen))
+        return 0.0f;
+
+    Float3 sampleIrradiance = sDotN * AppSettings::AreaLightColor.Value() * FP16Scale * attenuation;
+    return CalcLighting(normal, sampleIrradiance, sampleDir, 1.0f, position, 0.0f, 1.0f, false, 0.0f);
 }
 
 // Checks to see if a ray intersects with the area light
@@ -189,20 +335,68 @@ static float AreaLightIntersection(const Float3& rayStart, const Float3& rayDir,
 }
 
 // Computes the difuse and specular contribution from the sun, given a 2D random sample point
-// representing a location on the surface of the light
+// representing a direction within the sun disc
 static Float3 SampleSunLight(const Float3& position, const Float3& normal, RTCScene scene,
                              const Float3& diffuseAlbedo, const Float3& cameraPos,
                              bool includeSpecular, Float3 specAlbedo, float roughness,
-                             float u1, float u2, Float3& irradiance)
+                             float u1, float u2, Float3& irradiance, uint32& numShadowRays)
 {
-    // Treat the sun as a spherical area light that's very far away from the surface
+    // Treat the sun as a spherical area light that's very far away from the surface, and size it so
+    // that it covers the same cone as the sun disc that SampleSun() returns. AnalyticAreaLight only
+    // applies to the actual area light, so the sun is always sampled.
     const float sunDistance = 1000.0f;
-    const float radius = std::tan(DegToRad(AppSettings::SunSize)) * sunDistance;
+    const float radius = std::sin(DegToRad(AppSettings::SunSize)) * sunDistance;
     Float3 sunLuminance = AppSettings::SunLuminance();
     Float3 sunPos = position + AppSettings::SunDirection.Value() * sunDistance;
     Float3 sampleDir;
     return SampleSphericalAreaLight(position, normal, scene, diffuseAlbedo, cameraPos, includeSpecular,
-                                    specAlbedo, roughness, u1, u2, radius, sunPos, sunLuminance, irradiance, sampleDir);
+                                    specAlbedo, roughness, u1, u2, radius, sunPos, sunLuminance, false,
+                                    irradiance, sampleDir, numShadowRays);
+}
+
+// Picks one emissive triangle through the light BVH, and computes the diffuse and specular from a
+// point on it that's sampled uniformly by area
+static Float3 SampleEmissiveLight(const LightBVH& lights, const Float3& position, const Float3& normal,
+                                  RTCScene scene, const Float3& diffuseAlbedo, const Float3& cameraPos,
+                                  bool includeSpecular, Float3 specAlbedo, float roughness,
+                                  float uLight, float u1, float u2, Float3& irradiance, uint32& numShadowRays)
+{
+    numShadowRays = 0;
+
+    float lightPMF = 0.0f;
+    const EmissiveTriangle* emitter = lights.SampleLight(position, normal, uLight, lightPMF);
+    if(emitter == nullptr || lightPMF <= 0.0f)
+        return 0.0f;
+
+    const float sqrtU1 = std::sqrt(u1);
+    const float b0 = 1.0f - sqrtU1;
+    const float b1 = u2 * sqrtU1;
+    const Float3 lightPoint = emitter->V0 * b0 + emitter->V1 * b1 + emitter->V2 * (1.0f - b0 - b1);
+
+    Float3 sampleDir = lightPoint - position;
+    const float distSq = Float3::Dot(sampleDir, sampleDir);
+    if(distSq <= 0.0f)
+        return 0.0f;
+    const float dist = std::sqrt(distSq);
+    sampleDir /= dist;
+
+    // Emitters only light the side that their front face points at
+    const float nDotL = Saturate(Float3::Dot(normal, sampleDir));
+    const float lightCosTheta = -Float3::Dot(emitter->Normal, sampleDir);
+    if(nDotL <= 0.0f || lightCosTheta <= 0.0f)
+        return 0.0f;
+
+    // Stop short of the emitter, so that the shadow ray doesn't hit the triangle that it's aiming for
+    ++numShadowRays;
+    if(Occluded(scene, position, sampleDir, 0.1f, dist * 0.999f))
+        return 0.0f;
+
+    // Convert the uniform PDF from area to solid angle
+    const Float3 emission = emitter->Emission * AppSettings::EmissiveIntensity * FP16Scale;
+    const Float3 sampleIrradiance = nDotL * emission * lightCosTheta * emitter->Area / (distSq * lightPMF);
+    irradiance += sampleIrradiance;
+    return CalcLighting(normal, sampleIrradiance, sampleDir, diffuseAlbedo, position,
+                        cameraPos, roughness, includeSpecular, specAlbedo);
 }
 
 // Generates a full list of sample points for all integration types
@@ -247,6 +441,29 @@ void GenerateIntegrationSamples(IntegrationSamples& samples, uint64 sqrtNumSampl
     }
 }
 
+// A path vertex whose outgoing radiance is added to the radiance cache once the path is finished
+struct CacheVertex
+{
+    Float3 Position;
+    Float3 Normal;
+    Float3 RadianceStart;               // Radiance that the path had gathered before reaching the vertex
+    Float3 Throughput;
+};
+
+static const uint64 MaxCacheVertices = 8;
+
+// A bounce whose incident radiance is added to the path guide once the path is finished
+struct GuideVertex
+{
+    uint64 CellIdx = 0;
+    Float3 Direction;
+    float PDF = 0.0f;
+    Float3 RadianceStart;               // Radiance that the path had gathered before the bounce
+    Float3 Throughput;                  // Throughput after the bounce
+};
+
+static const uint64 MaxGuideVertices = 8;
+
 // Returns the incoming radiance along the ray specified by params.RayDir, computed using unidirectional
 // path tracing
 Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float& illuminance, bool& hitSky)
@@ -259,6 +476,12 @@ Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float&
     Float3 throughput = 1.0f;
     Float3 irrThroughput = 1.0f;
 
+    CacheVertex cacheVertices[MaxCacheVertices];
+    uint64 numCacheVertices = 0;
+
+    GuideVertex guideVertices[MaxGuideVertices];
+    uint64 numGuideVertices = 0;
+
     // Keep tracing paths until we reach the specified max
     const int64 maxPathLength = params.MaxPathLength;
     for(int64 pathLength = 1; pathLength <= maxPathLength || maxPathLength == -1; ++pathLength)
@@ -269,7 +492,10 @@ Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float&
         {
             float continueProbability = std::min<float>(params.RussianRouletteProbability, ComputeLuminance(throughput));
             if(randomGenerator.RandomFloat() > continueProbability)
+            {
+                BakeStatAdd_(params.Stats, RussianRouletteTerminations, 1);
                 break;
+            }
             throughput /= continueProbability;
             irrThroughput /= continueProbability;
         }
@@ -278,7 +504,16 @@ Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float&
         bool continueTracing = false;
 
         // Check for intersection with the scene
-        rtcIntersect(params.SceneBVH->Scene, ray);
+        {
+            TraceSpan intersectSpan("Intersect");
+            rtcIntersect(params.SceneBVH->Scene, ray);
+        }
+        if(params.RayCount != nullptr)
+            ++(*params.RayCount);
+        if(pathLength == 1)
+            BakeStatAdd_(params.Stats, PrimaryRays, 1);
+        else
+            BakeStatAdd_(params.Stats, BounceRays, 1);
         float sceneDistance = ray.Hit() ? ray.tfar : FLT_MAX;
 
         Float3 rayOrigin = ray.Origin();
@@ -294,13 +529,17 @@ Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float&
             // We hit the area light: just return the uniform radiance of the light source
             radiance = AppSettings::AreaLightColor.Value() * throughput * FP16Scale;
             irradiance = 0.0f;
+            BakeStatAdd_(params.Stats, AreaLightHits, 1);
         }
         else if(sceneDistance < FLT_MAX)
         {
             // We hit a triangle in the scene
+            TraceSpan shadingSpan("Shading");
             if(pathLength == maxPathLength)
             {
-                // There's no point in continuing anymore, since none of our scene surfaces are emissive.
+                // There's no point in continuing anymore, since emissive surfaces past the first hit
+                // are only picked up through next event estimation.
+                BakeStatAdd_(params.Stats, MaxLengthTerminations, 1);
                 break;
             }
 
@@ -308,7 +547,23 @@ Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float&
 
             // Treat back-facing triangles as pure black
             if(IsTriangleBackFacing(ray, bvh))
+            {
+                BakeStatAdd_(params.Stats, BackFaceTerminations, 1);
                 break;
+            }
+
+            // Emission is only added where the path starts out, since every later vertex already
+            // picked up the emitters through next event estimation at the vertex before it
+            const bool enableEmissiveLights = AppSettings::EnableEmissiveLights && bvh.EmissiveLights.Empty() == false;
+            if(enableEmissiveLights && params.EnableDirectEmissive && pathLength == 1)
+            {
+                const Float3& emissive = bvh.MaterialEmissive[bvh.MaterialIndices[ray.primID]];
+                if(ComputeLuminance(emissive) > 0.0f)
+                {
+                    radiance += emissive * AppSettings::EmissiveIntensity * FP16Scale * throughput;
+                    BakeStatAdd_(params.Stats, EmissiveHits, 1);
+                }
+            }
 
             // Interpolate the vertex data
             Vertex hitSurface = TriangleLerp(ray, bvh, bvh.Vertices);
@@ -317,6 +572,26 @@ Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float&
             hitSurface.Tangent = Float3::Normalize(hitSurface.Tangent);
             hitSurface.Bitangent = Float3::Normalize(hitSurface.Bitangent);
 
+            // Terminate into the radiance cache once the path is deep enough. The lookup is jittered
+            // within the tangent plane, which trades the blockiness of the grid for noise.
+            if(params.RadianceCache != nullptr && pathLength >= params.RadianceCacheDepth)
+            {
+                const Float2 jitter = randomGenerator.RandomFloat2();
+                const Float3 offset = hitSurface.Tangent * (jitter.x - 0.5f) + hitSurface.Bitangent * (jitter.y - 0.5f);
+                const Float3 lookupPos = hitSurface.Position + offset * params.RadianceCacheCellSize;
+
+                Float3 cachedRadiance;
+                if(params.RadianceCache->Lookup(lookupPos, hitSurface.Normal, params.RadianceCacheCellSize,
+                                                params.RadianceCacheGeneration, params.RadianceCacheMinSamples,
+                                                cachedRadiance))
+                {
+                    radiance += cachedRadiance * throughput;
+                    irradiance += cachedRadiance * irrThroughput;
+                    BakeStatAdd_(params.Stats, RadianceCacheTerminations, 1);
+                    break;
+                }
+            }
+
             // Look up the material data
             const uint64 materialIdx = bvh.MaterialIndices[ray.primID];
 
@@ -365,17 +640,33 @@ Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float&
 
             if(indirectSpecOnly == false)
             {
+                // Only vertices that receive all of their lighting are a valid estimate for the cache
+                const bool cacheVertex = params.RadianceCache != nullptr && numCacheVertices < MaxCacheVertices
+                                         && (AppSettings::EnableDirectLighting || pathLength > 1);
+                if(cacheVertex)
+                {
+                    CacheVertex& vertex = cacheVertices[numCacheVertices++];
+                    vertex.Position = hitSurface.Position;
+                    vertex.Normal = hitSurface.Normal;
+                    vertex.RadianceStart = radiance;
+                    vertex.Throughput = throughput;
+                }
+
                 // Compute direct lighting from the sun
                 Float3 directLighting;
                 Float3 directIrradiance;
-                if((AppSettings::EnableDirectLighting || pathLength > 1) && AppSettings::EnableSun)
+                if((AppSettings::EnableDirectLighting || pathLength > 1) && AppSettings::EnableSun && params.Transfer == nullptr)
                 {
                     Float2 sunSample = params.SampleSet->Sun();
                     if(pathLength > 1)
                         sunSample = randomGenerator.RandomFloat2();
+                    uint32 numShadowRays = 0;
                     directLighting += SampleSunLight(hitSurface.Position, normal, bvh.Scene, diffuseAlbedo,
                                                      rayOrigin, enableSpecular, specAlbedo, roughness,
-                                                     sunSample.x, sunSample.y, directIrradiance);
+                                                     sunSample.x, sunSample.y, directIrradiance, numShadowRays);
+                    if(params.RayCount != nullptr)
+                        *params.RayCount += numShadowRays;
+                    BakeStatAdd_(params.Stats, SunShadowRays, numShadowRays);
                 }
 
                 // Compute direct lighting from the area light
@@ -385,15 +676,49 @@ Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float&
                     if(pathLength > 1)
                         areaLightSample = randomGenerator.RandomFloat2();
                     Float3 areaLightSampleDir;
+                    uint32 numShadowRays = 0;
                     directLighting += SampleAreaLight(hitSurface.Position, normal, bvh.Scene, diffuseAlbedo,
                                                       rayOrigin, enableSpecular, specAlbedo, roughness,
-                                                      areaLightSample.x, areaLightSample.y, directIrradiance, areaLightSampleDir);
+                                                      areaLightSample.x, areaLightSample.y, directIrradiance,
+                                                      areaLightSampleDir, numShadowRays);
+                    if(params.RayCount != nullptr)
+                        *params.RayCount += numShadowRays;
+                    BakeStatAdd_(params.Stats, AreaLightShadowRays, numShadowRays);
+                }
+
+                // Compute direct lighting from a single emitter, picked by the light BVH
+                if((AppSettings::EnableDirectLighting || pathLength > 1) && enableEmissiveLights)
+                {
+                    Float2 emissiveSample = params.SampleSet->EmissiveLight();
+                    if(pathLength > 1)
+                        emissiveSample = randomGenerator.RandomFloat2();
+                    uint32 numShadowRays = 0;
+                    directLighting += SampleEmissiveLight(bvh.EmissiveLights, hitSurface.Position, normal, bvh.Scene,
+                                                          diffuseAlbedo, rayOrigin, enableSpecular, specAlbedo,
+                                                          roughness, randomGenerator.RandomFloat(), emissiveSample.x,
+                                                          emissiveSample.y, directIrradiance, numShadowRays);
+                    if(params.RayCount != nullptr)
+                        *params.RayCount += numShadowRays;
+                    BakeStatAdd_(params.Stats, EmissiveShadowRays, numShadowRays);
                 }
 
                 radiance += directLighting * throughput;
                 irradiance += directIrradiance * irrThroughput;
             }
 
+            // Iterative bounce passes end the path here, and read back the irradiance that the
+            // previous pass baked into the light map at the hit point
+            if(params.BounceIrradiance != nullptr)
+            {
+                if(AppSettings::EnableIndirectLighting && AppSettings::EnableIndirectDiffuse && indirectSpecOnly == false)
+                {
+                    const Float3 bounceIrradiance = params.BounceIrradiance->Sample(hitSurface.LightMapUV);
+                    radiance += diffuseAlbedo * bounceIrradiance * throughput;
+                    irradiance += bounceIrradiance * Pi * irrThroughput;
+                }
+                break;
+            }
+
             // Pick a new path, using MIS to sample both our diffuse and specular BRDF's
             if(AppSettings::EnableIndirectLighting || params.ViewIndirectSpecular)
             {
@@ -415,7 +740,22 @@ Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float&
                     Float3 sampleDir;
                     Float3 v = Float3::Normalize(rayOrigin - hitSurface.Position);
 
-                    if(selector < 0.5f)
+                    // The guide only replaces diffuse sampling, and only in cells that it learned something about
+                    uint64 guideCellIdx = 0;
+                    float guideFraction = 0.0f;
+                    if(params.Guide != nullptr && enableDiffuseSampling)
+                    {
+                        guideCellIdx = params.Guide->CellIndex(hitSurface.Position);
+                        if(params.GuideTraining == false && params.Guide->HasDistribution(guideCellIdx))
+                            guideFraction = params.GuideFraction;
+                    }
+
+                    if(guideFraction > 0.0f && randomGenerator.RandomFloat() < guideFraction)
+                    {
+                        sampleDir = params.Guide->SampleDirection(guideCellIdx, randomGenerator.RandomFloat2());
+                        BakeStatAdd_(params.Stats, GuidedBounces, 1);
+                    }
+                    else if(selector < 0.5f)
                     {
                         // We're sampling the diffuse BRDF, so sample a cosine-weighted hemisphere
                         if(enableSpecularSampling)
@@ -439,6 +779,8 @@ Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float&
                     float pdf = diffusePDF + specularPDF;
                     if(enableDiffuseSampling && enableSpecularSampling)
                         pdf *= 0.5f;
+                    if(guideFraction > 0.0f)
+                        pdf = Lerp(pdf, params.Guide->PDF(guideCellIdx, sampleDir), guideFraction);
 
                     if(nDotL > 0.0f && pdf > 0.0f && Float3::Dot(sampleDir, hitSurface.Normal) > 0.0f)
                     {
@@ -456,6 +798,16 @@ Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float&
                         throughput *= brdf * nDotL / pdf;
                         irrThroughput *= nDotL / pdf;
 
+                        if(params.GuideTraining && enableDiffuseSampling && numGuideVertices < MaxGuideVertices)
+                        {
+                            GuideVertex& vertex = guideVertices[numGuideVertices++];
+                            vertex.CellIdx = guideCellIdx;
+                            vertex.Direction = sampleDir;
+                            vertex.PDF = pdf;
+                            vertex.RadianceStart = radiance;
+                            vertex.Throughput = throughput;
+                        }
+
                         // Generate the ray for the new path
                         ray = EmbreeRay(hitSurface.Position, sampleDir, 0.001f, FLT_MAX);
 
@@ -472,8 +824,21 @@ Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float&
         else {
             // We hit the sky, so we'll sample the sky radiance and then bail out
             hitSky = true;
+            BakeStatAdd_(params.Stats, SkyHits, 1);
 
-            if (AppSettings::SkyMode == SkyModes::Procedural)
+            if(params.Transfer != nullptr)
+            {
+                // The sky and the sun get applied to the transfer later on, when the bake is re-lit
+                const SH9 basis = ProjectOntoSH9(rayDir);
+                for(uint64 i = 0; i < DistantLightTransfer::NumCoefficients; ++i)
+                {
+                    if(pathLength == 1)
+                        params.Transfer->Sky(i) += throughput * basis.Coefficients[i];
+                    else
+                        params.Transfer->SkyAndSun(i) += throughput * basis.Coefficients[i];
+                }
+            }
+            else if (AppSettings::SkyMode == SkyModes::Procedural)
             {
                 Float3 skyRadiance = Skybox::SampleSky(*params.SkyCache, rayDir);
                 if (pathLength == 1 && params.EnableDirectSun)
@@ -501,6 +866,42 @@ Float3 PathTrace(const PathTracerParams& params, Random& randomGenerator, float&
             break;
     }
 
+    // The outgoing radiance of a vertex is everything that the path gathered after reaching it,
+    // divided by the throughput up to that vertex
+    for(uint64 i = 0; i < numCacheVertices; ++i)
+    {
+        const CacheVertex& vertex = cacheVertices[i];
+        if(vertex.Throughput.x <= 0.0f || vertex.Throughput.y <= 0.0f || vertex.Throughput.z <= 0.0f)
+            continue;
+
+        const Float3 outgoing = (radiance - vertex.RadianceStart) / vertex.Throughput;
+        if(!isfinite(outgoing.x) || !isfinite(outgoing.y) || !isfinite(outgoing.z))
+            continue;
+
+        params.RadianceCache->AddSample(vertex.Position, vertex.Normal, params.RadianceCacheCellSize,
+                                        params.RadianceCacheGeneration, outgoing);
+        BakeStatAdd_(params.Stats, RadianceCacheUpdates, 1);
+    }
+
+    // The incident radiance along a bounce is everything that the path gathered after it, divided
+    // by the throughput that the bounce left it with. Dividing that by the PDF of the bounce gives
+    // an estimate of the radiance integrated over the bin.
+    for(uint64 i = 0; i < numGuideVertices; ++i)
+    {
+        const GuideVertex& vertex = guideVertices[i];
+        if(vertex.Throughput.x <= 0.0f || vertex.Throughput.y <= 0.0f || vertex.Throughput.z <= 0.0f)
+            continue;
+
+        const float incident = ComputeLuminance((radiance - vertex.RadianceStart) / vertex.Throughput) / vertex.PDF;
+        if(!isfinite(incident) || incident <= 0.0f)
+            continue;
+
+        params.Guide->AddSample(vertex.CellIdx, vertex.Direction, incident, params.GuideGeneration);
+        BakeStatAdd_(params.Stats, GuideTrainingSamples, 1);
+    }
+
+    BakeStatAdd_(params.Stats, Paths, 1);
+
     illuminance = ComputeLuminance(irradiance);
     return radiance;
 }
\ No newline at end of file
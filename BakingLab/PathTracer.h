@@ -14,12 +14,18 @@
 #include <SF11_Math.h>
 #include <Graphics/Textures.h>
 #include <Graphics/Skybox.h>
+#include <MurmurHash.h>
 
 #include "AppSettings.h"
+#include "LightBVH.h"
 
 // Forward declarations
 struct __RTCScene;
 typedef __RTCScene* RTCScene;
+struct BakeStatShard;
+class RadianceCache;
+class BakeResultStorage;
+class PathGuide;
 
 using namespace SampleFramework11;
 
@@ -46,14 +52,33 @@ struct BVHData
     std::vector<TextureData<UByte4N>> MaterialNormalMaps;
     std::vector<TextureData<UByte4N>> MaterialRoughnessMaps;
     std::vector<TextureData<UByte4N>> MaterialMetallicMaps;
+    std::vector<Float3> MaterialEmissive;
+    LightBVH EmissiveLights;            // Built from MaterialEmissive after the BVH is loaded, so it's never cached
+    Hash SceneHash;
 
     ~BVHData()
+    {
+        Reset();
+    }
+
+    void Reset()
     {
         if(Scene != nullptr)
         {
             rtcDeleteScene(Scene);
             Scene = nullptr;
         }
+
+        Triangles = std::vector<Uint3>();
+        Vertices = std::vector<Vertex>();
+        MaterialIndices = std::vector<uint16>();
+        MaterialDiffuseMaps = std::vector<TextureData<UByte4N>>();
+        MaterialNormalMaps = std::vector<TextureData<UByte4N>>();
+        MaterialRoughnessMaps = std::vector<TextureData<UByte4N>>();
+        MaterialMetallicMaps = std::vector<TextureData<UByte4N>>();
+        MaterialEmissive = std::vector<Float3>();
+        EmissiveLights.Reset();
+        SceneHash = Hash();
     }
 };
 
@@ -102,6 +127,7 @@ enum class IntegrationTypes
     BRDF,
     Sun,
     AreaLight,
+    EmissiveLight,
 
     NumValues,
 };
@@ -182,17 +208,56 @@ struct IntegrationSampleSet
     Float2 BRDF() const { return Samples[uint64(IntegrationTypes::BRDF)]; }
     Float2 Sun() const { return Samples[uint64(IntegrationTypes::Sun)]; }
     Float2 AreaLight() const { return Samples[uint64(IntegrationTypes::AreaLight)]; }
+    Float2 EmissiveLight() const { return Samples[uint64(IntegrationTypes::EmissiveLight)]; }
 };
 
 // Generates a full list of sample points for all integration types
 void GenerateIntegrationSamples(IntegrationSamples& samples, uint64 sqrtNumSamples, uint64 tileSizeX, uint64 tileSizeY,
                                 SampleModes sampleMode, uint64 numIntegrationTypes, Random& rng);
 
-// Samples the spherical area light using a set of 2D sample points
+// Samples the spherical area light using a set of 2D sample points, which pick a direction within
+// the cone that the light covers. With AnalyticAreaLight enabled, the diffuse lighting is computed
+// analytically instead and only the shadowing is sampled. Returns the number of shadow rays that
+// were traced in "numShadowRays".
 Float3 SampleAreaLight(const Float3& position, const Float3& normal, RTCScene scene,
                        const Float3& diffuseAlbedo, const Float3& cameraPos,
                        bool includeSpecular, Float3 specAlbedo, float roughness,
-                       float u1, float u2, Float3& irradiance, Float3& sampleDir);
+                       float u1, float u2, Float3& irradiance, Float3& sampleDir, uint32& numShadowRays);
+
+// Picks a point on the cap of the spherical area light that's visible from "position", with the
+// same distribution as SampleAreaLight, and returns the inverse of its PDF (with respect to area)
+Float3 SampleAreaLightPoint(const Float3& position, float u1, float u2, float& invPDF);
+
+// Returns the diffuse lighting that a point on the spherical area light adds to a white surface,
+// before dividing by the PDF. Shadows are only tested if "testVisibility" is true.
+Float3 AreaLightPointLighting(const Float3& position, const Float3& normal, RTCScene scene,
+                              const Float3& lightPoint, bool testVisibility, Float3& sampleDir);
+
+// Irradiance / Pi that a previous bounce pass baked into the light map, which the next pass reads
+// back at its hit points instead of tracing any further. Sample() lives in MeshBaker.cpp along with
+// the result storage, and returns black if there are no pages.
+struct LightMapIrradiance
+{
+    const BakeResultStorage* Pages = nullptr;   // One result per texel, where w is 1 for baked texels
+    uint64 NumPages = 0;
+    uint64 LightMapSize = 0;
+
+    Float3 Sample(Float2 lightMapUV) const;
+};
+
+// The SH9 transfer of a single path from the distant lights, for relightable bakes. Paths that
+// escape right away only ever see the sky, since the sun disc is left out of primary rays. Paths
+// that escape after a bounce see both the sky and the sun, so the two are kept separate.
+struct DistantLightTransfer
+{
+    static const uint64 NumCoefficients = 9;
+    static const uint64 NumSets = NumCoefficients * 2;
+
+    Float3 Coefficients[NumSets];       // Sky coefficients, followed by the sky + sun coefficients
+
+    Float3& Sky(uint64 idx) { return Coefficients[idx]; }
+    Float3& SkyAndSun(uint64 idx) { return Coefficients[NumCoefficients + idx]; }
+};
 
 // Options for path tracing
 struct PathTracerParams
@@ -200,6 +265,7 @@ struct PathTracerParams
     Float3 RayDir;
     uint32 EnableDirectAreaLight = false;
     uint8 EnableDirectSun = false;
+    uint8 EnableDirectEmissive = true;  // Emission seen by the first ray of the path
     uint8 EnableDiffuse = false;
     uint8 EnableSpecular = false;
     uint8 EnableBounceSpecular = false;
@@ -214,6 +280,34 @@ struct PathTracerParams
     const IntegrationSampleSet* SampleSet = nullptr;
     const SkyCache* SkyCache = nullptr;
     const TextureData<Half4>* EnvMaps = nullptr;
+    uint64* RayCount = nullptr;         // If non-null, incremented for every ray cast against the scene
+    BakeStatShard* Stats = nullptr;     // If non-null, the hot-path counters are added to this shard
+
+    // If non-null, the outgoing radiance of every fully-shaded path vertex is added to the cache, and
+    // paths terminate into the cache once they reach RadianceCacheDepth and hit a warm cell
+    RadianceCache* RadianceCache = nullptr;
+    uint64 RadianceCacheGeneration = 0;
+    int32 RadianceCacheDepth = -1;
+    float RadianceCacheCellSize = 1.0f;
+    uint32 RadianceCacheMinSamples = 0;
+
+    // If non-null, paths end at their first surface hit, which gathers its indirect diffuse lighting
+    // from the light map instead of tracing another segment
+    const LightMapIrradiance* BounceIrradiance = nullptr;
+
+    // If non-null, escaping paths add their throughput times the SH9 basis of the escape direction
+    // to the transfer instead of evaluating the sky, and the sun isn't sampled at the hit points.
+    // The returned radiance then only contains the lighting from non-distant lights.
+    DistantLightTransfer* Transfer = nullptr;
+
+    // If non-null, training paths add the incident radiance along each of their bounces to the
+    // guide. Otherwise the guide has to be frozen, and paths draw their indirect diffuse bounces
+    // from it with probability GuideFraction, combined with the BRDF sampling through the balance
+    // heuristic.
+    PathGuide* Guide = nullptr;
+    uint64 GuideGeneration = 0;
+    uint8 GuideTraining = false;
+    float GuideFraction = 0.5f;
 };
 
 // Returns the incoming radiance along the ray specified by "RayDir", computed using unidirectional
@@ -0,0 +1,130 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+//=================================================================================================
+// Includes
+//=================================================================================================
+#include "SharedConstants.h"
+#include <SH.hlsl>
+#include "AppSettings.hlsl"
+#include "SG.hlsl"
+
+//=================================================================================================
+// Constant buffers
+//=================================================================================================
+cbuffer Constants : register(b0)
+{
+    float4x4 ViewProjection;
+    float4 SGDirections[MaxSGCount];
+    float3 ProbeGridOrigin;
+    float SGSharpness;
+    float3 ProbeGridSpacing;
+    float ProbeRadius;
+    uint3 ProbeGridSize;
+    uint ProbeBasis;
+}
+
+//=================================================================================================
+// Resources
+//=================================================================================================
+StructuredBuffer<float4> ProbeData : register(t0);
+
+//=================================================================================================
+// Input/Output structs
+//=================================================================================================
+struct VSOutput
+{
+    float4 PositionCS 		: SV_Position;
+    float3 NormalWS         : NORMALWS;
+    nointerpolation uint ProbeIdx : PROBEIDX;
+};
+
+struct PSInput
+{
+    float4 PositionSS 		: SV_Position;
+    float3 NormalWS         : NORMALWS;
+    nointerpolation uint ProbeIdx : PROBEIDX;
+};
+
+//=================================================================================================
+// Vertex shader
+//=================================================================================================
+VSOutput VS(in float3 SpherePosition : POSITION, in uint InstanceID : SV_InstanceID)
+{
+    VSOutput output;
+
+    // Probes are stored with x changing fastest, followed by y and then z
+    uint3 probeCoord;
+    probeCoord.x = InstanceID % ProbeGridSize.x;
+    probeCoord.y = (InstanceID / ProbeGridSize.x) % ProbeGridSize.y;
+    probeCoord.z = InstanceID / (ProbeGridSize.x * ProbeGridSize.y);
+
+    float3 probePos = ProbeGridOrigin + probeCoord * ProbeGridSpacing;
+    float3 positionWS = probePos + SpherePosition * ProbeRadius;
+    output.PositionCS = mul(float4(positionWS, 1.0f), ViewProjection);
+    output.NormalWS = SpherePosition;
+    output.ProbeIdx = InstanceID;
+
+    return output;
+}
+
+float3 EvalSGs(in uint probeIdx, in uint numSGs, in float3 dir)
+{
+    float3 output = 0.0f;
+
+    [unroll]
+    for(uint i = 0; i < numSGs; ++i)
+    {
+        SG sg;
+        sg.Amplitude = ProbeData[probeIdx * numSGs + i].xyz;
+        sg.Axis = SGDirections[i].xyz;
+        sg.Sharpness = SGSharpness;
+
+        output += EvaluateSG(sg, dir);
+    }
+
+    return output;
+}
+
+//=================================================================================================
+// Pixel shader
+//=================================================================================================
+float4 PS(in PSInput input) : SV_Target0
+{
+    float3 output = 0.0f;
+
+    float3 normalWS = normalize(input.NormalWS);
+    uint probeIdx = input.ProbeIdx;
+
+    if(ProbeBasis == ProbeBases_SH9)
+    {
+        SH9Color shRadiance;
+
+        [unroll]
+        for(uint i = 0; i < 9; ++i)
+            shRadiance.c[i] = ProbeData[probeIdx * 9 + i].xyz;
+
+        output = EvalSH9(normalWS, shRadiance);
+    }
+    else if(ProbeBasis == ProbeBases_SG6)
+    {
+        output = EvalSGs(probeIdx, 6, normalWS);
+    }
+    else if(ProbeBasis == ProbeBases_SG9)
+    {
+        output = EvalSGs(probeIdx, 9, normalWS);
+    }
+    else if(ProbeBasis == ProbeBases_SG12)
+    {
+        output = EvalSGs(probeIdx, 12, normalWS);
+    }
+
+    return float4(output, 1.0f);
+}
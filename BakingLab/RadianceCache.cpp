@@ -0,0 +1,146 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "RadianceCache.h"
+#include "AtomicFloat.h"
+
+StaticAssert_((RadianceCache::NumCells & (RadianceCache::NumCells - 1)) == 0);
+
+static const uint64 GenerationBits = 24;
+static const uint64 GenerationMask = (1ull << GenerationBits) - 1;
+
+// Hashes the quantized position together with the dominant axis of the normal, so that the
+// opposite sides of a thin wall end up in different cells
+static uint64 HashCell(const Float3& position, const Float3& normal, float cellSize)
+{
+    const float invCellSize = 1.0f / cellSize;
+    const int32 x = int32(std::floor(position.x * invCellSize));
+    const int32 y = int32(std::floor(position.y * invCellSize));
+    const int32 z = int32(std::floor(position.z * invCellSize));
+
+    const Float3 absNormal = Float3(std::abs(normal.x), std::abs(normal.y), std::abs(normal.z));
+    uint64 axis = 0;
+    if(absNormal.y > absNormal.x && absNormal.y > absNormal.z)
+        axis = 1;
+    else if(absNormal.z > absNormal.x && absNormal.z > absNormal.y)
+        axis = 2;
+    const uint64 normalIdx = axis * 2 + ((&normal.x)[axis] < 0.0f ? 1 : 0);
+
+    uint64 hash = uint64(uint32(x)) * 0x9E3779B97F4A7C15ull;
+    hash ^= uint64(uint32(y)) * 0xC2B2AE3D27D4EB4Full;
+    hash ^= uint64(uint32(z)) * 0x165667B19E3779F9ull;
+    hash ^= (normalIdx + 1) * 0x27D4EB2F165667C5ull;
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+static int64 CellTag(uint64 hash, uint64 generation)
+{
+    return int64((((hash >> GenerationBits) | 1) << GenerationBits) | (generation & GenerationMask));
+}
+
+void RadianceCache::Init()
+{
+    if(cells.Size() == 0)
+        cells.Init(NumCells);
+}
+
+void RadianceCache::Shutdown()
+{
+    cells.Shutdown();
+}
+
+bool RadianceCache::Lookup(const Float3& position, const Float3& normal, float cellSize, uint64 generation,
+                           uint32 minSamples, Float3& radiance) const
+{
+    Assert_(cells.Size() == NumCells);
+
+    const uint64 hash = HashCell(position, normal, cellSize);
+    const int64 tag = CellTag(hash, generation);
+    for(uint64 probeIdx = 0; probeIdx < MaxProbes; ++probeIdx)
+    {
+        const RadianceCacheCell& cell = cells[(hash + probeIdx) & (NumCells - 1)];
+        if(cell.Tag != tag)
+            continue;
+
+        // The sum and the count aren't read atomically, which can skew the average by a sample
+        const long numSamples = cell.NumSamples;
+        if(numSamples < long(minSamples) || numSamples == 0)
+            return false;
+
+        const float invNumSamples = 1.0f / numSamples;
+        radiance.x = AsFloat(cell.RadianceSum[0]) * invNumSamples;
+        radiance.y = AsFloat(cell.RadianceSum[1]) * invNumSamples;
+        radiance.z = AsFloat(cell.RadianceSum[2]) * invNumSamples;
+        return true;
+    }
+
+    return false;
+}
+
+void RadianceCache::AddSample(const Float3& position, const Float3& normal, float cellSize, uint64 generation,
+                              const Float3& radiance)
+{
+    Assert_(cells.Size() == NumCells);
+
+    const uint64 hash = HashCell(position, normal, cellSize);
+    const int64 tag = CellTag(hash, generation);
+    for(uint64 probeIdx = 0; probeIdx < MaxProbes; ++probeIdx)
+    {
+        RadianceCacheCell& cell = cells[(hash + probeIdx) & (NumCells - 1)];
+        int64 currTag = cell.Tag;
+        if(currTag != tag && (currTag == 0 || uint64(currTag & GenerationMask) != (generation & GenerationMask)))
+        {
+            // Claim the empty or stale cell. A thread that adds to the cell in between the claim and
+            // the reset loses its sample, which only costs a bit of convergence.
+            if(InterlockedCompareExchange64(&cell.Tag, tag, currTag) == currTag)
+            {
+                cell.RadianceSum[0] = 0;
+                cell.RadianceSum[1] = 0;
+                cell.RadianceSum[2] = 0;
+                cell.NumSamples = 0;
+                _WriteBarrier();
+            }
+            currTag = cell.Tag;
+        }
+
+        if(currTag != tag)
+            continue;
+
+        AtomicAddFloat(&cell.RadianceSum[0], radiance.x);
+        AtomicAddFloat(&cell.RadianceSum[1], radiance.y);
+        AtomicAddFloat(&cell.RadianceSum[2], radiance.z);
+        InterlockedIncrement(&cell.NumSamples);
+        return;
+    }
+}
+
+RadianceCacheOccupancy RadianceCache::Occupancy(uint64 generation, uint32 minSamples) const
+{
+    RadianceCacheOccupancy occupancy;
+    occupancy.NumCells = cells.Size();
+    for(uint64 i = 0; i < cells.Size(); ++i)
+    {
+        const int64 tag = cells[i].Tag;
+        if(tag == 0 || uint64(tag & GenerationMask) != (generation & GenerationMask))
+            continue;
+
+        ++occupancy.NumOccupiedCells;
+        if(cells[i].NumSamples >= long(std::max<uint32>(minSamples, 1)))
+            ++occupancy.NumWarmCells;
+    }
+
+    return occupancy;
+}
@@ -0,0 +1,70 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+#include <SF11_Math.h>
+#include <Containers.h>
+
+using namespace SampleFramework11;
+
+// Number of cells that are in use for the current bake, and how many of them have enough samples
+// for paths to terminate into them
+struct RadianceCacheOccupancy
+{
+    uint64 NumCells = 0;
+    uint64 NumOccupiedCells = 0;
+    uint64 NumWarmCells = 0;
+};
+
+// A single cell of the cache. The tag packs the hashed cell coordinates into the upper 40 bits and
+// the generation into the lower 24 bits, with 0 meaning that the cell was never used. The radiance
+// sum is stored as the bits of 3 floats, so that it can be updated with a compare-exchange.
+struct RadianceCacheCell
+{
+    volatile int64 Tag = 0;
+    volatile long RadianceSum[3] = { };
+    volatile long NumSamples = 0;
+};
+
+// World-space radiance cache, stored as a fixed-size hash grid that's keyed by the quantized
+// position and the dominant axis of the surface normal. The bake threads add the outgoing
+// (diffuse) radiance of their path vertices to it, and paths can terminate into it after a few
+// bounces. Every bake uses a new generation, which turns the cells of previous bakes into free
+// slots without needing to clear the grid while the bake threads are running.
+class RadianceCache
+{
+
+public:
+
+    static const uint64 NumCells = 1024 * 1024;
+    static const uint64 MaxProbes = 8;
+
+    void Init();
+    void Shutdown();
+
+    bool Initialized() const { return cells.Size() > 0; }
+
+    // Returns false if there's no cell for the position, or if it has fewer than minSamples samples
+    bool Lookup(const Float3& position, const Float3& normal, float cellSize, uint64 generation,
+                uint32 minSamples, Float3& radiance) const;
+
+    // Adds a radiance sample to the cell, which is dropped if every slot that it hashes to is in use
+    void AddSample(const Float3& position, const Float3& normal, float cellSize, uint64 generation,
+                   const Float3& radiance);
+
+    // Walks the whole grid, so this should only be used for debugging
+    RadianceCacheOccupancy Occupancy(uint64 generation, uint32 minSamples) const;
+
+private:
+
+    FixedArray<RadianceCacheCell> cells;
+};
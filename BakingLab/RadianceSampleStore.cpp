@@ -0,0 +1,241 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "RadianceSampleStore.h"
+
+static const uint32 IndexFileMagic = 0x53445252;
+static const uint32 IndexFileVersion = 2;
+
+// Chunks are kept to around this size, so that no single mapping needs a huge contiguous range of
+// address space
+static const uint64 TargetChunkSize = 256 * 1024 * 1024;
+
+StaticAssert_(sizeof(StoredRadianceSample) == 12);
+
+static float SignNotZero(float x)
+{
+    return x >= 0.0f ? 1.0f : -1.0f;
+}
+
+static uint32 QuantizeSNorm16(float x)
+{
+    return uint32(std::round((Clamp(x, -1.0f, 1.0f) * 0.5f + 0.5f) * 65535.0f));
+}
+
+static float DequantizeSNorm16(uint32 x)
+{
+    return (x / 65535.0f) * 2.0f - 1.0f;
+}
+
+void StoredRadianceSample::Encode(const Float3& sampleDirTS, const Float3& sample, uint64 sampleIdx, bool directSample)
+{
+    // Project onto the octahedron, and fold the lower half over the upper half
+    const float l1Norm = std::abs(sampleDirTS.x) + std::abs(sampleDirTS.y) + std::abs(sampleDirTS.z);
+    float u = l1Norm > 0.0f ? sampleDirTS.x / l1Norm : 0.0f;
+    float v = l1Norm > 0.0f ? sampleDirTS.y / l1Norm : 0.0f;
+    if(sampleDirTS.z < 0.0f)
+    {
+        const float foldedU = (1.0f - std::abs(v)) * SignNotZero(u);
+        const float foldedV = (1.0f - std::abs(u)) * SignNotZero(v);
+        u = foldedU;
+        v = foldedV;
+    }
+
+    Direction = QuantizeSNorm16(u) | (QuantizeSNorm16(v) << 16);
+    Radiance[0] = XMConvertFloatToHalf(sample.x);
+    Radiance[1] = XMConvertFloatToHalf(sample.y);
+    Radiance[2] = XMConvertFloatToHalf(sample.z);
+
+    Assert_(sampleIdx < MaxSamplesPerTexel);
+    SampleIdx = uint16(sampleIdx | (directSample ? DirectSampleBit : 0));
+}
+
+Float3 StoredRadianceSample::DecodeDirection() const
+{
+    float u = DequantizeSNorm16(Direction & 0xFFFF);
+    float v = DequantizeSNorm16(Direction >> 16);
+    const float z = 1.0f - std::abs(u) - std::abs(v);
+    if(z < 0.0f)
+    {
+        const float unfoldedU = (1.0f - std::abs(v)) * SignNotZero(u);
+        const float unfoldedV = (1.0f - std::abs(u)) * SignNotZero(v);
+        u = unfoldedU;
+        v = unfoldedV;
+    }
+
+    return Float3::Normalize(Float3(u, v, z));
+}
+
+Float3 StoredRadianceSample::DecodeRadiance() const
+{
+    return Float3(XMConvertHalfToFloat(Radiance[0]), XMConvertHalfToFloat(Radiance[1]),
+                  XMConvertHalfToFloat(Radiance[2]));
+}
+
+RadianceSampleStore::~RadianceSampleStore()
+{
+    Close();
+}
+
+void RadianceSampleStore::BeginRecording(const wchar* filePathPrefix_, uint64 lightMapSize, const uint32* pageSizes,
+                                         uint64 numPages, uint64 numGroups, uint64 texelsPerGroup, uint64 samplesPerTexel,
+                                         RadianceSampleDistribution distribution, const Hash& sourceHash)
+{
+    Assert_(numPages <= AppSettings::MaxLightMapPages);
+    Assert_(numGroups > 0 && texelsPerGroup > 0 && samplesPerTexel > 0);
+    Assert_(samplesPerTexel <= StoredRadianceSample::MaxSamplesPerTexel);
+
+    Close();
+
+    filePathPrefix = filePathPrefix_;
+
+    const uint64 groupSize = texelsPerGroup * samplesPerTexel * sizeof(StoredRadianceSample);
+    const uint64 groupsPerChunk = std::min(std::max<uint64>(TargetChunkSize / groupSize, 1), numGroups);
+
+    header = RadianceSampleStoreHeader();
+    header.Magic = IndexFileMagic;
+    header.Version = IndexFileVersion;
+    header.LightMapSize = uint32(lightMapSize);
+    header.NumPages = uint32(numPages);
+    for(uint64 pageIdx = 0; pageIdx < numPages; ++pageIdx)
+        header.PageSizes[pageIdx] = pageSizes[pageIdx];
+    header.NumGroups = uint32(numGroups);
+    header.TexelsPerGroup = uint32(texelsPerGroup);
+    header.SamplesPerTexel = uint32(samplesPerTexel);
+    header.GroupsPerChunk = uint32(groupsPerChunk);
+    header.NumChunks = uint32((numGroups + groupsPerChunk - 1) / groupsPerChunk);
+
+    RestartRecording(distribution, sourceHash);
+
+    chunkFiles.Init(header.NumChunks);
+    chunkSamples.Init(header.NumChunks);
+    for(uint64 chunkIdx = 0; chunkIdx < header.NumChunks; ++chunkIdx)
+    {
+        const uint64 numChunkGroups = std::min<uint64>(groupsPerChunk, numGroups - chunkIdx * groupsPerChunk);
+        chunkFiles[chunkIdx].Create(ChunkFilePath(chunkIdx).c_str(), numChunkGroups * groupSize);
+        chunkSamples[chunkIdx] = reinterpret_cast<StoredRadianceSample*>(chunkFiles[chunkIdx].WritableData());
+    }
+
+    recording = true;
+
+    PrintString("Recording %llu radiance samples to %llu chunks (%.2f MB)", NumSamples(), uint64(header.NumChunks),
+                (numGroups * groupSize) / (1024.0 * 1024.0));
+}
+
+void RadianceSampleStore::RestartRecording(RadianceSampleDistribution distribution, const Hash& sourceHash)
+{
+    complete = false;
+    header.Distribution = distribution;
+    header.SourceHash = sourceHash;
+
+    const std::wstring indexPath = IndexFilePath();
+    if(FileExists(indexPath.c_str()))
+        Win32Call(DeleteFile(indexPath.c_str()));
+}
+
+void RadianceSampleStore::FinishRecording()
+{
+    Assert_(recording);
+    if(complete)
+        return;
+
+    // The chunks only need to be on disk before the index that points at them
+    for(uint64 chunkIdx = 0; chunkIdx < header.NumChunks; ++chunkIdx)
+        Win32Call(FlushViewOfFile(chunkFiles[chunkIdx].Data(), 0));
+
+    File indexFile(IndexFilePath().c_str(), FileOpenMode::Write);
+    indexFile.Write(header);
+    complete = true;
+
+    PrintString("Finished recording radiance samples to %ls", IndexFilePath().c_str());
+}
+
+bool RadianceSampleStore::Open(const wchar* filePathPrefix_)
+{
+    Close();
+
+    filePathPrefix = filePathPrefix_;
+    const std::wstring indexPath = IndexFilePath();
+    if(FileExists(indexPath.c_str()) == false)
+        return false;
+
+    File indexFile(indexPath.c_str(), FileOpenMode::Read);
+    if(indexFile.Size() != sizeof(RadianceSampleStoreHeader))
+        return false;
+
+    indexFile.Read(header);
+    if(header.Magic != IndexFileMagic || header.Version != IndexFileVersion || header.NumChunks == 0
+       || header.GroupsPerChunk == 0 || header.NumPages > AppSettings::MaxLightMapPages
+       || header.SamplesPerTexel > StoredRadianceSample::MaxSamplesPerTexel
+       || header.Distribution > RadianceSampleDistribution::Cosine)
+        return false;
+
+    const uint64 groupSize = uint64(header.TexelsPerGroup) * header.SamplesPerTexel * sizeof(StoredRadianceSample);
+    chunkFiles.Init(header.NumChunks);
+    chunkSamples.Init(header.NumChunks);
+    for(uint64 chunkIdx = 0; chunkIdx < header.NumChunks; ++chunkIdx)
+    {
+        const std::wstring chunkPath = ChunkFilePath(chunkIdx);
+        if(FileExists(chunkPath.c_str()) == false)
+        {
+            Close();
+            return false;
+        }
+
+        const uint64 numChunkGroups = std::min<uint64>(header.GroupsPerChunk, header.NumGroups - chunkIdx * header.GroupsPerChunk);
+        chunkFiles[chunkIdx].Open(chunkPath.c_str());
+        if(chunkFiles[chunkIdx].Size() != numChunkGroups * groupSize)
+        {
+            Close();
+            return false;
+        }
+
+        // The samples are only ever written while recording
+        chunkSamples[chunkIdx] = const_cast<StoredRadianceSample*>(reinterpret_cast<const StoredRadianceSample*>(chunkFiles[chunkIdx].Data()));
+    }
+
+    complete = true;
+    return true;
+}
+
+void RadianceSampleStore::Close()
+{
+    chunkSamples.Shutdown();
+    chunkFiles.Shutdown();
+    header = RadianceSampleStoreHeader();
+    recording = false;
+    complete = false;
+}
+
+bool RadianceSampleStore::MatchesLayout(uint64 lightMapSize, const uint32* pageSizes, uint64 numPages,
+                                        uint64 numGroups, uint64 texelsPerGroup) const
+{
+    if(header.LightMapSize != lightMapSize || header.NumPages != numPages || header.NumGroups != numGroups
+       || header.TexelsPerGroup != texelsPerGroup)
+        return false;
+
+    for(uint64 pageIdx = 0; pageIdx < numPages; ++pageIdx)
+        if(header.PageSizes[pageIdx] != pageSizes[pageIdx])
+            return false;
+
+    return true;
+}
+
+std::wstring RadianceSampleStore::IndexFilePath() const
+{
+    return filePathPrefix + L".bin";
+}
+
+std::wstring RadianceSampleStore::ChunkFilePath(uint64 chunkIdx) const
+{
+    return MakeString(L"%ls_Chunk%03llu.bin", filePathPrefix.c_str(), chunkIdx);
+}
@@ -0,0 +1,141 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+#include <SF11_Math.h>
+#include <Containers.h>
+#include <FileIO.h>
+#include <MurmurHash.h>
+
+#include "AppSettings.h"
+
+using namespace SampleFramework11;
+
+// How the directions of the recorded samples were distributed over the hemisphere
+enum class RadianceSampleDistribution : uint32
+{
+    Uniform = 0,
+    Cosine = 1,
+};
+
+// A single radiance sample of a texel, quantized down to 12 bytes
+struct StoredRadianceSample
+{
+    static const uint64 MaxSamplesPerTexel = 0x8000;
+    static const uint16 DirectSampleBit = 0x8000;
+
+    uint32 Direction = 0;               // Tangent-space direction, octahedral-encoded with 16 bits per axis
+    uint16 Radiance[3] = { };           // RGB as halfs
+    uint16 SampleIdx = 0;               // The top bit marks direct area light samples
+
+    void Encode(const Float3& sampleDirTS, const Float3& sample, uint64 sampleIdx, bool directSample);
+
+    Float3 DecodeDirection() const;
+    Float3 DecodeRadiance() const;
+    uint64 DecodeSampleIdx() const { return SampleIdx & ~DirectSampleBit; }
+
+    // Direct area light samples are irradiance / Pi instead of radiance along the sample direction
+    bool IsDirectSample() const { return (SampleIdx & DirectSampleBit) != 0; }
+};
+
+// Written to the index file once every sample of a bake has been recorded
+struct RadianceSampleStoreHeader
+{
+    uint32 Magic = 0;
+    uint32 Version = 0;
+    uint32 LightMapSize = 0;
+    uint32 NumPages = 0;
+    uint32 PageSizes[AppSettings::MaxLightMapPages] = { };
+    uint32 NumGroups = 0;
+    uint32 TexelsPerGroup = 0;
+    uint32 SamplesPerTexel = 0;
+    uint32 GroupsPerChunk = 0;
+    uint32 NumChunks = 0;
+    RadianceSampleDistribution Distribution = RadianceSampleDistribution::Uniform;
+    Hash SourceHash;                    // The scene and the settings that the radiance depends on
+};
+
+// Keeps every radiance sample of a bake on disk, so that the samples can be run through a different
+// baker or solver later on without tracing them again. The samples of each bake group are stored
+// together in a fixed-size block, with all samples of the first texel followed by those of the next,
+// and the blocks are spread across chunk files that are mapped into memory. The bake threads write
+// straight into the mapped chunks, since every sample has its own slot. The index file that
+// describes the layout is only written once the bake finishes, which is what marks the store as
+// complete. It also records how the sample directions were distributed and a hash of what the
+// radiance was computed from, so that the samples are never replayed against a different scene.
+class RadianceSampleStore
+{
+
+public:
+
+    ~RadianceSampleStore();
+
+    // Creates zero-filled chunk files for the given layout, and removes the index file of a previous store
+    void BeginRecording(const wchar* filePathPrefix, uint64 lightMapSize, const uint32* pageSizes, uint64 numPages,
+                        uint64 numGroups, uint64 texelsPerGroup, uint64 samplesPerTexel,
+                        RadianceSampleDistribution distribution, const Hash& sourceHash);
+
+    // The samples are overwritten by a restarted bake, so the store stays incomplete until it finishes again.
+    // The restarted bake may sample a different distribution, or see a different scene.
+    void RestartRecording(RadianceSampleDistribution distribution, const Hash& sourceHash);
+    void FinishRecording();
+
+    // Maps the chunks of a complete store for reading, and returns false if there's no such store
+    bool Open(const wchar* filePathPrefix);
+    void Close();
+
+    bool Recording() const { return recording; }
+    bool Complete() const { return complete; }
+    bool MatchesLayout(uint64 lightMapSize, const uint32* pageSizes, uint64 numPages, uint64 numGroups,
+                       uint64 texelsPerGroup) const;
+
+    void Record(uint64 groupIdx, uint64 groupTexelIdx, uint64 sampleIdx, const Float3& sampleDirTS, const Float3& sample,
+                bool directSample)
+    {
+        Assert_(recording);
+        Assert_(sampleIdx < header.SamplesPerTexel);
+        chunkSamples[groupIdx / header.GroupsPerChunk][SampleOffset(groupIdx, groupTexelIdx) + sampleIdx].Encode(sampleDirTS, sample,
+                                                                                                               sampleIdx, directSample);
+    }
+
+    // Returns SamplesPerTexel() samples
+    const StoredRadianceSample* TexelSamples(uint64 groupIdx, uint64 groupTexelIdx) const
+    {
+        Assert_(complete);
+        return chunkSamples[groupIdx / header.GroupsPerChunk] + SampleOffset(groupIdx, groupTexelIdx);
+    }
+
+    uint64 NumGroups() const { return header.NumGroups; }
+    uint64 SamplesPerTexel() const { return header.SamplesPerTexel; }
+    uint64 NumSamples() const { return uint64(header.NumGroups) * header.TexelsPerGroup * header.SamplesPerTexel; }
+    RadianceSampleDistribution Distribution() const { return header.Distribution; }
+    const Hash& SourceHash() const { return header.SourceHash; }
+
+private:
+
+    uint64 SampleOffset(uint64 groupIdx, uint64 groupTexelIdx) const
+    {
+        Assert_(groupIdx < header.NumGroups);
+        Assert_(groupTexelIdx < header.TexelsPerGroup);
+        return ((groupIdx % header.GroupsPerChunk) * header.TexelsPerGroup + groupTexelIdx) * header.SamplesPerTexel;
+    }
+
+    std::wstring IndexFilePath() const;
+    std::wstring ChunkFilePath(uint64 chunkIdx) const;
+
+    RadianceSampleStoreHeader header;
+    std::wstring filePathPrefix;
+    FixedArray<MemoryMappedFile> chunkFiles;
+    FixedArray<StoredRadianceSample*> chunkSamples;
+    bool recording = false;
+    bool complete = false;
+};
@@ -23,6 +23,7 @@
 #include <Graphics/Sampling.h>
 
 static SG defaultInitialGuess[AppSettings::MaxSGCount];
+static SG countInitialGuesses[AppSettings::MaxSGCount + 1][AppSettings::MaxSGCount];
 static bool eigenInitialized = false;
 
 // Generate uniform spherical gaussians on the sphere or hemisphere
@@ -102,6 +103,28 @@ const SG* InitialGuess()
     return defaultInitialGuess;
 }
 
+void InitializeMultiSGSolver(SGDistribution distribution)
+{
+    if(eigenInitialized == false)
+    {
+        Eigen::initParallel();
+        eigenInitialized = true;
+    }
+
+    for(uint64 modeIdx = 0; modeIdx < uint64(BakeModes::NumValues); ++modeIdx)
+    {
+        const uint64 numSGs = AppSettings::SGCount(BakeModes(modeIdx));
+        if(numSGs > 0)
+            GenerateUniformSGs(countInitialGuesses[numSGs], numSGs, distribution);
+    }
+}
+
+const SG* InitialGuess(uint64 numSGs)
+{
+    Assert_(numSGs <= uint64(AppSettings::MaxSGCount));
+    return countInitialGuesses[numSGs];
+}
+
 // Solve for SG's using non-negative least squares
 static void SolveNNLS(SGSolveParam& params)
 {
@@ -292,8 +315,9 @@ static void SolveRunningAverage(SGSolveParam& params, bool nonNegative)
 void SolveSGs(SGSolveParam& params)
 {
     Assert_(params.NumSGs <= uint64(AppSettings::MaxSGCount));
+    const SG* initialGuess = params.InitialGuess != nullptr ? params.InitialGuess : defaultInitialGuess;
     for(uint64 i = 0; i < params.NumSGs; ++i)
-        params.OutSGs[i] = defaultInitialGuess[i];
+        params.OutSGs[i] = initialGuess[i];
 
     if(AppSettings::SolveMode == SolveModes::NNLS)
         SolveNNLS(params);
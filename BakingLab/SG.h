@@ -99,6 +99,7 @@ struct SGSolveParam
     uint64 NumSamples = 0;
 
     uint64 NumSGs = 0;                              // number of SG's we want to solve for
+    const SG* InitialGuess = nullptr;               // lobes to start from, or the default initial guess if null
 
     SG* OutSGs;                                     // output of final SG's we solve for
 };
@@ -109,9 +110,15 @@ enum class SGDistribution : uint32
     Hemispherical,
 };
 
+void GenerateUniformSGs(SG* outSGs, uint64 numSGs, SGDistribution distribution);
+
 void InitializeSGSolver(uint64 numSGs, SGDistribution distribution);
 const SG* InitialGuess();
 
+// Generates an initial guess for the SG count of every bake mode, for solving several counts at once
+void InitializeMultiSGSolver(SGDistribution distribution);
+const SG* InitialGuess(uint64 numSGs);
+
 // Solve for k-number of SG's based on a hemisphere of radiance
 void SolveSGs(SGSolveParam& params);
 
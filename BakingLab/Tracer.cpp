@@ -0,0 +1,132 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tracer.h"
+
+#include <FileIO.h>
+#include <mutex>
+
+namespace Tracer
+{
+
+// Number of spans that are kept for each thread
+static const uint64 RingBufferSize = 64 * 1024;
+
+struct TraceEvent
+{
+    const char* Name;
+    int64 StartTime;
+    int64 EndTime;
+};
+
+struct TraceBuffer
+{
+    std::string Name;
+    uint64 Idx = 0;
+    std::vector<TraceEvent> Events;             // Allocated on first use, so that idle threads cost nothing
+    volatile int64 NumEvents = 0;               // Total number of spans written, which wraps around the buffer
+};
+
+volatile bool32 TracingEnabled = false;
+
+static std::mutex bufferLock;
+static std::vector<TraceBuffer*> buffers;
+static __declspec(thread) TraceBuffer* threadBuffer = nullptr;
+static int64 startTime = Timestamp();
+
+void SetEnabled(bool32 enabled)
+{
+    TracingEnabled = enabled;
+}
+
+void RegisterThread(const char* name, uint64 idx)
+{
+    std::lock_guard<std::mutex> lock(bufferLock);
+
+    for(uint64 i = 0; i < buffers.size(); ++i)
+    {
+        if(buffers[i]->Name == name && buffers[i]->Idx == idx)
+        {
+            threadBuffer = buffers[i];
+            return;
+        }
+    }
+
+    TraceBuffer* buffer = new TraceBuffer();
+    buffer->Name = name;
+    buffer->Idx = idx;
+    buffers.push_back(buffer);
+    threadBuffer = buffer;
+}
+
+void RecordSpan(const char* name, int64 spanStart, int64 spanEnd)
+{
+    TraceBuffer* buffer = threadBuffer;
+    if(buffer == nullptr)
+        return;
+
+    if(buffer->Events.size() == 0)
+        buffer->Events.resize(RingBufferSize);
+
+    // Only the owning thread writes to the buffer, so publishing the new count is enough
+    const int64 eventIdx = buffer->NumEvents;
+    TraceEvent& traceEvent = buffer->Events[eventIdx % RingBufferSize];
+    traceEvent.Name = name;
+    traceEvent.StartTime = spanStart;
+    traceEvent.EndTime = spanEnd;
+    _WriteBarrier();
+    buffer->NumEvents = eventIdx + 1;
+}
+
+// The worker threads keep recording while the trace is exported, so spans that get overwritten
+// during the export may show up with mixed-up timings
+void ExportChromeTrace(const wchar* filePath)
+{
+    std::lock_guard<std::mutex> lock(bufferLock);
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    const double usPerTick = 1000000.0 / frequency.QuadPart;
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Baking Lab\"}}";
+
+    uint64 numExported = 0;
+    for(uint64 bufferIdx = 0; bufferIdx < buffers.size(); ++bufferIdx)
+    {
+        const TraceBuffer& buffer = *buffers[bufferIdx];
+        json += MakeAnsiString(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%llu,\"args\":{\"name\":\"%s %llu\"}}",
+                               bufferIdx, buffer.Name.c_str(), buffer.Idx);
+        json += MakeAnsiString(",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%llu,\"args\":{\"sort_index\":%llu}}",
+                               bufferIdx, bufferIdx);
+
+        const int64 numEvents = buffer.NumEvents;
+        _ReadBarrier();
+        const int64 firstEvent = std::max<int64>(numEvents - int64(RingBufferSize), 0);
+        for(int64 eventIdx = firstEvent; eventIdx < numEvents; ++eventIdx)
+        {
+            const TraceEvent& traceEvent = buffer.Events[eventIdx % RingBufferSize];
+            const double ts = (traceEvent.StartTime - startTime) * usPerTick;
+            const double dur = std::max<int64>(traceEvent.EndTime - traceEvent.StartTime, 0) * usPerTick;
+            json += MakeAnsiString(",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f}",
+                                   traceEvent.Name, bufferIdx, ts, dur);
+            ++numExported;
+        }
+    }
+
+    json += "\n]}\n";
+    WriteStringAsFile(filePath, json);
+
+    PrintString("Exported %llu trace spans from %llu threads to %ls", numExported, buffers.size(), filePath);
+}
+
+}
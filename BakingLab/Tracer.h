@@ -0,0 +1,64 @@
+//=================================================================================================
+//
+//  Baking Lab
+//  by MJP and David Neubelt
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+
+// Records timed spans from any number of threads. Each registered thread writes into its own ring
+// buffer, which only keeps the most recent spans, so recording never takes a lock. The spans of
+// all threads can be exported in the Chrome trace event format, for viewing in chrome://tracing
+// or ui.perfetto.dev. Spans are only recorded while tracing is enabled.
+namespace Tracer
+{
+    extern volatile bool32 TracingEnabled;
+
+    void SetEnabled(bool32 enabled);
+
+    // Binds the calling thread to the ring buffer for the given name and index, creating it if
+    // needed. Threads that are re-created with the same name and index share one buffer.
+    void RegisterThread(const char* name, uint64 idx);
+
+    // Writes the contents of every ring buffer as a JSON trace
+    void ExportChromeTrace(const wchar* filePath);
+
+    // The name must be a string literal, since only the pointer is stored
+    void RecordSpan(const char* name, int64 startTime, int64 endTime);
+
+    inline int64 Timestamp()
+    {
+        LARGE_INTEGER time;
+        QueryPerformanceCounter(&time);
+        return time.QuadPart;
+    }
+}
+
+// Records a span covering its lifetime, on the calling thread
+class TraceSpan
+{
+
+public:
+
+    explicit TraceSpan(const char* spanName) : name(spanName)
+    {
+        startTime = Tracer::TracingEnabled ? Tracer::Timestamp() : -1;
+    }
+
+    ~TraceSpan()
+    {
+        if(startTime >= 0)
+            Tracer::RecordSpan(name, startTime, Tracer::Timestamp());
+    }
+
+private:
+
+    const char* name = nullptr;
+    int64 startTime = -1;
+};
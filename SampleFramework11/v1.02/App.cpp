@@ -17,6 +17,7 @@
 #include "FileIO.h"
 #include "Settings.h"
 #include "TwHelper.h"
+#include "ThreadPool.h"
 
 // AppSettings framework
 namespace AppSettings
@@ -95,6 +96,8 @@ int32 App::Run()
 
         AppSettings::Initialize(deviceManager.Device());
 
+        ThreadPool::Initialize();
+
         Initialize();
 
         AfterReset();
@@ -142,6 +145,8 @@ int32 App::Run()
         return -1;
     }
 
+    ThreadPool::Shutdown();
+
     ShutdownShaders();
 
     TwCall(TwTerminate());
@@ -215,6 +215,15 @@ void File::Write(uint64 size, const void* data) const
     Win32Call(WriteFile(fileHandle, data, static_cast<DWORD>(size), &bytesWritten, NULL));
 }
 
+void File::Seek(uint64 position) const
+{
+    Assert_(fileHandle != INVALID_HANDLE_VALUE);
+
+    LARGE_INTEGER distance;
+    distance.QuadPart = position;
+    Win32Call(SetFilePointerEx(fileHandle, distance, nullptr, FILE_BEGIN));
+}
+
 uint64 File::Size() const
 {
     Assert_(fileHandle != INVALID_HANDLE_VALUE);
@@ -225,4 +234,109 @@ uint64 File::Size() const
     return fileSize.QuadPart;
 }
 
+// == MemoryMappedFile ============================================================================
+
+MemoryMappedFile::MemoryMappedFile() : fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL),
+                                       data(nullptr), size(0), writable(false)
+{
+}
+
+MemoryMappedFile::MemoryMappedFile(const wchar* filePath) : fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL),
+                                                            data(nullptr), size(0), writable(false)
+{
+    Open(filePath);
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    Close();
+}
+
+void MemoryMappedFile::Open(const wchar* filePath)
+{
+    Assert_(fileHandle == INVALID_HANDLE_VALUE);
+    Assert_(FileExists(filePath));
+
+    fileHandle = CreateFile(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE)
+    {
+        std::wstring errPrefix = std::wstring(L"Failed to open file ") + filePath + L":\n";
+        throw Win32Exception(GetLastError(), errPrefix.c_str());
+    }
+
+    LARGE_INTEGER fileSize;
+    Win32Call(GetFileSizeEx(fileHandle, &fileSize));
+    size = fileSize.QuadPart;
+
+    // Empty files can't be mapped
+    if(size == 0)
+        return;
+
+    mappingHandle = CreateFileMapping(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mappingHandle == NULL)
+    {
+        std::wstring errPrefix = std::wstring(L"Failed to map file ") + filePath + L":\n";
+        throw Win32Exception(GetLastError(), errPrefix.c_str());
+    }
+
+    data = reinterpret_cast<const uint8*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if(data == nullptr)
+    {
+        std::wstring errPrefix = std::wstring(L"Failed to map a view of file ") + filePath + L":\n";
+        throw Win32Exception(GetLastError(), errPrefix.c_str());
+    }
+}
+
+void MemoryMappedFile::Create(const wchar* filePath, uint64 fileSize)
+{
+    Assert_(fileHandle == INVALID_HANDLE_VALUE);
+    Assert_(fileSize > 0);
+
+    fileHandle = CreateFile(filePath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE)
+    {
+        std::wstring errPrefix = std::wstring(L"Failed to create file ") + filePath + L":\n";
+        throw Win32Exception(GetLastError(), errPrefix.c_str());
+    }
+
+    // Mapping more than the size of the file grows it, and the new part reads back as zeros
+    size = fileSize;
+    mappingHandle = CreateFileMapping(fileHandle, NULL, PAGE_READWRITE, DWORD(fileSize >> 32),
+                                     DWORD(fileSize & 0xFFFFFFFF), NULL);
+    if(mappingHandle == NULL)
+    {
+        std::wstring errPrefix = std::wstring(L"Failed to map file ") + filePath + L":\n";
+        throw Win32Exception(GetLastError(), errPrefix.c_str());
+    }
+
+    data = reinterpret_cast<const uint8*>(MapViewOfFile(mappingHandle, FILE_MAP_WRITE, 0, 0, 0));
+    if(data == nullptr)
+    {
+        std::wstring errPrefix = std::wstring(L"Failed to map a view of file ") + filePath + L":\n";
+        throw Win32Exception(GetLastError(), errPrefix.c_str());
+    }
+
+    writable = true;
+}
+
+void MemoryMappedFile::Close()
+{
+    if(data != nullptr)
+        Win32Call(UnmapViewOfFile(data));
+    data = nullptr;
+
+    if(mappingHandle != NULL)
+        Win32Call(CloseHandle(mappingHandle));
+    mappingHandle = NULL;
+
+    if(fileHandle != INVALID_HANDLE_VALUE)
+        Win32Call(CloseHandle(fileHandle));
+    fileHandle = INVALID_HANDLE_VALUE;
+
+    size = 0;
+    writable = false;
+}
+
 }
\ No newline at end of file
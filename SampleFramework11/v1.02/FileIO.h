@@ -58,6 +58,7 @@ public:
     // I/O
     void Read(uint64 size, void* data) const;
     void Write(uint64 size, const void* data) const;
+    void Seek(uint64 position) const;
 
     template<typename T> void Read(T& data) const;
     template<typename T> void Write(const T& data) const;
@@ -66,6 +67,37 @@ public:
     uint64 Size() const;
 };
 
+// Maps an entire file into memory, either read-only for an existing file or writable for a newly
+// created one
+class MemoryMappedFile
+{
+
+private:
+
+    HANDLE fileHandle;
+    HANDLE mappingHandle;
+    const uint8* data;
+    uint64 size;
+    bool writable;
+
+public:
+
+    // Lifetime
+    MemoryMappedFile();
+    explicit MemoryMappedFile(const wchar* filePath);
+    ~MemoryMappedFile();
+
+    // Explicit Open and close. Create() replaces any existing file with a zero-filled one.
+    void Open(const wchar* filePath);
+    void Create(const wchar* filePath, uint64 fileSize);
+    void Close();
+
+    // Accessors
+    const uint8* Data() const { return data; }
+    uint8* WritableData() const { Assert_(writable); return const_cast<uint8*>(data); }
+    uint64 Size() const { return size; }
+};
+
 // == File ========================================================================================
 
 template<typename T> void File::Read(T& data) const
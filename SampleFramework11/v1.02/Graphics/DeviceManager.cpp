@@ -104,7 +104,9 @@ void DeviceManager::Initialize(HWND outputWindow)
     desc.OutputWindow = outputWindow;
     desc.Windowed = !fullScreen;
 
-    uint32 flags = D3D11_CREATE_DEVICE_SINGLETHREADED;
+    // The device is left free-threaded, so that textures and buffers can be created from the
+    // thread pool while loading. The immediate context must still only be used by one thread.
+    uint32 flags = 0;
     #if UseDebugDevice_
         flags |= D3D11_CREATE_DEVICE_DEBUG;
     #endif
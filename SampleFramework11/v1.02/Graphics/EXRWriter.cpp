@@ -0,0 +1,238 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "EXRWriter.h"
+
+#include "..\\Exceptions.h"
+#include "..\\Assert.h"
+#include "..\\FileIO.h"
+#include "..\\ThreadPool.h"
+#include "TinyEXR.h"
+
+namespace SampleFramework11
+{
+
+static const uint32 EXRMagic = 20000630;
+static const uint32 EXRVersion = 2;                 // Single-part scanline file
+static const int32 EXRHalfPixelType = 1;
+static const uint8 EXRZipCompression = 3;
+static const uint32 ScanlinesPerBlock = 16;         // Fixed by the format for ZIP compression
+static const uint64 BlocksPerThread = 4;
+
+struct EXRChannel
+{
+    std::string Name;
+    uint64 LayerIdx = 0;
+    uint64 Component = 0;
+};
+
+template<typename T> static void AppendValue(std::vector<uint8>& data, const T& value)
+{
+    const uint8* bytes = reinterpret_cast<const uint8*>(&value);
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+static void AppendString(std::vector<uint8>& data, const std::string& str)
+{
+    data.insert(data.end(), str.c_str(), str.c_str() + str.length() + 1);
+}
+
+static void AppendAttribute(std::vector<uint8>& header, const char* name, const char* type,
+                            const void* data, uint64 size)
+{
+    AppendString(header, name);
+    AppendString(header, type);
+    AppendValue(header, uint32(size));
+
+    const uint8* bytes = reinterpret_cast<const uint8*>(data);
+    header.insert(header.end(), bytes, bytes + size);
+}
+
+static std::vector<uint8> BuildHeader(uint32 width, uint32 height, const std::vector<EXRChannel>& channels)
+{
+    std::vector<uint8> header;
+    AppendValue(header, EXRMagic);
+    AppendValue(header, EXRVersion);
+
+    std::vector<uint8> channelList;
+    for(uint64 i = 0; i < channels.size(); ++i)
+    {
+        AppendString(channelList, channels[i].Name);
+        AppendValue(channelList, EXRHalfPixelType);
+        AppendValue(channelList, uint32(0));            // pLinear and 3 reserved bytes
+        AppendValue(channelList, int32(1));             // xSampling
+        AppendValue(channelList, int32(1));             // ySampling
+    }
+    channelList.push_back(0);
+    AppendAttribute(header, "channels", "chlist", channelList.data(), channelList.size());
+
+    AppendAttribute(header, "compression", "compression", &EXRZipCompression, sizeof(EXRZipCompression));
+
+    const int32 window[4] = { 0, 0, int32(width) - 1, int32(height) - 1 };
+    AppendAttribute(header, "dataWindow", "box2i", window, sizeof(window));
+    AppendAttribute(header, "displayWindow", "box2i", window, sizeof(window));
+
+    const uint8 lineOrder = 0;                          // Increasing Y
+    AppendAttribute(header, "lineOrder", "lineOrder", &lineOrder, sizeof(lineOrder));
+
+    const float aspectRatio = 1.0f;
+    AppendAttribute(header, "pixelAspectRatio", "float", &aspectRatio, sizeof(aspectRatio));
+
+    const float windowCenter[2] = { 0.0f, 0.0f };
+    AppendAttribute(header, "screenWindowCenter", "v2f", windowCenter, sizeof(windowCenter));
+
+    const float windowWidth = 1.0f;
+    AppendAttribute(header, "screenWindowWidth", "float", &windowWidth, sizeof(windowWidth));
+
+    header.push_back(0);
+
+    return header;
+}
+
+// Gathers the scanlines of one block and compresses them, producing the block exactly as it's
+// stored in the file
+static void BuildBlock(uint64 blockIdx, uint32 width, uint32 height, uint64 numLayers,
+                       const std::vector<EXRChannel>& channels, const EXRRowFunction& getRow,
+                       std::vector<uint8>& output)
+{
+    const uint32 startY = uint32(blockIdx * ScanlinesPerBlock);
+    const uint32 endY = std::min(startY + ScanlinesPerBlock, height);
+    const uint64 numChannels = channels.size();
+
+    // Each scanline stores all of the texels of one channel before moving on to the next
+    std::vector<uint16> rawData(uint64(endY - startY) * numChannels * width);
+    std::vector<Float4> rowTexels(numLayers * width);
+    for(uint32 y = startY; y < endY; ++y)
+    {
+        for(uint64 layerIdx = 0; layerIdx < numLayers; ++layerIdx)
+            getRow(layerIdx, y, &rowTexels[layerIdx * width]);
+
+        uint16* dst = &rawData[uint64(y - startY) * numChannels * width];
+        for(uint64 channelIdx = 0; channelIdx < numChannels; ++channelIdx)
+        {
+            const EXRChannel& channel = channels[channelIdx];
+            const Float4* src = &rowTexels[channel.LayerIdx * width];
+            for(uint32 x = 0; x < width; ++x)
+                dst[x] = XMConvertFloatToHalf((&src[x].x)[channel.Component]);
+            dst += width;
+        }
+    }
+
+    const uint8* blockData = reinterpret_cast<const uint8*>(rawData.data());
+    const uint64 rawSize = rawData.size() * sizeof(uint16);
+    uint64 blockSize = rawSize;
+
+    std::vector<uint8> compressed(CompressBoundEXRZip(static_cast<unsigned long>(rawSize)));
+    const uint64 compressedSize = CompressEXRZipBlock(compressed.data(), blockData, static_cast<unsigned long>(rawSize));
+
+    // The format stores blocks that don't get any smaller without compression
+    if(compressedSize < rawSize)
+    {
+        blockData = compressed.data();
+        blockSize = compressedSize;
+    }
+
+    output.clear();
+    AppendValue(output, int32(startY));
+    AppendValue(output, int32(blockSize));
+    output.insert(output.end(), blockData, blockData + blockSize);
+}
+
+void WriteEXR(const wchar* filePath, uint32 width, uint32 height, const std::vector<std::string>& layerNames,
+              const EXRRowFunction& getRow)
+{
+    Assert_(width > 0 && height > 0);
+    Assert_(layerNames.size() > 0);
+
+    // The format requires the channels to be sorted by name
+    const char* componentNames[3] = { "R", "G", "B" };
+    const uint64 numLayers = layerNames.size();
+    std::vector<EXRChannel> channels;
+    for(uint64 layerIdx = 0; layerIdx < numLayers; ++layerIdx)
+    {
+        for(uint64 component = 0; component < ArraySize_(componentNames); ++component)
+        {
+            EXRChannel channel;
+            channel.Name = layerNames[layerIdx].length() > 0 ? layerNames[layerIdx] + "." : "";
+            channel.Name += componentNames[component];
+            channel.LayerIdx = layerIdx;
+            channel.Component = component;
+            channels.push_back(channel);
+        }
+    }
+
+    std::sort(channels.begin(), channels.end(), [](const EXRChannel& a, const EXRChannel& b)
+    {
+        return a.Name < b.Name;
+    });
+
+    const std::vector<uint8> header = BuildHeader(width, height, channels);
+
+    // The offset table comes right after the header, and gets filled in once every block has
+    // been written
+    const uint64 numBlocks = (height + ScanlinesPerBlock - 1) / ScanlinesPerBlock;
+    std::vector<uint64> offsets(numBlocks, 0);
+
+    File file(filePath, FileOpenMode::Write);
+    file.Write(header.size(), header.data());
+    file.Write(offsets.size() * sizeof(uint64), offsets.data());
+    uint64 fileOffset = header.size() + offsets.size() * sizeof(uint64);
+
+    // Each batch of blocks is compressed while the previous batch is being written out, which
+    // takes one extra pass at the end to write out the last batch
+    const uint64 batchSize = std::max<uint64>(ThreadPool::NumThreads(), 1) * BlocksPerThread;
+    std::vector<std::vector<uint8>> batches[2];
+    batches[0].resize(batchSize);
+    batches[1].resize(batchSize);
+
+    uint64 prevBatchStart = 0;
+    uint64 prevBatchCount = 0;
+    for(uint64 batchStart = 0; batchStart < numBlocks + batchSize; batchStart += batchSize)
+    {
+        const uint64 batchIdx = batchStart / batchSize;
+        std::vector<std::vector<uint8>>& currBatch = batches[batchIdx % 2];
+        const std::vector<std::vector<uint8>>& prevBatch = batches[(batchIdx + 1) % 2];
+        const uint64 batchCount = batchStart < numBlocks ? std::min(batchSize, numBlocks - batchStart) : 0;
+
+        JobGroup jobs;
+
+        if(prevBatchCount > 0)
+        {
+            jobs.Run([&]()
+            {
+                for(uint64 i = 0; i < prevBatchCount; ++i)
+                {
+                    offsets[prevBatchStart + i] = fileOffset;
+                    file.Write(prevBatch[i].size(), prevBatch[i].data());
+                    fileOffset += prevBatch[i].size();
+                }
+            });
+        }
+
+        for(uint64 i = 0; i < batchCount; ++i)
+        {
+            jobs.Run([&, i]()
+            {
+                BuildBlock(batchStart + i, width, height, numLayers, channels, getRow, currBatch[i]);
+            });
+        }
+
+        jobs.Wait();
+
+        prevBatchStart = batchStart;
+        prevBatchCount = batchCount;
+    }
+
+    file.Seek(header.size());
+    file.Write(offsets.size() * sizeof(uint64), offsets.data());
+}
+
+}
@@ -0,0 +1,33 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\SF11_Math.h"
+
+#include <functional>
+
+namespace SampleFramework11
+{
+
+// Fills in the "width" texels of one scanline of one layer. This is called from the thread pool,
+// so it needs to be safe to call from several threads at once.
+typedef std::function<void(uint64 layerIdx, uint64 y, Float4* rowTexels)> EXRRowFunction;
+
+// Writes a ZIP-compressed scanline EXR file made up of one or more layers, which each have R, G
+// and B channels stored as 16-bit floats. A layer with an empty name gets plain R, G and B
+// channels, and any other layer gets channels such as "Name.R". Blocks of scanlines are pulled
+// from the row function and compressed in parallel, and are written out while the next batch is
+// being compressed, so the full image never needs to exist in memory.
+void WriteEXR(const wchar* filePath, uint32 width, uint32 height, const std::vector<std::string>& layerNames,
+              const EXRRowFunction& getRow);
+
+}
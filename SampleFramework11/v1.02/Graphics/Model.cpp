@@ -18,6 +18,7 @@
 #include "..\\Serialization.h"
 #include "..\\FileIO.h"
 #include "Textures.h"
+#include "..\\ThreadPool.h"
 
 using std::string;
 using std::wstring;
@@ -28,6 +29,87 @@ using std::wifstream;
 namespace SampleFramework11
 {
 
+static const uint32 AssimpImportFlags = aiProcess_CalcTangentSpace |
+                                        aiProcess_Triangulate |
+                                        aiProcess_JoinIdenticalVertices |
+                                        aiProcess_MakeLeftHanded |
+                                        aiProcess_PreTransformVertices |
+                                        aiProcess_RemoveRedundantMaterials |
+                                        aiProcess_OptimizeMeshes |
+                                        aiProcess_FlipUVs |
+                                        aiProcess_FlipWindingOrder;
+
+static const uint64 NumMaterialMaps = uint64(MaterialMaps::NumValues);
+static const uint64 DiffuseMapIdx = uint64(MaterialMaps::Diffuse);
+
+static const wchar* DefaultMaterialMapPaths[] =
+{
+    L"..\\Content\\Textures\\Default.dds",
+    L"..\\Content\\Textures\\DefaultNormalMap.dds",
+    L"..\\Content\\Textures\\DefaultRoughness.dds",
+    L"..\\Content\\Textures\\DefaultBlack.dds",
+};
+
+StaticAssert_(ArraySize_(DefaultMaterialMapPaths) == NumMaterialMaps);
+
+// The default textures are shared by every material that's missing a map, and are only loaded once
+static ID3D11ShaderResourceViewPtr defaultMaterialMaps[NumMaterialMaps];
+static std::mutex defaultMaterialMapLock;
+
+static std::wstring& MaterialMapName(MeshMaterial& material, uint64 mapIdx)
+{
+    std::wstring* names[] = { &material.DiffuseMapName, &material.NormalMapName,
+                              &material.RoughnessMapName, &material.MetallicMapName };
+    StaticAssert_(ArraySize_(names) == NumMaterialMaps);
+    Assert_(mapIdx < NumMaterialMaps);
+    return *names[mapIdx];
+}
+
+static const std::wstring& MaterialMapName(const MeshMaterial& material, uint64 mapIdx)
+{
+    return MaterialMapName(const_cast<MeshMaterial&>(material), mapIdx);
+}
+
+// Returns the path of the file that a material map gets loaded from, or an empty string if the
+// material doesn't have that map
+static wstring MaterialMapFilePath(const MeshMaterial& material, uint64 mapIdx, const wstring& directory)
+{
+    const wstring& mapName = MaterialMapName(material, mapIdx);
+    const wstring mapPath = directory + mapName;
+    if(mapName.length() > 1 && FileExists(mapPath.c_str()))
+        return mapPath;
+    return wstring();
+}
+
+static ID3D11ShaderResourceViewPtr& MaterialMap(MeshMaterial& material, uint64 mapIdx)
+{
+    ID3D11ShaderResourceViewPtr* maps[] = { &material.DiffuseMap, &material.NormalMap,
+                                            &material.RoughnessMap, &material.MetallicMap };
+    StaticAssert_(ArraySize_(maps) == NumMaterialMaps);
+    Assert_(mapIdx < NumMaterialMaps);
+    return *maps[mapIdx];
+}
+
+static ID3D11ShaderResourceViewPtr DefaultMaterialMap(ID3D11Device* device, uint64 mapIdx)
+{
+    std::lock_guard<std::mutex> lock(defaultMaterialMapLock);
+    if(defaultMaterialMaps[mapIdx] == nullptr)
+        defaultMaterialMaps[mapIdx] = LoadTexture(device, DefaultMaterialMapPaths[mapIdx]);
+    return defaultMaterialMaps[mapIdx];
+}
+
+// Loads one map of a material, falling back to the default texture if the material doesn't have
+// one. Only the diffuse map is ever treated as sRGB. This can be called from any thread.
+static void LoadMaterialMap(MeshMaterial& material, uint64 mapIdx, const wstring& directory, ID3D11Device* device,
+                            bool forceSRGB, Blob* ddsData)
+{
+    const wstring mapPath = MaterialMapFilePath(material, mapIdx, directory);
+    if(mapPath.length() > 0)
+        MaterialMap(material, mapIdx) = LoadTexture(device, mapPath.c_str(), forceSRGB && mapIdx == DiffuseMapIdx, ddsData);
+    else
+        MaterialMap(material, mapIdx) = DefaultMaterialMap(device, mapIdx);
+}
+
 struct Vertex
 {
     Float3 Position;
@@ -886,6 +968,7 @@ void Model::CreateFromSDKMeshFile(ID3D11Device* device, LPCWSTR fileName, const
         LoadMaterialResources(material, fileDirectory, device, forceSRGB);
 
         meshMaterials.push_back(material);
+        materialsSRGB = forceSRGB;
     }
 
     uint32 numMeshes = sdkMesh.GetNumMeshes();
@@ -895,22 +978,18 @@ void Model::CreateFromSDKMeshFile(ID3D11Device* device, LPCWSTR fileName, const
 }
 
 void Model::CreateWithAssimp(ID3D11Device* device, const wchar* fileName, bool forceSRGB)
+{
+    ImportWithAssimp(device, fileName, forceSRGB, nullptr);
+}
+
+void Model::ImportWithAssimp(ID3D11Device* device, const wchar* fileName, bool forceSRGB, vector<Blob>* ddsData)
 {
     Assert_(FileExists(fileName));
 
     std::string fileNameAnsi = WStringToAnsi(fileName);
 
     Assimp::Importer importer;
-    uint32 flags = aiProcess_CalcTangentSpace |
-                   aiProcess_Triangulate |
-                   aiProcess_JoinIdenticalVertices |
-                   aiProcess_MakeLeftHanded |
-                   aiProcess_PreTransformVertices |
-                   aiProcess_RemoveRedundantMaterials |
-                   aiProcess_OptimizeMeshes |
-                   aiProcess_FlipUVs |
-                   aiProcess_FlipWindingOrder ;
-    const aiScene* scene = importer.ReadFile(fileNameAnsi, flags);
+    const aiScene* scene = importer.ReadFile(fileNameAnsi, AssimpImportFlags);
 
     if(scene == nullptr)
         throw Exception(L"Failed to load scene " + std::wstring(fileName) +
@@ -924,7 +1003,7 @@ void Model::CreateWithAssimp(ID3D11Device* device, const wchar* fileName, bool f
 
     fileDirectory = GetDirectoryFromFilePath(fileName);
 
-    // Load the materials
+    // Create the materials
     const uint64 numMaterials = scene->mNumMaterials;
     for(uint64 i = 0; i < numMaterials; ++i)
     {
@@ -948,24 +1027,331 @@ void Model::CreateWithAssimp(ID3D11Device* device, const wchar* fileName, bool f
         if(mat.GetTexture(aiTextureType_AMBIENT, 0, &metallicMapPath) == aiReturn_SUCCESS)
             material.MetallicMapName = GetFileName(AnsiToWString(metallicMapPath.C_Str()).c_str());
 
-        LoadMaterialResources(material, fileDirectory, device, forceSRGB);
+        aiColor3D emissive(0.0f, 0.0f, 0.0f);
+        if(mat.Get(AI_MATKEY_COLOR_EMISSIVE, emissive) == aiReturn_SUCCESS)
+            material.Emissive = Float3(emissive.r, emissive.g, emissive.b);
 
         meshMaterials.push_back(material);
     }
 
-    // Initialize the meshes
+    // Load all of the textures and initialize the meshes at the same time
+    JobGroup loadJobs;
+    loadJobs.Run([&]() { LoadMaterials(device, forceSRGB, ddsData); });
+
     const uint64 numMeshes = scene->mNumMeshes;
     meshes.resize(numMeshes);
     for(uint64 i = 0; i < numMeshes; ++i)
-        meshes[i].InitFromAssimpMesh(device, *scene->mMeshes[i]);
+        loadJobs.Run([this, device, scene, i]() { meshes[i].InitFromAssimpMesh(device, *scene->mMeshes[i]); });
+
+    loadJobs.Wait();
 }
 
 void Model::CreateFromMeshData(ID3D11Device* device, const wchar* fileName, bool forceSRGB)
 {
-    FileReadSerializer serializer(fileName);
+    // The vertex and index data is copied straight out of the mapping in one go
+    MappedFileReadSerializer serializer(fileName);
     Serialize(serializer, device, forceSRGB);
 }
 
+// The scene cache is a single file holding everything that CreateWithAssimp produces: the vertex
+// and index data of every mesh in its final layout, and the full mip chain of every material
+// texture as DDS data. Every blob starts on a 16-byte boundary, so that it can be used straight
+// from the mapped file. Bump the version whenever the layout or the import settings change.
+static const uint32 SceneCacheMagic = 0x4E435353;
+static const uint32 SceneCacheVersion = 3;
+static const uint64 SceneCacheAlignment = 16;
+
+struct SceneCacheBlob
+{
+    uint64 Offset;
+    uint64 Size;
+};
+
+struct SceneCacheHeader
+{
+    uint32 Magic;
+    uint32 Version;
+    uint64 FileSize;
+    uint64 SourceTimestamp;
+    uint64 SourceSize;
+    uint32 ImportFlags;
+    uint32 ForceSRGB;
+    uint64 NumMeshes;
+    uint64 NumMaterials;
+    SceneCacheBlob Meshes;                  // SceneCacheMesh[NumMeshes]
+    SceneCacheBlob Materials;               // SceneCacheMaterial[NumMaterials]
+};
+
+struct SceneCacheMesh
+{
+    uint32 VertexStride;
+    uint32 NumVertices;
+    uint32 NumIndices;
+    uint32 IndexType;
+    SceneCacheBlob MeshParts;               // MeshPart[]
+    SceneCacheBlob InputElements;           // SceneCacheInputElement[]
+    SceneCacheBlob Vertices;
+    SceneCacheBlob Indices;
+};
+
+struct SceneCacheInputElement
+{
+    char SemanticName[32];
+    uint32 SemanticIndex;
+    uint32 Format;
+    uint32 InputSlot;
+    uint32 AlignedByteOffset;
+    uint32 InputSlotClass;
+    uint32 InstanceDataStepRate;
+};
+
+struct SceneCacheTexture
+{
+    SceneCacheBlob Name;                    // wchar[], without a null terminator
+    SceneCacheBlob DDSData;                 // Empty when the material uses a default texture
+    uint64 SourceTimestamp;
+};
+
+struct SceneCacheMaterial
+{
+    SceneCacheTexture Maps[NumMaterialMaps];
+    Float3 Emissive;
+};
+
+static uint64 GetSourceFileSize(const wchar* filePath)
+{
+    File file(filePath, FileOpenMode::Read);
+    return file.Size();
+}
+
+static SceneCacheBlob AppendBlob(vector<uint8>& fileData, const void* data, uint64 size)
+{
+    SceneCacheBlob blob;
+    blob.Offset = (fileData.size() + SceneCacheAlignment - 1) & ~(SceneCacheAlignment - 1);
+    blob.Size = size;
+    fileData.resize(size_t(blob.Offset + size), 0);
+    if(size > 0)
+        memcpy(&fileData[size_t(blob.Offset)], data, size_t(size));
+    return blob;
+}
+
+static wstring ReadBlobString(const uint8* fileData, const SceneCacheBlob& blob)
+{
+    const wchar* chars = reinterpret_cast<const wchar*>(fileData + blob.Offset);
+    return wstring(chars, chars + blob.Size / sizeof(wchar));
+}
+
+void Model::CreateWithSceneCache(ID3D11Device* device, const wchar* fileName, bool forceSRGB)
+{
+    Assert_(FileExists(fileName));
+
+    const wstring cachePath = GetFilePathWithoutExtension(fileName) + L".scenecache";
+    if(FileExists(cachePath.c_str()) && LoadSceneCache(device, cachePath.c_str(), fileName, forceSRGB))
+        return;
+
+    vector<Blob> ddsData;
+    ImportWithAssimp(device, fileName, forceSRGB, &ddsData);
+    WriteSceneCache(cachePath.c_str(), fileName, forceSRGB, ddsData);
+}
+
+// Returns false without modifying the model if the cache doesn't match the source files
+bool Model::LoadSceneCache(ID3D11Device* device, const wchar* cachePath, const wchar* fileName, bool forceSRGB)
+{
+    MemoryMappedFile cacheFile(cachePath);
+    const uint8* fileData = cacheFile.Data();
+    if(cacheFile.Size() < sizeof(SceneCacheHeader))
+        return false;
+
+    const SceneCacheHeader& header = *reinterpret_cast<const SceneCacheHeader*>(fileData);
+    if(header.Magic != SceneCacheMagic || header.Version != SceneCacheVersion || header.FileSize != cacheFile.Size())
+        return false;
+
+    if(header.SourceTimestamp != GetFileTimestamp(fileName) || header.SourceSize != GetSourceFileSize(fileName)
+       || header.ImportFlags != AssimpImportFlags || header.ForceSRGB != (forceSRGB ? 1u : 0u))
+        return false;
+
+    const SceneCacheMesh* cacheMeshes = reinterpret_cast<const SceneCacheMesh*>(fileData + header.Meshes.Offset);
+    const SceneCacheMaterial* cacheMaterials = reinterpret_cast<const SceneCacheMaterial*>(fileData + header.Materials.Offset);
+    const wstring directory = GetDirectoryFromFilePath(fileName);
+
+    // Make sure that none of the textures have been modified, added, or removed
+    for(uint64 materialIdx = 0; materialIdx < header.NumMaterials; ++materialIdx)
+    {
+        for(uint64 mapIdx = 0; mapIdx < NumMaterialMaps; ++mapIdx)
+        {
+            const SceneCacheTexture& cacheTexture = cacheMaterials[materialIdx].Maps[mapIdx];
+            const wstring mapName = ReadBlobString(fileData, cacheTexture.Name);
+            const wstring mapPath = directory + mapName;
+            const bool mapExists = mapName.length() > 1 && FileExists(mapPath.c_str());
+            if(mapExists != (cacheTexture.DDSData.Size > 0))
+                return false;
+            if(mapExists && GetFileTimestamp(mapPath.c_str()) != cacheTexture.SourceTimestamp)
+                return false;
+        }
+    }
+
+    fileDirectory = directory;
+
+    meshes.resize(header.NumMeshes);
+    for(uint64 meshIdx = 0; meshIdx < header.NumMeshes; ++meshIdx)
+    {
+        const SceneCacheMesh& cacheMesh = cacheMeshes[meshIdx];
+        Mesh& mesh = meshes[meshIdx];
+
+        mesh.vertexStride = cacheMesh.VertexStride;
+        mesh.numVertices = cacheMesh.NumVertices;
+        mesh.numIndices = cacheMesh.NumIndices;
+        mesh.indexType = IndexType(cacheMesh.IndexType);
+
+        const MeshPart* meshParts = reinterpret_cast<const MeshPart*>(fileData + cacheMesh.MeshParts.Offset);
+        mesh.meshParts.assign(meshParts, meshParts + cacheMesh.MeshParts.Size / sizeof(MeshPart));
+
+        const SceneCacheInputElement* cacheElements = reinterpret_cast<const SceneCacheInputElement*>(fileData + cacheMesh.InputElements.Offset);
+        const uint64 numInputElements = cacheMesh.InputElements.Size / sizeof(SceneCacheInputElement);
+        mesh.inputElements.resize(numInputElements);
+        mesh.inputElementStrings.resize(numInputElements);
+        for(uint64 i = 0; i < numInputElements; ++i)
+        {
+            const SceneCacheInputElement& cacheElement = cacheElements[i];
+            mesh.inputElementStrings[i] = cacheElement.SemanticName;
+
+            D3D11_INPUT_ELEMENT_DESC& element = mesh.inputElements[i];
+            element.SemanticName = mesh.inputElementStrings[i].c_str();
+            element.SemanticIndex = cacheElement.SemanticIndex;
+            element.Format = DXGI_FORMAT(cacheElement.Format);
+            element.InputSlot = cacheElement.InputSlot;
+            element.AlignedByteOffset = cacheElement.AlignedByteOffset;
+            element.InputSlotClass = D3D11_INPUT_CLASSIFICATION(cacheElement.InputSlotClass);
+            element.InstanceDataStepRate = cacheElement.InstanceDataStepRate;
+        }
+
+        const uint8* vertices = fileData + cacheMesh.Vertices.Offset;
+        mesh.vertices.assign(vertices, vertices + cacheMesh.Vertices.Size);
+
+        const uint8* indices = fileData + cacheMesh.Indices.Offset;
+        mesh.indices.assign(indices, indices + cacheMesh.Indices.Size);
+
+        mesh.CreateVertexAndIndexBuffers(device);
+    }
+
+    meshMaterials.resize(header.NumMaterials);
+    materialsSRGB = forceSRGB;
+    for(uint64 materialIdx = 0; materialIdx < header.NumMaterials; ++materialIdx)
+    {
+        for(uint64 mapIdx = 0; mapIdx < NumMaterialMaps; ++mapIdx)
+            MaterialMapName(meshMaterials[materialIdx], mapIdx) = ReadBlobString(fileData, cacheMaterials[materialIdx].Maps[mapIdx].Name);
+        meshMaterials[materialIdx].Emissive = cacheMaterials[materialIdx].Emissive;
+    }
+
+    // Create the textures straight from the mapped file
+    ParallelFor(header.NumMaterials * NumMaterialMaps, [&](uint64 idx)
+    {
+        const uint64 materialIdx = idx / NumMaterialMaps;
+        const uint64 mapIdx = idx % NumMaterialMaps;
+        const SceneCacheTexture& cacheTexture = cacheMaterials[materialIdx].Maps[mapIdx];
+        MeshMaterial& material = meshMaterials[materialIdx];
+
+        if(cacheTexture.DDSData.Size > 0)
+            MaterialMap(material, mapIdx) = LoadTextureFromDDSMemory(device, fileData + cacheTexture.DDSData.Offset,
+                                                                     cacheTexture.DDSData.Size,
+                                                                     forceSRGB && mapIdx == DiffuseMapIdx);
+        else
+            MaterialMap(material, mapIdx) = DefaultMaterialMap(device, mapIdx);
+    });
+
+    return true;
+}
+
+void Model::WriteSceneCache(const wchar* cachePath, const wchar* fileName, bool forceSRGB, const vector<Blob>& ddsData)
+{
+    // The header is filled in last, once all of the offsets are known
+    vector<uint8> fileData(sizeof(SceneCacheHeader), 0);
+
+    vector<SceneCacheMesh> cacheMeshes(meshes.size());
+    for(uint64 meshIdx = 0; meshIdx < meshes.size(); ++meshIdx)
+    {
+        const Mesh& mesh = meshes[meshIdx];
+        SceneCacheMesh& cacheMesh = cacheMeshes[meshIdx];
+
+        cacheMesh.VertexStride = mesh.vertexStride;
+        cacheMesh.NumVertices = mesh.numVertices;
+        cacheMesh.NumIndices = mesh.numIndices;
+        cacheMesh.IndexType = uint32(mesh.indexType);
+
+        vector<SceneCacheInputElement> cacheElements(mesh.inputElements.size());
+        for(uint64 i = 0; i < mesh.inputElements.size(); ++i)
+        {
+            const D3D11_INPUT_ELEMENT_DESC& element = mesh.inputElements[i];
+            SceneCacheInputElement& cacheElement = cacheElements[i];
+            Assert_(strlen(element.SemanticName) < ArraySize_(cacheElement.SemanticName));
+
+            strcpy_s(cacheElement.SemanticName, element.SemanticName);
+            cacheElement.SemanticIndex = element.SemanticIndex;
+            cacheElement.Format = uint32(element.Format);
+            cacheElement.InputSlot = element.InputSlot;
+            cacheElement.AlignedByteOffset = element.AlignedByteOffset;
+            cacheElement.InputSlotClass = uint32(element.InputSlotClass);
+            cacheElement.InstanceDataStepRate = element.InstanceDataStepRate;
+        }
+
+        cacheMesh.MeshParts = AppendBlob(fileData, mesh.meshParts.data(), mesh.meshParts.size() * sizeof(MeshPart));
+        cacheMesh.InputElements = AppendBlob(fileData, cacheElements.data(), cacheElements.size() * sizeof(SceneCacheInputElement));
+        cacheMesh.Vertices = AppendBlob(fileData, mesh.vertices.data(), mesh.vertices.size());
+        cacheMesh.Indices = AppendBlob(fileData, mesh.indices.data(), mesh.indices.size());
+    }
+
+    vector<SceneCacheMaterial> cacheMaterials(meshMaterials.size());
+    for(uint64 materialIdx = 0; materialIdx < meshMaterials.size(); ++materialIdx)
+    {
+        MeshMaterial& material = meshMaterials[materialIdx];
+        cacheMaterials[materialIdx].Emissive = material.Emissive;
+        for(uint64 mapIdx = 0; mapIdx < NumMaterialMaps; ++mapIdx)
+        {
+            const wstring& mapName = MaterialMapName(material, mapIdx);
+            const wstring mapPath = fileDirectory + mapName;
+            SceneCacheTexture& cacheTexture = cacheMaterials[materialIdx].Maps[mapIdx];
+            cacheTexture.Name = AppendBlob(fileData, mapName.c_str(), mapName.length() * sizeof(wchar));
+
+            // Default textures aren't stored, since they're shared by all materials
+            if(mapName.length() > 1 && FileExists(mapPath.c_str()))
+            {
+                const Blob& mapData = ddsData[materialIdx * NumMaterialMaps + mapIdx];
+                Assert_(mapData.GetBufferSize() > 0);
+                cacheTexture.DDSData = AppendBlob(fileData, mapData.GetBufferPointer(), mapData.GetBufferSize());
+                cacheTexture.SourceTimestamp = GetFileTimestamp(mapPath.c_str());
+            }
+        }
+    }
+
+    SceneCacheHeader header;
+    header.Magic = SceneCacheMagic;
+    header.Version = SceneCacheVersion;
+    header.SourceTimestamp = GetFileTimestamp(fileName);
+    header.SourceSize = GetSourceFileSize(fileName);
+    header.ImportFlags = AssimpImportFlags;
+    header.ForceSRGB = forceSRGB ? 1 : 0;
+    header.NumMeshes = meshes.size();
+    header.NumMaterials = meshMaterials.size();
+    header.Meshes = AppendBlob(fileData, cacheMeshes.data(), cacheMeshes.size() * sizeof(SceneCacheMesh));
+    header.Materials = AppendBlob(fileData, cacheMaterials.data(), cacheMaterials.size() * sizeof(SceneCacheMaterial));
+    header.FileSize = fileData.size();
+    memcpy(fileData.data(), &header, sizeof(SceneCacheHeader));
+
+    // Write to a temporary file and then swap it in, so that an interrupted write can never
+    // leave behind a cache that looks valid
+    const wstring tempPath = wstring(cachePath) + L".tmp";
+    {
+        File file(tempPath.c_str(), FileOpenMode::Write);
+
+        // File::Write can only handle 4GB at a time
+        const uint64 maxWriteSize = 1024 * 1024 * 1024;
+        for(uint64 offset = 0; offset < fileData.size(); offset += maxWriteSize)
+            file.Write(std::min<uint64>(fileData.size() - offset, maxWriteSize), &fileData[size_t(offset)]);
+    }
+
+    Win32Call(MoveFileEx(tempPath.c_str(), cachePath, MOVEFILE_REPLACE_EXISTING));
+}
+
 void Model::GenerateBoxScene(ID3D11Device* device, const Float3& dimensions, const Float3& position,
                              const Quaternion& orientation, const wchar* colorMap,
                              const wchar* normalMap)
@@ -1026,53 +1412,44 @@ void Model::GenerateCorneaScene(ID3D11Device* device)
 
 void Model::LoadMaterialResources(MeshMaterial& material, const wstring& directory, ID3D11Device* device, bool forceSRGB)
 {
-    // Load the diffuse map
-    wstring diffuseMapPath = directory + material.DiffuseMapName;
-    if(material.DiffuseMapName.length() > 1 && FileExists(diffuseMapPath.c_str()))
-        material.DiffuseMap = LoadTexture(device, diffuseMapPath.c_str(), forceSRGB);
-    else
+    ParallelFor(NumMaterialMaps, [&](uint64 mapIdx)
     {
-        static ID3D11ShaderResourceViewPtr defaultDiffuse;
-        if(defaultDiffuse == nullptr)
-            defaultDiffuse = LoadTexture(device, L"..\\Content\\Textures\\Default.dds");
-        material.DiffuseMap = defaultDiffuse;
-    }
+        LoadMaterialMap(material, mapIdx, directory, device, forceSRGB, nullptr);
+    });
+}
 
-    // Load the normal map
-    wstring normalMapPath = directory + material.NormalMapName;
-    if(material.NormalMapName.length() > 1 && FileExists(normalMapPath.c_str()))
-        material.NormalMap = LoadTexture(device, normalMapPath.c_str());
-    else
-    {
-        static ID3D11ShaderResourceViewPtr defaultNormalMap;
-        if(defaultNormalMap == nullptr)
-            defaultNormalMap = LoadTexture(device, L"..\\Content\\Textures\\DefaultNormalMap.dds");
-        material.NormalMap = defaultNormalMap;
-    }
+// Loads the maps of all materials in parallel, optionally keeping the DDS data of every map that
+// was loaded from a file
+void Model::LoadMaterials(ID3D11Device* device, bool forceSRGB, vector<Blob>* ddsData)
+{
+    materialsSRGB = forceSRGB;
+    if(ddsData != nullptr)
+        ddsData->resize(meshMaterials.size() * NumMaterialMaps);
 
-     // Load the roughness map
-    wstring roughnessMapPath = directory + material.RoughnessMapName;
-    if(material.RoughnessMapName.length() > 1 && FileExists(roughnessMapPath.c_str()))
-        material.RoughnessMap = LoadTexture(device, roughnessMapPath.c_str());
-    else
+    ParallelFor(meshMaterials.size() * NumMaterialMaps, [&](uint64 idx)
     {
-        static ID3D11ShaderResourceViewPtr defaultRoughnessMap;
-        if(defaultRoughnessMap == nullptr)
-            defaultRoughnessMap = LoadTexture(device, L"..\\Content\\Textures\\DefaultRoughness.dds");
-        material.RoughnessMap = defaultRoughnessMap;
-    }
+        Blob* mapData = ddsData != nullptr ? &(*ddsData)[idx] : nullptr;
+        LoadMaterialMap(meshMaterials[idx / NumMaterialMaps], idx % NumMaterialMaps, fileDirectory, device, forceSRGB, mapData);
+    });
+}
 
-     // Load the metallic map
-    wstring metallicMapPath = directory + material.MetallicMapName;
-    if(material.MetallicMapName.length() > 1 && FileExists(metallicMapPath.c_str()))
-        material.MetallicMap = LoadTexture(device, metallicMapPath.c_str());
-    else
+// Returns the file that a material map was loaded from, which is one of the default textures if
+// the material doesn't have its own map
+wstring Model::MaterialMapPath(uint64 materialIdx, MaterialMaps map, bool& srgb) const
+{
+    Assert_(materialIdx < meshMaterials.size());
+    const uint64 mapIdx = uint64(map);
+    Assert_(mapIdx < NumMaterialMaps);
+
+    const wstring mapPath = MaterialMapFilePath(meshMaterials[materialIdx], mapIdx, fileDirectory);
+    if(mapPath.length() > 0)
     {
-        static ID3D11ShaderResourceViewPtr defaultMetallicMap;
-        if(defaultMetallicMap == nullptr)
-            defaultMetallicMap = LoadTexture(device, L"..\\Content\\Textures\\DefaultBlack.dds");
-        material.MetallicMap = defaultMetallicMap;
+        srgb = materialsSRGB && mapIdx == DiffuseMapIdx;
+        return mapPath;
     }
+
+    srgb = false;
+    return DefaultMaterialMapPaths[mapIdx];
 }
 
 }
\ No newline at end of file
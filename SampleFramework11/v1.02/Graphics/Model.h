@@ -22,12 +22,23 @@ namespace SampleFramework11
 
 class SDKMesh;
 
+enum class MaterialMaps
+{
+    Diffuse = 0,
+    Normal,
+    Roughness,
+    Metallic,
+
+    NumValues
+};
+
 struct MeshMaterial
 {
     std::wstring DiffuseMapName;
     std::wstring NormalMapName;
     std::wstring RoughnessMapName;
     std::wstring MetallicMapName;
+    Float3 Emissive;                        // Only imported with Assimp, and not serialized
     ID3D11ShaderResourceViewPtr DiffuseMap;
     ID3D11ShaderResourceViewPtr NormalMap;
     ID3D11ShaderResourceViewPtr RoughnessMap;
@@ -104,6 +115,10 @@ public:
     const uint8* Vertices() const { return vertices.data(); }
     const uint8* Indices() const { return indices.data(); }
 
+    // Modifying the vertex data requires a call to UpdateBuffers() before the changes are visible to the GPU
+    uint8* Vertices() { return vertices.data(); }
+    void UpdateBuffers(ID3D11Device* device) { CreateVertexAndIndexBuffers(device); }
+
     template<typename TSerializer> void Serialize(TSerializer& serializer)
     {
         SerializeRawVector(serializer, meshParts);
@@ -166,6 +181,10 @@ public:
 
     void CreateFromMeshData(ID3D11Device* device, const wchar* fileName, bool forceSRGB = false);
 
+    // Loads from a binary scene cache that sits next to the source file, which is re-generated
+    // with Assimp whenever it's missing or out of date
+    void CreateWithSceneCache(ID3D11Device* device, const wchar* fileName, bool forceSRGB = false);
+
     // Procedural generation
     void GenerateBoxScene(ID3D11Device* device,
                           const Float3& dimensions = Float3(1.0f, 1.0f, 1.0f),
@@ -189,6 +208,11 @@ public:
     std::vector<Mesh>& Meshes() { return meshes; }
     const std::vector<Mesh>& Meshes() const { return meshes; }
 
+    const std::wstring& FileDirectory() const { return fileDirectory; }
+
+    // The file that a material map was loaded from, and whether it was loaded as sRGB
+    std::wstring MaterialMapPath(uint64 materialIdx, MaterialMaps map, bool& srgb) const;
+
     // Serialization
     template<typename TSerializer>
     void Serialize(TSerializer& serializer, ID3D11Device* device, bool forceSRGB = false)
@@ -202,18 +226,24 @@ public:
             for(uint64 i = 0; i  < meshes.size(); ++i)
                 meshes[i].CreateVertexAndIndexBuffers(device);
 
-            for(uint64 i = 0; i < meshMaterials.size(); ++i)
-                LoadMaterialResources(meshMaterials[i], fileDirectory, device, forceSRGB);
+            LoadMaterials(device, forceSRGB);
         }
     }
 
 protected:
 
     static void LoadMaterialResources(MeshMaterial& material, const std::wstring& directory, ID3D11Device* device, bool forceSRGB);
+    void LoadMaterials(ID3D11Device* device, bool forceSRGB, std::vector<Blob>* ddsData = nullptr);
+
+    void ImportWithAssimp(ID3D11Device* device, const wchar* fileName, bool forceSRGB, std::vector<Blob>* ddsData);
+
+    bool LoadSceneCache(ID3D11Device* device, const wchar* cachePath, const wchar* fileName, bool forceSRGB);
+    void WriteSceneCache(const wchar* cachePath, const wchar* fileName, bool forceSRGB, const std::vector<Blob>& ddsData);
 
     std::vector<Mesh> meshes;
     std::vector<MeshMaterial> meshMaterials;
     std::wstring fileDirectory;
+    bool materialsSRGB = false;
 };
 
 }
\ No newline at end of file
@@ -17,7 +17,8 @@
 #include "..\\FileIO.h"
 #include "ShaderCompilation.h"
 #include "GraphicsTypes.h"
-#include "TinyEXR.h"
+#include "EXRWriter.h"
+#include "..\\ThreadPool.h"
 
 namespace SampleFramework11
 {
@@ -43,12 +44,11 @@ static bool IsUnormFormat(DXGI_FORMAT format)
     return false;
 }
 
-// Loads a texture, using either the DDS loader or the WIC loader
-ID3D11ShaderResourceViewPtr LoadTexture(ID3D11Device* device, const wchar* filePath, bool forceSRGB)
+// Loads a texture, using either the DDS loader or WIC. Mips for WIC images are generated on the
+// CPU, so that loading never touches the immediate context and can be done from any thread. If
+// ddsData is provided, it receives the texture and all of its mips in DDS form.
+ID3D11ShaderResourceViewPtr LoadTexture(ID3D11Device* device, const wchar* filePath, bool forceSRGB, Blob* ddsData)
 {
-    ID3D11DeviceContextPtr context;
-    device->GetImmediateContext(&context);
-
     ID3D11ResourcePtr resource;
     ID3D11ShaderResourceViewPtr srv;
 
@@ -58,17 +58,48 @@ ID3D11ShaderResourceViewPtr LoadTexture(ID3D11Device* device, const wchar* fileP
         DXCall(DirectX::CreateDDSTextureFromFileEx(device, filePath, 0, D3D11_USAGE_DEFAULT,
                                                    D3D11_BIND_SHADER_RESOURCE, 0, 0, forceSRGB,
                                                    &resource, &srv, nullptr));
+
+        if(ddsData != nullptr)
+        {
+            File file(filePath, FileOpenMode::Read);
+            DXCall(ddsData->Initialize(size_t(file.Size())));
+            file.Read(file.Size(), ddsData->GetBufferPointer());
+        }
+
         return srv;
     }
     else
     {
-        DXCall(DirectX:: CreateWICTextureFromFileEx(device, context, filePath, 0, D3D11_USAGE_DEFAULT,
-                                                    D3D11_BIND_SHADER_RESOURCE, 0, 0, forceSRGB, &resource, &srv));
+        ScratchImage image;
+        DXCall(LoadFromWICFile(filePath, WIC_FLAGS_NONE, nullptr, image));
+
+        ScratchImage mipChain;
+        DXCall(GenerateMipMaps(*image.GetImage(0, 0, 0), TEX_FILTER_DEFAULT, 0, mipChain));
+
+        DXCall(CreateShaderResourceViewEx(device, mipChain.GetImages(), mipChain.GetImageCount(),
+                                          mipChain.GetMetadata(), D3D11_USAGE_DEFAULT,
+                                          D3D11_BIND_SHADER_RESOURCE, 0, 0, forceSRGB, &srv));
+
+        if(ddsData != nullptr)
+            DXCall(SaveToDDSMemory(mipChain.GetImages(), mipChain.GetImageCount(), mipChain.GetMetadata(),
+                                   DDS_FLAGS_FORCE_DX10_EXT, *ddsData));
 
         return srv;
     }
 }
 
+// Creates a texture from the contents of a DDS file that's already in memory, including all of
+// its mip levels
+ID3D11ShaderResourceViewPtr LoadTextureFromDDSMemory(ID3D11Device* device, const uint8* ddsData, uint64 ddsSize,
+                                                     bool forceSRGB)
+{
+    ID3D11ResourcePtr resource;
+    ID3D11ShaderResourceViewPtr srv;
+    DXCall(DirectX::CreateDDSTextureFromMemoryEx(device, ddsData, size_t(ddsSize), 0, D3D11_USAGE_DEFAULT,
+                                                 D3D11_BIND_SHADER_RESOURCE, 0, 0, forceSRGB, &resource, &srv, nullptr));
+    return srv;
+}
+
 template<typename T>
 static void GetTextureData(ID3D11Device* device, ID3D11ShaderResourceView* textureSRV,
                            DXGI_FORMAT outFormat, TextureData<T>& texData)
@@ -196,6 +227,77 @@ void GetTextureData(ID3D11Device* device, ID3D11ShaderResourceView* textureSRV,
     GetTextureData(device, textureSRV, DXGI_FORMAT_R8G8B8A8_UNORM, textureData);
 }
 
+// Loads the top mip of every slice of a DDS or WIC image into CPU memory, converting it to the
+// requested format without involving the GPU. sRGB data is converted to linear, the same as when
+// sampling an sRGB texture through a shader.
+template<typename T>
+static void LoadTextureData(const wchar* filePath, bool forceSRGB, DXGI_FORMAT outFormat, TextureData<T>& texData)
+{
+    ScratchImage image;
+    const std::wstring extension = GetFileExtension(filePath);
+    if(extension == L"DDS" || extension == L"dds")
+        DXCall(LoadFromDDSFile(filePath, DDS_FLAGS_NONE, nullptr, image));
+    else
+        DXCall(LoadFromWICFile(filePath, WIC_FLAGS_NONE, nullptr, image));
+
+    const TexMetadata& metadata = image.GetMetadata();
+    if(metadata.dimension != TEX_DIMENSION_TEXTURE2D)
+        throw Exception(L"Only 2D textures can be loaded as texture data: " + std::wstring(filePath));
+
+    const uint32 width = uint32(metadata.width);
+    const uint32 height = uint32(metadata.height);
+    const uint32 numSlices = uint32(metadata.arraySize);
+    texData.Init(width, height, numSlices);
+
+    ParallelFor(numSlices, [&](uint64 slice)
+    {
+        const Image* srcImage = image.GetImage(0, slice, 0);
+
+        ScratchImage decompressed;
+        if(IsCompressed(srcImage->format))
+        {
+            DXCall(Decompress(*srcImage, DXGI_FORMAT_UNKNOWN, decompressed));
+            srcImage = decompressed.GetImage(0, 0, 0);
+        }
+
+        Image decodeImage = *srcImage;
+        if(forceSRGB)
+            decodeImage.format = MakeSRGB(decodeImage.format);
+
+        ScratchImage converted;
+        if(decodeImage.format != outFormat)
+        {
+            DXCall(Convert(decodeImage, outFormat, TEX_FILTER_DEFAULT, 0.5f, converted));
+            decodeImage = *converted.GetImage(0, 0, 0);
+        }
+
+        Assert_(decodeImage.rowPitch >= width * sizeof(T));
+        const uint8* srcData = decodeImage.pixels;
+        T* dstData = texData.Texels.data() + uint64(width) * height * slice;
+        for(uint32 y = 0; y < height; ++y)
+        {
+            memcpy(dstData, srcData, width * sizeof(T));
+            srcData += decodeImage.rowPitch;
+            dstData += width;
+        }
+    });
+}
+
+void LoadTextureData(const wchar* filePath, TextureData<UByte4N>& textureData, bool forceSRGB)
+{
+    LoadTextureData(filePath, forceSRGB, DXGI_FORMAT_R8G8B8A8_UNORM, textureData);
+}
+
+void LoadTextureData(const wchar* filePath, TextureData<Half4>& textureData, bool forceSRGB)
+{
+    LoadTextureData(filePath, forceSRGB, DXGI_FORMAT_R16G16B16A16_FLOAT, textureData);
+}
+
+void LoadTextureData(const wchar* filePath, TextureData<Float4>& textureData, bool forceSRGB)
+{
+    LoadTextureData(filePath, forceSRGB, DXGI_FORMAT_R32G32B32A32_FLOAT, textureData);
+}
+
 template<typename T>
 static ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device, const TextureData<T>& textureData)
 {
@@ -297,39 +399,11 @@ void SaveTextureAsEXR(const TextureData<Float4>& texture, const wchar* filePath)
     Assert_(texture.Width > 0 && texture.Height > 0);
     Assert_(texture.NumSlices == 1);
 
-    const uint64 numTexels = texture.Texels.size();
-    std::vector<float> channelDataR;
-    std::vector<float> channelDataG;
-    std::vector<float> channelDataB;
-    channelDataR.resize(numTexels);
-    channelDataG.resize(numTexels);
-    channelDataB.resize(numTexels);
-    for(uint64 i = 0; i < numTexels; ++i)
+    std::vector<std::string> layerNames(1);
+    WriteEXR(filePath, texture.Width, texture.Height, layerNames, [&](uint64 layerIdx, uint64 y, Float4* rowTexels)
     {
-        channelDataR[i] = texture.Texels[i].x;
-        channelDataG[i] = texture.Texels[i].y;
-        channelDataB[i] = texture.Texels[i].z;
-    }
-
-    float* imageChannels[3] = { channelDataB.data(), channelDataG.data(), channelDataR.data() };
-    const char* channelNames[3] = { "B", "G", "R" };
-
-    EXRImage exrImage;
-    exrImage.num_channels = 3;
-    exrImage.width = texture.Width;
-    exrImage.height = texture.Height;
-    exrImage.channel_names = channelNames;
-    exrImage.images = imageChannels;
-
-    std::string filePathAnsi = WStringToAnsi(filePath);
-
-    const char* errorString = nullptr;
-    int returnCode = SaveMultiChannelEXR(&exrImage, filePathAnsi.c_str(), &errorString);
-    if(returnCode != 0)
-    {
-        AssertFail_("%s", errorString);
-        throw Exception(AnsiToWString(errorString));
-    }
+        memcpy(rowTexels, &texture.Texels[y * texture.Width], texture.Width * sizeof(Float4));
+    });
 }
 
 void SaveTextureAsPNG(ID3D11ShaderResourceView* srv, const wchar* filePath)
@@ -23,7 +23,10 @@ struct UByte4N;
 class File;
 
 // Texture loading
-ID3D11ShaderResourceViewPtr LoadTexture(ID3D11Device* device, const wchar* filePath, bool forceSRGB = false);
+ID3D11ShaderResourceViewPtr LoadTexture(ID3D11Device* device, const wchar* filePath, bool forceSRGB = false,
+                                        Blob* ddsData = nullptr);
+ID3D11ShaderResourceViewPtr LoadTextureFromDDSMemory(ID3D11Device* device, const uint8* ddsData, uint64 ddsSize,
+                                                     bool forceSRGB = false);
 
 template<typename T> struct TextureData
 {
@@ -59,6 +62,12 @@ void GetTextureData(ID3D11Device* device, ID3D11ShaderResourceView* textureSRV,
 void GetTextureData(ID3D11Device* device, ID3D11ShaderResourceView* textureSRV,
                     TextureData<Float4>& textureData);
 
+// Decodes the top mip of a DDS or WIC image file on the CPU, without going through the GPU.
+// The slices of the texture are decoded in parallel.
+void LoadTextureData(const wchar* filePath, TextureData<UByte4N>& textureData, bool forceSRGB = false);
+void LoadTextureData(const wchar* filePath, TextureData<Half4>& textureData, bool forceSRGB = false);
+void LoadTextureData(const wchar* filePath, TextureData<Float4>& textureData, bool forceSRGB = false);
+
 ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device,
                                                      const TextureData<UByte4N>& textureData);
 
@@ -467,6 +467,15 @@ Float3 Float3::Perpendicular(const Float3& vec)
     return Float3::Normalize(perp);
 }
 
+Float3 Float3::Min(const Float3& a, const Float3& b)
+{
+	Float3 retVal;
+	retVal.x = SampleFramework11::Min(a.x, b.x);
+	retVal.y = SampleFramework11::Min(a.y, b.y);
+	retVal.z = SampleFramework11::Min(a.z, b.z);
+	return retVal;
+}
+
 Float3 Float3::Max(const Float3& a, const Float3& b)
 {
 	Float3 retVal;
@@ -116,6 +116,7 @@ struct Float3
     static Float3 Transform(const Float3& v, const Quaternion& q);
     static Float3 Clamp(const Float3& val, const Float3& min, const Float3& max);
     static Float3 Perpendicular(const Float3& v);
+	static Float3 Min(const Float3& a, const Float3& b);
 	static Float3 Max(const Float3& a, const Float3& b);
     static float Distance(const Float3& a, const Float3& b);
     static float Length(const Float3& v);
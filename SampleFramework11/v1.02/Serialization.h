@@ -13,60 +13,210 @@
 
 #include "Exceptions.h"
 #include "FileIO.h"
+#include "Assert.h"
 
 namespace SampleFramework11
 {
 
+// Reads through a large buffer, so that reading a small item is a copy out of memory instead of a
+// ReadFile call. Reads that are larger than the buffer go straight to the destination.
 class FileReadSerializer
 {
 
 private:
 
+    static const uint64 BufferSize = 1024 * 1024;
+
     File file;
+    std::vector<uint8> buffer;
+    uint64 bufferOffset = 0;
+    uint64 bufferEnd = 0;
+    uint64 fileRemaining = 0;
+
+    void ReadFromFile(uint64 size, void* data)
+    {
+        if(size > fileRemaining)
+            throw Exception(L"Tried to read past the end of a serialized file");
+
+        // ReadFile can only read 4GB at a time
+        uint8* dst = reinterpret_cast<uint8*>(data);
+        while(size > 0)
+        {
+            const uint64 chunkSize = std::min<uint64>(size, 1024 * 1024 * 1024);
+            file.Read(chunkSize, dst);
+            dst += chunkSize;
+            size -= chunkSize;
+            fileRemaining -= chunkSize;
+        }
+    }
 
 public:
 
     explicit FileReadSerializer(const wchar* path)
     {
         file.Open(path, FileOpenMode::Read);
+        fileRemaining = file.Size();
+        buffer.resize(BufferSize);
+    }
+
+    template<typename T> void SerializeItem(T& data)
+    {
+        SerializeData(sizeof(T), &data);
+    }
+
+    void SerializeData(uint64 size, void* data)
+    {
+        uint8* dst = reinterpret_cast<uint8*>(data);
+
+        const uint64 buffered = std::min(size, bufferEnd - bufferOffset);
+        if(buffered > 0)
+        {
+            memcpy(dst, buffer.data() + bufferOffset, buffered);
+            bufferOffset += buffered;
+            dst += buffered;
+            size -= buffered;
+        }
+
+        if(size == 0)
+            return;
+
+        if(size >= BufferSize)
+        {
+            ReadFromFile(size, dst);
+            return;
+        }
+
+        bufferOffset = 0;
+        bufferEnd = std::min<uint64>(buffer.size(), fileRemaining);
+        ReadFromFile(bufferEnd, buffer.data());
+
+        if(size > bufferEnd)
+            throw Exception(L"Tried to read past the end of a serialized file");
+
+        memcpy(dst, buffer.data(), size);
+        bufferOffset = size;
+    }
+
+    static bool IsReadSerializer() { return true; }
+    static bool IsWriteSerializer() { return false; }
+};
+
+// Reads out of a memory-mapped file, so that reading never makes a system call. Raw data can also
+// be viewed in place with ViewData() or SerializeRawView(), which stay valid for as long as the
+// serializer is alive. Views aren't guaranteed to have any particular alignment.
+class MappedFileReadSerializer
+{
+
+private:
+
+    MemoryMappedFile file;
+    uint64 offset = 0;
+
+public:
+
+    explicit MappedFileReadSerializer(const wchar* path)
+    {
+        file.Open(path);
     }
 
     template<typename T> void SerializeItem(T& data)
     {
-        file.Read(data);
+        SerializeData(sizeof(T), &data);
     }
 
     void SerializeData(uint64 size, void* data)
     {
-        file.Read(size, data);
+        memcpy(data, ViewData(size), size);
+    }
+
+    const void* ViewData(uint64 size)
+    {
+        if(size > file.Size() - offset)
+            throw Exception(L"Tried to read past the end of a serialized file");
+
+        const uint8* data = file.Data() + offset;
+        offset += size;
+        return data;
     }
 
     static bool IsReadSerializer() { return true; }
     static bool IsWriteSerializer() { return false; }
 };
 
+// Batches writes in a large buffer, and writes anything larger than the buffer directly. Call
+// Flush() once everything has been serialized, since the destructor can't report errors.
 class FileWriteSerializer
 {
 
 private:
 
+    static const uint64 BufferSize = 1024 * 1024;
+
     File file;
+    std::vector<uint8> buffer;
+
+    void WriteToFile(uint64 size, const void* data)
+    {
+        // WriteFile can only write 4GB at a time
+        const uint8* src = reinterpret_cast<const uint8*>(data);
+        while(size > 0)
+        {
+            const uint64 chunkSize = std::min<uint64>(size, 1024 * 1024 * 1024);
+            file.Write(chunkSize, src);
+            src += chunkSize;
+            size -= chunkSize;
+        }
+    }
 
 public:
 
     explicit FileWriteSerializer(const wchar* path)
     {
         file.Open(path, FileOpenMode::Write);
+        buffer.reserve(BufferSize);
+    }
+
+    ~FileWriteSerializer()
+    {
+        try
+        {
+            Flush();
+        }
+        catch(...)
+        {
+        }
     }
 
     template<typename T> void SerializeItem(const T& data)
     {
-        file.Write(data);
+        SerializeData(sizeof(T), &data);
     }
 
     void SerializeData(uint64 size, const void* data)
     {
-        file.Write(size, data);
+        if(buffer.size() + size > BufferSize)
+            Flush();
+
+        if(size >= BufferSize)
+        {
+            WriteToFile(size, data);
+            return;
+        }
+
+        const uint8* src = reinterpret_cast<const uint8*>(data);
+        buffer.insert(buffer.end(), src, src + size);
+    }
+
+    void Flush()
+    {
+        if(buffer.size() == 0)
+            return;
+
+        // Clear first, so that a failed write isn't retried by the destructor
+        std::vector<uint8> pending;
+        pending.swap(buffer);
+        buffer.reserve(BufferSize);
+        WriteToFile(pending.size(), pending.data());
     }
 
     static bool IsReadSerializer() { return false; }
@@ -227,6 +377,26 @@ void SerializeRawVector(TSerializer& serializer, std::vector<TVector>& vec)
     SerializeRawArray(serializer, vec.data(), numElements);
 }
 
+// Serializes raw data that's referenced by a pointer instead of owned by a vector. When reading
+// with a MappedFileReadSerializer the pointer is set to a view of the data inside the file,
+// which avoids copying it at all.
+template<typename TSerializer, typename TValue>
+void SerializeRawView(TSerializer& serializer, const TValue*& data, uint64& numElements)
+{
+    Assert_(TSerializer::IsWriteSerializer());
+
+    SerializeItem(serializer, numElements);
+    if(numElements > 0)
+        SerializeRawArray(serializer, const_cast<TValue*>(data), numElements);
+}
+
+template<typename TValue>
+void SerializeRawView(MappedFileReadSerializer& serializer, const TValue*& data, uint64& numElements)
+{
+    SerializeItem(serializer, numElements);
+    data = reinterpret_cast<const TValue*>(serializer.ViewData(sizeof(TValue) * numElements));
+}
+
 template<typename TSerializer, typename TString>
 void SerializeItem(TSerializer& serializer, std::basic_string<TString>& str)
 {
@@ -254,6 +424,7 @@ void SerializeToFile(const wchar* filePath, const T& item)
 {
     FileWriteSerializer serializer(filePath);
     SerializeItem(serializer, item);
+    serializer.Flush();
 }
 
 }
\ No newline at end of file
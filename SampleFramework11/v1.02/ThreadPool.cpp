@@ -0,0 +1,208 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "ThreadPool.h"
+
+#include "Exceptions.h"
+#include "Assert.h"
+
+#include <deque>
+#include <condition_variable>
+
+namespace SampleFramework11
+{
+
+struct QueuedJob
+{
+    std::function<void()> Func;
+    JobGroup* Group = nullptr;
+};
+
+static std::vector<HANDLE> threads;
+static std::deque<QueuedJob> jobQueue;
+static std::mutex queueLock;
+static std::condition_variable queueCondition;
+static bool shutdownThreads = false;
+
+// Takes the next job off the queue and runs it, optionally waiting for one to be queued. Returns
+// false if there was no job to run.
+static bool RunNextJob(bool waitForJob)
+{
+    QueuedJob job;
+
+    {
+        std::unique_lock<std::mutex> lock(queueLock);
+        if(waitForJob)
+            queueCondition.wait(lock, [] { return jobQueue.size() > 0 || shutdownThreads; });
+
+        if(jobQueue.size() == 0)
+            return false;
+
+        job = std::move(jobQueue.front());
+        jobQueue.pop_front();
+    }
+
+    job.Group->Execute(job.Func);
+    return true;
+}
+
+static uint32 __stdcall WorkerThread(void* data)
+{
+    // WIC needs COM to be initialized on every thread that decodes images
+    CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    while(true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueLock);
+            if(shutdownThreads && jobQueue.size() == 0)
+                break;
+        }
+
+        RunNextJob(true);
+    }
+
+    CoUninitialize();
+
+    return 0;
+}
+
+// == ThreadPool ==================================================================================
+
+namespace ThreadPool
+{
+
+void Initialize(uint64 numThreads)
+{
+    Assert_(threads.size() == 0);
+
+    if(numThreads == 0)
+    {
+        SYSTEM_INFO sysInfo;
+        GetSystemInfo(&sysInfo);
+        numThreads = std::max<uint64>(1, sysInfo.dwNumberOfProcessors - 1);
+    }
+
+    shutdownThreads = false;
+    threads.resize(numThreads);
+    for(uint64 i = 0; i < numThreads; ++i)
+    {
+        threads[i] = HANDLE(_beginthreadex(nullptr, 0, WorkerThread, nullptr, 0, nullptr));
+        if(threads[i] == 0)
+            throw Exception(L"Failed to create a thread pool thread");
+    }
+}
+
+void Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        shutdownThreads = true;
+    }
+    queueCondition.notify_all();
+
+    for(uint64 i = 0; i < threads.size(); ++i)
+    {
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+    }
+
+    threads.clear();
+}
+
+uint64 NumThreads()
+{
+    return threads.size();
+}
+
+}
+
+// == JobGroup ====================================================================================
+
+JobGroup::JobGroup() : numPending(0)
+{
+}
+
+JobGroup::~JobGroup()
+{
+    WaitForJobs();
+}
+
+void JobGroup::Run(std::function<void()> job)
+{
+    InterlockedIncrement64(&numPending);
+
+    if(threads.size() == 0)
+    {
+        Execute(job);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        QueuedJob queuedJob;
+        queuedJob.Func = std::move(job);
+        queuedJob.Group = this;
+        jobQueue.push_back(std::move(queuedJob));
+    }
+    queueCondition.notify_one();
+}
+
+void JobGroup::Execute(const std::function<void()>& job)
+{
+    try
+    {
+        job();
+    }
+    catch(...)
+    {
+        std::lock_guard<std::mutex> lock(exceptionLock);
+        if(exception == nullptr)
+            exception = std::current_exception();
+    }
+
+    // The group can be destroyed as soon as the count hits zero, so it can't be touched after this
+    InterlockedDecrement64(&numPending);
+}
+
+void JobGroup::WaitForJobs()
+{
+    while(numPending > 0)
+    {
+        // Help out with whatever is queued, which includes this group's own jobs
+        if(RunNextJob(false) == false)
+            SwitchToThread();
+    }
+}
+
+void JobGroup::Wait()
+{
+    WaitForJobs();
+
+    if(exception != nullptr)
+    {
+        std::exception_ptr jobException = exception;
+        exception = nullptr;
+        std::rethrow_exception(jobException);
+    }
+}
+
+// == Helpers =====================================================================================
+
+void ParallelFor(uint64 count, const std::function<void(uint64 idx)>& func)
+{
+    JobGroup group;
+    for(uint64 i = 0; i < count; ++i)
+        group.Run([&func, i]() { func(i); });
+    group.Wait();
+}
+
+}
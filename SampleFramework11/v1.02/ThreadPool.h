@@ -0,0 +1,68 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "PCH.h"
+
+#include <functional>
+#include <exception>
+#include <mutex>
+
+namespace SampleFramework11
+{
+
+// A fixed set of worker threads that run queued jobs. If the pool hasn't been initialized, jobs
+// just run on the thread that queues them.
+namespace ThreadPool
+{
+    // Uses one thread per core, minus one for the main thread, when numThreads is 0
+    void Initialize(uint64 numThreads = 0);
+    void Shutdown();
+
+    uint64 NumThreads();
+}
+
+// A set of jobs that can be waited on together. Jobs are free to start groups of their own, and
+// a thread waiting on a group runs other queued jobs in the meantime, so groups can be nested
+// without tying up the worker threads.
+class JobGroup
+{
+
+public:
+
+    JobGroup();
+    ~JobGroup();
+
+    void Run(std::function<void()> job);
+
+    // Waits for all queued jobs, and re-throws the first exception thrown by any of them
+    void Wait();
+
+    bool Done() const { return numPending == 0; }
+
+    // Runs one job for a group, called by whoever takes the job from the queue
+    void Execute(const std::function<void()>& job);
+
+private:
+
+    JobGroup(const JobGroup& other);
+    JobGroup& operator=(const JobGroup& other);
+
+    void WaitForJobs();
+
+    volatile int64 numPending;
+    std::exception_ptr exception;
+    std::mutex exceptionLock;
+};
+
+// Calls func for every index in [0, count), spread across the thread pool
+void ParallelFor(uint64 count, const std::function<void(uint64 idx)>& func);
+
+}
@@ -77,6 +77,15 @@ extern int LoadMultiChannelEXR(EXRImage *image, const char *filename,
 extern int SaveMultiChannelEXR(const EXRImage *image, const char *filename,
                                const char **err);
 
+// Compresses one block of scanline data the same way as ZIP-compressed EXR
+// files, with the EXR byte reordering and predictor applied before deflate.
+// `dst` must hold at least CompressBoundEXRZip(srcSize) bytes.
+// Returns the compressed size. Can be called from several threads at once.
+extern unsigned long CompressBoundEXRZip(unsigned long srcSize);
+extern unsigned long long CompressEXRZipBlock(unsigned char *dst,
+                                              const unsigned char *src,
+                                              unsigned long srcSize);
+
 // Loads single-frame OpenEXR deep image.
 // Application must free memory of variables in DeepImage(image, offset_table)
 // Return 0 if success